@@ -11,6 +11,7 @@ AirwaySegmentation::AirwaySegmentation() {
 	createOutputPort<Segmentation>(0);
 
 	createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/AirwaySegmentation/AirwaySegmentation.cl");
+	declareOpenCLProgramBuildOptions();
 }
 
 Vector3i AirwaySegmentation::findSeedVoxel(Image::pointer volume) {
@@ -31,6 +31,8 @@ BinaryThresholding::BinaryThresholding() {
     createOutputPort<Segmentation>(0);
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/BinaryThresholding/BinaryThresholding3D.cl", "3D");
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/BinaryThresholding/BinaryThresholding2D.cl", "2D");
+    declareOpenCLProgramBuildOptions("2D");
+    declareOpenCLProgramBuildOptions("3D");
 
     createFloatAttribute("lower-threshold", "Lower threshold", "Lower intensity threshold", std::nanf(""));
     createFloatAttribute("upper-threshold", "Upper threshold", "Upper intensity threshold", std::nanf(""));
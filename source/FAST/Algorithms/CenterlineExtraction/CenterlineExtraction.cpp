@@ -14,6 +14,7 @@ CenterlineExtraction::CenterlineExtraction() {
 	createOutputPort<Mesh>(0);
 
 	createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/CenterlineExtraction/CenterlineExtraction.cl");
+	declareOpenCLProgramBuildOptions();
 }
 
 Image::pointer CenterlineExtraction::calculateDistanceTransform(Image::pointer input) {
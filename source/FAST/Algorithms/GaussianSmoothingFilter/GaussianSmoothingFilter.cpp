@@ -2,6 +2,9 @@
 #include "FAST/Exception.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Data/Image.hpp"
+#include <iomanip>
+#include <sstream>
+#include <type_traits>
 using namespace fast;
 
 void GaussianSmoothingFilter::setMaskSize(unsigned char maskSize) {
@@ -35,6 +38,7 @@ GaussianSmoothingFilter::GaussianSmoothingFilter() {
     createOutputPort<Image>(0);
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/GaussianSmoothingFilter/GaussianSmoothingFilter2D.cl", "2D");
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/GaussianSmoothingFilter/GaussianSmoothingFilter3D.cl", "3D");
+    createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/GaussianSmoothingFilter/GaussianSmoothingFilterSeparable.cl", "separable");
     mStdDev = 0.5f;
     mMaskSize = -1;
     mIsModified = true;
@@ -138,61 +142,193 @@ void GaussianSmoothingFilter::recompileOpenCLCode(Image::pointer input) {
     mTypeCLCodeCompiledFor = input->getDataType();
 }
 
+// The 2D and 3D gaussian masks are separable, thus a normalized 1D mask can be used in each direction
+static std::vector<float> createSeparableMask(int maskSize, float stdDev) {
+    const int halfSize = (maskSize - 1) / 2;
+    std::vector<float> mask(maskSize);
+    float sum = 0.0f;
+    for(int x = -halfSize; x <= halfSize; x++) {
+        mask[x + halfSize] = exp(-(float)(x*x)/(2.0f*stdDev*stdDev));
+        sum += mask[x + halfSize];
+    }
+    for(auto&& value : mask)
+        value /= sum;
+    return mask;
+}
+
+void GaussianSmoothingFilter::executeSeparable(Image::pointer input, Image::pointer output, uchar maskSize, OpenCLDevice::pointer device) {
+    const int dimensions = input->getDimensions();
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int depth = dimensions == 3 ? input->getDepth() : 1;
+
+    // Bake mask into the kernels, thus each mask gets its own program binary
+    std::stringstream maskValues;
+    maskValues << std::setprecision(9);
+    const auto mask = createSeparableMask(maskSize, mStdDev);
+    for(int i = 0; i < maskSize; ++i) {
+        if(i > 0)
+            maskValues << ",";
+        maskValues << mask[i] << "f";
+    }
+    const std::string buildOptions = "-DMASK_SIZE=" + std::to_string(maskSize) +
+            " -DMASK_VALUES=" + maskValues.str() +
+            " -DDIMENSIONS=" + std::to_string(dimensions);
+
+    // Global size is rounded up to a multiple of the work group size
+    auto roundUp = [](int size, int multiple) {
+        return ((size + multiple - 1) / multiple)*multiple;
+    };
+
+    // Intermediate results are kept as float to avoid rounding between passes
+    cl::Buffer buffers[2];
+    for(int i = 0; i < std::min(dimensions - 1, 2); ++i)
+        buffers[i] = cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, sizeof(float)*width*height*depth);
+
+    auto inputAccess = input->getOpenCLImageAccess(ACCESS_READ, device);
+    auto outputAccess = output->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+    auto queue = device->getCommandQueue();
+    for(int direction = 0; direction < dimensions; ++direction) {
+        const bool firstPass = direction == 0;
+        const bool lastPass = direction == dimensions - 1;
+        std::string passOptions = buildOptions + " -DDIRECTION=" + std::to_string(direction);
+        if(firstPass)
+            passOptions += " -DFIRST_PASS";
+        if(lastPass) {
+            passOptions += " -DOUTPUT_TYPE=" + getCTypeAsString(output->getDataType());
+            if(output->getDataType() != TYPE_FLOAT)
+                passOptions += " -DROUND_OUTPUT";
+        } else {
+            passOptions += " -DOUTPUT_TYPE=float";
+        }
+        cl::Kernel kernel(getOpenCLProgram(device, "separable", passOptions), "gaussianSmoothingPass");
+
+        if(firstPass) {
+            if(dimensions == 2) {
+                kernel.setArg(0, *inputAccess->get2DImage());
+            } else {
+                kernel.setArg(0, *inputAccess->get3DImage());
+            }
+        } else {
+            kernel.setArg(0, buffers[(direction - 1) % 2]);
+        }
+        if(lastPass) {
+            kernel.setArg(1, *outputAccess->get());
+        } else {
+            kernel.setArg(1, buffers[direction % 2]);
+        }
+        kernel.setArg(2, width);
+        kernel.setArg(3, height);
+        kernel.setArg(4, depth);
+
+        cl::NDRange globalSize, localSize;
+        if(dimensions == 2) {
+            globalSize = cl::NDRange(roundUp(width, 16), roundUp(height, 16));
+            localSize = cl::NDRange(16, 16);
+        } else if(direction < 2) {
+            globalSize = cl::NDRange(roundUp(width, 16), roundUp(height, 16), depth);
+            localSize = cl::NDRange(16, 16, 1);
+        } else {
+            globalSize = cl::NDRange(roundUp(width, 16), height, roundUp(depth, 16));
+            localSize = cl::NDRange(16, 1, 16);
+        }
+        queue.enqueueNDRangeKernel(kernel, cl::NullRange, globalSize, localSize);
+    }
+}
+
 template <class T>
-void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, const float* const mask, unsigned char maskSize) {
-    // TODO: this method currently only processes the first component
-    unsigned int nrOfComponents = input->getNrOfChannels();
-    ImageAccess::pointer inputAccess = input->getImageAccess(ACCESS_READ);
-    ImageAccess::pointer outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
-
-    T * inputData = (T*)inputAccess->get();
-    T * outputData = (T*)outputAccess->get();
-
-    const unsigned char halfSize = (maskSize-1)/2;
-    unsigned int width = input->getWidth();
-    unsigned int height = input->getHeight();
-    if(input->getDimensions() == 3) {
-        unsigned int depth = input->getDepth();
-        for(unsigned int z = 0; z < depth; z++) {
-        for(unsigned int y = 0; y < height; y++) {
-        for(unsigned int x = 0; x < width; x++) {
-
-            if(x < halfSize || x >= width-halfSize ||
-            y < halfSize || y >= height-halfSize ||
-            z < halfSize || z >= depth-halfSize) {
-                // on border only copy values
-                outputData[x*nrOfComponents+y*nrOfComponents*width+z*nrOfComponents*width*height] = inputData[x*nrOfComponents+y*nrOfComponents*width+z*nrOfComponents*width*height];
-                continue;
+static void loadChannel(const void* data, int channel, int nrOfChannels, std::size_t size, float* output) {
+    const T* input = (const T*)data;
+    for(std::size_t i = 0; i < size; ++i)
+        output[i] = (float)input[i*nrOfChannels + channel];
+}
+
+template <class T>
+static void storeChannel(const float* input, int channel, int nrOfChannels, std::size_t size, void* data) {
+    T* output = (T*)data;
+    // Round for integer types, as done by the OpenCL kernels
+    const bool round = !std::is_floating_point<T>::value;
+    for(std::size_t i = 0; i < size; ++i)
+        output[i*nrOfChannels + channel] = round ? (T)std::round(input[i]) : (T)input[i];
+}
+
+/**
+ * Convolve every row of a volume with a 1D mask in the x direction. Pixels outside are clamped to the edge.
+ */
+static void convolveX(const float* input, float* output, int width, int rows, const std::vector<float>& mask) {
+    const int halfSize = (mask.size() - 1) / 2;
+    parallelFor(rows, [&](int startRow, int endRow) {
+        std::vector<float> padded(width + 2*halfSize);
+        for(int row = startRow; row < endRow; ++row) {
+            const float* in = &input[(std::size_t)row*width];
+            for(int i = 0; i < halfSize; ++i) {
+                padded[i] = in[0];
+                padded[width + halfSize + i] = in[width - 1];
             }
+            std::copy(in, in + width, padded.begin() + halfSize);
+            Eigen::Map<Eigen::ArrayXf> out(&output[(std::size_t)row*width], width);
+            out.setZero();
+            for(int k = 0; k < mask.size(); ++k)
+                out += mask[k]*Eigen::Map<const Eigen::ArrayXf>(&padded[k], width);
+        }
+    });
+}
 
-            double sum = 0.0;
-            for(int c = -halfSize; c <= halfSize; c++) {
-            for(int b = -halfSize; b <= halfSize; b++) {
-            for(int a = -halfSize; a <= halfSize; a++) {
-                sum += mask[a+halfSize+(b+halfSize)*maskSize+(c+halfSize)*maskSize*maskSize]*
-                        inputData[(x+a)*nrOfComponents+(y+b)*nrOfComponents*width+(z+c)*nrOfComponents*width*height];
-            }}}
-            outputData[x*nrOfComponents+y*nrOfComponents*width+z*nrOfComponents*width*height] = (T)sum;
-        }}}
-    } else {
-        for(unsigned int y = halfSize; y < height-halfSize; y++) {
-        for(unsigned int x = halfSize; x < width-halfSize; x++) {
-
-            if(x < halfSize || x >= width-halfSize ||
-            y < halfSize || y >= height-halfSize) {
-                // on border only copy values
-                outputData[x*nrOfComponents+y*nrOfComponents*width] = inputData[x*nrOfComponents+y*nrOfComponents*width];
-                continue;
+/**
+ * Convolve a volume with a 1D mask in the y (stride = width) or z (stride = width*height) direction.
+ * Each output row is a weighted sum of entire input rows, which is vectorized.
+ */
+static void convolveStrided(const float* input, float* output, int width, int height, int depth, bool zDirection, const std::vector<float>& mask) {
+    const int halfSize = (mask.size() - 1) / 2;
+    const int size = zDirection ? depth : height;
+    parallelFor(height*depth, [&](int start, int end) {
+        for(int row = start; row < end; ++row) {
+            const int y = row % height;
+            const int z = row / height;
+            const int position = zDirection ? z : y;
+            Eigen::Map<Eigen::ArrayXf> out(&output[(std::size_t)row*width], width);
+            out.setZero();
+            for(int k = 0; k < mask.size(); ++k) {
+                const int neighbor = std::min(std::max(position + k - halfSize, 0), size - 1);
+                const std::size_t neighborRow = zDirection ? (std::size_t)neighbor*height + y : (std::size_t)z*height + neighbor;
+                out += mask[k]*Eigen::Map<const Eigen::ArrayXf>(&input[neighborRow*width], width);
             }
+        }
+    });
+}
 
-            double sum = 0.0;
-            for(int b = -halfSize; b <= halfSize; b++) {
-            for(int a = -halfSize; a <= halfSize; a++) {
-                sum += mask[a+halfSize+(b+halfSize)*maskSize]*
-                        inputData[(x+a)*nrOfComponents+(y+b)*nrOfComponents*width];
-            }}
-            outputData[x*nrOfComponents+y*nrOfComponents*width] = (T)sum;
-        }}
+/**
+ * Gaussian smoothing on the host with separable 1D passes, using all cores and SIMD instructions (through Eigen).
+ * Borders are clamped to the edge, as in the OpenCL kernels. All channels are smoothed.
+ */
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, const std::vector<float>& mask) {
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    const void* inputData = inputAccess->get();
+    void* outputData = outputAccess->get();
+
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int depth = input->getDimensions() == 3 ? input->getDepth() : 1;
+    const int nrOfChannels = input->getNrOfChannels();
+    const std::size_t size = (std::size_t)width*height*depth;
+    auto buffer1 = make_uninitialized_unique<float[]>(size);
+    auto buffer2 = make_uninitialized_unique<float[]>(size);
+
+    for(int channel = 0; channel < nrOfChannels; ++channel) {
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(loadChannel<FAST_TYPE>(inputData, channel, nrOfChannels, size, buffer1.get()));
+        }
+        convolveX(buffer1.get(), buffer2.get(), width, height*depth, mask);
+        convolveStrided(buffer2.get(), buffer1.get(), width, height, depth, false, mask);
+        float* result = buffer1.get();
+        if(depth > 1) {
+            convolveStrided(buffer1.get(), buffer2.get(), width, height, depth, true, mask);
+            result = buffer2.get();
+        }
+        switch(output->getDataType()) {
+            fastSwitchTypeMacro(storeChannel<FAST_TYPE>(result, channel, nrOfChannels, size, outputData));
+        }
     }
 }
 
@@ -220,13 +356,18 @@ void GaussianSmoothingFilter::execute() {
 
 
     if(device->isHost()) {
-        createMask(input, maskSize, false);
-        switch(input->getDataType()) {
-            fastSwitchTypeMacro(executeAlgorithmOnHost<FAST_TYPE>(input, output, mMask.get(), maskSize));
-        }
+        executeAlgorithmOnHost(input, output, createSeparableMask(maskSize, mStdDev));
     } else {
         OpenCLDevice::pointer clDevice = std::static_pointer_cast<OpenCLDevice>(device);
 
+        // The separable kernels need 16x16 work groups, and only smooth the first channel like the other kernels.
+        // For small 2D masks reading the full mask directly is as fast.
+        if(input->getNrOfChannels() == 1 && (input->getDimensions() == 3 || maskSize >= 5) &&
+                clDevice->getDevice().getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>() >= 256) {
+            executeSeparable(input, output, maskSize, clDevice);
+            return;
+        }
+
         recompileOpenCLCode(input);
 
         cl::NDRange globalSize;
@@ -20,6 +20,11 @@ class FAST_EXPORT  GaussianSmoothingFilter : public ProcessObject {
         void waitToFinish();
         void createMask(Image::pointer input, uchar maskSize, bool useSeperableFilter);
         void recompileOpenCLCode(Image::pointer input);
+        /**
+         * Smooth with one pass per dimension, where each pass loads a tile of the image into local memory.
+         * The 1D mask is compiled into the kernels.
+         */
+        void executeSeparable(Image::pointer input, Image::pointer output, uchar maskSize, OpenCLDevice::pointer device);
 
         char mMaskSize;
         float mStdDev;
@@ -0,0 +1,103 @@
+// One pass of separable gaussian smoothing along DIRECTION (0 = x, 1 = y, 2 = z).
+// The 1D mask is given at compile time by MASK_SIZE and MASK_VALUES.
+// The first pass reads the input image, the other passes read the float result of the previous pass.
+// The last pass writes OUTPUT_TYPE, rounded if ROUND_OUTPUT is defined, intermediate passes write float.
+__constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+__constant float mask[MASK_SIZE] = {MASK_VALUES};
+
+#define HALF_SIZE ((MASK_SIZE-1)/2)
+// Work group size along the smoothing direction and across it in x (or y when smoothing in x)
+#define GROUP_SIZE 16
+#define TILE_SIZE (GROUP_SIZE+2*HALF_SIZE)
+
+#if DIRECTION == 0
+#define COMPONENT x
+// Neighbors in the x direction are stored next to each other in local memory
+#define TILE(across, along) tile[(across)*TILE_SIZE + (along)]
+#elif DIRECTION == 1
+#define COMPONENT y
+// Work items next to each other in x access local memory next to each other
+#define TILE(across, along) tile[(along)*GROUP_SIZE + (across)]
+#else
+#define COMPONENT z
+#define TILE(across, along) tile[(along)*GROUP_SIZE + (across)]
+#endif
+
+#if DIMENSIONS == 2
+#define IMAGE_TYPE image2d_t
+#define IMAGE_POSITION(pos) (pos).xy
+#else
+#define IMAGE_TYPE image3d_t
+#define IMAGE_POSITION(pos) (pos)
+#endif
+
+#ifdef FIRST_PASS
+float readInput(__read_only IMAGE_TYPE input, int4 pos, int4 size) {
+    int dataType = get_image_channel_data_type(input);
+    if(dataType == CLK_FLOAT) {
+        return read_imagef(input, sampler, IMAGE_POSITION(pos)).x;
+    } else if(dataType == CLK_UNSIGNED_INT8 || dataType == CLK_UNSIGNED_INT16) {
+        return read_imageui(input, sampler, IMAGE_POSITION(pos)).x;
+    } else {
+        return read_imagei(input, sampler, IMAGE_POSITION(pos)).x;
+    }
+}
+#else
+float readInput(__global const float* input, int4 pos, int4 size) {
+    pos = clamp(pos, (int4)(0, 0, 0, 0), size - 1);
+    return input[pos.x + pos.y*size.x + pos.z*size.x*size.y];
+}
+#endif
+
+__kernel void gaussianSmoothingPass(
+#ifdef FIRST_PASS
+        __read_only IMAGE_TYPE input,
+#else
+        __global const float* input,
+#endif
+        __global OUTPUT_TYPE* output,
+        __private int width,
+        __private int height,
+        __private int depth
+        ) {
+
+    __local float tile[GROUP_SIZE*TILE_SIZE];
+    const int4 size = {width, height, depth, 1};
+    const int4 pos = {get_global_id(0), get_global_id(1), get_global_id(2), 0};
+
+    // Position of this work item in the work group, along and across the smoothing direction
+#if DIRECTION == 0
+    const int along = get_local_id(0);
+    const int across = get_local_id(1);
+#elif DIRECTION == 1
+    const int along = get_local_id(1);
+    const int across = get_local_id(0);
+#else
+    const int along = get_local_id(2);
+    const int across = get_local_id(0);
+#endif
+    const int start = (int)get_group_id(DIRECTION)*GROUP_SIZE - HALF_SIZE;
+
+    // Load the line of this work item, including the halo on both sides, into local memory.
+    // Work items outside the image also load, as their values are needed by the others.
+    for(int i = along; i < TILE_SIZE; i += GROUP_SIZE) {
+        int4 samplePos = pos;
+        samplePos.COMPONENT = start + i;
+        TILE(across, i) = readInput(input, samplePos, size);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if(pos.x >= width || pos.y >= height || pos.z >= depth)
+        return;
+
+    float sum = 0.0f;
+    for(int i = 0; i < MASK_SIZE; ++i)
+        sum += mask[i]*TILE(across, along + i);
+
+#ifdef ROUND_OUTPUT
+    output[pos.x + pos.y*width + pos.z*width*height] = round(sum);
+#else
+    output[pos.x + pos.y*width + pos.z*width*height] = sum;
+#endif
+}
@@ -24,6 +24,74 @@ TEST_CASE("Even input as mask size throws exception in GaussianSmoothingFilter",
     CHECK_THROWS(filter->setMaskSize(2));
 }
 
+TEST_CASE("GaussianSmoothingFilter on Host keeps constant image constant including borders", "[fast][GaussianSmoothingFilter]") {
+    auto image = Image::New();
+    image->create(37, 23, TYPE_UINT8, 2);
+    {
+        auto access = image->getImageAccess(ACCESS_READ_WRITE);
+        uint8_t* data = (uint8_t*)access->get();
+        for(int i = 0; i < 37*23; i++) {
+            data[i*2] = 100;
+            data[i*2 + 1] = 200;
+        }
+    }
+    auto filter = GaussianSmoothingFilter::New();
+    filter->setMainDevice(Host::getInstance());
+    filter->setMaskSize(7);
+    filter->setStandardDeviation(2.0);
+    filter->setInputData(image);
+    auto output = filter->updateAndGetOutputData<Image>();
+    CHECK(output->getDataType() == TYPE_UINT8);
+    CHECK(output->getNrOfChannels() == 2);
+
+    auto access = output->getImageAccess(ACCESS_READ);
+    uint8_t* data = (uint8_t*)access->get();
+    bool success = true;
+    for(int i = 0; i < 37*23; i++) {
+        if(data[i*2] != 100 || data[i*2 + 1] != 200)
+            success = false;
+    }
+    CHECK(success);
+}
+
+TEST_CASE("GaussianSmoothingFilter separable OpenCL kernels give same result as Host", "[fast][GaussianSmoothingFilter]") {
+    for(int dimensions = 2; dimensions <= 3; ++dimensions) {
+        const int width = 45, height = 38, depth = dimensions == 3 ? 21 : 1;
+        auto image = Image::New();
+        if(dimensions == 2) {
+            image->create(width, height, TYPE_FLOAT, 1);
+        } else {
+            image->create(width, height, depth, TYPE_FLOAT, 1);
+        }
+        {
+            auto access = image->getImageAccess(ACCESS_READ_WRITE);
+            float* data = (float*)access->get();
+            for(int i = 0; i < width*height*depth; i++)
+                data[i] = (float)((i*7919) % 255);
+        }
+
+        Image::pointer outputs[2];
+        for(int i = 0; i < 2; ++i) {
+            auto filter = GaussianSmoothingFilter::New();
+            if(i == 1)
+                filter->setMainDevice(Host::getInstance());
+            filter->setMaskSize(7);
+            filter->setStandardDeviation(1.5);
+            filter->setInputData(image);
+            outputs[i] = filter->updateAndGetOutputData<Image>();
+        }
+
+        auto accessCL = outputs[0]->getImageAccess(ACCESS_READ);
+        auto accessHost = outputs[1]->getImageAccess(ACCESS_READ);
+        float* dataCL = (float*)accessCL->get();
+        float* dataHost = (float*)accessHost->get();
+        float maxDifference = 0.0f;
+        for(int i = 0; i < width*height*depth; i++)
+            maxDifference = std::max(maxDifference, std::fabs(dataCL[i] - dataHost[i]));
+        CHECK(maxDifference < 0.01f);
+    }
+}
+
 /*
 TEST_CASE("Correct output with small 3x3 2D image as input to GaussianSmoothingFilter on OpenCLDevice", "[fast][GaussianSmoothingFilter]") {
     DeviceManager* deviceManager = DeviceManager::getInstance();
@@ -42,6 +42,7 @@ EulerGradientVectorFlow::EulerGradientVectorFlow() {
     createInputPort<Image>(0);
     createOutputPort<Image>(0);
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/GradientVectorFlow/EulerGradientVectorFlow.cl");
+    declareOpenCLProgramBuildOptions();
     mIterations = 0;
     mMu = 0.05f;
     mUse16bitFormat = true;
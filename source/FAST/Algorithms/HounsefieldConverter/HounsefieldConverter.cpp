@@ -7,6 +7,7 @@ HounsefieldConverter::HounsefieldConverter() {
     createInputPort<Image>(0);
     createOutputPort<Image>(0);
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/HounsefieldConverter/HounsefieldConverter.cl");
+    declareOpenCLProgramBuildOptions();
 }
 
 Image::pointer HounsefieldConverter::convertToHU(Image::pointer image) {
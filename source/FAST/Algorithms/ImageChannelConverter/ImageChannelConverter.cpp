@@ -72,6 +72,7 @@ ImageChannelConverter::ImageChannelConverter() {
     createOutputPort<Image>(0);
 
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/ImageChannelConverter/ImageChannelConverter.cl");
+    declareOpenCLProgramBuildOptions();
 
     for(int i = 0; i < 4; ++i)
         m_channelsToRemove[i] = false;
@@ -1,9 +1,27 @@
 #include <FAST/Data/ImagePyramid.hpp>
 #include <FAST/Data/Image.hpp>
 #include "PatchGenerator.hpp"
+#include <map>
+#include <condition_variable>
 
 namespace fast {
 
+// Frame data keys used by the PatchStitcher
+static const FrameData::Key keyOriginalWidth = FrameData::getKey("original-width");
+static const FrameData::Key keyOriginalHeight = FrameData::getKey("original-height");
+static const FrameData::Key keyOriginalDepth = FrameData::getKey("original-depth");
+static const FrameData::Key keyOriginalTransform = FrameData::getKey("original-transform");
+static const FrameData::Key keyPatchIdX = FrameData::getKey("patchid-x");
+static const FrameData::Key keyPatchIdY = FrameData::getKey("patchid-y");
+static const FrameData::Key keyPatchWidth = FrameData::getKey("patch-width");
+static const FrameData::Key keyPatchHeight = FrameData::getKey("patch-height");
+static const FrameData::Key keyPatchOffsetX = FrameData::getKey("patch-offset-x");
+static const FrameData::Key keyPatchOffsetY = FrameData::getKey("patch-offset-y");
+static const FrameData::Key keyPatchOffsetZ = FrameData::getKey("patch-offset-z");
+static const FrameData::Key keyPatchSpacingX = FrameData::getKey("patch-spacing-x");
+static const FrameData::Key keyPatchSpacingY = FrameData::getKey("patch-spacing-y");
+static const FrameData::Key keyPatchSpacingZ = FrameData::getKey("patch-spacing-z");
+
 PatchGenerator::PatchGenerator() {
     createInputPort<SpatialDataObject>(0); // Either ImagePyramid or Image/Volume
     createInputPort<Image>(1, false); // Optional mask
@@ -21,6 +39,8 @@ PatchGenerator::PatchGenerator() {
 
     createIntegerAttribute("patch-size", "Patch size", "", 0);
     createIntegerAttribute("patch-level", "Patch level", "Patch level used for image pyramid inputs", m_level);
+    createIntegerAttribute("reader-threads", "Reader threads", "Number of threads reading patches from image pyramid in parallel", m_readerThreads);
+    createStringAttribute("patch-order", "Patch order", "Order of patches from image pyramid: raster or hilbert", "raster");
 }
 
 void PatchGenerator::loadAttributes() {
@@ -34,12 +54,196 @@ void PatchGenerator::loadAttributes() {
     }
 
     setPatchLevel(getIntegerAttribute("patch-level"));
+    setNumberOfReaderThreads(getIntegerAttribute("reader-threads"));
+    const std::string order = getStringAttribute("patch-order");
+    if(order == "raster") {
+        setPatchOrder(PatchOrder::RASTER);
+    } else if(order == "hilbert") {
+        setPatchOrder(PatchOrder::HILBERT);
+    } else {
+        throw Exception("Unknown patch order " + order + " given to PatchGenerator. Expected raster or hilbert");
+    }
 }
 
 PatchGenerator::~PatchGenerator() {
     stop();
 }
 
+static uint64_t getHilbertIndex(uint64_t size, uint64_t x, uint64_t y) {
+    // Map x,y to distance along Hilbert curve covering a size x size grid, where size is a power of two
+    uint64_t index = 0;
+    for(uint64_t s = size / 2; s > 0; s /= 2) {
+        const uint64_t rx = (x & s) > 0 ? 1 : 0;
+        const uint64_t ry = (y & s) > 0 ? 1 : 0;
+        index += s * s * ((3 * rx) ^ ry);
+        // Rotate quadrant
+        if(ry == 0) {
+            if(rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+std::vector<Vector2i> PatchGenerator::getPatchList(int patchesX, int patchesY) {
+    std::vector<Vector2i> patches;
+    patches.reserve(patchesX*patchesY);
+    std::unique_ptr<ImageAccess> maskAccess;
+    if(m_inputMask)
+        maskAccess = m_inputMask->getImageAccess(ACCESS_READ);
+    for(int patchY = 0; patchY < patchesY; ++patchY) {
+        for(int patchX = 0; patchX < patchesX; ++patchX) {
+            if(maskAccess) {
+                // If a mask exist, check if this patch should be included or not
+                // Take center of patch
+                Vector2i position(
+                        round(m_inputMask->getWidth() * ((float) patchX / patchesX + 0.5f / patchesX)),
+                        round(m_inputMask->getHeight() * ((float) patchY / patchesY + 0.5f / patchesY))
+                );
+                float value = maskAccess->getScalar(position);
+                if(value != 1)
+                    continue;
+            }
+            patches.push_back(Vector2i(patchX, patchY));
+        }
+    }
+
+    if(m_patchOrder == PatchOrder::HILBERT) {
+        uint64_t size = 1;
+        while(size < (uint64_t)std::max(patchesX, patchesY))
+            size *= 2;
+        std::stable_sort(patches.begin(), patches.end(), [size](const Vector2i& a, const Vector2i& b) {
+            return getHilbertIndex(size, a.x(), a.y()) < getHilbertIndex(size, b.x(), b.y());
+        });
+    }
+
+    return patches;
+}
+
+Image::pointer PatchGenerator::createPatch(ImagePyramidAccess* access, int patchX, int patchY) {
+    const int levelWidth = m_inputImagePyramid->getLevelWidth(m_level);
+    const int levelHeight = m_inputImagePyramid->getLevelHeight(m_level);
+    const int patchesX = std::ceil((float) levelWidth / m_width);
+    const int patchesY = std::ceil((float) levelHeight / m_height);
+    int patchWidth = m_width;
+    if(patchX == patchesX - 1)
+        patchWidth = levelWidth - patchX * m_width - 1;
+    int patchHeight = m_height;
+    if(patchY == patchesY - 1)
+        patchHeight = levelHeight - patchY * m_height - 1;
+
+    reportInfo() << "Generating patch " << patchX << " " << patchY << reportEnd();
+    auto patch = access->getPatchAsImage(m_level, patchX * m_width, patchY * m_height, patchWidth, patchHeight);
+
+    // Store some frame data useful for patch stitching
+    auto& frameData = patch->getFrameData();
+    frameData.set(keyOriginalWidth, levelWidth);
+    frameData.set(keyOriginalHeight, levelHeight);
+    frameData.set(keyPatchIdX, patchX);
+    frameData.set(keyPatchIdY, patchY);
+    // Target width/height of patches
+    frameData.set(keyPatchWidth, m_width);
+    frameData.set(keyPatchHeight, m_height);
+    frameData.set(keyPatchSpacingX, patch->getSpacing().x());
+    frameData.set(keyPatchSpacingY, patch->getSpacing().y());
+
+    return patch;
+}
+
+bool PatchGenerator::outputPatch(Image::pointer patch, Image::pointer& previousPatch) {
+    try {
+        if(previousPatch) {
+            addOutputData(0, previousPatch);
+            frameAdded();
+        }
+    } catch(ThreadStopped &e) {
+        std::unique_lock<std::mutex> lock(m_stopMutex);
+        m_stop = true;
+        return false;
+    }
+    previousPatch = patch;
+    std::unique_lock<std::mutex> lock(m_stopMutex);
+    return !m_stop;
+}
+
+void PatchGenerator::generatePatchesInParallel(const std::vector<Vector2i>& patches, Image::pointer& previousPatch) {
+    // Reader threads take the next patch index, and store the patch until the stream thread outputs it in order.
+    // Readers never get more than m_prefetchSize patches ahead of the output.
+    std::mutex mutex;
+    std::condition_variable patchReady;
+    std::condition_variable patchOutput;
+    std::map<std::size_t, Image::pointer> readyPatches;
+    std::size_t nextPatch = 0;
+    std::size_t outputPatches = 0;
+    bool stopReaders = false;
+    std::exception_ptr error;
+    const std::size_t prefetchSize = std::max(m_prefetchSize, m_readerThreads);
+
+    auto reader = [&]() {
+        try {
+            auto access = m_inputImagePyramid->getAccess(ACCESS_READ);
+            access->openPrivateFileHandle();
+            while(true) {
+                std::size_t index;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    patchOutput.wait(lock, [&]() { return stopReaders || nextPatch < outputPatches + prefetchSize; });
+                    if(stopReaders || nextPatch >= patches.size())
+                        return;
+                    index = nextPatch;
+                    nextPatch++;
+                }
+                auto patch = createPatch(access.get(), patches[index].x(), patches[index].y());
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    readyPatches[index] = patch;
+                }
+                patchReady.notify_all();
+            }
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!error)
+                error = std::current_exception();
+            stopReaders = true;
+            patchReady.notify_all();
+            patchOutput.notify_all();
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for(int i = 0; i < std::min<std::size_t>(m_readerThreads, patches.size()); ++i)
+        readers.push_back(std::thread(reader));
+
+    for(std::size_t index = 0; index < patches.size(); ++index) {
+        Image::pointer patch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            patchReady.wait(lock, [&]() { return stopReaders || readyPatches.count(index) > 0; });
+            if(readyPatches.count(index) == 0)
+                break;
+            patch = readyPatches[index];
+            readyPatches.erase(index);
+            outputPatches = index + 1;
+        }
+        patchOutput.notify_all();
+        if(!outputPatch(patch, previousPatch))
+            break;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopReaders = true;
+    }
+    patchOutput.notify_all();
+    for(auto&& thread : readers)
+        thread.join();
+    if(error)
+        std::rethrow_exception(error);
+}
+
 void PatchGenerator::generateStream() {
     Image::pointer previousPatch;
 
@@ -48,93 +252,47 @@ void PatchGenerator::generateStream() {
         const int levelHeight = m_inputImagePyramid->getLevelHeight(m_level);
         const int patchesX = std::ceil((float) levelWidth / m_width);
         const int patchesY = std::ceil((float) levelHeight / m_height);
+        const auto patches = getPatchList(patchesX, patchesY);
 
-        for(int patchY = 0; patchY < patchesY; ++patchY) {
-            for(int patchX = 0; patchX < patchesX; ++patchX) {
+        if(m_readerThreads > 0) {
+            generatePatchesInParallel(patches, previousPatch);
+        } else {
+            auto access = m_inputImagePyramid->getAccess(ACCESS_READ);
+            for(auto&& patchId : patches) {
                 mRuntimeManager->startRegularTimer("create patch");
-                int patchWidth = m_width;
-                if(patchX == patchesX - 1)
-                    patchWidth = levelWidth - patchX * m_width - 1;
-                int patchHeight = m_height;
-                if(patchY == patchesY - 1)
-                    patchHeight = levelHeight - patchY * m_height - 1;
-
-                if(m_inputMask) {
-                    // If a mask exist, check if this patch should be included or not
-                    auto access = m_inputMask->getImageAccess(ACCESS_READ);
-                    // Take center of patch
-                    Vector2i position(
-                            round(m_inputMask->getWidth() * ((float) patchX / patchesX + 0.5f / patchesX)),
-                            round(m_inputMask->getHeight() * ((float) patchY / patchesY + 0.5f / patchesY))
-                    );
-                    float value = access->getScalar(position);
-                    if(value != 1)
-                        continue;
-                }
-                reportInfo() << "Generating patch " << patchX << " " << patchY << reportEnd();
-                auto access = m_inputImagePyramid->getAccess(ACCESS_READ);
-                auto patch = access->getPatchAsImage(m_level, patchX * m_width, patchY * m_height,
-                                                                  patchWidth,
-                                                                  patchHeight);
-
-                // Store some frame data useful for patch stitching
-                patch->setFrameData("original-width", std::to_string(levelWidth));
-                patch->setFrameData("original-height", std::to_string(levelHeight));
-                patch->setFrameData("patchid-x", std::to_string(patchX));
-                patch->setFrameData("patchid-y", std::to_string(patchY));
-                // Target width/height of patches
-                patch->setFrameData("patch-width", std::to_string(m_width));
-                patch->setFrameData("patch-height", std::to_string(m_height));
-                patch->setFrameData("patch-spacing-x", std::to_string(patch->getSpacing().x()));
-                patch->setFrameData("patch-spacing-y", std::to_string(patch->getSpacing().y()));
-
+                auto patch = createPatch(access.get(), patchId.x(), patchId.y());
                 mRuntimeManager->stopRegularTimer("create patch");
-                try {
-                    if(previousPatch) {
-                        addOutputData(0, previousPatch);
-                        frameAdded();
-                    }
-                } catch(ThreadStopped &e) {
-                    std::unique_lock<std::mutex> lock(m_stopMutex);
-                    m_stop = true;
-                    break;
-                }
-                previousPatch = patch;
-                std::unique_lock<std::mutex> lock(m_stopMutex);
-                if(m_stop)
+                if(!outputPatch(patch, previousPatch))
                     break;
             }
-            std::unique_lock<std::mutex> lock(m_stopMutex);
-            if(m_stop) {
-                //m_streamIsStarted = false;
-                m_firstFrameIsInserted = false;
-                break;
-            }
+        }
+        std::unique_lock<std::mutex> lock(m_stopMutex);
+        if(m_stop) {
+            //m_streamIsStarted = false;
+            m_firstFrameIsInserted = false;
         }
     } else if(m_inputVolume) {
         // TODO Support patching in x and y direction as well for volumes. For now, only depth
         const int width = m_inputVolume->getWidth();
         const int height = m_inputVolume->getHeight();
         const int depth = m_inputVolume->getDepth();
-        auto transformData = SceneGraph::getEigenAffineTransformationFromData(m_inputVolume).data();
-        std::string transformString;
-        for(int i = 0; i < 16; ++i)
-            transformString += std::to_string(transformData[i]) + " ";
+        const Affine3f transform = SceneGraph::getEigenAffineTransformationFromData(m_inputVolume);
 
         for(int z = 0; z < depth; z += m_depth) {
             mRuntimeManager->startRegularTimer("create patch");
             auto patch = m_inputVolume->crop(Vector3i(0, 0, z), Vector3i(width, height, m_depth), true);
-            patch->setFrameData("original-width", std::to_string(width));
-            patch->setFrameData("original-height", std::to_string(height));
-            patch->setFrameData("original-depth", std::to_string(depth));
-            patch->setFrameData("original-transform", transformString);
-            patch->setFrameData("patch-offset-x", std::to_string(0));
-            patch->setFrameData("patch-offset-y", std::to_string(0));
-            patch->setFrameData("patch-offset-z", std::to_string(z));
+            auto& frameData = patch->getFrameData();
+            frameData.set(keyOriginalWidth, width);
+            frameData.set(keyOriginalHeight, height);
+            frameData.set(keyOriginalDepth, depth);
+            frameData.set(keyOriginalTransform, transform);
+            frameData.set(keyPatchOffsetX, 0);
+            frameData.set(keyPatchOffsetY, 0);
+            frameData.set(keyPatchOffsetZ, z);
             Vector3f spacing = m_inputVolume->getSpacing();
-            patch->setFrameData("patch-spacing-x", std::to_string(spacing.x()));
-            patch->setFrameData("patch-spacing-y", std::to_string(spacing.y()));
-            patch->setFrameData("patch-spacing-z", std::to_string(spacing.z()));
+            frameData.set(keyPatchSpacingX, spacing.x());
+            frameData.set(keyPatchSpacingY, spacing.y());
+            frameData.set(keyPatchSpacingZ, spacing.z());
             try {
                 if(previousPatch) {
                     addOutputData(0, previousPatch);
@@ -155,6 +313,10 @@ void PatchGenerator::generateStream() {
     } else {
         throw Exception("Unsupported data object given to PatchGenerator");
     }
+    if(!previousPatch) {
+        reportWarning() << "PatchGenerator did not generate any patches" << reportEnd();
+        return;
+    }
     // Add final patch, and mark it has last frame
     previousPatch->setLastFrame(getNameOfClass());
     try {
@@ -194,4 +356,23 @@ void PatchGenerator::setPatchLevel(int level) {
     mIsModified = true;
 }
 
+void PatchGenerator::setNumberOfReaderThreads(int threads) {
+    if(threads < 0)
+        throw Exception("Number of reader threads can't be negative");
+    m_readerThreads = threads;
+    mIsModified = true;
+}
+
+void PatchGenerator::setPrefetchSize(int patches) {
+    if(patches <= 0)
+        throw Exception("Prefetch size must be larger than 0");
+    m_prefetchSize = patches;
+    mIsModified = true;
+}
+
+void PatchGenerator::setPatchOrder(PatchOrder order) {
+    m_patchOrder = order;
+    mIsModified = true;
+}
+
 }
\ No newline at end of file
@@ -7,17 +7,42 @@
 namespace fast {
 
 class ImagePyramid;
+class ImagePyramidAccess;
 class Image;
 
+/**
+ * Order in which patches of an image pyramid are generated
+ */
+enum class PatchOrder {
+    RASTER, // Row by row
+    HILBERT // Along a Hilbert curve, neighbouring patches are generated close in time
+};
+
 class FAST_EXPORT PatchGenerator : public Streamer {
     FAST_OBJECT(PatchGenerator)
     public:
         void setPatchSize(int width, int height, int depth = 1);
         void setPatchLevel(int level);
+        /**
+         * Set number of threads reading patches from an image pyramid in parallel.
+         * Each thread reads with its own file handle, and patches are read ahead of the consumer into a bounded queue.
+         * Patches are still output in the patch order. If 0 (default), patches are read on the stream thread.
+         * @param threads
+         */
+        void setNumberOfReaderThreads(int threads);
+        /**
+         * Set maximum number of patches read ahead of the consumer when using reader threads
+         * @param patches
+         */
+        void setPrefetchSize(int patches);
+        void setPatchOrder(PatchOrder order);
         ~PatchGenerator();
         void loadAttributes() override;
     protected:
         int m_width, m_height, m_depth;
+        int m_readerThreads = 0;
+        int m_prefetchSize = 16;
+        PatchOrder m_patchOrder = PatchOrder::RASTER;
 
         SharedPointer<ImagePyramid> m_inputImagePyramid;
         SharedPointer<Image> m_inputVolume;
@@ -28,5 +53,16 @@ class FAST_EXPORT PatchGenerator : public Streamer {
         void generateStream() override;
     private:
         PatchGenerator();
+        /**
+         * Get list of patches to generate in the patch order, skipping patches outside the mask
+         */
+        std::vector<Vector2i> getPatchList(int patchesX, int patchesY);
+        SharedPointer<Image> createPatch(ImagePyramidAccess* access, int patchX, int patchY);
+        /**
+         * Output previous patch, and store the given patch as previous. The last patch is output at end of stream.
+         * Returns false if the stream was stopped.
+         */
+        bool outputPatch(SharedPointer<Image> patch, SharedPointer<Image>& previousPatch);
+        void generatePatchesInParallel(const std::vector<Vector2i>& patches, SharedPointer<Image>& previousPatch);
 };
 }
\ No newline at end of file
@@ -6,12 +6,28 @@
 
 namespace fast {
 
+// Frame data keys set by the PatchGenerator
+static const FrameData::Key keyOriginalWidth = FrameData::getKey("original-width");
+static const FrameData::Key keyOriginalHeight = FrameData::getKey("original-height");
+static const FrameData::Key keyOriginalDepth = FrameData::getKey("original-depth");
+static const FrameData::Key keyOriginalTransform = FrameData::getKey("original-transform");
+static const FrameData::Key keyPatchIdX = FrameData::getKey("patchid-x");
+static const FrameData::Key keyPatchIdY = FrameData::getKey("patchid-y");
+static const FrameData::Key keyPatchWidth = FrameData::getKey("patch-width");
+static const FrameData::Key keyPatchHeight = FrameData::getKey("patch-height");
+static const FrameData::Key keyPatchOffsetZ = FrameData::getKey("patch-offset-z");
+static const FrameData::Key keyPatchSpacingX = FrameData::getKey("patch-spacing-x");
+static const FrameData::Key keyPatchSpacingY = FrameData::getKey("patch-spacing-y");
+static const FrameData::Key keyPatchSpacingZ = FrameData::getKey("patch-spacing-z");
+
 PatchStitcher::PatchStitcher() {
     createInputPort<DataObject>(0); // Can be Image, Batch or Tensor
     createOutputPort<DataObject>(0); // Can be Image or Tensor
 
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/ImagePatch/PatchStitcher2D.cl", "2D");
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/ImagePatch/PatchStitcher3D.cl", "3D");
+    declareOpenCLProgramBuildOptions("2D");
+    declareOpenCLProgramBuildOptions("3D");
 }
 
 void PatchStitcher::execute() {
@@ -53,22 +69,31 @@ void PatchStitcher::execute() {
 }
 
 void PatchStitcher::processTensor(SharedPointer<Tensor> patch) {
-    const int fullWidth = std::stoi(patch->getFrameData("original-width"));
-    const int fullHeight = std::stoi(patch->getFrameData("original-height"));
-
-    const int patchWidth = std::stoi(patch->getFrameData("patch-width"));
-    const int patchHeight = std::stoi(patch->getFrameData("patch-height"));
-
-    const float patchSpacingX = std::stof(patch->getFrameData("patch-spacing-x"));
-    const float patchSpacingY = std::stof(patch->getFrameData("patch-spacing-y"));
+    // A tensor with batch frame data contains one patch per sample in the first dimension
+    std::vector<FrameData> patchFrameData = patch->getBatchFrameData();
+    const bool isBatch = !patchFrameData.empty();
+    if(!isBatch)
+        patchFrameData.push_back(patch->getFrameData());
 
     auto shape = patch->getShape();
-    if(shape.getDimensions() != 1) {
+    if(shape.getDimensions() != (isBatch ? 2 : 1)) {
         throw Exception("Can only handle 1D tensors atm");
     }
-    const int channels = shape[0];
+    if(isBatch && shape[0] != patchFrameData.size())
+        throw Exception("The batch frame data of the tensor given to PatchStitcher must have one entry per sample");
+    const int channels = shape[shape.getDimensions() - 1];
 
     if(!m_outputTensor) {
+        const auto& frameData = patchFrameData.front();
+        const int fullWidth = frameData.getInt(keyOriginalWidth);
+        const int fullHeight = frameData.getInt(keyOriginalHeight);
+
+        const int patchWidth = frameData.getInt(keyPatchWidth);
+        const int patchHeight = frameData.getInt(keyPatchHeight);
+
+        const float patchSpacingX = frameData.getFloat(keyPatchSpacingX);
+        const float patchSpacingY = frameData.getFloat(keyPatchSpacingY);
+
         // Create output tensor
         m_outputTensor = Tensor::New();
         TensorShape fullShape({(int)std::ceil((float)fullHeight / patchHeight), (int)std::ceil((float)fullWidth / patchWidth), channels});
@@ -76,38 +101,36 @@ void PatchStitcher::processTensor(SharedPointer<Tensor> patch) {
         m_outputTensor->create(std::move(initializedData), fullShape);
         m_outputTensor->setSpacing(Vector3f(patchHeight*patchSpacingY, patchWidth*patchSpacingX, 1.0f));
     }
-    reportInfo() << "Stitching " << patch->getFrameData("patchid-x") << " " << patch->getFrameData("patchid-y") << reportEnd();
-    reportInfo() << "Stitching data" << patch->getFrameData("patch-spacing-x") << " " << patch->getFrameData("patch-spacing-y") << reportEnd();
-
-    const int startX = std::stoi(patch->getFrameData("patchid-x"));
-    const int startY = std::stoi(patch->getFrameData("patchid-y"));
 
     auto inputAccess = patch->getAccess(ACCESS_READ);
-    auto tensorData = inputAccess->getData<1>();
+    const float* tensorData = inputAccess->getRawData();
     auto outputAccess = m_outputTensor->getAccess(ACCESS_READ_WRITE);
     auto outputTensorData = outputAccess->getData<3>();
 
-    for(int i = 0; i < channels; ++i) {
-        outputTensorData(startY, startX, i) = tensorData(i); // TODO fix
+    for(int sample = 0; sample < patchFrameData.size(); ++sample) {
+        const int startX = patchFrameData[sample].getInt(keyPatchIdX);
+        const int startY = patchFrameData[sample].getInt(keyPatchIdY);
+        reportInfo() << "Stitching " << startX << " " << startY << reportEnd();
+        for(int i = 0; i < channels; ++i) {
+            outputTensorData(startY, startX, i) = tensorData[sample*channels + i];
+        }
     }
-    //outputTensorData(startY, startX, 1) = 1.0f; // TODO remove
 }
 
 void PatchStitcher::processImage(SharedPointer<Image> patch) {
-    const int fullWidth = std::stoi(patch->getFrameData("original-width"));
-    const int fullHeight = std::stoi(patch->getFrameData("original-height"));
-    const float patchSpacingX = std::stof(patch->getFrameData("patch-spacing-x"));
-    const float patchSpacingY = std::stof(patch->getFrameData("patch-spacing-y"));
+    const auto& frameData = patch->getFrameData();
+    const int fullWidth = frameData.getInt(keyOriginalWidth);
+    const int fullHeight = frameData.getInt(keyOriginalHeight);
+    const float patchSpacingX = frameData.getFloat(keyPatchSpacingX);
+    const float patchSpacingY = frameData.getFloat(keyPatchSpacingY);
 
     int fullDepth = 1;
     float patchSpacingZ = 1.0f;
-    bool is3D = true;
-    try {
-        fullDepth = std::stoi(patch->getFrameData("original-depth"));
-        patchSpacingZ = std::stof(patch->getFrameData("patch-spacing-z"));
-    } catch(Exception &e) {
-        // If exception: is a 2D image
-        is3D = false;
+    // Only 3D patches have a depth
+    const bool is3D = frameData.has(keyOriginalDepth);
+    if(is3D) {
+        fullDepth = frameData.getInt(keyOriginalDepth);
+        patchSpacingZ = frameData.getFloat(keyPatchSpacingZ);
     }
 
     if(!m_outputImage && !m_outputImagePyramid) {
@@ -132,32 +155,25 @@ void PatchStitcher::processImage(SharedPointer<Image> patch) {
             //m_outputImagePyramid->fill(0);
             //m_outputImagePyramid->setSpacing(Vector3f(patchSpacingX, patchSpacingY, patchSpacingZ));
         }
-        try {
-            auto transformData = split(patch->getFrameData("original-transform"));
+        if(frameData.has(keyOriginalTransform)) {
             auto T = AffineTransformation::New();
-            Affine3f transform;
-            for(int i = 0; i < 16; ++i)
-                transform.matrix()(i) = std::stof(transformData[i]);
-            T->setTransform(transform);
+            T->setTransform(frameData.getTransform(keyOriginalTransform));
             if(m_outputImage) {
                 m_outputImage->getSceneGraphNode()->setTransformation(T);
             } else {
                 m_outputImagePyramid->getSceneGraphNode()->setTransformation(T);
             }
-        } catch(Exception &e) {
-
         }
     }
 
     auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
 
     if(fullDepth == 1) {
-		const int startX = std::stoi(patch->getFrameData("patchid-x")) * std::stoi(patch->getFrameData("patch-width"));
-		const int startY = std::stoi(patch->getFrameData("patchid-y")) * std::stoi(patch->getFrameData("patch-height"));
+		const int startX = frameData.getInt(keyPatchIdX) * frameData.getInt(keyPatchWidth);
+		const int startY = frameData.getInt(keyPatchIdY) * frameData.getInt(keyPatchHeight);
 		const int endX = startX + patch->getWidth();
 		const int endY = startY + patch->getHeight();
-		reportInfo() << "Stitching " << patch->getFrameData("patchid-x") << " " << patch->getFrameData("patchid-y")
-			<< reportEnd();
+		reportInfo() << "Stitching " << startX << " " << startY << reportEnd();
         if(m_outputImage) {
             cl::Program program = getOpenCLProgram(device, "2D");
 
@@ -177,16 +193,22 @@ void PatchStitcher::processImage(SharedPointer<Image> patch) {
             );
         } else {
             enableRuntimeMeasurements();
-            // Image pyramid, do it on CPU TODO: optimize somehow?
+            // Image pyramid, write entire patch at once on CPU. Coarser levels are updated once per patch.
             auto outputAccess = m_outputImagePyramid->getAccess(ACCESS_READ_WRITE);
             auto patchAccess = patch->getImageAccess(ACCESS_READ);
             mRuntimeManager->startRegularTimer("copy patch");
-            const int maxY = std::min(endY, fullHeight);
-            const int maxX = std::min(endX, fullWidth);
-            for(int y = startY; y < maxY; ++y) {
-                for(int x = startX; x < maxX; ++x) {
-                    outputAccess->setScalarFast(x, y, 0, patchAccess->getScalarFast<uchar>(Vector2i(x - startX, y - startY)));
+            const int width = patch->getWidth();
+            const int height = patch->getHeight();
+            const int channels = patch->getNrOfChannels();
+            if(patch->getDataType() == TYPE_UINT8) {
+                outputAccess->setPatch(0, startX, startY, width, height, (const uint8_t*)patchAccess->get());
+            } else {
+                auto data = make_uninitialized_unique<uint8_t[]>((std::size_t)width*height*channels);
+                for(int i = 0; i < width*height; ++i) {
+                    for(int c = 0; c < channels; ++c)
+                        data[i*channels + c] = (uint8_t)patchAccess->getScalar(i, c);
                 }
+                outputAccess->setPatch(0, startX, startY, width, height, data.get());
             }
             mRuntimeManager->stopRegularTimer("copy patch");
             mRuntimeManager->getTiming("copy patch")->print();
@@ -195,7 +217,7 @@ void PatchStitcher::processImage(SharedPointer<Image> patch) {
         // 3D
         const int startX = 0;
         const int startY = 0;
-        const int startZ = std::stoi(patch->getFrameData("patch-offset-z"));
+        const int startZ = frameData.getInt(keyPatchOffsetZ);
         const int endX = startX + patch->getWidth();
         const int endY = startY + patch->getHeight();
         reportInfo() << "Stitching " << startZ << reportEnd();
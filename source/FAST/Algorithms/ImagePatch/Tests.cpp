@@ -112,4 +112,67 @@ TEST_CASE("Patch generator, sticher and image to batch generator for WSI", "[fas
         std::cout << "Got a batch" << std::endl;
     } while(!batch->isLastFrame());
     std::cout << "Done" << std::endl;
-}
\ No newline at end of file
+}
+
+TEST_CASE("Patch generator with parallel readers outputs every patch once", "[fast][wsi][PatchGenerator]") {
+    auto importer = WholeSlideImageImporter::New();
+    importer->setFilename(Config::getTestDataPath() + "/WSI/A05.svs");
+
+    auto generator = PatchGenerator::New();
+    generator->setPatchSize(512, 512);
+    generator->setPatchLevel(2);
+    generator->setNumberOfReaderThreads(4);
+    generator->setPatchOrder(PatchOrder::HILBERT);
+    generator->setInputConnection(importer->getOutputPort());
+    auto port = generator->getOutputPort();
+    generator->update();
+
+    const auto keyX = FrameData::getKey("patchid-x");
+    const auto keyY = FrameData::getKey("patchid-y");
+    std::set<std::pair<int, int>> patches;
+    Image::pointer patch;
+    do {
+        patch = port->getNextFrame<Image>();
+        auto id = std::make_pair(patch->getFrameData().getInt(keyX), patch->getFrameData().getInt(keyY));
+        CHECK(patches.count(id) == 0);
+        patches.insert(id);
+    } while(!patch->isLastFrame());
+    const int patchesX = std::ceil((float)patch->getFrameData().getInt(FrameData::getKey("original-width")) / 512);
+    const int patchesY = std::ceil((float)patch->getFrameData().getInt(FrameData::getKey("original-height")) / 512);
+    CHECK(patches.size() == patchesX*patchesY);
+}
+
+TEST_CASE("Patch stitcher stitches batch tensor with frame data per sample", "[fast][PatchStitcher][batch]") {
+    auto tensor = Tensor::New();
+    tensor->create(std::make_unique<float[]>(2*3), TensorShape({2, 3}));
+    {
+        auto access = tensor->getAccess(ACCESS_READ_WRITE);
+        float* data = access->getRawData();
+        for(int i = 0; i < 6; ++i)
+            data[i] = i;
+    }
+    std::vector<FrameData> batchFrameData(2);
+    for(int i = 0; i < 2; ++i) {
+        batchFrameData[i].set(FrameData::getKey("original-width"), 1024);
+        batchFrameData[i].set(FrameData::getKey("original-height"), 512);
+        batchFrameData[i].set(FrameData::getKey("patch-width"), 512);
+        batchFrameData[i].set(FrameData::getKey("patch-height"), 512);
+        batchFrameData[i].set(FrameData::getKey("patch-spacing-x"), 1.0f);
+        batchFrameData[i].set(FrameData::getKey("patch-spacing-y"), 1.0f);
+        batchFrameData[i].set(FrameData::getKey("patchid-x"), i);
+        batchFrameData[i].set(FrameData::getKey("patchid-y"), 0);
+    }
+    tensor->setBatchFrameData(batchFrameData);
+
+    auto stitcher = PatchStitcher::New();
+    stitcher->setInputData(tensor);
+    auto output = stitcher->updateAndGetOutputData<Tensor>();
+    CHECK(output->getShape()[0] == 1);
+    CHECK(output->getShape()[1] == 2);
+    auto access = output->getAccess(ACCESS_READ);
+    auto data = access->getData<3>();
+    for(int i = 0; i < 3; ++i) {
+        CHECK(data(0, 0, i) == i);
+        CHECK(data(0, 1, i) == 3 + i);
+    }
+}
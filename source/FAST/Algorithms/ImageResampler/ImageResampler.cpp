@@ -9,6 +9,7 @@ ImageResampler::ImageResampler() {
     createOutputPort<Image>(0);
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/ImageResampler/ImageResampler2D.cl", "2D");
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/ImageResampler/ImageResampler3D.cl", "3D");
+    declareOpenCLProgramBuildOptions("2D");
 
     mSpacing = Vector3f(-1, -1, -1);
     mInterpolationSet = false;
@@ -42,6 +42,7 @@ ImageResizer::ImageResizer() {
 	createOutputPort<Image>(0);
 
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/ImageResizer/ImageResizer.cl");
+    declareOpenCLProgramBuildOptions();
 
 	mSize = Vector3i::Zero();
     mPreserveAspectRatio = false;
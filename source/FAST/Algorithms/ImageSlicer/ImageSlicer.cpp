@@ -23,6 +23,7 @@ ImageSlicer::ImageSlicer() : mArbitrarySlicePlane(Plane(Vector3f(1,0,0))) {
 	createInputPort<Image>(0);
 	createOutputPort<Image>(0);
 	createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/ImageSlicer/ImageSlicer.cl");
+	declareOpenCLProgramBuildOptions();
 
 	mArbitrarySlicing = false;
 	mOrthogonalSlicing = false;
@@ -1,133 +1,269 @@
-#ifdef NO_3D_WRITE
-#define PHI_WRITE_TYPE __global float *
-#define WRITE_RESULT(storage, pos, value) storage[pos.x+pos.y*get_global_size(0)+pos.z*get_global_size(0)*get_global_size(1)] = value;
-#else
-#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable
-#define PHI_WRITE_TYPE __write_only image3d_t
-#define WRITE_RESULT(storage, pos, value) write_imagef(storage, pos, value)
-#endif
+// Narrow band level set. The volume is divided into blocks of BLOCK_SIZE^3 voxels, and only blocks containing
+// the narrow band (|phi| < BAND_WIDTH) and their neighbor blocks are updated. Phi is clamped to
+// [-BAND_WIDTH, BAND_WIDTH], thus outside the band the gradient, and the update, is zero.
+#define BLOCK_SIZE 8
+#define BLOCK_VOXELS (BLOCK_SIZE*BLOCK_SIZE*BLOCK_SIZE)
+#define BAND_WIDTH 3.0f
 
 __constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
 
-__kernel void updateLevelSetFunction(
-        __read_only image3d_t input,
-        __read_only image3d_t phi_read,
-        PHI_WRITE_TYPE phi_write,
-        __private float threshold,
-        __private float epsilon,
-        __private float alpha,
-        PHI_WRITE_TYPE speedStorage,
-        __private float deltaT
-) {
-    int x = get_global_id(0);
-    int y = get_global_id(1);
-    int z = get_global_id(2);
-    const int4 pos = {x,y,z,0};
-
-    // Calculate all first order derivatives
-    float3 D = {
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x+1,y,z,0)).x-read_imagef(phi_read,sampler,(int4)(x-1,y,z,0)).x),
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x,y+1,z,0)).x-read_imagef(phi_read,sampler,(int4)(x,y-1,z,0)).x),
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x,y,z+1,0)).x-read_imagef(phi_read,sampler,(int4)(x,y,z-1,0)).x)
-    };
-    float3 Dminus = {
-            read_imagef(phi_read,sampler,pos).x-read_imagef(phi_read,sampler,(int4)(x-1,y,z,0)).x,
-            read_imagef(phi_read,sampler,pos).x-read_imagef(phi_read,sampler,(int4)(x,y-1,z,0)).x,
-            read_imagef(phi_read,sampler,pos).x-read_imagef(phi_read,sampler,(int4)(x,y,z-1,0)).x
-    };
-    float3 Dplus = {
-            read_imagef(phi_read,sampler,(int4)(x+1,y,z,0)).x-read_imagef(phi_read,sampler,pos).x,
-            read_imagef(phi_read,sampler,(int4)(x,y+1,z,0)).x-read_imagef(phi_read,sampler,pos).x,
-            read_imagef(phi_read,sampler,(int4)(x,y,z+1,0)).x-read_imagef(phi_read,sampler,pos).x
-    };
-
-    // Calculate gradient
-    float3 gradientMin = {
-            sqrt(pow(min(Dplus.x, 0.0f), 2.0f) + pow(min(-Dminus.x, 0.0f), 2.0f)),
-            sqrt(pow(min(Dplus.y, 0.0f), 2.0f) + pow(min(-Dminus.y, 0.0f), 2.0f)),
-            sqrt(pow(min(Dplus.z, 0.0f), 2.0f) + pow(min(-Dminus.z, 0.0f), 2.0f))
-    };
-    float3 gradientMax = {
-            sqrt(pow(max(Dplus.x, 0.0f), 2.0f) + pow(max(-Dminus.x, 0.0f), 2.0f)),
-            sqrt(pow(max(Dplus.y, 0.0f), 2.0f) + pow(max(-Dminus.y, 0.0f), 2.0f)),
-            sqrt(pow(max(Dplus.z, 0.0f), 2.0f) + pow(max(-Dminus.z, 0.0f), 2.0f))
-    };
-
-    // Calculate all second order derivatives
-    float3 DxMinus = {
-            0.0f,
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x+1,y-1,z,0)).x-read_imagef(phi_read,sampler,(int4)(x-1,y-1,z,0)).x),
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x+1,y,z-1,0)).x-read_imagef(phi_read,sampler,(int4)(x-1,y,z-1,0)).x)
-    };
-    float3 DxPlus = {
-            0.0f,
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x+1,y+1,z,0)).x-read_imagef(phi_read,sampler,(int4)(x-1,y+1,z,0)).x),
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x+1,y,z+1,0)).x-read_imagef(phi_read,sampler,(int4)(x-1,y,z+1,0)).x)
-    };
-    float3 DyMinus = {
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x-1,y+1,z,0)).x-read_imagef(phi_read,sampler,(int4)(x-1,y-1,z,0)).x),
-            0.0f,
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x,y+1,z-1,0)).x-read_imagef(phi_read,sampler,(int4)(x,y-1,z-1,0)).x)
-    };
-    float3 DyPlus = {
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x+1,y+1,z,0)).x-read_imagef(phi_read,sampler,(int4)(x+1,y-1,z,0)).x),
-            0.0f,
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x,y+1,z+1,0)).x-read_imagef(phi_read,sampler,(int4)(x,y-1,z+1,0)).x)
-    };
-    float3 DzMinus = {
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x-1,y,z+1,0)).x-read_imagef(phi_read,sampler,(int4)(x-1,y,z-1,0)).x),
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x,y-1,z+1,0)).x-read_imagef(phi_read,sampler,(int4)(x,y-1,z-1,0)).x),
-            0.0f
-    };
-    float3 DzPlus = {
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x+1,y,z+1,0)).x-read_imagef(phi_read,sampler,(int4)(x+1,y,z-1,0)).x),
-            0.5f*(read_imagef(phi_read,sampler,(int4)(x,y+1,z+1,0)).x-read_imagef(phi_read,sampler,(int4)(x,y+1,z-1,0)).x),
-            0.0f
-    };
-
-    // Calculate curvature
-    float3 nMinus = {
-            Dminus.x / sqrt(FLT_EPSILON+Dminus.x*Dminus.x+pow(0.5f*(DyMinus.x+D.y),2.0f)+pow(0.5f*(DzMinus.x+D.z),2.0f)),
-            Dminus.y / sqrt(FLT_EPSILON+Dminus.y*Dminus.y+pow(0.5f*(DxMinus.y+D.x),2.0f)+pow(0.5f*(DzMinus.y+D.z),2.0f)),
-            Dminus.z / sqrt(FLT_EPSILON+Dminus.z*Dminus.z+pow(0.5f*(DxMinus.z+D.x),2.0f)+pow(0.5f*(DyMinus.z+D.y),2.0f))
-    };
-    float3 nPlus = {
-            Dplus.x / sqrt(FLT_EPSILON+Dplus.x*Dplus.x+pow(0.5f*(DyPlus.x+D.y),2.0f)+pow(0.5f*(DzPlus.x+D.z),2.0f)),
-            Dplus.y / sqrt(FLT_EPSILON+Dplus.y*Dplus.y+pow(0.5f*(DxPlus.y+D.x),2.0f)+pow(0.5f*(DzPlus.y+D.z),2.0f)),
-            Dplus.z / sqrt(FLT_EPSILON+Dplus.z*Dplus.z+pow(0.5f*(DxPlus.z+D.x),2.0f)+pow(0.5f*(DyPlus.z+D.y),2.0f))
-    };
-
-    float curvature = ((nPlus.x-nMinus.x)+(nPlus.y-nMinus.y)+(nPlus.z-nMinus.z))*0.5f;
-
-    // Calculate speed term
-    float speed = -(1.0f-alpha)*max(-epsilon, (epsilon-fabs(threshold-read_imagei(input,sampler,pos).x)))/epsilon + alpha*curvature;
-
-    // Determine gradient based on speed direction
-    float3 gradient;
-    if(speed < 0) {
-        gradient = gradientMin;
-    } else {
-        gradient = gradientMax;
-    }
-    if(length(gradient) > 1.0f)
-        gradient = normalize(gradient);
+uint getBlockIndex(int4 pos, int4 size) {
+    const int4 blocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    return pos.x/BLOCK_SIZE + (pos.y/BLOCK_SIZE + (pos.z/BLOCK_SIZE)*blocks.y)*blocks.x;
+}
 
-    // Stability CFL
-    // max(fabs(speed*gradient.length()))
-    WRITE_RESULT(speedStorage, pos, fabs(speed*length(gradient)));
+// Get voxel position of a work item, where each active block has BLOCK_VOXELS work items.
+// Returns false if outside the volume or the active blocks.
+bool getActiveVoxel(uint id, __global const uint* activeBlocks, uint activeBlockCount, int4 size, int4* pos) {
+    const uint blockNr = id / BLOCK_VOXELS;
+    if(blockNr >= activeBlockCount)
+        return false;
+    const uint block = activeBlocks[blockNr];
+    const int4 blocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const uint voxel = id % BLOCK_VOXELS;
+    *pos = (int4)(
+            (block % blocks.x)*BLOCK_SIZE + voxel % BLOCK_SIZE,
+            ((block / blocks.x) % blocks.y)*BLOCK_SIZE + (voxel / BLOCK_SIZE) % BLOCK_SIZE,
+            (block / (blocks.x*blocks.y))*BLOCK_SIZE + voxel / (BLOCK_SIZE*BLOCK_SIZE),
+            0
+    );
+    return pos->x < size.x && pos->y < size.y && pos->z < size.z;
+}
 
-    // Update the level set function phi
-    WRITE_RESULT(phi_write, pos, read_imagef(phi_read,sampler,pos).x + deltaT*speed*length(gradient));
+float readPhi(__global const float* phi, int x, int y, int z, int4 size) {
+    x = clamp(x, 0, size.x - 1);
+    y = clamp(y, 0, size.y - 1);
+    z = clamp(z, 0, size.z - 1);
+    return phi[x + (y + z*size.y)*size.x];
 }
 
 __kernel void initializeLevelSetFunction(
-        PHI_WRITE_TYPE phi,
+        __global float* phi,
+        __global float* phi2,
+        __global uchar* bandBlocks,
         __private int seedX,
         __private int seedY,
         __private int seedZ,
         __private float radius
 ) {
     const int4 pos = {get_global_id(0), get_global_id(1), get_global_id(2), 0};
+    const int4 size = {get_global_size(0), get_global_size(1), get_global_size(2), 1};
+    const uint index = pos.x + (pos.y + pos.z*size.y)*size.x;
+
+    const float value = clamp(distance((float3)(seedX,seedY,seedZ), convert_float3(pos.xyz)) - radius, -BAND_WIDTH, BAND_WIDTH);
+    phi[index] = value;
+    phi2[index] = value;
+    if(fabs(value) < BAND_WIDTH)
+        bandBlocks[getBlockIndex(pos, size)] = 1;
+}
+
+// Mark the blocks which contain part of the narrow band. The band can only be within the active blocks.
+__kernel void markBandBlocks(
+        __global const float* phi,
+        __global const uint* activeBlocks,
+        __private uint activeBlockCount,
+        __global uchar* bandBlocks,
+        __private int width,
+        __private int height,
+        __private int depth
+) {
+    const int4 size = {width, height, depth, 1};
+    int4 pos;
+    if(!getActiveVoxel(get_global_id(0), activeBlocks, activeBlockCount, size, &pos))
+        return;
+    if(fabs(phi[pos.x + (pos.y + pos.z*size.y)*size.x]) < BAND_WIDTH)
+        bandBlocks[getBlockIndex(pos, size)] = 1;
+}
+
+// Create list of blocks which contain the band or are next to a block containing the band.
+// counters[0] is the number of active blocks.
+__kernel void findActiveBlocks(
+        __global const uchar* bandBlocks,
+        __global uint* activeBlocks,
+        __global volatile uint* counters
+) {
+    const int4 block = {get_global_id(0), get_global_id(1), get_global_id(2), 0};
+    const int4 blocks = {get_global_size(0), get_global_size(1), get_global_size(2), 1};
+    for(int z = max(block.z - 1, 0); z <= min(block.z + 1, blocks.z - 1); ++z) {
+        for(int y = max(block.y - 1, 0); y <= min(block.y + 1, blocks.y - 1); ++y) {
+            for(int x = max(block.x - 1, 0); x <= min(block.x + 1, blocks.x - 1); ++x) {
+                if(bandBlocks[x + (y + z*blocks.y)*blocks.x] == 1) {
+                    activeBlocks[atomic_inc(&counters[0])] = block.x + (block.y + block.z*blocks.y)*blocks.x;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+// Copy the voxels of the active blocks, used to make both phi buffers equal before the active blocks change
+__kernel void copyActiveBlocks(
+        __global const float* source,
+        __global float* destination,
+        __global const uint* activeBlocks,
+        __private uint activeBlockCount,
+        __private int width,
+        __private int height,
+        __private int depth
+) {
+    const int4 size = {width, height, depth, 1};
+    int4 pos;
+    if(!getActiveVoxel(get_global_id(0), activeBlocks, activeBlockCount, size, &pos))
+        return;
+    const uint index = pos.x + (pos.y + pos.z*size.y)*size.x;
+    destination[index] = source[index];
+}
 
-    WRITE_RESULT(phi, pos, distance((float3)(seedX,seedY,seedZ), convert_float3(pos.xyz)) - radius);
-}
\ No newline at end of file
+// maxSpeed has 3 slots with the bits of the maximum speed as uint: the previous iteration (read to get deltaT),
+// this iteration (written) and the next iteration (cleared). counters[1] is the number of voxels which changed sign.
+// Must be run with a local size of 64.
+__kernel void updateLevelSetFunction(
+        __read_only image3d_t input,
+        __global const float* phi_read,
+        __global float* phi_write,
+        __global const uint* activeBlocks,
+        __private uint activeBlockCount,
+        __private float threshold,
+        __private float epsilon,
+        __private float alpha,
+        __global volatile uint* maxSpeed,
+        __private int iteration,
+        __global volatile uint* counters
+) {
+    __local float localMaxSpeed[64];
+    const int4 size = {get_image_width(input), get_image_height(input), get_image_depth(input), 1};
+    if(get_global_id(0) == 0)
+        maxSpeed[(iteration + 1) % 3] = 0;
+
+    float speedMagnitude = 0.0f;
+    int4 pos;
+    if(getActiveVoxel(get_global_id(0), activeBlocks, activeBlockCount, size, &pos)) {
+        const int x = pos.x;
+        const int y = pos.y;
+        const int z = pos.z;
+        #define PHI(dx, dy, dz) readPhi(phi_read, x+(dx), y+(dy), z+(dz), size)
+        const float phi = PHI(0,0,0);
+
+        // Calculate all first order derivatives
+        float3 D = {
+                0.5f*(PHI(1,0,0)-PHI(-1,0,0)),
+                0.5f*(PHI(0,1,0)-PHI(0,-1,0)),
+                0.5f*(PHI(0,0,1)-PHI(0,0,-1))
+        };
+        float3 Dminus = {
+                phi-PHI(-1,0,0),
+                phi-PHI(0,-1,0),
+                phi-PHI(0,0,-1)
+        };
+        float3 Dplus = {
+                PHI(1,0,0)-phi,
+                PHI(0,1,0)-phi,
+                PHI(0,0,1)-phi
+        };
+
+        // Calculate gradient
+        float3 gradientMin = {
+                sqrt(pow(min(Dplus.x, 0.0f), 2.0f) + pow(min(-Dminus.x, 0.0f), 2.0f)),
+                sqrt(pow(min(Dplus.y, 0.0f), 2.0f) + pow(min(-Dminus.y, 0.0f), 2.0f)),
+                sqrt(pow(min(Dplus.z, 0.0f), 2.0f) + pow(min(-Dminus.z, 0.0f), 2.0f))
+        };
+        float3 gradientMax = {
+                sqrt(pow(max(Dplus.x, 0.0f), 2.0f) + pow(max(-Dminus.x, 0.0f), 2.0f)),
+                sqrt(pow(max(Dplus.y, 0.0f), 2.0f) + pow(max(-Dminus.y, 0.0f), 2.0f)),
+                sqrt(pow(max(Dplus.z, 0.0f), 2.0f) + pow(max(-Dminus.z, 0.0f), 2.0f))
+        };
+
+        // Calculate all second order derivatives
+        float3 DxMinus = {
+                0.0f,
+                0.5f*(PHI(1,-1,0)-PHI(-1,-1,0)),
+                0.5f*(PHI(1,0,-1)-PHI(-1,0,-1))
+        };
+        float3 DxPlus = {
+                0.0f,
+                0.5f*(PHI(1,1,0)-PHI(-1,1,0)),
+                0.5f*(PHI(1,0,1)-PHI(-1,0,1))
+        };
+        float3 DyMinus = {
+                0.5f*(PHI(-1,1,0)-PHI(-1,-1,0)),
+                0.0f,
+                0.5f*(PHI(0,1,-1)-PHI(0,-1,-1))
+        };
+        float3 DyPlus = {
+                0.5f*(PHI(1,1,0)-PHI(1,-1,0)),
+                0.0f,
+                0.5f*(PHI(0,1,1)-PHI(0,-1,1))
+        };
+        float3 DzMinus = {
+                0.5f*(PHI(-1,0,1)-PHI(-1,0,-1)),
+                0.5f*(PHI(0,-1,1)-PHI(0,-1,-1)),
+                0.0f
+        };
+        float3 DzPlus = {
+                0.5f*(PHI(1,0,1)-PHI(1,0,-1)),
+                0.5f*(PHI(0,1,1)-PHI(0,1,-1)),
+                0.0f
+        };
+        #undef PHI
+
+        // Calculate curvature
+        float3 nMinus = {
+                Dminus.x / sqrt(FLT_EPSILON+Dminus.x*Dminus.x+pow(0.5f*(DyMinus.x+D.y),2.0f)+pow(0.5f*(DzMinus.x+D.z),2.0f)),
+                Dminus.y / sqrt(FLT_EPSILON+Dminus.y*Dminus.y+pow(0.5f*(DxMinus.y+D.x),2.0f)+pow(0.5f*(DzMinus.y+D.z),2.0f)),
+                Dminus.z / sqrt(FLT_EPSILON+Dminus.z*Dminus.z+pow(0.5f*(DxMinus.z+D.x),2.0f)+pow(0.5f*(DyMinus.z+D.y),2.0f))
+        };
+        float3 nPlus = {
+                Dplus.x / sqrt(FLT_EPSILON+Dplus.x*Dplus.x+pow(0.5f*(DyPlus.x+D.y),2.0f)+pow(0.5f*(DzPlus.x+D.z),2.0f)),
+                Dplus.y / sqrt(FLT_EPSILON+Dplus.y*Dplus.y+pow(0.5f*(DxPlus.y+D.x),2.0f)+pow(0.5f*(DzPlus.y+D.z),2.0f)),
+                Dplus.z / sqrt(FLT_EPSILON+Dplus.z*Dplus.z+pow(0.5f*(DxPlus.z+D.x),2.0f)+pow(0.5f*(DyPlus.z+D.y),2.0f))
+        };
+
+        float curvature = ((nPlus.x-nMinus.x)+(nPlus.y-nMinus.y)+(nPlus.z-nMinus.z))*0.5f;
+
+        // Calculate speed term
+        float intensity;
+        int dataType = get_image_channel_data_type(input);
+        if(dataType == CLK_FLOAT) {
+            intensity = read_imagef(input, sampler, pos).x;
+        } else if(dataType == CLK_UNSIGNED_INT8 || dataType == CLK_UNSIGNED_INT16) {
+            intensity = read_imageui(input, sampler, pos).x;
+        } else {
+            intensity = read_imagei(input, sampler, pos).x;
+        }
+        float speed = -(1.0f-alpha)*max(-epsilon, (epsilon-fabs(threshold-intensity)))/epsilon + alpha*curvature;
+
+        // Determine gradient based on speed direction
+        float3 gradient;
+        if(speed < 0) {
+            gradient = gradientMin;
+        } else {
+            gradient = gradientMax;
+        }
+        if(length(gradient) > 1.0f)
+            gradient = normalize(gradient);
+
+        // Stability CFL, deltaT is calculated from the maximum speed of the previous iteration
+        speedMagnitude = fabs(speed*length(gradient));
+        const float previousMaxSpeed = as_float(maxSpeed[(iteration + 2) % 3]);
+        const float deltaT = previousMaxSpeed > 0.0f ? 0.5f/previousMaxSpeed : 0.0f;
+
+        // Update the level set function phi
+        const float newPhi = clamp(phi + deltaT*speed*length(gradient), -BAND_WIDTH, BAND_WIDTH);
+        phi_write[pos.x + (pos.y + pos.z*size.y)*size.x] = newPhi;
+        if((phi < 0.0f) != (newPhi < 0.0f))
+            atomic_inc(&counters[1]);
+    }
+
+    // Maximum speed of the work group, then one atomic per work group.
+    // Non-negative floats have the same order as their bits interpreted as uint.
+    const uint localId = get_local_id(0);
+    localMaxSpeed[localId] = speedMagnitude;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for(uint stride = get_local_size(0) / 2; stride > 0; stride /= 2) {
+        if(localId < stride)
+            localMaxSpeed[localId] = max(localMaxSpeed[localId], localMaxSpeed[localId + stride]);
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    if(localId == 0)
+        atomic_max(&maxSpeed[iteration % 3], as_uint(localMaxSpeed[0]));
+}
@@ -8,11 +8,13 @@ LevelSetSegmentation::LevelSetSegmentation() {
     createInputPort<Image>(0);
     createOutputPort<Segmentation>(0);
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/LevelSet/LevelSetSegmentation.cl");
+    declareOpenCLProgramBuildOptions();
 
     mCurvatureWeight = 0.9;
     mIntensityMeanSet = false;
     mIntensityVarianceSet = false;
     mIterations = 1000;
+    mStopWhenConverged = false;
 }
 
 void LevelSetSegmentation::setCurvatureWeight(float weight) {
@@ -38,6 +40,10 @@ void LevelSetSegmentation::setMaxIterations(uint iterations) {
     mIterations = iterations;
 }
 
+void LevelSetSegmentation::setStopWhenConverged(bool stop) {
+    mStopWhenConverged = stop;
+}
+
 void LevelSetSegmentation::addSeedPoint(Vector3i position, float size) {
     mSeeds.push_back(std::make_pair(position, size));
     mIsModified = true;
@@ -52,32 +58,49 @@ void LevelSetSegmentation::execute() {
     if(input->getDimensions() != 3)
         throw Exception("Level set segmentation only supports 3D atm");
 
+    if(mSeeds.size() == 0)
+        throw Exception("The LevelSetSegmentation algorithm must be given a seed point");
 
     OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
     cl::CommandQueue queue = device->getCommandQueue();
     cl::Program program = getOpenCLProgram(device);
-
-    Image::pointer phi = Image::New();
-    phi->create(input->getSize(), TYPE_FLOAT, 1);
-
-    OpenCLImageAccess::pointer phiAccess = phi->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
-    cl::Image3D phi_1 = *phiAccess->get3DImage();
-
-    if(mSeeds.size() == 0)
-        throw Exception("The LevelSetSegmentation algorithm must be given a seed point");
+    cl::Context context = device->getContext();
 
     Vector3i seedPos = mSeeds[0].first;
     reportInfo() << "Using seed: " << seedPos.transpose() << reportEnd();
     float seedRadius = mSeeds[0].second;
     Vector3ui size = input->getSize();
+    const uint nrOfVoxels = size.x()*size.y()*size.z();
+    // Must match BLOCK_SIZE in the kernel
+    const int blockSize = 8;
+    const Vector3ui blocks = (size + Vector3ui::Constant(blockSize - 1)) / blockSize;
+    const uint nrOfBlocks = blocks.x()*blocks.y()*blocks.z();
+    // Number of iterations between each update of the active blocks and convergence check. The front moves at most
+    // half a voxel per iteration, thus it stays within the active blocks between updates.
+    const int activeBlocksUpdateInterval = 8;
+
+    cl::Buffer phiBuffers[2] = {
+            cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(float)*nrOfVoxels),
+            cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(float)*nrOfVoxels)
+    };
+    cl::Buffer bandBlocks(context, CL_MEM_READ_WRITE, nrOfBlocks);
+    cl::Buffer activeBlocks(context, CL_MEM_READ_WRITE, sizeof(uint)*nrOfBlocks);
+    // Number of active blocks and number of voxels which changed sign
+    cl::Buffer counters(context, CL_MEM_READ_WRITE, sizeof(uint)*2);
+    // Maximum speed of previous, current and next iteration. Initial delta t is 0.0001.
+    const float initialMaxSpeed[3] = {0.0f, 0.0f, 0.5f/0.0001f};
+    cl::Buffer maxSpeed(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(float)*3, (void*)initialMaxSpeed);
 
     // Create seed
+    queue.enqueueFillBuffer(bandBlocks, (uchar)0, 0, nrOfBlocks);
     cl::Kernel createSeedKernel(program, "initializeLevelSetFunction");
-    createSeedKernel.setArg(0, phi_1);
-    createSeedKernel.setArg(1, seedPos.x());
-    createSeedKernel.setArg(2, seedPos.y());
-    createSeedKernel.setArg(3, seedPos.z());
-    createSeedKernel.setArg(4, seedRadius);
+    createSeedKernel.setArg(0, phiBuffers[0]);
+    createSeedKernel.setArg(1, phiBuffers[1]);
+    createSeedKernel.setArg(2, bandBlocks);
+    createSeedKernel.setArg(3, seedPos.x());
+    createSeedKernel.setArg(4, seedPos.y());
+    createSeedKernel.setArg(5, seedPos.z());
+    createSeedKernel.setArg(6, seedRadius);
     queue.enqueueNDRangeKernel(
             createSeedKernel,
             cl::NullRange,
@@ -85,85 +108,90 @@ void LevelSetSegmentation::execute() {
             cl::NullRange
     );
 
+    OpenCLImageAccess::pointer access = input->getOpenCLImageAccess(ACCESS_READ, device);
     cl::Kernel kernel(program, "updateLevelSetFunction");
-    cl::size_t<3> origin = createOrigoRegion();
-    cl::size_t<3> region = createRegion(size);
-
-    Vector3f spacing = input->getSpacing();
-    const float minimumSpacing = std::min(std::min(spacing.x(), spacing.y()), spacing.z());
-
-    if(!device->isWritingTo3DTexturesSupported()) {
-        // Create auxillary buffer
-        cl::Buffer writeBuffer = cl::Buffer(
-                device->getContext(),
-                CL_MEM_WRITE_ONLY,
-                sizeof(float)*size.x()*size.y()*size.z()
-        );
-
-        /*
-        for(int i = 0; i < iterations; i++) {
-            updateLevelSetFunction(ocl, kernel, inputData, phi_1, writeBuffer, size, threshold, epsilon, alpha);
-            ocl.queue.enqueueCopyBufferToImage(
-                    writeBuffer,
-                    phi_1,
-                    0,
-                    origin,
-                    region
-            );
-        }
-         */
-    } else {
-        cl::Image3D phi_2 = cl::Image3D(
-                device->getContext(),
-                CL_MEM_READ_WRITE,
-                cl::ImageFormat(CL_R, CL_FLOAT),
-                input->getWidth(),
-                input->getHeight(),
-                input->getDepth()
-        );
-
-        Image::pointer speed = Image::New();
-        speed->create(input->getSize(), TYPE_FLOAT, 1);
-
-        OpenCLImageAccess::pointer access = input->getOpenCLImageAccess(ACCESS_READ, device);
-        kernel.setArg(0, *access->get3DImage());
-        kernel.setArg(3, mIntensityMean);
-        kernel.setArg(4, mIntensityVariance);
-        kernel.setArg(5, mCurvatureWeight);
-
-        float deltaT = 0.0001;
-        for(int i = 0; i < mIterations; i++) {
-            kernel.setArg(7, deltaT);
-            reportInfo() << "Iteration: " << i << " delta t: " << deltaT << reportEnd();
-            if(i % 2 == 0) {
-                kernel.setArg(1, phi_1);
-                kernel.setArg(2, phi_2);
-            } else {
-                kernel.setArg(1, phi_2);
-                kernel.setArg(2, phi_1);
+    kernel.setArg(0, *access->get3DImage());
+    kernel.setArg(3, activeBlocks);
+    kernel.setArg(5, mIntensityMean);
+    kernel.setArg(6, mIntensityVariance);
+    kernel.setArg(7, mCurvatureWeight);
+    kernel.setArg(8, maxSpeed);
+    kernel.setArg(10, counters);
+
+    cl::Kernel markKernel(program, "markBandBlocks");
+    markKernel.setArg(1, activeBlocks);
+    markKernel.setArg(3, bandBlocks);
+    markKernel.setArg(4, (int)size.x());
+    markKernel.setArg(5, (int)size.y());
+    markKernel.setArg(6, (int)size.z());
+    cl::Kernel copyKernel(program, "copyActiveBlocks");
+    copyKernel.setArg(2, activeBlocks);
+    copyKernel.setArg(4, (int)size.x());
+    copyKernel.setArg(5, (int)size.y());
+    copyKernel.setArg(6, (int)size.z());
+    cl::Kernel findActiveBlocksKernel(program, "findActiveBlocks");
+    findActiveBlocksKernel.setArg(0, bandBlocks);
+    findActiveBlocksKernel.setArg(1, activeBlocks);
+    findActiveBlocksKernel.setArg(2, counters);
+
+    int current = 0; // Index of the phi buffer with the latest result
+    uint activeBlockCount = 0;
+    int iteration = 0;
+    while(iteration < mIterations) {
+        if(iteration % activeBlocksUpdateInterval == 0) {
+            if(iteration > 0) {
+                // Voxels of the blocks which become inactive must have the same value in both buffers
+                const cl::NDRange activeVoxels(activeBlockCount*blockSize*blockSize*blockSize);
+                copyKernel.setArg(0, phiBuffers[current]);
+                copyKernel.setArg(1, phiBuffers[1 - current]);
+                copyKernel.setArg(3, activeBlockCount);
+                queue.enqueueNDRangeKernel(copyKernel, cl::NullRange, activeVoxels, cl::NullRange);
+
+                queue.enqueueFillBuffer(bandBlocks, (uchar)0, 0, nrOfBlocks);
+                markKernel.setArg(0, phiBuffers[current]);
+                markKernel.setArg(2, activeBlockCount);
+                queue.enqueueNDRangeKernel(markKernel, cl::NullRange, activeVoxels, cl::NullRange);
             }
-            {
-                OpenCLImageAccess::pointer speedAccess = speed->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
-                kernel.setArg(6, *speedAccess->get3DImage());
-                queue.enqueueNDRangeKernel(
-                        kernel,
-                        cl::NullRange,
-                        cl::NDRange(size.x(), size.y(), size.z()),
-                        cl::NullRange
-                );
-                queue.finish();
+            queue.enqueueFillBuffer(counters, (uint)0, 0, sizeof(uint));
+            queue.enqueueNDRangeKernel(
+                    findActiveBlocksKernel,
+                    cl::NullRange,
+                    cl::NDRange(blocks.x(), blocks.y(), blocks.z()),
+                    cl::NullRange
+            );
+            // The only host synchronization
+            uint counterValues[2];
+            queue.enqueueReadBuffer(counters, CL_TRUE, 0, sizeof(uint)*2, counterValues);
+            activeBlockCount = counterValues[0];
+            reportInfo() << "Iteration: " << iteration << " active blocks: " << activeBlockCount << " changed voxels: " << counterValues[1] << reportEnd();
+            if(activeBlockCount == 0 || (mStopWhenConverged && iteration > 0 && counterValues[1] == 0)) {
+                reportInfo() << "Level set converged after " << iteration << " iterations" << reportEnd();
+                break;
             }
-
-            // Calculate max speed and deltaT for next round
-            deltaT = 0.5/speed->calculateMaximumIntensity();
-        }
-        if(mIterations % 2 != 0) {
-            // Phi_2 was written to in the last iteration, copy this to the result
-            queue.enqueueCopyImage(phi_2,phi_1,origin,origin,region);
+            queue.enqueueFillBuffer(counters, (uint)0, sizeof(uint), sizeof(uint));
         }
+
+        kernel.setArg(1, phiBuffers[current]);
+        kernel.setArg(2, phiBuffers[1 - current]);
+        kernel.setArg(4, activeBlockCount);
+        kernel.setArg(9, iteration);
+        queue.enqueueNDRangeKernel(
+                kernel,
+                cl::NullRange,
+                cl::NDRange(activeBlockCount*blockSize*blockSize*blockSize),
+                cl::NDRange(64)
+        );
+        current = 1 - current;
+        ++iteration;
     }
+    access->release();
 
-    phiAccess->release();
+    Image::pointer phi = Image::New();
+    phi->create(input->getSize(), TYPE_FLOAT, 1);
+    {
+        OpenCLBufferAccess::pointer phiAccess = phi->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+        queue.enqueueCopyBuffer(phiBuffers[current], *phiAccess->get(), 0, 0, sizeof(float)*nrOfVoxels);
+    }
 
     // Create segmentation from level set function
     BinaryThresholding::pointer thresholding = BinaryThresholding::New();
@@ -5,6 +5,16 @@
 
 namespace fast {
 
+/**
+ * Level set segmentation of 3D images, with a speed function based on intensity and curvature.
+ *
+ * Only a narrow band around the zero level is updated. The volume is divided into blocks of 8x8x8 voxels, and
+ * the list of blocks containing the band and their neighbors is kept on the device. The active blocks, and
+ * whether the segmentation has converged, are only checked every 8 iterations, and the time step is calculated
+ * from the maximum speed on the device, thus the host only synchronizes with the device at these checks.
+ * The segmentation has converged when no voxel changed sign since the previous check. Stopping at convergence
+ * is off by default, see setStopWhenConverged.
+ */
 class FAST_EXPORT  LevelSetSegmentation : public ProcessObject {
     FAST_OBJECT(LevelSetSegmentation)
     public:
@@ -13,6 +23,13 @@ class FAST_EXPORT  LevelSetSegmentation : public ProcessObject {
         void setIntensityMean(float intensity);
         void setIntensityVariance(float variation);
         void setMaxIterations(uint iterations);
+        /**
+         * Stop before the max number of iterations if no voxel changed sign during the last 8 iterations.
+         * A slow front may move less than one voxel in 8 iterations, thus this may stop the front too early.
+         * Default is false.
+         * @param stop
+         */
+        void setStopWhenConverged(bool stop);
     private:
         LevelSetSegmentation();
         void execute();
@@ -23,6 +40,7 @@ class FAST_EXPORT  LevelSetSegmentation : public ProcessObject {
         bool mIntensityMeanSet;
         bool mIntensityVarianceSet;
         int mIterations;
+        bool mStopWhenConverged;
 
 };
 
@@ -1,6 +1,7 @@
 #include "FAST/Testing.hpp"
 #include "LevelSetSegmentation.hpp"
 #include "FAST/Importers/ImageFileImporter.hpp"
+#include "FAST/Data/Segmentation.hpp"
 #include "FAST/Algorithms/SurfaceExtraction/SurfaceExtraction.hpp"
 #include "FAST/Visualization/TriangleRenderer/TriangleRenderer.hpp"
 #include "FAST/Visualization/SegmentationRenderer/SegmentationRenderer.hpp"
@@ -45,3 +46,61 @@ TEST_CASE("Level set segmentation", "[fast][levelset][visual]") {
     window->start();
 }
     */
+
+TEST_CASE("Level set segmentation of a sphere", "[fast][levelset]") {
+    // Bright sphere in a dark volume
+    const int size = 64;
+    const Vector3f center(32, 32, 32);
+    const float radius = 15;
+    std::vector<float> data(size*size*size);
+    int sphereVoxels = 0;
+    for(int z = 0; z < size; ++z) {
+        for(int y = 0; y < size; ++y) {
+            for(int x = 0; x < size; ++x) {
+                const bool inside = (Vector3f(x, y, z) - center).norm() <= radius;
+                data[x + (y + z*size)*size] = inside ? 100.0f : 0.0f;
+                if(inside)
+                    ++sphereVoxels;
+            }
+        }
+    }
+    auto image = Image::New();
+    image->create(size, size, size, TYPE_FLOAT, 1, data.data());
+
+    for(bool stopWhenConverged : {false, true}) {
+        auto segmentation = LevelSetSegmentation::New();
+        segmentation->setIntensityMean(100);
+        segmentation->setIntensityVariance(20);
+        segmentation->setCurvatureWeight(0.5);
+        segmentation->setMaxIterations(300);
+        segmentation->setStopWhenConverged(stopWhenConverged);
+        segmentation->addSeedPoint(center.cast<int>(), 5);
+        segmentation->setInputData(image);
+        auto result = segmentation->updateAndGetOutputData<Segmentation>();
+        REQUIRE(result->getWidth() == size);
+        REQUIRE(result->getHeight() == size);
+        REQUIRE(result->getDepth() == size);
+
+        auto access = result->getImageAccess(ACCESS_READ);
+        const uchar* labels = (const uchar*)access->get();
+        int voxels = 0;
+        Vector3i minimum = Vector3i::Constant(size);
+        Vector3i maximum = Vector3i::Constant(-1);
+        for(int z = 0; z < size; ++z) {
+            for(int y = 0; y < size; ++y) {
+                for(int x = 0; x < size; ++x) {
+                    if(labels[x + (y + z*size)*size] == 0)
+                        continue;
+                    ++voxels;
+                    minimum = minimum.cwiseMin(Vector3i(x, y, z));
+                    maximum = maximum.cwiseMax(Vector3i(x, y, z));
+                }
+            }
+        }
+        CHECK(voxels == Approx(sphereVoxels).epsilon(0.1));
+        for(int i = 0; i < 3; ++i) {
+            CHECK(minimum[i] == Approx(center[i] - radius).margin(1));
+            CHECK(maximum[i] == Approx(center[i] + radius).margin(1));
+        }
+    }
+}
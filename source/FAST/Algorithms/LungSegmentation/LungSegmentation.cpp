@@ -19,6 +19,7 @@ LungSegmentation::LungSegmentation() {
     createOutputPort<Image>(1);
 
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/LungSegmentation/LungSegmentation.cl");
+    declareOpenCLProgramBuildOptions();
 }
 
 DataChannel::pointer LungSegmentation::getBloodVesselOutputPort() {
@@ -10,6 +10,7 @@ MeshToSegmentation::MeshToSegmentation() {
 	createInputPort<Image>(1, false);
 	createOutputPort<Segmentation>(0);
 	createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/MeshToSegmentation/MeshToSegmentation.cl");
+	declareOpenCLProgramBuildOptions();
 
 	mResolution = Vector3i::Zero();
 }
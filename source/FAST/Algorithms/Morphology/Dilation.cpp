@@ -7,6 +7,7 @@ Dilation::Dilation() {
     createInputPort<Image>(0);
     createOutputPort<Image>(0);
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/Morphology/Dilation.cl");
+    declareOpenCLProgramBuildOptions();
     mSize = 3;
 }
 
@@ -7,6 +7,7 @@ Erosion::Erosion() {
     createInputPort<Image>(0);
     createOutputPort<Image>(0);
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/Morphology/Erosion.cl");
+    declareOpenCLProgramBuildOptions();
     mSize = 3;
 }
 
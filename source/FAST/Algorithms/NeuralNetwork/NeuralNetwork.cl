@@ -12,7 +12,8 @@ __kernel void normalize2DInput(
 	__private float minIntensity,
 	__private float maxIntensity,
 	__private int clipIntensity,
-	__private int channelFirst
+	__private int channelFirst,
+	__private int outputOffset
 	) {
 	
 	const int2 pos = {get_global_id(0), get_global_id(1)};
@@ -42,6 +43,7 @@ __kernel void normalize2DInput(
 	}
 	const int width = get_global_size(0);
 	const int height = get_global_size(1);
+    output += outputOffset;
     if(channelFirst == 0) {
         int position = (pos.x + pos.y*width)*channels;
         output[position] = value.x;
@@ -75,7 +77,8 @@ __kernel void normalize3DInput(
 	__private float minIntensity,
 	__private float maxIntensity,
 	__private int clipIntensity,
-	__private int channelFirst
+	__private int channelFirst,
+	__private int outputOffset
 	) {
 
 	const int4 pos = {get_global_id(0), get_global_id(1), get_global_id(2), 0};
@@ -100,6 +103,7 @@ __kernel void normalize3DInput(
     const int width = get_global_size(0);
 	const int height = get_global_size(1);
 	const int depth = get_global_size(2);
+    output += outputOffset;
     if(channelFirst == 0) {
         int position = (pos.x + pos.y*width + pos.z*width*height)*channels;
         output[position] = value.x;
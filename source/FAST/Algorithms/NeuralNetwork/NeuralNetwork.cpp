@@ -3,6 +3,7 @@
 #include "FAST/Data/Tensor.hpp"
 #include "FAST/Algorithms/ImageResizer/ImageResizer.hpp"
 #include "InferenceEngineManager.hpp"
+#include <functional>
 
 
 namespace fast {
@@ -35,6 +36,7 @@ void NeuralNetwork::loadAttributes() {
     setScaleFactor(getFloatAttribute("scale-factor"));
     setSignedInputNormalization(getBooleanAttribute("signed-input-normalization"));
     setPreserveAspectRatio(getBooleanAttribute("preserve-aspect"));
+    setBatchOutputAsTensor(getBooleanAttribute("batch-output-as-tensor"));
 }
 
 NeuralNetwork::NeuralNetwork() {
@@ -43,6 +45,7 @@ NeuralNetwork::NeuralNetwork() {
 	mMean = 0.0;
 	mStd = 1.0f;
 	createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/NeuralNetwork/NeuralNetwork.cl");
+	declareOpenCLProgramBuildOptions();
     
 	createStringAttribute("model", "Model path", "Path to the neural network model", "");
     createStringAttribute("inference-engine", "Inference Engine", "Manually set the inference engine to be used to execute this neural network.", "");
@@ -50,6 +53,7 @@ NeuralNetwork::NeuralNetwork() {
 	createStringAttribute("output-names", "Output names", "Name of output nodes", "");
 	createBooleanAttribute("signed-input-normalization", "Signed input normalization", "Normalize input to -1 and 1 instead of 0 to 1.", false);
     createBooleanAttribute("preserve-aspect", "Preserve aspect ratio of input images", "", mPreserveAspectRatio);
+    createBooleanAttribute("batch-output-as-tensor", "Batch output as tensor", "Output a batch as a single tensor instead of a batch of tensors", m_batchOutputAsTensor);
 
 	m_engine = InferenceEngineManager::loadBestAvailableEngine();
 	reportInfo() << "Inference engine " << m_engine->getName() << " selected" << reportEnd();
@@ -222,7 +226,23 @@ void NeuralNetwork::execute() {
         // TODO and any frame data (such as patch info should be transferred)
         auto tensor = m_engine->getOutputData(node.first);
 
-        if(m_batchSize > 1) {
+        if(m_batchSize > 1 && m_batchOutputAsTensor) {
+            // Keep the batch as one tensor, and store frame data of each input image per sample
+            // Only input images have frame data, such as patch positions
+            std::vector<FrameData> batchFrameData(m_batchSize);
+            for(auto& inputNode : m_engine->getInputNodes()) {
+                auto images = mInputImages.find(inputNode.first);
+                if(images == mInputImages.end() || images->second.size() != m_batchSize)
+                    continue;
+                for(int i = 0; i < m_batchSize; ++i) {
+                    batchFrameData[i].merge(images->second[i]->getFrameData());
+                    for(auto &&lastFrame : images->second[i]->getLastFrame())
+                        tensor->setLastFrame(lastFrame);
+                }
+            }
+            tensor->setBatchFrameData(std::move(batchFrameData));
+            addOutputData(node.second.portID, tensor);
+        } else if(m_batchSize > 1) {
             // Create a batch of tensors
             std::vector<Tensor::pointer> tensorList;
             auto tensorAccess = tensor->getAccess(ACCESS_READ);
@@ -244,9 +264,7 @@ void NeuralNetwork::execute() {
                 tensorList.push_back(newTensor);
                 for(auto& inputNode : m_engine->getInputNodes()) {
                     // TODO assuming input are images here:
-                    for(auto &&frameData : mInputImages[inputNode.first][i]->getFrameData()) {
-                        newTensor->setFrameData(frameData.first, frameData.second);
-                    }
+                    newTensor->setFrameData(mInputImages[inputNode.first][i]->getFrameData());
                     for(auto &&lastFrame : mInputImages[inputNode.first][i]->getLastFrame())
                         newTensor->setLastFrame(lastFrame);
                 }
@@ -259,9 +277,7 @@ void NeuralNetwork::execute() {
             tensor->deleteDimension(0);
             for(auto& inputNode : m_engine->getInputNodes()) {
                 // TODO assuming input are images here: Should also be able to handle tensors
-                for(auto &&frameData : mInputImages[inputNode.first][0]->getFrameData()) {
-                    tensor->setFrameData(frameData.first, frameData.second);
-                }
+                tensor->setFrameData(mInputImages[inputNode.first][0]->getFrameData());
                 for(auto &&lastFrame : mInputImages[inputNode.first][0]->getLastFrame())
                     tensor->setLastFrame(lastFrame);
             }
@@ -275,9 +291,6 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
     if(shape.getUnknownDimensions() > 0)
         throw Exception("Shape must be known at this time");
 
-    // Create input tensor
-    auto values = make_uninitialized_unique<float[]>(shape.getTotalSize());
-
     OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
     cl::Program program = getOpenCLProgram(device);
     int depth = 1;
@@ -329,23 +342,31 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
         if(image->getNrOfChannels() != channels)
             throw Exception("Input image sent to executeNetwork has incorrect nr of channels: " +
                     std::to_string(image->getNrOfChannels())+ ". Expected: " + std::to_string(channels) + ".");
+    }
+    // All images are normalized into one buffer, which is read back once for the entire batch
+    auto memoryPool = device->getMemoryPool();
+    // The buffer is returned to the pool when leaving this function, also if enqueueing the kernels or the read throws
+    std::unique_ptr<cl::Buffer, std::function<void(cl::Buffer*)>> buffer(
+            memoryPool->leaseBuffer(CL_MEM_WRITE_ONLY, sizeof(float) * size * images.size()),
+            [memoryPool](cl::Buffer* buffer) { memoryPool->returnBuffer(buffer); }
+    );
+    kernel.setArg(1, *buffer);
+    kernel.setArg(2, mScaleFactor);
+    kernel.setArg(3, mMean);
+    kernel.setArg(4, mStd);
+    kernel.setArg(5, (int) (mSignedInputNormalization ? 1 : 0));
+    kernel.setArg(6, (int) (mHorizontalImageFlipping ? 1 : 0));
+    kernel.setArg(7, channels);
+    kernel.setArg(8, mMinIntensity);
+    kernel.setArg(9, mMaxIntensity);
+    kernel.setArg(10, (int)(mMinAndMaxIntensitySet ? 1 : 0));
+    kernel.setArg(11, (int)(m_engine->getPreferredImageOrdering() == ImageOrdering::ChannelFirst ? 1 : 0));
+    // Keep accesses until the kernels are finished
+    std::vector<OpenCLImageAccess::pointer> accesses;
+    for(int i = 0; i < images.size(); ++i) {
+        auto image = images[i];
         OpenCLImageAccess::pointer access = image->getOpenCLImageAccess(ACCESS_READ, device);
-        cl::Buffer buffer(
-                device->getContext(),
-                CL_MEM_WRITE_ONLY,
-                sizeof(float) * size
-        );
-        kernel.setArg(1, buffer);
-        kernel.setArg(2, mScaleFactor);
-        kernel.setArg(3, mMean);
-        kernel.setArg(4, mStd);
-        kernel.setArg(5, (int) (mSignedInputNormalization ? 1 : 0));
-        kernel.setArg(6, (int) (mHorizontalImageFlipping ? 1 : 0));
-        kernel.setArg(7, image->getNrOfChannels());
-        kernel.setArg(8, mMinIntensity);
-        kernel.setArg(9, mMaxIntensity);
-        kernel.setArg(10, (int)(mMinAndMaxIntensitySet ? 1 : 0));
-        kernel.setArg(11, (int)(m_engine->getPreferredImageOrdering() == ImageOrdering::ChannelFirst ? 1 : 0));
+        kernel.setArg(12, (int)(i*size));
         cl::NDRange globalSize;
         if(image->getDimensions() == 2) {
             kernel.setArg(0, *access->get2DImage());
@@ -361,14 +382,17 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
                 globalSize,
                 cl::NullRange
         );
-
-        // Read data directly into slice
-        device->getCommandQueue().enqueueReadBuffer(buffer, CL_TRUE, 0, sizeof(float) * size,
-                                                    values.get() + i*size);
+        accesses.push_back(std::move(access));
     }
 
+    // Read the entire batch directly into the tensor
     auto tensor = Tensor::New();
-    tensor->create(std::move(values), shape);
+    tensor->create(shape);
+    {
+        auto tensorAccess = tensor->getAccess(ACCESS_READ_WRITE);
+        device->getCommandQueue().enqueueReadBuffer(*buffer, CL_TRUE, 0, sizeof(float) * size * images.size(),
+                                                    tensorAccess->getRawData());
+    }
     return tensor;
 }
 
@@ -408,6 +432,10 @@ void NeuralNetwork::setTemporalWindow(uint window) {
 	mTemporalWindow = window;
 }
 
+void NeuralNetwork::setBatchOutputAsTensor(bool enable) {
+    m_batchOutputAsTensor = enable;
+}
+
 void NeuralNetwork::setSignedInputNormalization(bool signedInputNormalization) {
 	mSignedInputNormalization = signedInputNormalization;
 }
@@ -140,6 +140,15 @@ class FAST_EXPORT NeuralNetwork : public ProcessObject {
          * @param window
          */
         void setTemporalWindow(uint window);
+        /**
+         * If enabled, the output of a batch is a single tensor where the first dimension is the batch,
+         * instead of a Batch with one tensor per input image. This avoids copying the output of each image.
+         * The frame data of each input image, such as patch coordinates, is stored per sample in the tensor,
+         * see Tensor::getBatchFrameData. The PatchStitcher can stitch such tensors directly.
+         * Disabled by default.
+         * @param enable
+         */
+        void setBatchOutputAsTensor(bool enable);
 
         void loadAttributes();
 
@@ -151,6 +160,7 @@ class FAST_EXPORT NeuralNetwork : public ProcessObject {
         bool mSignedInputNormalization = false;
         int mTemporalWindow = 0;
         int m_batchSize;
+        bool m_batchOutputAsTensor = false;
         float mScaleFactor, mMean, mStd, mMinIntensity, mMaxIntensity;
         bool mMinAndMaxIntensitySet = false;
         Vector3f mNewInputSpacing;
@@ -291,6 +291,62 @@ TEST_CASE("Execute NN on batch of 2D images", "[fast][neuralnetwork][batch]") {
     }
 }
 
+TEST_CASE("Execute NN on batch of 2D images with batch output as tensor", "[fast][neuralnetwork][batch]") {
+    for(auto&& engine : InferenceEngineManager::getEngineList()) {
+        std::vector<Image::pointer> images;
+
+        // Import data, one image for each sample with its own frame data
+        for(int i = 0; i < 2; ++i) {
+            auto importer = ImageFileImporter::New();
+            importer->setFilename(Config::getTestDataPath() + "US/JugularVein/US-2D_0.mhd");
+            auto port = importer->getOutputPort();
+            importer->update();
+            auto data = port->getNextFrame<Image>();
+            data->setFrameData("patchid-x", std::to_string(i));
+            data->setFrameData("patchid-y", std::to_string(2*i));
+            images.push_back(data);
+        }
+        auto batch = Batch::New();
+        batch->create(images);
+
+        auto network = NeuralNetwork::New();
+        network->setInferenceEngine(engine);
+        network->getInferenceEngine()->setMaxBatchSize(2);
+        network->setBatchOutputAsTensor(true);
+        if(engine.substr(0, 10) == "TensorFlow") {
+            network->setOutputNode(0, "dense_1/BiasAdd", NodeType::TENSOR);
+            network->setOutputNode(1, "dense_2/BiasAdd", NodeType::TENSOR);
+            network->load(Config::getTestDataPath() + "NeuralNetworkModels/single_input_multi_output.pb");
+        } else if(engine == "TensorRT") {
+            network->setInputNode(0, "input_1", NodeType::IMAGE, TensorShape({-1, 1, 64, 64}));
+            network->setOutputNode(0, "dense_1/BiasAdd", NodeType::TENSOR, TensorShape({-1, 6}));
+            network->setOutputNode(1, "dense_2/BiasAdd", NodeType::TENSOR, TensorShape({-1, 6}));
+            network->load(Config::getTestDataPath() + "NeuralNetworkModels/single_input_multi_output_channels_first.uff");
+        } else {
+            network->load(Config::getTestDataPath() + "NeuralNetworkModels/single_input_multi_output.xml");
+        }
+        network->setInputData(batch);
+        auto port1 = network->getOutputPort(0);
+        auto port2 = network->getOutputPort(1);
+        network->update();
+
+        // We are expecting one tensor per output with dimensions (2, 6), and the frame data of each input image
+        const auto keyX = FrameData::getKey("patchid-x");
+        const auto keyY = FrameData::getKey("patchid-y");
+        for(auto&& tensor : {port1->getNextFrame<Tensor>(), port2->getNextFrame<Tensor>()}) {
+            REQUIRE(tensor->getShape().getDimensions() == 2);
+            CHECK(tensor->getShape()[0] == 2);
+            CHECK(tensor->getShape()[1] == 6);
+            const auto& batchFrameData = tensor->getBatchFrameData();
+            REQUIRE(batchFrameData.size() == 2);
+            for(int i = 0; i < 2; ++i) {
+                CHECK(batchFrameData[i].getInt(keyX) == i);
+                CHECK(batchFrameData[i].getInt(keyY) == 2*i);
+            }
+        }
+    }
+}
+
 TEST_CASE("NN: temporal input static output", "[fast][neuralnetwork][sequence]") {
     for(const std::string& engine : {"TensorFlowCPU", "TensorFlowCUDA"}) {
         if(!InferenceEngineManager::isEngineAvailable(engine)) {
@@ -14,6 +14,7 @@ NonLocalMeans::NonLocalMeans() {
     createIntegerAttribute("filter-size", "Filter size", "Filter size", 3);
     createIntegerAttribute("iterations", "Iterations", "Number of multiscale iterations", 3);
     createBooleanAttribute("preprocess", "Preprocess", "Apply preprocessing (5x5 median filter) or not", true);
+    createBooleanAttribute("blockwise", "Blockwise", "Compute patch weights once for each block of filter size x filter size pixels", false);
 }
 
 void NonLocalMeans::loadAttributes() {
@@ -22,22 +23,162 @@ void NonLocalMeans::loadAttributes() {
     setFilterSize(getIntegerAttribute("filter-size"));
     setMultiscaleIterations(getIntegerAttribute("iterations"));
     setPreProcess(getBooleanAttribute("preprocess"));
+    setBlockwise(getBooleanAttribute("blockwise"));
+}
+
+static inline float sampleClamped(const uchar* image, int width, int height, int x, int y) {
+    return image[std::min(std::max(x, 0), width - 1) + std::min(std::max(y, 0), height - 1)*width];
+}
+
+// Same as the preprocess kernel
+static void preprocessOnHost(const uchar* input, uchar* output, int width, int height) {
+    parallelFor(height, [=](int startY, int endY) {
+        uchar elements[25];
+        for(int y = startY; y < endY; ++y) {
+            for(int x = 0; x < width; ++x) {
+                int counter = 0;
+                for(int a = -2; a <= 2; ++a) {
+                    for(int b = -2; b <= 2; ++b) {
+                        elements[counter] = sampleClamped(input, width, height, x + a, y + b);
+                        ++counter;
+                    }
+                }
+                std::nth_element(elements, elements + 12, elements + 25);
+                const float median = elements[12];
+                const float threshold = 150.0f;
+                const float current = input[x + y*width];
+                output[x + y*width] = (uchar)std::max(current - std::max(median - current - threshold, 0.0f), 0.0f);
+            }
+        }
+    });
+}
+
+/**
+ * One multiscale iteration on the host, using the same running sums as the OpenCL kernels.
+ * The image is split into bands of block rows, and each thread computes the patch distances of its own band.
+ */
+static void nonLocalMeansOnHost(const uchar* input, uchar* output, int width, int height, int searchSize,
+                                int filterSize, int blockSize, float parameterH, int scale) {
+    const int blocksX = (width + blockSize - 1) / blockSize;
+    const int blocksY = (height + blockSize - 1) / blockSize;
+    const int nrOfOffsets = (2*searchSize + 1)*(2*searchSize + 1);
+    auto isBlockCenter = [blockSize](int position, int size) {
+        return position == std::min((position / blockSize)*blockSize + blockSize/2, size - 1);
+    };
+
+    parallelFor(blocksY, [&](int startBlock, int endBlock) {
+        const int startY = startBlock*blockSize;
+        const int endY = std::min(endBlock*blockSize, height);
+        const int bandHeight = endY - startY;
+        const int paddedHeight = bandHeight + 2*filterSize;
+        std::vector<float> rowSums(paddedHeight*blocksX);
+        std::vector<float> weights((endBlock - startBlock)*blocksX);
+        std::vector<float> sumTop(bandHeight*width, 0.0f);
+        std::vector<float> sumBottom(bandHeight*width, 0.0f);
+
+        for(int i = 0; i < nrOfOffsets; ++i) {
+            const int offsetX = (i % (2*searchSize + 1) - searchSize)*scale;
+            const int offsetY = (i / (2*searchSize + 1) - searchSize)*scale;
+
+            for(int row = 0; row < paddedHeight; ++row) {
+                const int y = startY + row - filterSize;
+                auto squaredDifference = [&](int x) {
+                    const float diff = (sampleClamped(input, width, height, x, y) -
+                                        sampleClamped(input, width, height, x + offsetX, y + offsetY))/255.0f;
+                    return diff*diff;
+                };
+                float sum = 0.0f;
+                for(int x = -filterSize; x <= filterSize; ++x)
+                    sum += squaredDifference(x);
+                for(int x = 0; x < width; ++x) {
+                    if(isBlockCenter(x, width))
+                        rowSums[row*blocksX + x / blockSize] = sum;
+                    sum += squaredDifference(x + filterSize + 1) - squaredDifference(x - filterSize);
+                }
+            }
+
+            for(int blockX = 0; blockX < blocksX; ++blockX) {
+                float sum = 0.0f;
+                for(int row = 0; row <= 2*filterSize; ++row)
+                    sum += rowSums[row*blocksX + blockX];
+                for(int y = startY; y < endY; ++y) {
+                    const int row = y - startY;
+                    if(isBlockCenter(y, height))
+                        weights[(y / blockSize - startBlock)*blocksX + blockX] = std::exp(-sum/(2.0f*parameterH*parameterH));
+                    if(y + 1 < endY)
+                        sum += rowSums[(row + 2*filterSize + 1)*blocksX + blockX] - rowSums[row*blocksX + blockX];
+                }
+            }
+
+            for(int y = startY; y < endY; ++y) {
+                const float* weightRow = &weights[(y / blockSize - startBlock)*blocksX];
+                for(int x = 0; x < width; ++x) {
+                    const float weight = weightRow[x / blockSize];
+                    const int index = x + (y - startY)*width;
+                    sumTop[index] += weight*sampleClamped(input, width, height, x + offsetX, y + offsetY)/255.0f;
+                    sumBottom[index] += weight;
+                }
+            }
+        }
+
+        for(int i = 0; i < bandHeight*width; ++i)
+            output[startY*width + i] = (uchar)std::min(std::max((sumTop[i]/sumBottom[i])*255.0f, 0.0f), 255.0f);
+    });
 }
 
 void NonLocalMeans::execute() {
     auto input = getInputData<Image>(0);
+    if(input->getDataType() != TYPE_UINT8 || input->getDimensions() != 2 || input->getNrOfChannels() != 1)
+        throw Exception("NonLocalMeans only supports 2D uint8 images with one channel");
     auto output = getOutputData<Image>(0);
     output->createFromImage(input);
+
+    if(getMainDevice()->isHost()) {
+        executeOnHost(input, output);
+    } else {
+        executeOnDevice(input, output);
+    }
+}
+
+void NonLocalMeans::executeOnHost(SharedPointer<Image> input, SharedPointer<Image> output) {
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int blockSize = m_blockwise ? m_filterSize : 1;
+    std::vector<uchar> source(width*height);
+    std::vector<uchar> destination(width*height);
+    {
+        auto access = input->getImageAccess(ACCESS_READ);
+        const uchar* data = (const uchar*)access->get();
+        if(m_preProcess) {
+            preprocessOnHost(data, source.data(), width, height);
+        } else {
+            std::copy(data, data + width*height, source.begin());
+        }
+    }
+
+    for(int iteration = 0; iteration < m_iterations; ++iteration) {
+        nonLocalMeansOnHost(source.data(), destination.data(), width, height, m_searchSize, (m_filterSize - 1)/2,
+                            blockSize, m_parameterH*(1.0f/(float)std::pow(2, iteration)), iteration + 1);
+        source.swap(destination);
+    }
+
+    auto access = output->getImageAccess(ACCESS_READ_WRITE);
+    std::copy(source.begin(), source.end(), (uchar*)access->get());
+}
+
+void NonLocalMeans::executeOnDevice(SharedPointer<Image> input, SharedPointer<Image> output) {
     auto auxImage = Image::New();
     auxImage->createFromImage(input);
 
     const int width = input->getWidth();
     const int height = input->getHeight();
+    const int blockSize = m_blockwise ? m_filterSize : 1;
 
     auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
     auto program = getOpenCLProgram(device, "", 
             "-DFILTER_SIZE=" + std::to_string((m_filterSize - 1)/2) + " "
-            "-DSEARCH_SIZE=" + std::to_string(m_searchSize)
+            "-DSEARCH_SIZE=" + std::to_string(m_searchSize) + " "
+            "-DBLOCK_SIZE=" + std::to_string(blockSize)
             );
     auto queue = device->getCommandQueue();
 
@@ -48,8 +189,10 @@ void NonLocalMeans::execute() {
     auto accessOutput = output->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
     auto accessAux = auxImage->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
 
+    // Start in the image which makes the last iteration write to the output
     auto bufferIn = accessInput->get2DImage();
-    auto bufferOut = accessAux->get2DImage();
+    auto bufferOut = m_iterations % 2 == 0 ? accessOutput->get2DImage() : accessAux->get2DImage();
+    auto bufferOther = m_iterations % 2 == 0 ? accessAux->get2DImage() : accessOutput->get2DImage();
 
     if(m_preProcess) {
         kernelPreProcess.setArg(0, *bufferIn);
@@ -60,9 +203,6 @@ void NonLocalMeans::execute() {
             cl::NDRange(width, height),
             cl::NullRange
         );
-
-        bufferIn = bufferOut;
-        bufferOut = accessOutput->get2DImage();
     } else {
         queue.enqueueCopyImage(
             *bufferIn,
@@ -71,24 +211,74 @@ void NonLocalMeans::execute() {
             createOrigoRegion(),
             createRegion(width, height, 1)
         );
-        bufferIn = bufferOut;
-        bufferOut = accessOutput->get2DImage();
+    }
+    bufferIn = bufferOut;
+    bufferOut = bufferOther;
+
+    // Comparing patches directly is faster than the running sums for the smallest filter
+    const bool direct = m_filterSize <= 3 && !m_blockwise;
+    const int nrOfOffsets = (2*m_searchSize + 1)*(2*m_searchSize + 1);
+    const int blocksX = (width + blockSize - 1) / blockSize;
+    const int blocksY = (height + blockSize - 1) / blockSize;
+    const int paddedHeight = height + 2*((m_filterSize - 1)/2);
+    // Search offsets are processed in batches to limit the memory used for row sums and weights
+    const int offsetsPerBatch = std::max(1, std::min(nrOfOffsets, (1 << 23) / (paddedHeight*blocksX)));
+    cl::Buffer rowSums, weights, sums;
+    cl::Kernel kernelRows, kernelWeights, kernelAccumulate, kernelNormalize;
+    if(!direct) {
+        rowSums = cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, sizeof(float)*offsetsPerBatch*paddedHeight*blocksX);
+        weights = cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, sizeof(float)*offsetsPerBatch*blocksY*blocksX);
+        sums = cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, sizeof(float)*2*width*height);
+        kernelRows = cl::Kernel(program, "patchDistanceRows");
+        kernelWeights = cl::Kernel(program, "patchWeights");
+        kernelAccumulate = cl::Kernel(program, "accumulateWeights");
+        kernelNormalize = cl::Kernel(program, "normalizeWeights");
     }
 
     for (int iteration = 0; iteration < m_iterations; ++iteration) {
-        kernelNLM.setArg(0, *bufferIn);
-        kernelNLM.setArg(1, *bufferOut);
-        kernelNLM.setArg(2, m_searchSize);
-        kernelNLM.setArg(3, (m_filterSize - 1)/2);
-        kernelNLM.setArg(4, m_parameterH*(1.0f/(float)std::pow(2, iteration)));
-        kernelNLM.setArg(5, iteration); // iteration
+        const float parameterH = m_parameterH*(1.0f/(float)std::pow(2, iteration));
+        if(direct) {
+            kernelNLM.setArg(0, *bufferIn);
+            kernelNLM.setArg(1, *bufferOut);
+            kernelNLM.setArg(2, m_searchSize);
+            kernelNLM.setArg(3, (m_filterSize - 1)/2);
+            kernelNLM.setArg(4, parameterH);
+            kernelNLM.setArg(5, iteration); // iteration
 
-        queue.enqueueNDRangeKernel(
-            kernelNLM,
-            cl::NullRange,
-            cl::NDRange(width, height),
-            cl::NullRange
-        );
+            queue.enqueueNDRangeKernel(
+                kernelNLM,
+                cl::NullRange,
+                cl::NDRange(width, height),
+                cl::NullRange
+            );
+        } else {
+            queue.enqueueFillBuffer(sums, 0.0f, 0, sizeof(float)*2*width*height);
+            for(int firstOffset = 0; firstOffset < nrOfOffsets; firstOffset += offsetsPerBatch) {
+                const int offsets = std::min(offsetsPerBatch, nrOfOffsets - firstOffset);
+                kernelRows.setArg(0, *bufferIn);
+                kernelRows.setArg(1, rowSums);
+                kernelRows.setArg(2, firstOffset);
+                kernelRows.setArg(3, iteration + 1);
+                queue.enqueueNDRangeKernel(kernelRows, cl::NullRange, cl::NDRange(paddedHeight, offsets), cl::NullRange);
+
+                kernelWeights.setArg(0, rowSums);
+                kernelWeights.setArg(1, weights);
+                kernelWeights.setArg(2, height);
+                kernelWeights.setArg(3, parameterH);
+                queue.enqueueNDRangeKernel(kernelWeights, cl::NullRange, cl::NDRange(blocksX, offsets), cl::NullRange);
+
+                kernelAccumulate.setArg(0, *bufferIn);
+                kernelAccumulate.setArg(1, weights);
+                kernelAccumulate.setArg(2, sums);
+                kernelAccumulate.setArg(3, firstOffset);
+                kernelAccumulate.setArg(4, offsets);
+                kernelAccumulate.setArg(5, iteration + 1);
+                queue.enqueueNDRangeKernel(kernelAccumulate, cl::NullRange, cl::NDRange(width, height), cl::NullRange);
+            }
+            kernelNormalize.setArg(0, sums);
+            kernelNormalize.setArg(1, *bufferOut);
+            queue.enqueueNDRangeKernel(kernelNormalize, cl::NullRange, cl::NDRange(width, height), cl::NullRange);
+        }
 
         auto tmp = bufferIn;
         bufferIn = bufferOut;
@@ -108,6 +298,10 @@ void NonLocalMeans::setPreProcess(bool preProcess) {
     m_preProcess = preProcess;
 }
 
+void NonLocalMeans::setBlockwise(bool blockwise) {
+    m_blockwise = blockwise;
+}
+
 void NonLocalMeans::setMultiscaleIterations(int iterations) {
     if(iterations < 1)
         throw Exception("Multiscale iterations must be larger than 0");
@@ -3,6 +3,16 @@
 #include <FAST/ProcessObject.hpp>
 
 namespace fast {
+    class Image;
+
+    /**
+     * Non-local means denoising of 2D uint8 images, with several multiscale iterations.
+     *
+     * The patch distances of each search offset are computed from the squared difference image of the offset
+     * with running (summed-area) sums along rows and columns, thus the cost does not depend on the filter size.
+     * Small filters on OpenCL devices use a kernel which compares each patch directly instead.
+     * On the host the image is split into bands which are processed by several threads.
+     */
     class FAST_EXPORT NonLocalMeans : public ProcessObject {
         FAST_OBJECT(NonLocalMeans);
     public:
@@ -11,15 +21,26 @@ namespace fast {
         void setMultiscaleIterations(int iterations);
         void setSearchSize(int searchSize);
         void setFilterSize(int filterSize);
+        /**
+         * Compute the patch weights once for each non-overlapping block of filter size x filter size pixels,
+         * at the center of the block, and use them for all pixels in the block. This reduces the amount of
+         * patch distances to compute by filter size squared, at the cost of some blocking artifacts.
+         * Disabled by default.
+         * @param blockwise
+         */
+        void setBlockwise(bool blockwise);
         void loadAttributes() override;
     private:
         NonLocalMeans();
         void execute() override;
+        void executeOnHost(SharedPointer<Image> input, SharedPointer<Image> output);
+        void executeOnDevice(SharedPointer<Image> input, SharedPointer<Image> output);
 
         float m_parameterH = 0.15f;
         bool m_preProcess = true;
         int m_iterations = 3; // How many multiscale iterations to do
         int m_searchSize = 11; // How large the pixel search area should be
         int m_filterSize = 3;
+        bool m_blockwise = false;
     };
 }
\ No newline at end of file
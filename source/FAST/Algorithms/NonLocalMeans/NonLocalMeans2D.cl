@@ -49,7 +49,7 @@ __kernel void preprocess(
 
     const float threshold = 150.0f; // TODO Set this threshold in a smarter way
     const float current = read_imageui(input, sampler, pos).x;
-    uchar newPixel = current - max((float)median - current - threshold, 0.0f);
+    uchar newPixel = max(current - max((float)median - current - threshold, 0.0f), 0.0f);
     write_imageui(output, pos, newPixel);
 }
 
@@ -78,3 +78,109 @@ __kernel void nonLocalMeansFilter(
 
     write_imageui(imageOutput, pos, (uchar)clamp((sumTop/sumBottom)*255.0f, 0.0f, 255.0f ));
 }
+
+
+// Patch distances with running sums of the squared difference image of each search offset. Several search offsets
+// are processed by each pass, offset number k of the pass is given by the second global dimension.
+// Weights are computed at the center of each block of BLOCK_SIZE x BLOCK_SIZE pixels, BLOCK_SIZE is 1 unless blockwise.
+
+int2 getSearchOffset(int i, int scale) {
+    return (int2)(i % (2*SEARCH_SIZE + 1) - SEARCH_SIZE, i / (2*SEARCH_SIZE + 1) - SEARCH_SIZE)*scale;
+}
+
+float squaredDifference(__read_only image2d_t image, int2 pos, int2 offset) {
+    const float diff = ((float)read_imageui(image, sampler, pos).x - (float)read_imageui(image, sampler, pos + offset).x)/255.0f;
+    return diff*diff;
+}
+
+// Is position the center of its block
+bool isBlockCenter(int position, int size) {
+    const int block = position / BLOCK_SIZE;
+    return position == min(block*BLOCK_SIZE + BLOCK_SIZE/2, size - 1);
+}
+
+// Sum of squared differences over the filter width along each row, stored at the center column of each block.
+// Rows are padded with FILTER_SIZE rows above and below the image.
+__kernel void patchDistanceRows(
+        __read_only image2d_t image,
+        __global float* rowSums,
+        __private int firstOffset,
+        __private int scale
+        ) {
+    const int paddedY = get_global_id(0);
+    const int y = paddedY - FILTER_SIZE;
+    const int k = get_global_id(1);
+    const int2 offset = getSearchOffset(firstOffset + k, scale);
+    const int width = get_image_width(image);
+    const int blocksX = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    __global float* output = &rowSums[(k*get_global_size(0) + paddedY)*blocksX];
+
+    float sum = 0.0f;
+    for(int x = -FILTER_SIZE; x <= FILTER_SIZE; ++x)
+        sum += squaredDifference(image, (int2)(x, y), offset);
+    for(int x = 0; x < width; ++x) {
+        if(isBlockCenter(x, width))
+            output[x / BLOCK_SIZE] = sum;
+        sum += squaredDifference(image, (int2)(x + FILTER_SIZE + 1, y), offset) -
+               squaredDifference(image, (int2)(x - FILTER_SIZE, y), offset);
+    }
+}
+
+// Sum the row sums over the filter height to get the patch distance at the center of each block,
+// and convert it to a weight
+__kernel void patchWeights(
+        __global const float* rowSums,
+        __global float* weights,
+        __private int height,
+        __private float parameterH
+        ) {
+    const int blockX = get_global_id(0);
+    const int blocksX = get_global_size(0);
+    const int blocksY = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const int k = get_global_id(1);
+    __global const float* input = &rowSums[k*(height + 2*FILTER_SIZE)*blocksX + blockX];
+    __global float* output = &weights[k*blocksY*blocksX + blockX];
+
+    // The patch of row y covers padded rows y to y + 2*FILTER_SIZE
+    float sum = 0.0f;
+    for(int y = 0; y <= 2*FILTER_SIZE; ++y)
+        sum += input[y*blocksX];
+    for(int y = 0; y < height; ++y) {
+        if(isBlockCenter(y, height))
+            output[(y / BLOCK_SIZE)*blocksX] = native_exp(-sum/(2.0f*parameterH*parameterH));
+        if(y + 1 < height)
+            sum += input[(y + 2*FILTER_SIZE + 1)*blocksX] - input[y*blocksX];
+    }
+}
+
+__kernel void accumulateWeights(
+        __read_only image2d_t image,
+        __global const float* weights,
+        __global float2* sums,
+        __private int firstOffset,
+        __private int nrOfOffsets,
+        __private int scale
+        ) {
+    const int2 pos = {get_global_id(0), get_global_id(1)};
+    const int blocksX = (get_global_size(0) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const int blocksY = (get_global_size(1) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const int blockIndex = pos.x / BLOCK_SIZE + (pos.y / BLOCK_SIZE)*blocksX;
+    const int index = pos.x + pos.y*get_global_size(0);
+
+    float2 sum = sums[index];
+    for(int k = 0; k < nrOfOffsets; ++k) {
+        const float weight = weights[k*blocksX*blocksY + blockIndex];
+        const float value = read_imageui(image, sampler, pos + getSearchOffset(firstOffset + k, scale)).x/255.0f;
+        sum += (float2)(weight*value, weight);
+    }
+    sums[index] = sum;
+}
+
+__kernel void normalizeWeights(
+        __global const float2* sums,
+        __write_only image2d_t imageOutput
+        ) {
+    const int2 pos = {get_global_id(0), get_global_id(1)};
+    const float2 sum = sums[pos.x + pos.y*get_global_size(0)];
+    write_imageui(imageOutput, pos, (uchar)clamp((sum.x/sum.y)*255.0f, 0.0f, 255.0f));
+}
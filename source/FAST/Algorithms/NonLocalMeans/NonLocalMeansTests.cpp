@@ -4,6 +4,7 @@
 #include <FAST/Visualization/ImageRenderer/ImageRenderer.hpp>
 #include <FAST/Visualization/DualViewWindow.hpp>
 #include <FAST/Algorithms/UltrasoundImageEnhancement/UltrasoundImageEnhancement.hpp>
+#include <FAST/Importers/ImageFileImporter.hpp>
 
 using namespace fast;
 
@@ -35,3 +36,34 @@ TEST_CASE("Non local means", "[fast][nlm]") {
     window->setTimeout(2000);
     window->start();
 }
+
+TEST_CASE("Non local means on Host gives same result as OpenCL device", "[fast][nlm]") {
+    auto importer = ImageFileImporter::New();
+    importer->setFilename(Config::getTestDataPath() + "US/Heart/ApicalFourChamber/US-2D_0.mhd");
+    auto image = importer->updateAndGetOutputData<Image>();
+
+    for(bool blockwise : {false, true}) {
+        Image::pointer outputs[2];
+        for(int i = 0; i < 2; ++i) {
+            auto filter = NonLocalMeans::New();
+            if(i == 1)
+                filter->setMainDevice(Host::getInstance());
+            filter->setFilterSize(5);
+            filter->setSearchSize(5);
+            filter->setMultiscaleIterations(2);
+            filter->setBlockwise(blockwise);
+            filter->setInputData(image);
+            outputs[i] = filter->updateAndGetOutputData<Image>();
+        }
+
+        auto accessCL = outputs[0]->getImageAccess(ACCESS_READ);
+        auto accessHost = outputs[1]->getImageAccess(ACCESS_READ);
+        uchar* dataCL = (uchar*)accessCL->get();
+        uchar* dataHost = (uchar*)accessHost->get();
+        int maxDifference = 0;
+        for(int i = 0; i < image->getWidth()*image->getHeight(); i++)
+            maxDifference = std::max(maxDifference, std::abs((int)dataCL[i] - (int)dataHost[i]));
+        // Rounding of float sums can differ by one intensity in each iteration
+        CHECK(maxDifference <= 2);
+    }
+}
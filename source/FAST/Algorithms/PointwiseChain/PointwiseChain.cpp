@@ -0,0 +1,302 @@
+#include "PointwiseChain.hpp"
+#include <FAST/Data/Image.hpp>
+#include <FAST/SceneGraph.hpp>
+#include <limits>
+
+namespace fast {
+
+// Number of parameters stored for each operation
+static const int parametersPerOperation = 4;
+
+PointwiseChain::PointwiseChain() {
+    createInputPort<Image>(0);
+    createOutputPort<Image>(0);
+}
+
+void PointwiseChain::addOperation(OperationType type, std::vector<float> parameters) {
+    Operation operation;
+    operation.type = type;
+    operation.parameters = parameters;
+    m_operations.push_back(operation);
+    setModified(true);
+}
+
+void PointwiseChain::addScaling(float low, float high) {
+    if(high <= low)
+        throw Exception("The high value must be higher than the low value in PointwiseChain scaling");
+    addOperation(SCALING, {low, high});
+}
+
+void PointwiseChain::addInversion() {
+    addOperation(INVERSION, {});
+}
+
+void PointwiseChain::addClipping(float min, float max) {
+    if(max < min)
+        throw Exception("The max value must be higher than the min value in PointwiseChain clipping");
+    addOperation(CLIPPING, {min, max});
+}
+
+void PointwiseChain::addMultiplication(float factor) {
+    addOperation(MULTIPLICATION, {factor});
+}
+
+void PointwiseChain::addAddition(float value) {
+    addOperation(ADDITION, {value});
+}
+
+void PointwiseChain::addThresholding(float lowerThreshold, float upperThreshold, uchar label) {
+    if(upperThreshold < lowerThreshold)
+        throw Exception("The upper threshold must be higher than the lower threshold in PointwiseChain thresholding");
+    addOperation(THRESHOLDING, {lowerThreshold, upperThreshold, (float)label});
+}
+
+void PointwiseChain::addHounsefieldConversion() {
+    addOperation(HOUNSEFIELD_CONVERSION, {});
+}
+
+void PointwiseChain::clear() {
+    m_operations.clear();
+    setModified(true);
+}
+
+void PointwiseChain::setOutputType(DataType type) {
+    m_outputType = type;
+    m_outputTypeSet = true;
+    setModified(true);
+}
+
+DataType PointwiseChain::getOutputType(DataType inputType) const {
+    if(m_outputTypeSet)
+        return m_outputType;
+
+    DataType type = inputType;
+    for(auto&& operation : m_operations) {
+        switch(operation.type) {
+            case SCALING:
+            case MULTIPLICATION:
+            case ADDITION:
+                type = TYPE_FLOAT;
+                break;
+            case THRESHOLDING:
+                type = TYPE_UINT8;
+                break;
+            case HOUNSEFIELD_CONVERSION:
+                type = TYPE_INT16;
+                break;
+            default:
+                break;
+        }
+    }
+    return type;
+}
+
+// Must give the same result as the code generated in getKernelCode
+float PointwiseChain::applyOperation(OperationType type, const float* p, float value) {
+    switch(type) {
+        case SCALING:
+            return (value - p[2])/(p[3] - p[2])*(p[1] - p[0]) + p[0];
+        case INVERSION:
+            return (p[1] - p[0]) - value;
+        case CLIPPING:
+            return std::min(std::max(value, p[0]), p[1]);
+        case MULTIPLICATION:
+            return value*p[0];
+        case ADDITION:
+            return value + p[0];
+        case THRESHOLDING:
+            return value >= p[0] && value <= p[1] ? p[2] : 0.0f;
+        case HOUNSEFIELD_CONVERSION:
+            return value - 1024.0f;
+    }
+    return value;
+}
+
+std::string PointwiseChain::getKernelCode(DataType inputType, DataType outputType) const {
+    const std::string outputCType = getCTypeAsString(outputType);
+    std::string code =
+            "__kernel void pointwiseChain(\n"
+            "        __global const " + getCTypeAsString(inputType) + "* input,\n"
+            "        __global " + outputCType + "* output,\n"
+            "        __constant float* parameters\n"
+            "        ) {\n"
+            "    const uint i = get_global_id(0);\n"
+            "    float value = input[i];\n";
+    for(int i = 0; i < m_operations.size(); ++i) {
+        auto p = [i](int index) {
+            return "parameters[" + std::to_string(i*parametersPerOperation + index) + "]";
+        };
+        code += "    ";
+        switch(m_operations[i].type) {
+            case SCALING:
+                code += "value = (value - " + p(2) + ")/(" + p(3) + " - " + p(2) + ")*(" + p(1) + " - " + p(0) + ") + " + p(0) + ";\n";
+                break;
+            case INVERSION:
+                code += "value = (" + p(1) + " - " + p(0) + ") - value;\n";
+                break;
+            case CLIPPING:
+                code += "value = clamp(value, " + p(0) + ", " + p(1) + ");\n";
+                break;
+            case MULTIPLICATION:
+                code += "value *= " + p(0) + ";\n";
+                break;
+            case ADDITION:
+                code += "value += " + p(0) + ";\n";
+                break;
+            case THRESHOLDING:
+                code += "value = value >= " + p(0) + " && value <= " + p(1) + " ? " + p(2) + " : 0.0f;\n";
+                break;
+            case HOUNSEFIELD_CONVERSION:
+                code += "value -= 1024.0f;\n";
+                break;
+        }
+    }
+    if(outputType == TYPE_FLOAT) {
+        code += "    output[i] = value;\n";
+    } else {
+        code += "    output[i] = convert_" + outputCType + "_sat_rte(value);\n";
+    }
+    code += "}\n";
+    return code;
+}
+
+std::vector<float> PointwiseChain::getParameters(SharedPointer<Image> input) const {
+    std::vector<float> parameters(std::max((int)m_operations.size(), 1)*parametersPerOperation, 0.0f);
+    bool rangeNeeded = false;
+    for(auto&& operation : m_operations)
+        rangeNeeded = rangeNeeded || operation.type == SCALING || operation.type == INVERSION;
+    if(!rangeNeeded) {
+        for(int i = 0; i < m_operations.size(); ++i)
+            std::copy(m_operations[i].parameters.begin(), m_operations[i].parameters.end(), &parameters[i*parametersPerOperation]);
+        return parameters;
+    }
+
+    // Intensity range at the current position in the chain
+    float minimum = input->calculateMinimumIntensity();
+    float maximum = input->calculateMaximumIntensity();
+    for(int i = 0; i < m_operations.size(); ++i) {
+        const Operation& operation = m_operations[i];
+        float* p = &parameters[i*parametersPerOperation];
+        std::copy(operation.parameters.begin(), operation.parameters.end(), p);
+        if(operation.type == SCALING) {
+            p[2] = minimum;
+            p[3] = maximum;
+        } else if(operation.type == INVERSION) {
+            p[0] = minimum;
+            p[1] = maximum;
+        }
+
+        if(operation.type == THRESHOLDING) {
+            const bool inside = p[0] <= maximum && p[1] >= minimum;
+            const bool outside = minimum < p[0] || maximum > p[1];
+            minimum = inside ? p[2] : 0.0f;
+            maximum = outside ? 0.0f : p[2];
+            if(inside && outside) {
+                minimum = std::min(p[2], 0.0f);
+                maximum = std::max(p[2], 0.0f);
+            }
+        } else {
+            // All other operations are monotonic
+            const float a = applyOperation(operation.type, p, minimum);
+            const float b = applyOperation(operation.type, p, maximum);
+            minimum = std::min(a, b);
+            maximum = std::max(a, b);
+        }
+    }
+    return parameters;
+}
+
+template <class T>
+static void loadValues(const void* data, std::size_t start, std::size_t count, float* values) {
+    const T* input = (const T*)data + start;
+    for(std::size_t i = 0; i < count; ++i)
+        values[i] = (float)input[i];
+}
+
+// Rounded and saturated for integer types, same as convert_T_sat_rte in OpenCL
+template <class T>
+static void storeValues(const float* values, std::size_t start, std::size_t count, void* data) {
+    T* output = (T*)data + start;
+    for(std::size_t i = 0; i < count; ++i) {
+        if(std::numeric_limits<T>::is_integer) {
+            const float value = std::isnan(values[i]) ? 0.0f : std::nearbyint(values[i]);
+            output[i] = (T)std::min(std::max(value, (float)std::numeric_limits<T>::lowest()), (float)std::numeric_limits<T>::max());
+        } else {
+            output[i] = (T)values[i];
+        }
+    }
+}
+
+void PointwiseChain::execute() {
+    auto input = getInputData<Image>();
+    auto output = getOutputData<Image>();
+    const DataType inputType = input->getDataType();
+    const DataType outputType = getOutputType(inputType);
+    if(input->getDimensions() == 2) {
+        output->create(input->getWidth(), input->getHeight(), outputType, input->getNrOfChannels());
+    } else {
+        output->create(input->getWidth(), input->getHeight(), input->getDepth(), outputType, input->getNrOfChannels());
+    }
+    output->setSpacing(input->getSpacing());
+    SceneGraph::setParentNode(output, input);
+
+    const std::vector<float> parameters = getParameters(input);
+    const std::size_t size = (std::size_t)input->getWidth()*input->getHeight()*input->getDepth()*input->getNrOfChannels();
+
+    if(getMainDevice()->isHost()) {
+        auto inputAccess = input->getImageAccess(ACCESS_READ);
+        auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+        const void* inputData = inputAccess->get();
+        void* outputData = outputAccess->get();
+        // Blocks of values are small enough to stay in cache while all operations are applied
+        const std::size_t blockSize = 4096;
+        parallelFor((size + blockSize - 1) / blockSize, [&](std::size_t startBlock, std::size_t endBlock) {
+            std::vector<float> values(blockSize);
+            for(std::size_t block = startBlock; block < endBlock; ++block) {
+                const std::size_t start = block*blockSize;
+                const std::size_t count = std::min(blockSize, size - start);
+                switch(inputType) {
+                    fastSwitchTypeMacro(loadValues<FAST_TYPE>(inputData, start, count, values.data()))
+                }
+                for(int i = 0; i < m_operations.size(); ++i) {
+                    const float* p = &parameters[i*parametersPerOperation];
+                    for(std::size_t j = 0; j < count; ++j)
+                        values[j] = applyOperation(m_operations[i].type, p, values[j]);
+                }
+                switch(outputType) {
+                    fastSwitchTypeMacro(storeValues<FAST_TYPE>(values.data(), start, count, outputData))
+                }
+            }
+        });
+    } else {
+        auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+        // The program only depends on the operations and data types, parameters are given to the kernel
+        const std::string code = getKernelCode(inputType, outputType);
+        if(code != m_kernelCode || device != m_programDevice) {
+            m_program = device->getProgram(device->createProgramFromString(code));
+            m_kernelCode = code;
+            m_programDevice = device;
+        }
+
+        cl::Buffer parameterBuffer(
+                device->getContext(),
+                CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                sizeof(float)*parameters.size(),
+                (void*)parameters.data()
+        );
+        auto inputAccess = input->getOpenCLBufferAccess(ACCESS_READ, device);
+        auto outputAccess = output->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+        cl::Kernel kernel(m_program, "pointwiseChain");
+        kernel.setArg(0, *inputAccess->get());
+        kernel.setArg(1, *outputAccess->get());
+        kernel.setArg(2, parameterBuffer);
+        device->getCommandQueue().enqueueNDRangeKernel(
+                kernel,
+                cl::NullRange,
+                cl::NDRange(size),
+                cl::NullRange
+        );
+    }
+}
+
+}
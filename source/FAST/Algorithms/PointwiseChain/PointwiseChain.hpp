@@ -0,0 +1,109 @@
+#pragma once
+
+#include <FAST/ProcessObject.hpp>
+
+namespace fast {
+
+class Image;
+
+/**
+ * Apply a chain of point-wise intensity operations to an image in one pass.
+ *
+ * Each operation corresponds to a point-wise filter such as ScaleImage, ImageInverter, BinaryThresholding or
+ * HounsefieldConverter. Instead of writing a full image for each filter, one OpenCL kernel applying all operations
+ * is generated for the chain, and every pixel is read and written once. The kernel is only rebuilt when the
+ * operations change, not when their parameters change. On the host the operations are applied to blocks of pixels
+ * using all cores.
+ *
+ * Operations are applied in the order they are added, to every channel, in float. The minimum and maximum
+ * intensity used by scaling and inversion is found from the input image and propagated through the preceding
+ * operations. This is exact for all operations except thresholding, where the range is assumed to include the
+ * label if the threshold range overlaps the intensity range, and 0 if it does not cover it.
+ *
+ * The output data type is the type of the last operation which changes it (float for scaling, multiplication and
+ * addition, uint8 for thresholding, int16 for hounsefield conversion), otherwise the input type, unless set
+ * with setOutputType. Values are rounded and saturated when written to integer types.
+ */
+class FAST_EXPORT PointwiseChain : public ProcessObject {
+    FAST_OBJECT(PointwiseChain)
+    public:
+        /**
+         * Scale intensities to the range [low, high], same as ScaleImage
+         * @param low
+         * @param high
+         */
+        void addScaling(float low = 0.0f, float high = 1.0f);
+        /**
+         * Replace intensity x with (max - min) - x, same as ImageInverter
+         */
+        void addInversion();
+        /**
+         * Clamp intensities to the range [min, max]
+         * @param min
+         * @param max
+         */
+        void addClipping(float min, float max);
+        /**
+         * Multiply intensities with a constant
+         * @param factor
+         */
+        void addMultiplication(float factor);
+        /**
+         * Add a constant to the intensities
+         * @param value
+         */
+        void addAddition(float value);
+        /**
+         * Set intensities in the range [lowerThreshold, upperThreshold] to label and all others to 0,
+         * same as BinaryThresholding. Use -infinity or infinity for a threshold with only one limit.
+         * @param lowerThreshold
+         * @param upperThreshold
+         * @param label
+         */
+        void addThresholding(float lowerThreshold, float upperThreshold, uchar label = 1);
+        /**
+         * Convert unsigned CT intensities to hounsefield units by subtracting 1024, same as HounsefieldConverter
+         */
+        void addHounsefieldConversion();
+        /**
+         * Remove all operations
+         */
+        void clear();
+        void setOutputType(DataType type);
+        /**
+         * @return the OpenCL code of the kernel for the current operations and the given data types
+         */
+        std::string getKernelCode(DataType inputType, DataType outputType) const;
+    protected:
+        PointwiseChain();
+        void execute() override;
+
+        enum OperationType {
+            SCALING,
+            INVERSION,
+            CLIPPING,
+            MULTIPLICATION,
+            ADDITION,
+            THRESHOLDING,
+            HOUNSEFIELD_CONVERSION
+        };
+        struct Operation {
+            OperationType type;
+            // Scaling and inversion have their input range appended at execution
+            std::vector<float> parameters;
+        };
+        void addOperation(OperationType type, std::vector<float> parameters);
+        std::vector<float> getParameters(SharedPointer<Image> input) const;
+        DataType getOutputType(DataType inputType) const;
+        static float applyOperation(OperationType type, const float* parameters, float value);
+
+        std::vector<Operation> m_operations;
+        DataType m_outputType;
+        bool m_outputTypeSet = false;
+
+        std::string m_kernelCode;
+        cl::Program m_program;
+        SharedPointer<OpenCLDevice> m_programDevice;
+};
+
+}
@@ -0,0 +1,88 @@
+#include "FAST/Testing.hpp"
+#include "PointwiseChain.hpp"
+#include "FAST/Data/Image.hpp"
+
+namespace fast {
+
+TEST_CASE("PointwiseChain on Host", "[fast][PointwiseChain]") {
+    auto image = Image::New();
+    image->create(16, 16, TYPE_UINT8, 1);
+    {
+        auto access = image->getImageAccess(ACCESS_READ_WRITE);
+        uchar* data = (uchar*)access->get();
+        for(int i = 0; i < 256; i++)
+            data[i] = i;
+    }
+
+    auto chain = PointwiseChain::New();
+    chain->setMainDevice(Host::getInstance());
+    chain->addMultiplication(2);
+    chain->addAddition(-10);
+    chain->addClipping(0, 300);
+    chain->addThresholding(100, 200, 3);
+    chain->setInputData(image);
+    auto result = chain->updateAndGetOutputData<Image>();
+    REQUIRE(result->getDataType() == TYPE_UINT8);
+    {
+        auto access = result->getImageAccess(ACCESS_READ);
+        uchar* data = (uchar*)access->get();
+        bool success = true;
+        for(int i = 0; i < 256; i++) {
+            const int value = std::min(std::max(2*i - 10, 0), 300);
+            if(data[i] != (value >= 100 && value <= 200 ? 3 : 0))
+                success = false;
+        }
+        CHECK(success);
+    }
+
+    // Range of inversion is used by scaling
+    chain->clear();
+    chain->addInversion();
+    chain->addScaling(-1, 1);
+    result = chain->updateAndGetOutputData<Image>();
+    REQUIRE(result->getDataType() == TYPE_FLOAT);
+    CHECK(result->calculateMinimumIntensity() == Approx(-1));
+    CHECK(result->calculateMaximumIntensity() == Approx(1));
+    auto access = result->getImageAccess(ACCESS_READ);
+    float* data = (float*)access->get();
+    CHECK(data[0] == Approx(1));
+    CHECK(data[255] == Approx(-1));
+}
+
+TEST_CASE("PointwiseChain on OpenCL device gives same result as Host", "[fast][PointwiseChain]") {
+    const int width = 37, height = 29, depth = 11;
+    auto image = Image::New();
+    image->create(width, height, depth, TYPE_UINT16, 2);
+    {
+        auto access = image->getImageAccess(ACCESS_READ_WRITE);
+        ushort* data = (ushort*)access->get();
+        for(int i = 0; i < width*height*depth*2; i++)
+            data[i] = (i*7919) % 4096;
+    }
+
+    Image::pointer outputs[2];
+    for(int i = 0; i < 2; ++i) {
+        auto chain = PointwiseChain::New();
+        if(i == 1)
+            chain->setMainDevice(Host::getInstance());
+        chain->addHounsefieldConversion();
+        chain->addClipping(-500, 2000);
+        chain->addInversion();
+        chain->addScaling(0, 100);
+        chain->setOutputType(TYPE_INT16);
+        chain->setInputData(image);
+        outputs[i] = chain->updateAndGetOutputData<Image>();
+    }
+
+    auto accessCL = outputs[0]->getImageAccess(ACCESS_READ);
+    auto accessHost = outputs[1]->getImageAccess(ACCESS_READ);
+    short* dataCL = (short*)accessCL->get();
+    short* dataHost = (short*)accessHost->get();
+    int maxDifference = 0;
+    for(int i = 0; i < width*height*depth*2; i++)
+        maxDifference = std::max(maxDifference, std::abs(dataCL[i] - dataHost[i]));
+    // Values exactly halfway between two integers may be rounded differently
+    CHECK(maxDifference <= 1);
+}
+
+}
@@ -0,0 +1,67 @@
+// Union-find connected component labelling. Roots always point to the smallest index of the region,
+// which is merged with atomic min, thus the result is the same as the host version.
+
+uint findRoot(__global volatile uint* parent, uint i) {
+    while(parent[i] != i)
+        i = parent[i];
+    return i;
+}
+
+void unite(__global volatile uint* parent, uint a, uint b) {
+    bool done;
+    do {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if(a < b) {
+            // If another work item changed the root of b, try again with its new parent
+            const uint old = atomic_min(&parent[b], a);
+            done = old == b;
+            b = old;
+        } else if(b < a) {
+            const uint old = atomic_min(&parent[a], b);
+            done = old == a;
+            a = old;
+        } else {
+            done = true;
+        }
+    } while(!done);
+}
+
+__kernel void initialize(__global uint* parent) {
+    const uint i = get_global_id(0);
+    parent[i] = i;
+}
+
+// Unite each pixel with its neighbors before it in raster order with the same label (8/26-connectivity)
+__kernel void merge(
+        __global const uchar* segmentation,
+        __global volatile uint* parent
+        ) {
+    const int4 size = {get_global_size(0), get_global_size(1), get_global_size(2), 1};
+    const int4 pos = {get_global_id(0), get_global_id(1), get_global_id(2), 0};
+    const uint index = pos.x + (pos.y + pos.z*size.y)*size.x;
+    const uchar label = segmentation[index];
+    if(label == 0)
+        return;
+
+    const int startZ = size.z > 1 ? -1 : 0;
+    for(int z = startZ; z <= 0; ++z) {
+        for(int y = -1; y <= 1; ++y) {
+            for(int x = -1; x <= 1; ++x) {
+                if(!(z < 0 || y < 0 || (y == 0 && x < 0)))
+                    continue;
+                const int4 neighbor = pos + (int4)(x, y, z, 0);
+                if(neighbor.x < 0 || neighbor.x >= size.x || neighbor.y < 0 || neighbor.y >= size.y || neighbor.z < 0)
+                    continue;
+                const uint neighborIndex = neighbor.x + (neighbor.y + neighbor.z*size.y)*size.x;
+                if(segmentation[neighborIndex] == label)
+                    unite(parent, index, neighborIndex);
+            }
+        }
+    }
+}
+
+__kernel void compress(__global volatile uint* parent) {
+    const uint i = get_global_id(0);
+    parent[i] = findRoot(parent, i);
+}
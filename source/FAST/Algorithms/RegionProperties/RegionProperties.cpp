@@ -1,157 +1,231 @@
 #include <FAST/Data/Image.hpp>
 #include "RegionProperties.hpp"
-#include <unordered_set>
-#include <queue>
 #include <FAST/Data/Mesh.hpp>
+#include <FAST/SceneGraph.hpp>
+#include <thread>
 
 namespace fast {
 
 RegionProperties::RegionProperties() {
     createInputPort<Image>(0);
     createOutputPort<RegionList>(0);
-}
-
-void RegionProperties::execute() {
-    auto input = getInputData<Image>();
-    if(input->getDataType() != TYPE_UINT8)
-        throw Exception("Wrong input data type to RegionProperties");
-    if(input->getDimensions() != 2)
-        throw Exception("Region properties is only implemented for 2D segmentations");
-
-    std::vector<Region> regions;
-
-    const int width = input->getWidth();
-    const int height = input->getHeight();
-
-    std::unordered_set<uint> visited;
-    auto access = input->getImageAccess(ACCESS_READ);
-    auto pixels = (uchar*)access->get();
-
-    // Get regions by flood fill first
-    std::queue<Vector2i> queue;
-    for(int y = 0; y < height; ++y) {
-        for(int x = 0; x < width; ++x) {
-            uchar currentLabel = pixels[x + y*width];
-            if(currentLabel == 0 || visited.count(x+y*width) > 0)
-                continue;
+    createOutputPort<Image>(1); // Label image
 
-            // Start flood fill
+    createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/RegionProperties/RegionProperties.cl");
+    declareOpenCLProgramBuildOptions();
+}
 
-            // Create region
-            Region region;
-            region.label = currentLabel;
-            region.area = 0;
-            region.centroid = Vector2f::Zero();
+void RegionProperties::setStorePixels(bool store) {
+    m_storePixels = store;
+    setModified(true);
+}
 
-            queue.push(Vector2i(x,y));
-            visited.insert(x + y*width);
-            while(!queue.empty()) {
-                Vector2i current = queue.front();
-                queue.pop();
+static uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t i) {
+    // Path halving
+    while(parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
 
-                region.centroid += current.cast<float>();
-                region.pixels.push_back(current);
+// Roots always point to the smallest index, thus the root of a region is its first pixel in raster order
+static void unite(std::vector<uint32_t>& parent, uint32_t a, uint32_t b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if(a < b) {
+        parent[b] = a;
+    } else if(b < a) {
+        parent[a] = b;
+    }
+}
 
-                ++region.area;
+/**
+ * Neighbors which are before a pixel in raster order. Uniting each pixel with these covers the entire
+ * 8 (2D) or 26 (3D) neighborhood.
+ */
+static std::vector<Vector3i> getPreviousNeighbors(bool is3D) {
+    std::vector<Vector3i> offsets;
+    for(int z = is3D ? -1 : 0; z <= 0; ++z) {
+        for(int y = -1; y <= 1; ++y) {
+            for(int x = -1; x <= 1; ++x) {
+                if(z < 0 || y < 0 || (y == 0 && x < 0))
+                    offsets.push_back(Vector3i(x, y, z));
+            }
+        }
+    }
+    return offsets;
+}
 
-                // Check neighbors
-                for(int a = -1; a <= 1; ++a) {
-                    for(int b = -1; b <= 1; ++b) {
-                        Vector2i next = current + Vector2i(a,b);
-                        // Out of bounds check
-                        if(next.x() < 0 || next.y() < 0 || next.x() >= width || next.y() >= height)
-                            continue;
-                        uchar label = pixels[next.x() + next.y() * width];
-                        if(label == currentLabel && visited.count(next.x() + next.y() * width) == 0) {
-                            queue.push(next);
-                            visited.insert(next.x() + next.y()*width);
-                        }
-                    }
+/**
+ * Union-find on the host. The image is split into blocks of rows (2D) or slices (3D) which are labelled in parallel,
+ * each thread only touching the pixels of its own block. The blocks are then merged along their borders.
+ */
+static void findRegionsOnHost(const uchar* pixels, const Vector3i& size, std::vector<uint32_t>& parent) {
+    const bool is3D = size.z() > 1;
+    const int outerSize = is3D ? size.z() : size.y();
+    const auto neighbors = getPreviousNeighbors(is3D);
+    const int threads = std::min(outerSize, std::max(1, (int)std::thread::hardware_concurrency()));
+    const int blockSize = (outerSize + threads - 1) / threads;
+
+    auto processNeighbors = [&](int x, int y, int z, int outerStart, bool borderOnly) {
+        const uint32_t index = x + (y + z*size.y())*size.x();
+        const uchar label = pixels[index];
+        if(label == 0)
+            return;
+        for(auto&& offset : neighbors) {
+            const Vector3i neighbor = Vector3i(x, y, z) + offset;
+            if(neighbor.x() < 0 || neighbor.x() >= size.x() || neighbor.y() < 0 || neighbor.y() >= size.y() || neighbor.z() < 0)
+                continue;
+            const int neighborOuter = is3D ? neighbor.z() : neighbor.y();
+            // Within a block only neighbors in the block are used, when merging only neighbors in the previous block
+            if(borderOnly != (neighborOuter < outerStart))
+                continue;
+            const uint32_t neighborIndex = neighbor.x() + (neighbor.y() + neighbor.z()*size.y())*size.x();
+            if(pixels[neighborIndex] == label)
+                unite(parent, index, neighborIndex);
+        }
+    };
+
+    auto labelBlock = [&](int outerStart, int outerEnd) {
+        const int startZ = is3D ? outerStart : 0;
+        const int endZ = is3D ? outerEnd : 1;
+        const int startY = is3D ? 0 : outerStart;
+        const int endY = is3D ? size.y() : outerEnd;
+        for(int z = startZ; z < endZ; ++z) {
+            for(int y = startY; y < endY; ++y) {
+                for(int x = 0; x < size.x(); ++x) {
+                    const uint32_t index = x + (y + z*size.y())*size.x();
+                    parent[index] = index;
+                    processNeighbors(x, y, z, outerStart, false);
                 }
             }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for(int start = 0; start < outerSize; start += blockSize)
+        workers.push_back(std::thread(labelBlock, start, std::min(start + blockSize, outerSize)));
+    for(auto&& worker : workers)
+        worker.join();
+
+    // Merge each block with the previous one, only the first row or slice of a block has neighbors in another block
+    for(int start = blockSize; start < outerSize; start += blockSize) {
+        const int startZ = is3D ? start : 0;
+        const int startY = is3D ? 0 : start;
+        const int endY = is3D ? size.y() : start + 1;
+        for(int y = startY; y < endY; ++y) {
+            for(int x = 0; x < size.x(); ++x) {
+                processNeighbors(x, y, startZ, start, true);
+            }
+        }
+    }
+}
 
-            region.centroid /= region.area;
+void RegionProperties::execute() {
+    auto input = getInputData<Image>();
+    if(input->getDataType() != TYPE_UINT8)
+        throw Exception("Wrong input data type to RegionProperties");
 
-            regions.push_back(region);
-        }
+    const bool is3D = input->getDimensions() == 3;
+    const Vector3i size(input->getWidth(), input->getHeight(), is3D ? input->getDepth() : 1);
+    const uint32_t nrOfPixels = size.prod();
+    std::vector<uint32_t> parent(nrOfPixels);
+
+    if(getMainDevice()->isHost()) {
+        auto access = input->getImageAccess(ACCESS_READ);
+        findRegionsOnHost((const uchar*)access->get(), size, parent);
+    } else {
+        // Union-find with atomic min on the device, the roots are compressed before reading back
+        auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+        auto program = getOpenCLProgram(device);
+        auto queue = device->getCommandQueue();
+        auto inputAccess = input->getOpenCLBufferAccess(ACCESS_READ, device);
+        cl::Buffer parentBuffer(device->getContext(), CL_MEM_READ_WRITE, sizeof(uint32_t)*nrOfPixels);
+
+        cl::Kernel initializeKernel(program, "initialize");
+        initializeKernel.setArg(0, parentBuffer);
+        queue.enqueueNDRangeKernel(initializeKernel, cl::NullRange, cl::NDRange(nrOfPixels), cl::NullRange);
+
+        cl::Kernel mergeKernel(program, "merge");
+        mergeKernel.setArg(0, *inputAccess->get());
+        mergeKernel.setArg(1, parentBuffer);
+        queue.enqueueNDRangeKernel(mergeKernel, cl::NullRange, cl::NDRange(size.x(), size.y(), size.z()), cl::NullRange);
+
+        cl::Kernel compressKernel(program, "compress");
+        compressKernel.setArg(0, parentBuffer);
+        queue.enqueueNDRangeKernel(compressKernel, cl::NullRange, cl::NDRange(nrOfPixels), cl::NullRange);
+
+        queue.enqueueReadBuffer(parentBuffer, CL_TRUE, 0, sizeof(uint32_t)*nrOfPixels, parent.data());
     }
 
-    visited.clear();
-    std::vector<Vector2i> vertices;
-
-    // TODO do contour tracing for each region if enabled
-    // TODO handle holes
-    for(auto region : regions) {
-        // Start moore neigbhorhood tracing
-        int checkLocationNr = 1;  // The neighbor number of the location we want to check for a new border point
-        Vector2i checkPosition;      // The corresponding absolute array address of checkLocationNr
-        int newCheckLocationNr;   // Variable that holds the neighborhood position we want to check if we find a new border at checkLocationNr
-        Vector2i startPos = region.pixels[0];      // Set start position
-        int counter = 0;       // Counter is used for the jacobi stop criterion
-        int counter2 = 0;       // Counter2 is used to determine if the point we have discovered is one single point
-
-        // Defines the neighborhood offset position from current position and the neighborhood
-        // position we want to check next if we find a new border at checkLocationNr
-        Vector3i neighborhood[8] = {
-                {-1, 0, 7},
-                {-1, -1, 7},
-                {0, -1, 1},
-                {1, -1, 1},
-                {1, 0, 3},
-                {1, 1, 3},
-                {0, 1, 5},
-                {-1, 1, 5},
-        };
-        Vector2i pos = startPos;
-        // Trace around the neighborhood
-        while(true)
-        {
-            checkPosition = pos + neighborhood[checkLocationNr-1].head(2);
-            newCheckLocationNr = neighborhood[checkLocationNr-1].z();
-
-            if(pixels[checkPosition.x() + checkPosition.y()*width] == 2 && visited.count(checkPosition.x() + checkPosition.y()*width) == 0) // Next border point found
-            {
-                if(checkPosition == startPos) { // Should we stop?
-                    counter ++;
-
-                    // Stopping criterion (jacob)
-                    if(newCheckLocationNr == 1 || counter >= 3)
-                    {
-                        // Close loop
-                        //inside = true; // Since we are starting the search at were we first started we must set inside to true
-                        break;
-                    }
+    // Assign region ids in raster order, and accumulate region properties and the label image in one pass.
+    // The root of a region is its first pixel, thus the id of the root is always assigned before it is needed.
+    auto access = input->getImageAccess(ACCESS_READ);
+    auto pixels = (const uchar*)access->get();
+    std::vector<uint32_t> labels(nrOfPixels);
+    std::vector<Region> regions;
+    std::vector<Eigen::Vector3d> positionSums;
+    const bool storePixels = m_storePixels && !is3D;
+    uint32_t index = 0;
+    for(int z = 0; z < size.z(); ++z) {
+        for(int y = 0; y < size.y(); ++y) {
+            for(int x = 0; x < size.x(); ++x, ++index) {
+                if(pixels[index] == 0) {
+                    labels[index] = 0;
+                    continue;
                 }
-
-                checkLocationNr = newCheckLocationNr; // Update which neighborhood position we should check next
-                pos = checkPosition;
-                counter2 = 0;             // Reset the counter that keeps track of how many neighbors we have visited
-                //borderImage[checkPosition] = BLACK; // Set the border pixel
-                visited.insert(pos.x() + pos.y()*width);
-                vertices.push_back(Vector2i(pos.x(), pos.y()));
-            } else {
-                // No match
-                // Rotate clockwise in the neighborhood
-                checkLocationNr = 1 + (checkLocationNr % 8);
-                if(counter2 > 8) {
-                    // If counter2 is above 8 we have traced around the neighborhood and
-                    // therefor the border is a single black pixel and we can exit
-                    counter2 = 0;
-                    break;
+                const uint32_t root = findRoot(parent, index);
+                const Vector3i position(x, y, z);
+                if(root == index) {
+                    Region region;
+                    region.id = regions.size() + 1;
+                    region.label = pixels[index];
+                    region.area = 0;
+                    region.boundingBoxMin = position;
+                    region.boundingBoxMax = position;
+                    regions.push_back(region);
+                    positionSums.push_back(Eigen::Vector3d::Zero());
+                    labels[index] = region.id;
                 } else {
-                    counter2 ++;
+                    labels[index] = labels[root];
                 }
+                const uint32_t regionIndex = labels[index] - 1;
+                Region& region = regions[regionIndex];
+                ++region.area;
+                positionSums[regionIndex] += position.cast<double>();
+                region.boundingBoxMin = region.boundingBoxMin.cwiseMin(position);
+                region.boundingBoxMax = region.boundingBoxMax.cwiseMax(position);
+                if(storePixels)
+                    region.pixels.push_back(Vector2i(x, y));
             }
         }
-
-        // TODO Create mesh
-        //region.contour = Mesh::New();
-        //region.contour->create(vertices);
+    }
+    for(int i = 0; i < regions.size(); ++i)
+        regions[i].centroid = (positionSums[i] / regions[i].area).cast<float>();
+
+    auto labelImage = Image::New();
+    const DataType labelType = regions.size() > 65535 ? TYPE_FLOAT : TYPE_UINT16;
+    if(is3D) {
+        labelImage->create(size.x(), size.y(), size.z(), labelType, 1);
+    } else {
+        labelImage->create(size.x(), size.y(), labelType, 1);
+    }
+    labelImage->setSpacing(input->getSpacing());
+    SceneGraph::setParentNode(labelImage, input);
+    {
+        auto labelAccess = labelImage->getImageAccess(ACCESS_READ_WRITE);
+        if(labelType == TYPE_UINT16) {
+            std::copy(labels.begin(), labels.end(), (ushort*)labelAccess->get());
+        } else {
+            std::copy(labels.begin(), labels.end(), (float*)labelAccess->get());
+        }
     }
 
     auto regionList = RegionList::New();
     regionList->create(regions);
     addOutputData(0, regionList);
+    addOutputData(1, labelImage);
 }
 
 }
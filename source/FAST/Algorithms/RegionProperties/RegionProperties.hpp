@@ -7,21 +7,50 @@ namespace fast {
 class Mesh;
 
 struct FAST_EXPORT Region {
+    // Id of the region in the label image
+    uint id;
     int area;
     uchar label;
-    Vector2f centroid;
+    // Z is 0 for 2D images
+    Vector3f centroid;
+    // Inclusive pixel bounding box
+    Vector3i boundingBoxMin;
+    Vector3i boundingBoxMax;
     SharedPointer<Mesh> contour;
+    // Only stored for 2D images, see RegionProperties::setStorePixels
     std::vector<Vector2i> pixels;
 };
 
 FAST_SIMPLE_DATA_OBJECT(RegionList, std::vector<Region>)
 
+/**
+ * Find the connected regions of a 2D or 3D uint8 segmentation, where neighbor pixels (8-connectivity in 2D and
+ * 26-connectivity in 3D) with the same non-zero label belong to the same region.
+ *
+ * Regions are found by union-find connected component labelling. On the host, the image is split into blocks
+ * which are labelled in parallel and then merged. With an OpenCL main device the union-find is done on the device.
+ * Area, centroid and bounding box of every region are accumulated in one pass over the image, which also creates
+ * the label image.
+ *
+ * Outputs:
+ * - 0: RegionList, ordered by the first pixel of each region in raster order
+ * - 1: Label image with the region id of each pixel, 0 is background. It is TYPE_UINT16, or TYPE_FLOAT if there
+ *   are more than 65535 regions.
+ */
 class FAST_EXPORT RegionProperties : public ProcessObject {
     FAST_OBJECT(RegionProperties)
     public:
+        /**
+         * Store the position of every pixel of each region in Region::pixels. Only supported for 2D images.
+         * Disabled by default, use the label image instead.
+         * @param store
+         */
+        void setStorePixels(bool store);
     protected:
         RegionProperties();
         void execute() override;
+
+        bool m_storePixels = false;
 };
 
-}
\ No newline at end of file
+}
@@ -25,4 +25,79 @@ TEST_CASE("Region properties", "[regionproperties][fast]") {
         //std::cout << "Area: " << region.area << std::endl;
         //std::cout << "Label: " << (int)region.label << std::endl;
     }
-}
\ No newline at end of file
+}
+
+static Image::pointer createSegmentation(int width, int height, int depth) {
+    // Two boxes with label 1 touching diagonally, and one box with label 2
+    std::vector<uchar> data(width*height*depth, 0);
+    auto fillBox = [&](Vector3i start, Vector3i end, uchar label) {
+        for(int z = start.z(); z <= end.z(); ++z)
+            for(int y = start.y(); y <= end.y(); ++y)
+                for(int x = start.x(); x <= end.x(); ++x)
+                    data[x + (y + z*height)*width] = label;
+    };
+    const int endZ = depth - 1;
+    fillBox(Vector3i(2, 2, 0), Vector3i(5, 5, endZ), 1);
+    fillBox(Vector3i(6, 6, 0), Vector3i(9, 7, endZ), 1);
+    fillBox(Vector3i(20, 3, 0), Vector3i(30, 40, endZ), 2);
+    auto image = Image::New();
+    if(depth > 1) {
+        image->create(width, height, depth, TYPE_UINT8, 1, data.data());
+    } else {
+        image->create(width, height, TYPE_UINT8, 1, data.data());
+    }
+    return image;
+}
+
+TEST_CASE("Region properties on host finds connected regions in 2D and 3D", "[regionproperties][fast]") {
+    for(int depth : {1, 8}) {
+        auto regionProperties = RegionProperties::New();
+        regionProperties->setMainDevice(Host::getInstance());
+        regionProperties->setInputData(createSegmentation(40, 50, depth));
+        auto labelPort = regionProperties->getOutputPort(1);
+        auto regionList = regionProperties->updateAndGetOutputData<RegionList>();
+        auto regions = regionList->getAccess(ACCESS_READ)->getData();
+
+        REQUIRE(regions.size() == 2);
+        CHECK(regions[0].id == 1);
+        CHECK(regions[0].label == 1);
+        CHECK(regions[0].area == (16 + 8)*depth);
+        CHECK(regions[0].boundingBoxMin == Vector3i(2, 2, 0));
+        CHECK(regions[0].boundingBoxMax == Vector3i(9, 7, depth - 1));
+        CHECK(regions[1].id == 2);
+        CHECK(regions[1].label == 2);
+        CHECK(regions[1].area == 11*38*depth);
+        CHECK(regions[1].centroid.x() == Approx(25.0f));
+        CHECK(regions[1].centroid.y() == Approx(21.5f));
+        CHECK(regions[1].centroid.z() == Approx((depth - 1)*0.5f));
+
+        auto labelImage = labelPort->getNextFrame<Image>();
+        CHECK(labelImage->getDataType() == TYPE_UINT16);
+        auto access = labelImage->getImageAccess(ACCESS_READ);
+        const ushort* labels = (const ushort*)access->get();
+        CHECK(labels[0] == 0);
+        CHECK(labels[3 + 3*40] == 1);
+        CHECK(labels[7 + 7*40] == 1);
+        CHECK(labels[25 + 20*40] == 2);
+    }
+}
+
+TEST_CASE("Region properties on OpenCL device gives same regions as host", "[regionproperties][fast]") {
+    for(int depth : {1, 8}) {
+        auto segmentation = createSegmentation(40, 50, depth);
+        std::vector<Region> regions[2];
+        for(int i = 0; i < 2; ++i) {
+            auto regionProperties = RegionProperties::New();
+            if(i == 1)
+                regionProperties->setMainDevice(Host::getInstance());
+            regionProperties->setInputData(segmentation);
+            regions[i] = regionProperties->updateAndGetOutputData<RegionList>()->getAccess(ACCESS_READ)->getData();
+        }
+        REQUIRE(regions[0].size() == regions[1].size());
+        for(int i = 0; i < regions[0].size(); ++i) {
+            CHECK(regions[0][i].area == regions[1][i].area);
+            CHECK(regions[0][i].boundingBoxMin == regions[1][i].boundingBoxMin);
+            CHECK(regions[0][i].boundingBoxMax == regions[1][i].boundingBoxMax);
+        }
+    }
+}
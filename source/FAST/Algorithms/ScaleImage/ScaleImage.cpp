@@ -7,6 +7,7 @@ ScaleImage::ScaleImage() {
     createInputPort<Image>(0);
     createOutputPort<Image>(0);
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/ScaleImage/ScaleImage.cl");
+    declareOpenCLProgramBuildOptions();
     mLow = 0.0f;
     mHigh = 1.0f;
 }
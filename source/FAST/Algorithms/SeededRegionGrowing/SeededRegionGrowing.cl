@@ -0,0 +1,152 @@
+// Frontier (wavefront) based region growing. Only voxels added in the previous iteration are processed,
+// and each voxel is claimed once with an atomic or on a visited bit mask, thus it is tested at most once.
+// Counters: slots 0-2 are the frontier sizes used in rotation, slot 3 is set if a frontier overflowed.
+#define OVERFLOW_SLOT 3
+
+__constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_FILTER_NEAREST | CLK_ADDRESS_NONE;
+
+#ifdef TYPE_FLOAT
+#define READ_IMAGE(image, pos) read_imagef(image, sampler, pos).x
+#elif TYPE_INT
+#define READ_IMAGE(image, pos) (float)read_imagei(image, sampler, pos).x
+#else
+#define READ_IMAGE(image, pos) (float)read_imageui(image, sampler, pos).x
+#endif
+
+#if DIMENSIONS == 2
+#define IMAGE_TYPE image2d_t
+#define IMAGE_POSITION(pos) (pos).xy
+#define IMAGE_DEPTH(image) 1
+#define NEIGHBORS 8
+__constant int4 offsets[NEIGHBORS] = {
+        {1,0,0,0},
+        {0,1,0,0},
+        {1,1,0,0},
+        {-1,0,0,0},
+        {0,-1,0,0},
+        {-1,-1,0,0},
+        {-1,1,0,0},
+        {1,-1,0,0}
+};
+#else
+#define IMAGE_TYPE image3d_t
+#define IMAGE_POSITION(pos) (pos)
+#define IMAGE_DEPTH(image) get_image_depth(image)
+#define NEIGHBORS 6
+__constant int4 offsets[NEIGHBORS] = {
+        {1,0,0,0},
+        {-1,0,0,0},
+        {0,1,0,0},
+        {0,-1,0,0},
+        {0,0,1,0},
+        {0,0,-1,0}
+};
+#endif
+
+bool claim(__global volatile uint* visited, uint index) {
+    const uint bit = 1u << (index % 32);
+    return (atomic_or(&visited[index / 32], bit) & bit) == 0;
+}
+
+// Add a claimed voxel to the segmentation and the next frontier if it is within the intensity range
+void tryAdd(
+        __read_only IMAGE_TYPE image,
+        int4 pos,
+        uint index,
+        __global uchar* segmentation,
+        __global uint* frontier,
+        __global volatile uint* counters,
+        uint slot,
+        uint capacity,
+        float minIntensity,
+        float maxIntensity
+        ) {
+    const float intensity = READ_IMAGE(image, IMAGE_POSITION(pos));
+    if(intensity < minIntensity || intensity > maxIntensity)
+        return;
+
+    const uint i = atomic_inc(&counters[slot]);
+    if(i < capacity) {
+        frontier[i] = index;
+        segmentation[index] = 1;
+    } else {
+        // Frontier is full, the neighbors of this voxel are processed later by collectPending
+        segmentation[index] = 2;
+        counters[OVERFLOW_SLOT] = 1;
+    }
+}
+
+__kernel void initializeSeeds(
+        __read_only IMAGE_TYPE image,
+        __global const uint* seeds,
+        __global uchar* segmentation,
+        __global volatile uint* visited,
+        __global uint* frontier,
+        __global volatile uint* counters,
+        __private uint capacity,
+        __private float minIntensity,
+        __private float maxIntensity
+        ) {
+    const int4 size = {get_image_width(image), get_image_height(image), IMAGE_DEPTH(image), 1};
+    const uint index = seeds[get_global_id(0)];
+    const int4 pos = {index % size.x, (index / size.x) % size.y, index / (size.x*size.y), 0};
+    if(claim(visited, index))
+        tryAdd(image, pos, index, segmentation, frontier, counters, 0, capacity, minIntensity, maxIntensity);
+}
+
+// One growing iteration. The frontier of this iteration is in counters[iteration % 3], the next frontier is
+// appended to counters[(iteration + 1) % 3], and the slot of the previous frontier is reset for the next iteration.
+// The global size is independent of the frontier size, which is only known on the device.
+__kernel void grow(
+        __read_only IMAGE_TYPE image,
+        __global uchar* segmentation,
+        __global volatile uint* visited,
+        __global const uint* frontier,
+        __global uint* nextFrontier,
+        __global volatile uint* counters,
+        __private uint iteration,
+        __private uint capacity,
+        __private float minIntensity,
+        __private float maxIntensity
+        ) {
+    const int4 size = {get_image_width(image), get_image_height(image), IMAGE_DEPTH(image), 1};
+    const uint frontierSize = min(counters[iteration % 3], capacity);
+    const uint nextSlot = (iteration + 1) % 3;
+    if(get_global_id(0) == 0)
+        counters[(iteration + 2) % 3] = 0;
+
+    for(uint i = get_global_id(0); i < frontierSize; i += get_global_size(0)) {
+        const uint index = frontier[i];
+        const int4 pos = {index % size.x, (index / size.x) % size.y, index / (size.x*size.y), 0};
+        for(int j = 0; j < NEIGHBORS; ++j) {
+            const int4 neighbor = pos + offsets[j];
+            if(neighbor.x < 0 || neighbor.y < 0 || neighbor.z < 0 ||
+                neighbor.x >= size.x || neighbor.y >= size.y || neighbor.z >= size.z)
+                continue;
+            const uint neighborIndex = neighbor.x + (neighbor.y + neighbor.z*size.y)*size.x;
+            if(claim(visited, neighborIndex))
+                tryAdd(image, neighbor, neighborIndex, segmentation, nextFrontier, counters, nextSlot, capacity, minIntensity, maxIntensity);
+        }
+    }
+}
+
+// Move voxels which did not fit in a frontier to a new frontier, after the previous frontier has been emptied
+__kernel void collectPending(
+        __global uchar* segmentation,
+        __global uint* frontier,
+        __global volatile uint* counters,
+        __private uint slot,
+        __private uint capacity
+        ) {
+    const uint index = get_global_id(0);
+    if(segmentation[index] != 2)
+        return;
+
+    const uint i = atomic_inc(&counters[slot]);
+    if(i < capacity) {
+        frontier[i] = index;
+        segmentation[index] = 1;
+    } else {
+        counters[OVERFLOW_SLOT] = 1;
+    }
+}
@@ -1,7 +1,8 @@
 #include "FAST/Algorithms/SeededRegionGrowing/SeededRegionGrowing.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/SceneGraph.hpp"
-#include <stack>
+#include <atomic>
+#include <thread>
 #include "FAST/Data/Segmentation.hpp"
 
 namespace fast {
@@ -38,105 +39,208 @@ void SeededRegionGrowing::addSeedPoint(Vector3ui position) {
 SeededRegionGrowing::SeededRegionGrowing() {
     createInputPort<Image>(0);
     createOutputPort<Segmentation>(0);
-    mDimensionCLCodeCompiledFor = 0;
+    createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/SeededRegionGrowing/SeededRegionGrowing.cl");
 }
 
-void SeededRegionGrowing::recompileOpenCLCode(Image::pointer input) {
-    // Check if there is a need to recompile OpenCL code
-    if(input->getDimensions() == mDimensionCLCodeCompiledFor &&
-            input->getDataType() == mTypeCLCodeCompiledFor)
-        return;
-
-    OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
-    std::string buildOptions = "";
-    if(input->getDataType() == TYPE_FLOAT) {
-        buildOptions = "-DTYPE_FLOAT";
-    } else if(input->getDataType() == TYPE_INT8 || input->getDataType() == TYPE_INT16) {
-        buildOptions = "-DTYPE_INT";
-    } else {
-        buildOptions = "-DTYPE_UINT";
-    }
-    std::string filename;
-    if(input->getDimensions() == 2) {
-        filename = "Algorithms/SeededRegionGrowing/SeededRegionGrowing2D.cl";
-    } else {
-        filename = "Algorithms/SeededRegionGrowing/SeededRegionGrowing3D.cl";
+/**
+ * Neighborhood used for growing, same as the OpenCL kernels: 8-connectivity in 2D and 6-connectivity in 3D
+ */
+static std::vector<Vector3i> getNeighborhood(int dimensions) {
+    std::vector<Vector3i> neighborhood;
+    for(int a = -1; a < 2; a++) {
+        for(int b = -1; b < 2; b++) {
+            for(int c = -1; c < 2; c++) {
+                if(dimensions == 2 ? (c != 0 || (a == 0 && b == 0)) : abs(a) + abs(b) + abs(c) != 1)
+                    continue;
+                neighborhood.push_back(Vector3i(a, b, c));
+            }
+        }
     }
-    int programNr = device->createProgramFromSource(Config::getKernelSourcePath() + filename, buildOptions);
-    mKernel = cl::Kernel(device->getProgram(programNr), "seededRegionGrowing");
-    mDimensionCLCodeCompiledFor = input->getDimensions();
-    mTypeCLCodeCompiledFor = input->getDataType();
+    return neighborhood;
 }
 
-template <class T>
-void SeededRegionGrowing::executeOnHost(T* input, Image::pointer output) {
-    ImageAccess::pointer outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
-    uchar* outputData = (uchar*)outputAccess->get();
-    // initialize output to all zero
-    memset(outputData, 0, output->getWidth()*output->getHeight()*output->getDepth());
-    std::stack<Vector3i> queue;
-
-    // Add seeds to queue
+std::vector<uint> SeededRegionGrowing::getSeedIndices(Image::pointer output) const {
+    std::vector<uint> seeds;
     for(int i = 0; i < mSeedPoints.size(); i++) {
         Vector3ui pos = mSeedPoints[i];
 
         // Check if seed point is in bounds
-        if(pos.x() < 0 || pos.y() < 0 || pos.z() < 0 ||
-            pos.x() >= output->getWidth() || pos.y() >= output->getHeight() || pos.z() >= output->getDepth())
+        if(pos.x() >= output->getWidth() || pos.y() >= output->getHeight() || pos.z() >= output->getDepth())
             throw Exception("One of the seed points given to SeededRegionGrowing was out of bounds.");
 
-        queue.push(pos.cast<int>());
+        seeds.push_back(pos.x() + (pos.y() + pos.z()*output->getHeight())*output->getWidth());
     }
+    return seeds;
+}
 
-    std::vector<Vector3i> neighborhood;
-    if(output->getDimensions() == 2) {
-        for(int a = -1; a < 2; a++) {
-            for(int b = -1; b < 2; b++) {
-                for(int c = -1; c < 2; c++) {
-                    if(abs(a) + abs(b) + abs(c) != 1) // connectivity
-                        continue;
-                    neighborhood.push_back(Vector3i(a, b, c));
-                }
-            }
+/**
+ * Frontier based growing on the host. Each frontier is split between threads, which claim voxels with an atomic
+ * or on a visited bit mask, thus every voxel is tested once and only by one thread.
+ */
+template <class T>
+void SeededRegionGrowing::executeOnHost(T* input, Image::pointer output) {
+    ImageAccess::pointer outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    uchar* outputData = (uchar*)outputAccess->get();
+    const Vector3i size(output->getWidth(), output->getHeight(), output->getDepth());
+    const uint nrOfVoxels = size.prod();
+    // initialize output to all zero
+    memset(outputData, 0, nrOfVoxels);
+    std::vector<std::atomic<uint32_t>> visited((nrOfVoxels + 31) / 32);
+    for(auto&& bits : visited)
+        bits.store(0, std::memory_order_relaxed);
+
+    auto claimAndTest = [&](uint index) {
+        const uint32_t bit = 1u << (index % 32);
+        if(visited[index / 32].fetch_or(bit, std::memory_order_relaxed) & bit)
+            return false;
+        T value = input[index];
+        if(value >= mMinimumIntensity && value <= mMaximumIntensity) {
+            // add it to segmentation
+            outputData[index] = 1;
+            return true;
         }
-    } else {
-        for(int a = -1; a < 2; a++) {
-            for(int b = -1; b < 2; b++) {
-                if(abs(a) + abs(b) != 1) // connectivity
+        return false;
+    };
+
+    std::vector<uint> frontier;
+    for(uint index : getSeedIndices(output)) {
+        if(claimAndTest(index))
+            frontier.push_back(index);
+    }
+
+    const std::vector<Vector3i> neighborhood = getNeighborhood(output->getDimensions());
+    auto growPart = [&](std::size_t start, std::size_t end, std::vector<uint>& nextFrontier) {
+        for(std::size_t i = start; i < end; ++i) {
+            const uint index = frontier[i];
+            const Vector3i pos(index % size.x(), (index / size.x()) % size.y(), index / (size.x()*size.y()));
+            for(auto&& offset : neighborhood) {
+                const Vector3i neighbor = pos + offset;
+                // Check for out of bounds
+                if(neighbor.x() < 0 || neighbor.y() < 0 || neighbor.z() < 0 ||
+                    neighbor.x() >= size.x() || neighbor.y() >= size.y() || neighbor.z() >= size.z())
                     continue;
-                neighborhood.push_back(Vector3i(a, b, 0));
+                const uint neighborIndex = neighbor.x() + (neighbor.y() + neighbor.z()*size.y())*size.x();
+                if(claimAndTest(neighborIndex))
+                    nextFrontier.push_back(neighborIndex);
             }
         }
+    };
+
+    // Small frontiers are not worth starting threads for
+    const std::size_t minimumFrontierPerThread = 4096;
+    const int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    while(!frontier.empty()) {
+        const int threads = std::min(maxThreads, (int)(frontier.size() / minimumFrontierPerThread) + 1);
+        std::vector<std::vector<uint>> nextFrontiers(threads);
+        std::vector<std::thread> workers;
+        for(int i = 1; i < threads; ++i) {
+            workers.push_back(std::thread(growPart, frontier.size()*i/threads, frontier.size()*(i + 1)/threads,
+                                          std::ref(nextFrontiers[i])));
+        }
+        growPart(0, frontier.size()/threads, nextFrontiers[0]);
+        for(auto&& worker : workers)
+            worker.join();
+
+        frontier.swap(nextFrontiers[0]);
+        for(int i = 1; i < threads; ++i)
+            frontier.insert(frontier.end(), nextFrontiers[i].begin(), nextFrontiers[i].end());
     }
+}
 
-    // Process queue
-    while(!queue.empty()) {
-        Vector3i pos = queue.top();
-        queue.pop();
-
-        // Add neighbors to queue
-        for(auto offset : neighborhood) {
-            Vector3i neighbor = pos.cast<int>() + offset;
-            // Check for out of bounds
-            if(neighbor.x() < 0 || neighbor.y() < 0 || neighbor.z() < 0 ||
-                neighbor.x() >= output->getWidth() || neighbor.y() >= output->getHeight() || neighbor.z() >= output->getDepth())
-                continue;
-
-            // Check that voxel is not already segmented
-            if(outputData[neighbor.x()+neighbor.y()*output->getWidth()+neighbor.z()*output->getWidth()*output->getHeight()] == 1)
-                continue;
-
-            // Check condition
-            T value = input[neighbor.x()+neighbor.y()*output->getWidth()+neighbor.z()*output->getWidth()*output->getHeight()];
-            if(value >= mMinimumIntensity && value <= mMaximumIntensity) {
-                // add it to segmentation
-                outputData[neighbor.x()+neighbor.y()*output->getWidth()+neighbor.z()*output->getWidth()*output->getHeight()] = 1;
-
-                // Add to queue
-                queue.push(neighbor);
-            }
+void SeededRegionGrowing::executeOnDevice(Image::pointer input, Image::pointer output) {
+    OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+    std::string buildOptions = "-DDIMENSIONS=" + std::to_string(input->getDimensions());
+    if(input->getDataType() == TYPE_FLOAT) {
+        buildOptions += " -DTYPE_FLOAT";
+    } else if(input->getDataType() == TYPE_INT8 || input->getDataType() == TYPE_INT16) {
+        buildOptions += " -DTYPE_INT";
+    } else {
+        buildOptions += " -DTYPE_UINT";
+    }
+    cl::Program program = getOpenCLProgram(device, "", buildOptions);
+    cl::CommandQueue queue = device->getCommandQueue();
+    cl::Context context = device->getContext();
+
+    const uint nrOfVoxels = output->getWidth()*output->getHeight()*output->getDepth();
+    const std::vector<uint> seeds = getSeedIndices(output);
+    // A frontier is usually a small part of the image. Voxels which don't fit are collected after the frontier
+    // has been emptied, see collectPending in the kernel.
+    const uint capacity = std::min(nrOfVoxels, std::max(1u << 20, nrOfVoxels / 16));
+    cl::Buffer frontiers[2] = {
+            cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(uint)*capacity),
+            cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(uint)*capacity)
+    };
+    const uint visitedSize = sizeof(uint)*((nrOfVoxels + 31) / 32);
+    cl::Buffer visited(context, CL_MEM_READ_WRITE, visitedSize);
+    cl::Buffer counters(context, CL_MEM_READ_WRITE, sizeof(uint)*4);
+    cl::Buffer seedBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(uint)*seeds.size(), (void*)seeds.data());
+
+    OpenCLImageAccess::pointer inputAccess = input->getOpenCLImageAccess(ACCESS_READ, device);
+    OpenCLBufferAccess::pointer outputAccess = output->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+    cl::Buffer* segmentation = outputAccess->get();
+    queue.enqueueFillBuffer(*segmentation, (uchar)0, 0, nrOfVoxels);
+    queue.enqueueFillBuffer(visited, (uint)0, 0, visitedSize);
+    queue.enqueueFillBuffer(counters, (uint)0, 0, sizeof(uint)*4);
+
+    cl::Kernel seedKernel(program, "initializeSeeds");
+    seedKernel.setArg(0, *inputAccess->get());
+    seedKernel.setArg(1, seedBuffer);
+    seedKernel.setArg(2, *segmentation);
+    seedKernel.setArg(3, visited);
+    seedKernel.setArg(4, frontiers[0]);
+    seedKernel.setArg(5, counters);
+    seedKernel.setArg(6, capacity);
+    seedKernel.setArg(7, mMinimumIntensity);
+    seedKernel.setArg(8, mMaximumIntensity);
+    queue.enqueueNDRangeKernel(seedKernel, cl::NullRange, cl::NDRange(seeds.size()), cl::NullRange);
+
+    cl::Kernel growKernel(program, "grow");
+    growKernel.setArg(0, *inputAccess->get());
+    growKernel.setArg(1, *segmentation);
+    growKernel.setArg(2, visited);
+    growKernel.setArg(5, counters);
+    growKernel.setArg(7, capacity);
+    growKernel.setArg(8, mMinimumIntensity);
+    growKernel.setArg(9, mMaximumIntensity);
+
+    cl::Kernel collectKernel(program, "collectPending");
+    collectKernel.setArg(0, *segmentation);
+    collectKernel.setArg(2, counters);
+    collectKernel.setArg(4, capacity);
+
+    // The frontier size is only known on the device, thus several iterations are enqueued between each check.
+    // Iterations with an empty frontier return immediately.
+    const int iterationsPerCheck = 16;
+    uint iteration = 0;
+    uint frontierSize = seeds.size();
+    while(true) {
+        // Each work item loops over several frontier voxels, the global size only follows the frontier size
+        const uint globalSize = std::min(std::max(frontierSize*4, 1024u), 1u << 20);
+        for(int i = 0; i < iterationsPerCheck; ++i) {
+            growKernel.setArg(3, frontiers[iteration % 2]);
+            growKernel.setArg(4, frontiers[(iteration + 1) % 2]);
+            growKernel.setArg(6, iteration);
+            queue.enqueueNDRangeKernel(growKernel, cl::NullRange, cl::NDRange(globalSize), cl::NullRange);
+            ++iteration;
         }
+
+        uint counterValues[4];
+        queue.enqueueReadBuffer(counters, CL_TRUE, 0, sizeof(uint)*4, counterValues);
+        frontierSize = std::min(counterValues[iteration % 3], capacity);
+        if(frontierSize > 0)
+            continue;
+        if(counterValues[3] == 0)
+            break;
+
+        // Restart from the voxels which did not fit in a frontier
+        const uint noOverflow = 0;
+        queue.enqueueWriteBuffer(counters, CL_FALSE, sizeof(uint)*3, sizeof(uint), &noOverflow);
+        collectKernel.setArg(1, frontiers[iteration % 2]);
+        collectKernel.setArg(3, iteration % 3);
+        queue.enqueueNDRangeKernel(collectKernel, cl::NullRange, cl::NDRange(nrOfVoxels), cl::NullRange);
+        frontierSize = capacity;
     }
+    reportInfo() << "Seeded region growing finished after " << iteration << " iterations" << reportEnd();
 }
 
 void SeededRegionGrowing::execute() {
@@ -159,70 +263,8 @@ void SeededRegionGrowing::execute() {
             fastSwitchTypeMacro(executeOnHost<FAST_TYPE>((FAST_TYPE*)inputData, output));
         }
     } else {
-        OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
-
-        recompileOpenCLCode(input);
-
-        ImageAccess::pointer access = output->getImageAccess(ACCESS_READ_WRITE);
-        uchar* outputData = (uchar*)access->get();
-        // Initialize to all 0s
-        memset(outputData,0,sizeof(uchar)*output->getWidth()*output->getHeight()*output->getDepth());
-
-        // Add sedd points
-        for(int i = 0; i < mSeedPoints.size(); i++) {
-            Vector3ui pos = mSeedPoints[i];
-
-            // Check if seed point is in bounds
-            if(pos.x() < 0 || pos.y() < 0 || pos.z() < 0 ||
-                pos.x() >= output->getWidth() || pos.y() >= output->getHeight() || pos.z() >= output->getDepth())
-                throw Exception("One of the seed points given to SeededRegionGrowing was out of bounds.");
-
-            outputData[pos.x() + pos.y()*output->getWidth() + pos.z()*output->getWidth()*output->getHeight()] = 2;
-        }
-        access->release();
-
-        cl::NDRange globalSize;
-        OpenCLImageAccess::pointer inputAccess = input->getOpenCLImageAccess(ACCESS_READ, device);
-        if(output->getDimensions() == 2) {
-            globalSize = cl::NDRange(input->getWidth(),input->getHeight());
-            mKernel.setArg(0, *inputAccess->get2DImage());
-        } else {
-            globalSize = cl::NDRange(input->getWidth(),input->getHeight(), input->getDepth());
-            mKernel.setArg(0, *inputAccess->get3DImage());
-        }
-
-        OpenCLBufferAccess::pointer outputAccess = output->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
-        cl::Buffer stopGrowingBuffer = cl::Buffer(
-                device->getContext(),
-                CL_MEM_READ_WRITE,
-                sizeof(char));
-        cl::CommandQueue queue = device->getCommandQueue();
-        mKernel.setArg(1, *outputAccess->get());
-        mKernel.setArg(2, stopGrowingBuffer);
-        mKernel.setArg(3, mMinimumIntensity);
-        mKernel.setArg(4, mMaximumIntensity);
-
-        bool stopGrowing = false;
-        char stopGrowingInit = 1;
-        char stopGrowingResult;
-        int iterations = 0;
-        do {
-            iterations++;
-            queue.enqueueWriteBuffer(stopGrowingBuffer, CL_TRUE, 0, sizeof(char), &stopGrowingInit);
-
-            queue.enqueueNDRangeKernel(
-                    mKernel,
-                    cl::NullRange,
-                    globalSize,
-                    cl::NullRange
-            );
-
-            queue.enqueueReadBuffer(stopGrowingBuffer, CL_TRUE, 0, sizeof(char), &stopGrowingResult);
-            if(stopGrowingResult == 1)
-                stopGrowing = true;
-        } while(!stopGrowing);
+        executeOnDevice(input, output);
     }
-
 }
 
 void SeededRegionGrowing::waitToFinish() {
@@ -7,6 +7,15 @@
 
 namespace fast {
 
+/**
+ * Segment the voxels connected to a set of seed points (8-connectivity in 2D and 6-connectivity in 3D) with an
+ * intensity within a given range.
+ *
+ * Growing is frontier based: only the voxels added in the previous iteration are processed, and every voxel is
+ * tested once. On OpenCL devices the frontier is an atomic work list on the device, and several iterations are
+ * run between each time the host checks whether growing has finished. On the host each frontier is processed by
+ * several threads.
+ */
 class FAST_EXPORT  SeededRegionGrowing : public ProcessObject {
     FAST_OBJECT(SeededRegionGrowing)
     public:
@@ -18,17 +27,14 @@ class FAST_EXPORT  SeededRegionGrowing : public ProcessObject {
         SeededRegionGrowing();
         void execute();
         void waitToFinish();
-        void recompileOpenCLCode(Image::pointer input);
+        std::vector<uint> getSeedIndices(Image::pointer output) const;
         template <class T>
         void executeOnHost(T* input, Image::pointer output);
+        void executeOnDevice(Image::pointer input, Image::pointer output);
 
         float mMinimumIntensity, mMaximumIntensity;
         std::vector<Vector3ui> mSeedPoints;
 
-        cl::Kernel mKernel;
-        unsigned char mDimensionCLCodeCompiledFor;
-        DataType mTypeCLCodeCompiledFor;
-
 };
 
 } // end namespace fast
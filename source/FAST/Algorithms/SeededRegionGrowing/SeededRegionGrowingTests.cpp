@@ -6,20 +6,22 @@
 
 namespace fast {
 
-TEST_CASE("2D Seeded region growing on OpenCL device", "[fast][SeededRegionGrowing]") {
-    std::vector<OpenCLDevice::pointer> devices = DeviceManager::getInstance()->getAllDevices();
-    for(int i = 0; i < devices.size(); i++) {
-        INFO("Device " << devices[i]->getName());
+TEST_CASE("2D Seeded region growing on Host and OpenCL devices", "[fast][SeededRegionGrowing]") {
+    std::vector<ExecutionDevice::pointer> devices = {Host::getInstance()};
+    for(auto&& device : DeviceManager::getInstance()->getAllDevices())
+        devices.push_back(device);
+    for(auto&& device : devices) {
+        INFO("Device " << (device->isHost() ? "Host" : std::dynamic_pointer_cast<OpenCLDevice>(device)->getName()));
         ImageFileImporter::pointer importer = ImageFileImporter::New();
         importer->setFilename(Config::getTestDataPath()+"US/Heart/ApicalFourChamber/US-2D_0.mhd");
-        importer->setMainDevice(devices[i]);
+        importer->setMainDevice(device);
 
         SeededRegionGrowing::pointer algorithm = SeededRegionGrowing::New();
         algorithm->setInputConnection(importer->getOutputPort());
         algorithm->addSeedPoint(50,50);
         algorithm->addSeedPoint(100,100);
         algorithm->setIntensityRange(26,255);
-        algorithm->setMainDevice(devices[i]);
+        algorithm->setMainDevice(device);
         auto port = algorithm->getOutputPort();
         algorithm->update();
         Segmentation::pointer result = port->getNextFrame<Segmentation>();
@@ -1,19 +1,17 @@
 #pragma once
 
-#include "FAST/ProcessObject.hpp"
+#include <FAST/Algorithms/VolumeReconstructor/VolumeReconstructor.hpp>
 
 namespace fast {
 
-class Segmentation;
-
-class FAST_EXPORT SegmentationVolumeReconstructor : public ProcessObject {
+/**
+ * Reconstruct a segmentation volume from a stream of tracked 2D segmentations, using maximum compounding.
+ * The output is always a Segmentation, also if the input frames are plain images. See VolumeReconstructor.
+ */
+class FAST_EXPORT SegmentationVolumeReconstructor : public VolumeReconstructor {
     FAST_OBJECT(SegmentationVolumeReconstructor)
-    public:
-    private:
+    protected:
         SegmentationVolumeReconstructor();
-        void execute() override;
-
-        SharedPointer<Segmentation> m_volume;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,48 @@
+// Matching metrics, same order as TemplateMatching::MatchingMetric
+#define NORMALIZED_CROSS_CORRELATION 0
+#define SUM_OF_SQUARED_DIFFERENCES 1
+#define SUM_OF_ABSOLUTE_DIFFERENCES 2
+
+// Calculate score of the template with top left corner at every position of the search window.
+// Image and template are normalized to [0, 1], and for NCC the template has zero mean.
+__kernel void templateMatching(
+        __global const float* image,
+        __private int imageWidth,
+        __global const float* templateData,
+        __private int templateWidth,
+        __private int templateHeight,
+        __private float templateSumSquares,
+        __global float* scores
+        ) {
+    const int x = get_global_id(0);
+    const int y = get_global_id(1);
+
+    float sum = 0.0f;
+    float sumSquares = 0.0f;
+    float product = 0.0f;
+    float absoluteDifference = 0.0f;
+    for(int b = 0; b < templateHeight; ++b) {
+        for(int a = 0; a < templateWidth; ++a) {
+            const float value = image[x + a + (y + b)*imageWidth];
+            const float templateValue = templateData[a + b*templateWidth];
+#if METRIC == SUM_OF_ABSOLUTE_DIFFERENCES
+            absoluteDifference += fabs(value - templateValue);
+#else
+            sum += value;
+            sumSquares += value*value;
+            product += value*templateValue;
+#endif
+        }
+    }
+
+    const float N = templateWidth*templateHeight;
+#if METRIC == NORMALIZED_CROSS_CORRELATION
+    const float variance = (sumSquares - sum*sum/N)*templateSumSquares;
+    const float score = variance > 0.0f ? product / sqrt(variance) : 0.0f;
+#elif METRIC == SUM_OF_SQUARED_DIFFERENCES
+    const float score = 1.0f - (sumSquares - 2.0f*product + templateSumSquares) / N;
+#else
+    const float score = 1.0f - absoluteDifference / N;
+#endif
+    scores[x + y*get_global_size(0)] = score;
+}
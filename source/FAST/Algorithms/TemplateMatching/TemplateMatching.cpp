@@ -1,25 +1,202 @@
 #include <FAST/Data/Image.hpp>
 #include "TemplateMatching.hpp"
+#include <eigen3/unsupported/Eigen/FFT>
 
 namespace fast {
 
+typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> ImageMatrix;
 
 TemplateMatching::TemplateMatching() {
     createInputPort<Image>(0); // Image to search in
     createInputPort<Image>(1); // Template
 
     createOutputPort<Image>(0); // Match scores
+
+    createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/TemplateMatching/TemplateMatching.cl");
+}
+
+template <class T>
+static void copyFirstChannel(const T* data, int nrOfChannels, ImageMatrix& matrix) {
+    for(int i = 0; i < matrix.size(); ++i)
+        matrix.data()[i] = (float)data[i*nrOfChannels];
+}
+
+static ImageMatrix getImageMatrix(SharedPointer<Image> image) {
+    ImageMatrix matrix(image->getHeight(), image->getWidth());
+    auto access = image->getImageAccess(ACCESS_READ);
+    switch(image->getDataType()) {
+        fastSwitchTypeMacro(copyFirstChannel<FAST_TYPE>((const FAST_TYPE*)access->get(), image->getNrOfChannels(), matrix));
+    }
+    return matrix;
+}
+
+// Average of 2x2 pixels
+static ImageMatrix downsample(const ImageMatrix& matrix) {
+    ImageMatrix result(matrix.rows() / 2, matrix.cols() / 2);
+    for(int y = 0; y < result.rows(); ++y) {
+        for(int x = 0; x < result.cols(); ++x) {
+            result(y, x) = 0.25f*(matrix(2*y, 2*x) + matrix(2*y, 2*x + 1) + matrix(2*y + 1, 2*x) + matrix(2*y + 1, 2*x + 1));
+        }
+    }
+    return result;
+}
+
+// Smallest size >= size which only has the factors 2, 3 and 5, for which the FFT is fast
+static int getFFTSize(int size) {
+    for(int n = size; ; ++n) {
+        int remainder = n;
+        for(int factor : {2, 3, 5}) {
+            while(remainder % factor == 0)
+                remainder /= factor;
+        }
+        if(remainder == 1)
+            return n;
+    }
+}
+
+static void fft2D(Eigen::MatrixXcf& data, bool inverse) {
+    Eigen::FFT<float> fft;
+    std::vector<std::complex<float>> input, output;
+    for(int y = 0; y < data.rows(); ++y) {
+        input.resize(data.cols());
+        for(int x = 0; x < data.cols(); ++x)
+            input[x] = data(y, x);
+        if(inverse) {
+            fft.inv(output, input);
+        } else {
+            fft.fwd(output, input);
+        }
+        for(int x = 0; x < data.cols(); ++x)
+            data(y, x) = output[x];
+    }
+    for(int x = 0; x < data.cols(); ++x) {
+        input.assign(data.col(x).data(), data.col(x).data() + data.rows());
+        if(inverse) {
+            fft.inv(output, input);
+        } else {
+            fft.fwd(output, input);
+        }
+        std::copy(output.begin(), output.end(), data.col(x).data());
+    }
 }
 
-static float calculateMeanIntensity(ImageAccess::pointer& access, const Vector2i start, const Vector2i size) {
-    float sum = 0;
-    for(int y = start.y(); y < start.y() + size.y(); ++y) {
-        for(int x = start.x(); x < start.x() + size.x(); ++x) {
-            sum += access->getScalar(Vector2i(x, y));
+/**
+ * Cross correlation of template and patch for every position where the template is inside the patch.
+ * Each row of the result is accumulated as a weighted sum of patch rows, which is vectorized.
+ */
+static ImageMatrix crossCorrelateDirect(const ImageMatrix& patch, const ImageMatrix& templateMatrix) {
+    const int rows = patch.rows() - templateMatrix.rows() + 1;
+    const int cols = patch.cols() - templateMatrix.cols() + 1;
+    ImageMatrix result = ImageMatrix::Zero(rows, cols);
+    for(int y = 0; y < rows; ++y) {
+        for(int b = 0; b < templateMatrix.rows(); ++b) {
+            for(int a = 0; a < templateMatrix.cols(); ++a) {
+                result.row(y) += templateMatrix(b, a)*patch.row(y + b).segment(a, cols);
+            }
         }
     }
+    return result;
+}
 
-    return sum / (size.x()*size.y());
+/**
+ * Cross correlation using the FFT. The patch is zero padded, and as only positions where the template is
+ * inside the patch are used, the circular correlation does not wrap around.
+ */
+static ImageMatrix crossCorrelateFFT(const ImageMatrix& patch, const ImageMatrix& templateMatrix) {
+    const int rows = getFFTSize(patch.rows());
+    const int cols = getFFTSize(patch.cols());
+    Eigen::MatrixXcf patchFFT = Eigen::MatrixXcf::Zero(rows, cols);
+    patchFFT.topLeftCorner(patch.rows(), patch.cols()) = patch.cast<std::complex<float>>();
+    Eigen::MatrixXcf templateFFT = Eigen::MatrixXcf::Zero(rows, cols);
+    templateFFT.topLeftCorner(templateMatrix.rows(), templateMatrix.cols()) = templateMatrix.cast<std::complex<float>>();
+    fft2D(patchFFT, false);
+    fft2D(templateFFT, false);
+    patchFFT = patchFFT.cwiseProduct(templateFFT.conjugate());
+    fft2D(patchFFT, true);
+    return patchFFT.real().topLeftCorner(patch.rows() - templateMatrix.rows() + 1, patch.cols() - templateMatrix.cols() + 1);
+}
+
+/**
+ * Calculate scores on the host for every position where the template is inside the patch.
+ * Sums and sums of squares of the image under the template are found with summed area tables,
+ * and the cross correlation with the FFT when it requires fewer operations than direct summation.
+ * SAD can't be decomposed like this and is summed directly.
+ */
+static ImageMatrix calculateScoresOnHost(const ImageMatrix& patch, const ImageMatrix& templateMatrix, TemplateMatching::MatchingMetric metric, float templateSumSquares) {
+    const int rows = patch.rows() - templateMatrix.rows() + 1;
+    const int cols = patch.cols() - templateMatrix.cols() + 1;
+    const float N = templateMatrix.size();
+    ImageMatrix scores(rows, cols);
+
+    if(metric == TemplateMatching::MatchingMetric::SUM_OF_ABSOLUTE_DIFFERENCES) {
+        scores.setZero();
+        for(int y = 0; y < rows; ++y) {
+            for(int b = 0; b < templateMatrix.rows(); ++b) {
+                for(int a = 0; a < templateMatrix.cols(); ++a) {
+                    scores.row(y).array() += (patch.row(y + b).segment(a, cols).array() - templateMatrix(b, a)).abs();
+                }
+            }
+        }
+        scores = 1.0f - scores.array() / N; // calculate average and invert
+        return scores;
+    }
+
+    const double directOperations = (double)rows*cols*N;
+    const double fftSize = (double)getFFTSize(patch.rows())*getFFTSize(patch.cols());
+    const ImageMatrix correlation = directOperations > 10.0*fftSize*std::log2(fftSize) ?
+            crossCorrelateFFT(patch, templateMatrix) : crossCorrelateDirect(patch, templateMatrix);
+
+    // Summed area tables in double precision to avoid cancellation
+    Eigen::MatrixXd sum = Eigen::MatrixXd::Zero(patch.rows() + 1, patch.cols() + 1);
+    Eigen::MatrixXd sumSquares = Eigen::MatrixXd::Zero(patch.rows() + 1, patch.cols() + 1);
+    for(int y = 0; y < patch.rows(); ++y) {
+        for(int x = 0; x < patch.cols(); ++x) {
+            const double value = patch(y, x);
+            sum(y + 1, x + 1) = value + sum(y, x + 1) + sum(y + 1, x) - sum(y, x);
+            sumSquares(y + 1, x + 1) = value*value + sumSquares(y, x + 1) + sumSquares(y + 1, x) - sumSquares(y, x);
+        }
+    }
+    const int height = templateMatrix.rows();
+    const int width = templateMatrix.cols();
+    for(int y = 0; y < rows; ++y) {
+        for(int x = 0; x < cols; ++x) {
+            const double imageSum = sum(y + height, x + width) - sum(y, x + width) - sum(y + height, x) + sum(y, x);
+            const double imageSumSquares = sumSquares(y + height, x + width) - sumSquares(y, x + width) - sumSquares(y + height, x) + sumSquares(y, x);
+            if(metric == TemplateMatching::MatchingMetric::NORMALIZED_CROSS_CORRELATION) {
+                // Template has zero mean, thus the image mean does not contribute to the correlation
+                const double variance = (imageSumSquares - imageSum*imageSum / N)*templateSumSquares;
+                scores(y, x) = variance > 0 ? correlation(y, x) / std::sqrt(variance) : 0.0f;
+            } else {
+                const double ssd = imageSumSquares - 2.0*correlation(y, x) + templateSumSquares;
+                scores(y, x) = 1.0f - ssd / N; // calculate average and invert
+            }
+        }
+    }
+    return scores;
+}
+
+static ImageMatrix calculateScoresOnDevice(const ImageMatrix& patch, const ImageMatrix& templateMatrix, float templateSumSquares, OpenCLDevice::pointer device, cl::Program program) {
+    const int rows = patch.rows() - templateMatrix.rows() + 1;
+    const int cols = patch.cols() - templateMatrix.cols() + 1;
+    auto context = device->getContext();
+    cl::Buffer patchBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(float)*patch.size(), (void*)patch.data());
+    cl::Buffer templateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(float)*templateMatrix.size(), (void*)templateMatrix.data());
+    cl::Buffer scoresBuffer(context, CL_MEM_WRITE_ONLY, sizeof(float)*rows*cols);
+
+    cl::Kernel kernel(program, "templateMatching");
+    kernel.setArg(0, patchBuffer);
+    kernel.setArg(1, (int)patch.cols());
+    kernel.setArg(2, templateBuffer);
+    kernel.setArg(3, (int)templateMatrix.cols());
+    kernel.setArg(4, (int)templateMatrix.rows());
+    kernel.setArg(5, templateSumSquares);
+    kernel.setArg(6, scoresBuffer);
+    auto queue = device->getCommandQueue();
+    queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(cols, rows), cl::NullRange);
+
+    ImageMatrix scores(rows, cols);
+    queue.enqueueReadBuffer(scoresBuffer, CL_TRUE, 0, sizeof(float)*rows*cols, scores.data());
+    return scores;
 }
 
 void TemplateMatching::execute() {
@@ -29,112 +206,86 @@ void TemplateMatching::execute() {
     if(templateImage->getWidth() % 2 == 0 || templateImage->getHeight() % 2 == 0)
         throw Exception("Template image size for template matching must be odd");
 
-    outputScores = Image::New();
-    outputScores->create(image->getSize(), TYPE_FLOAT, 1);
-    outputScores->fill(0);
-    auto outputAccess = outputScores->getImageAccess(ACCESS_READ_WRITE);
-    auto templateAccess = templateImage->getImageAccess(ACCESS_READ);
-    uchar* templatePointer = (uchar*)templateAccess->get();
-    auto imageAccess = image->getImageAccess(ACCESS_READ);
-    uchar* imagePointer = (uchar*)imageAccess->get();
-
-    float templateMean = 0.0f;
-    if(m_type == MatchingMetric::NORMALIZED_CROSS_CORRELATION)
-        templateMean = calculateMeanIntensity(templateAccess, Vector2i::Zero(), Vector2i(templateImage->getWidth(), templateImage->getHeight()));
-
-    int start_y = templateImage->getHeight();
-    int start_x = templateImage->getWidth();
-    int end_y = image->getHeight() - templateImage->getHeight();
-    int end_x = image->getWidth() - templateImage->getWidth();
+    // Intensities of both images are normalized to [0, 1] using the range of the image
+    ImageMatrix imageMatrix = getImageMatrix(image);
+    ImageMatrix templateMatrix = getImageMatrix(templateImage);
+    const float minIntensity = imageMatrix.minCoeff();
+    float intensityRange = imageMatrix.maxCoeff() - minIntensity;
+    if(intensityRange == 0.0f)
+        intensityRange = 1.0f;
+    imageMatrix = (imageMatrix.array() - minIntensity) / intensityRange;
+    templateMatrix = (templateMatrix.array() - minIntensity) / intensityRange;
+
+    // Range of top left corner positions of the template to search
+    const Vector2i halfSize(templateImage->getWidth() / 2, templateImage->getHeight() / 2);
+    Vector2i start = Vector2i::Zero();
+    Vector2i end(image->getWidth() - templateImage->getWidth(), image->getHeight() - templateImage->getHeight());
     if(m_center.x() != -1) {
-        start_x = m_center.x() - m_offset.x();
-        end_x = m_center.x() + m_offset.x();
-        start_y = m_center.y() - m_offset.y();
-        end_y = m_center.y() + m_offset.y();
+        start = start.cwiseMax(m_center - m_offset - halfSize);
+        end = end.cwiseMin(m_center + m_offset - halfSize);
     }
+    if(end.x() < start.x() || end.y() < start.y())
+        throw Exception("Region of interest for template matching is outside the image");
 
-    int halfSize_x = templateImage->getWidth() / 2;
-    int halfSize_y = templateImage->getHeight() / 2;
-    float bestMatchScore = std::numeric_limits<float>::min();
-    float maxIntensity = image->calculateMaximumIntensity();
-    float minIntensity = image->calculateMinimumIntensity();
-    // For every possible ROI position
-    switch(m_type) {
-        case MatchingMetric::NORMALIZED_CROSS_CORRELATION:
-            for (int y = start_y; y <= end_y; ++y) {
-                for (int x = start_x; x <= end_x; ++x) {
-                    float imageTargetMean = calculateMeanIntensity(imageAccess,
-                                                                   Vector2i(x - halfSize_x, y - halfSize_y),
-                                                                   Vector2i(templateImage->getWidth(),
-                                                                            templateImage->getHeight()));
-                    float upperPart = 0.0f;
-                    float lowerPart1 = 0.0f;
-                    float lowerPart2 = 0.0f;
-                    // Loop over current ROI
-                    for (int a = -halfSize_x; a <= halfSize_x; ++a) {
-                        for (int b = -halfSize_y; b <= halfSize_y; ++b) {
-                            float imagePart = (imageAccess->getScalar(Vector2i(x + a, y + b)) - imageTargetMean);
-                            float templatePart = (templateAccess->getScalar(Vector2i(a + halfSize_x, b + halfSize_y)) -
-                                                  templateMean);
-                            upperPart += imagePart * templatePart;
-                            lowerPart1 += imagePart * imagePart;
-                            lowerPart2 += templatePart * templatePart;
-                        }
-                    }
-
-                    float result = upperPart / std::sqrt(lowerPart1 * lowerPart2);
-                    outputAccess->setScalar(Vector2i(x, y), result);
-                    if (result > bestMatchScore) {
-                        bestMatchScore = result;
-                        m_bestFitPosition = Vector2i(x, y);
-                    }
-                }
-            }
-            break;
-        case MatchingMetric::SUM_OF_ABSOLUTE_DIFFERENCES:
-            for (int y = start_y; y <= end_y; ++y) {
-                for (int x = start_x; x <= end_x; ++x) {
-                    float sad = 0.0f;
-                    // Loop over current ROI
-                    for (int a = -halfSize_x; a <= halfSize_x; ++a) {
-                        for (int b = -halfSize_y; b <= halfSize_y; ++b) {
-                            float imagePart = (imagePointer[x + a + (y + b)*image->getWidth()] - minIntensity) / (maxIntensity - minIntensity);
-                            float templatePart = (templatePointer[a + halfSize_x + (b + halfSize_y)*templateImage->getWidth()] - minIntensity) / (maxIntensity - minIntensity);
-                            sad += std::fabs(imagePart - templatePart);
-                        }
-                    }
-                    const float result = 1.0f - (sad/(templateImage->getWidth()*templateImage->getHeight())); // calculate average and invert
-
-                    outputAccess->setScalar(Vector2i(x, y), result);
-                    if (result > bestMatchScore) {
-                        bestMatchScore = result;
-                        m_bestFitPosition = Vector2i(x, y);
-                    }
-                }
-            }
-            break;
-        case MatchingMetric::SUM_OF_SQUARED_DIFFERENCES:
-            for (int y = start_y; y <= end_y; ++y) {
-                for (int x = start_x; x <= end_x; ++x) {
-                    float ssd = 0.0f;
-                    // Loop over current ROI
-                    for (int a = -halfSize_x; a <= halfSize_x; ++a) {
-                        for (int b = -halfSize_y; b <= halfSize_y; ++b) {
-                            float imagePart = (imageAccess->getScalar(Vector2i(x + a, y + b)) - minIntensity) / (maxIntensity - minIntensity);
-                            float templatePart = (templateAccess->getScalar(Vector2i(a + halfSize_x, b + halfSize_y)) - minIntensity) / (maxIntensity - minIntensity);
-                            ssd += (imagePart - templatePart)*(imagePart - templatePart);
-                        }
-                    }
-                    const float result = 1.0f - (ssd/(templateImage->getWidth()*templateImage->getHeight())); // calculate average and invert
-
-                    outputAccess->setScalar(Vector2i(x, y), result);
-                    if (result > bestMatchScore) {
-                        bestMatchScore = result;
-                        m_bestFitPosition = Vector2i(x, y);
-                    }
-                }
-            }
+    std::vector<ImageMatrix> images = {imageMatrix};
+    std::vector<ImageMatrix> templates = {templateMatrix};
+    for(int level = 1; level < m_pyramidLevels; ++level) {
+        // Stop when the template becomes too small to be matched
+        if(templates.back().rows() < 6 || templates.back().cols() < 6)
             break;
+        images.push_back(downsample(images.back()));
+        templates.push_back(downsample(templates.back()));
+    }
+
+    // Search the coarsest level in the entire region, then only around the best position of the previous level
+    ImageMatrix scores;
+    Vector2i levelStart, best;
+    for(int level = images.size() - 1; level >= 0; --level) {
+        const ImageMatrix& levelImage = images[level];
+        ImageMatrix levelTemplate = templates[level];
+        levelStart = Vector2i(start.x() >> level, start.y() >> level);
+        Vector2i levelEnd(end.x() >> level, end.y() >> level);
+        levelEnd = levelEnd.cwiseMin(Vector2i(levelImage.cols() - levelTemplate.cols(), levelImage.rows() - levelTemplate.rows()));
+        if(level < images.size() - 1) {
+            const int radius = 2;
+            levelStart = levelStart.cwiseMax(best*2 - Vector2i(radius, radius));
+            levelEnd = levelEnd.cwiseMin(best*2 + Vector2i(radius, radius));
+            levelStart = levelStart.cwiseMin(levelEnd);
+        }
+
+        if(m_type == MatchingMetric::NORMALIZED_CROSS_CORRELATION)
+            levelTemplate = levelTemplate.array() - levelTemplate.mean();
+        const float templateSumSquares = levelTemplate.squaredNorm();
+        const Vector2i size = levelEnd - levelStart + Vector2i(levelTemplate.cols(), levelTemplate.rows());
+        const ImageMatrix patch = levelImage.block(levelStart.y(), levelStart.x(), size.y(), size.x());
+
+        // The OpenCL kernel is only used when there is enough work to hide the transfer and launch overhead
+        const double operations = (double)(levelEnd - levelStart + Vector2i(1, 1)).prod()*levelTemplate.size();
+        if(!getMainDevice()->isHost() && operations >= 1 << 20) {
+            auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+            const std::string buildOptions = "-DMETRIC=" + std::to_string((int)m_type);
+            scores = calculateScoresOnDevice(patch, levelTemplate, templateSumSquares, device, getOpenCLProgram(device, "", buildOptions));
+        } else {
+            scores = calculateScoresOnHost(patch, levelTemplate, m_type, templateSumSquares);
+        }
+
+        Eigen::Index bestX, bestY;
+        scores.maxCoeff(&bestY, &bestX);
+        best = levelStart + Vector2i(bestX, bestY);
+    }
+    m_bestFitPosition = best + halfSize;
+
+    // Scores are stored at the center position of the template
+    outputScores = Image::New();
+    outputScores->create(image->getSize(), TYPE_FLOAT, 1);
+    outputScores->fill(0);
+    {
+        auto outputAccess = outputScores->getImageAccess(ACCESS_READ_WRITE);
+        float* outputData = (float*)outputAccess->get();
+        for(int y = 0; y < scores.rows(); ++y) {
+            const Vector2i position = levelStart + halfSize + Vector2i(0, y);
+            std::copy(scores.row(y).data(), scores.row(y).data() + scores.cols(), &outputData[position.x() + position.y()*image->getWidth()]);
+        }
     }
 
     addOutputData(0, outputScores);
@@ -157,6 +308,13 @@ void TemplateMatching::setMatchingMetric(MatchingMetric type) {
     m_type = type;
 }
 
+void TemplateMatching::setPyramidLevels(int levels) {
+    if(levels < 1)
+        throw Exception("Number of pyramid levels in template matching must be at least 1");
+    m_pyramidLevels = levels;
+    setModified(true);
+}
+
 Vector2f TemplateMatching::getBestFitSubPixelPosition() const {
     if(outputScores) {
         // Calculate subpixel offset
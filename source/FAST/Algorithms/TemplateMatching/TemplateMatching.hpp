@@ -9,6 +9,10 @@ class Image;
 /**
  * This algorithms matches a template image to an image using normalized cross correlation (NCC),
  * sum of absolute differences (SAD) or sum of squared differences (SSD).
+ *
+ * On the host, NCC and SSD use summed area tables for the sums under the template, and the FFT for the cross
+ * correlation with large templates. When the main device is an OpenCL device and the search is large enough,
+ * all positions are matched in parallel by an OpenCL kernel.
  */
 class FAST_EXPORT TemplateMatching : public ProcessObject {
     FAST_OBJECT(TemplateMatching)
@@ -39,6 +43,13 @@ class FAST_EXPORT TemplateMatching : public ProcessObject {
          * @param type
          */
         void setMatchingMetric(MatchingMetric type);
+        /**
+         * Search coarse to fine in an image pyramid with the given number of levels, each half the size of the
+         * previous. The entire region of interest is only searched at the coarsest level, while the finer levels
+         * are searched 2 pixels around the best position of the previous level. Default is 1, i.e. no pyramid.
+         * @param levels
+         */
+        void setPyramidLevels(int levels);
     private:
         TemplateMatching();
         void execute() override;
@@ -47,6 +58,7 @@ class FAST_EXPORT TemplateMatching : public ProcessObject {
         Vector2i m_center = Vector2i(-1, -1);
         Vector2i m_offset;
         Vector2i m_bestFitPosition;
+        int m_pyramidLevels = 1;
         SharedPointer<Image> outputScores;
 
 };
@@ -99,3 +99,80 @@ TEST_CASE("Template matching NCC synthetic sequence", "[fast][NCC][TemplateMatch
         position = newPosition.cast<int>();
     }
 }
+
+static Image::pointer createBlobImage(int width, int height) {
+    std::vector<float> data(width*height);
+    const Vector2f blobs[] = {Vector2f(30, 20), Vector2f(75, 60), Vector2f(100, 30)};
+    for(int y = 0; y < height; ++y) {
+        for(int x = 0; x < width; ++x) {
+            float value = 0.3f*x + 0.2f*y;
+            for(auto&& blob : blobs)
+                value += 100.0f*std::exp(-(Vector2f(x, y) - blob).squaredNorm() / (2.0f*8.0f*8.0f));
+            data[x + y*width] = value;
+        }
+    }
+    auto image = Image::New();
+    image->create(width, height, TYPE_FLOAT, 1, data.data());
+    return image;
+}
+
+TEST_CASE("Template matching finds template with all metrics, with and without pyramid", "[fast][TemplateMatching]") {
+    auto image = createBlobImage(128, 96);
+    const Vector2i position(77, 57);
+    for(int size : {11, 41}) { // Large template uses FFT for NCC and SSD
+        auto templateImage = image->crop(position - Vector2i(size/2, size/2), Vector2i(size, size));
+        for(auto metric : {TemplateMatching::MatchingMetric::NORMALIZED_CROSS_CORRELATION,
+                           TemplateMatching::MatchingMetric::SUM_OF_SQUARED_DIFFERENCES,
+                           TemplateMatching::MatchingMetric::SUM_OF_ABSOLUTE_DIFFERENCES}) {
+            for(int levels : {1, 3}) {
+                auto matching = TemplateMatching::New();
+                matching->setMainDevice(Host::getInstance());
+                matching->setMatchingMetric(metric);
+                matching->setPyramidLevels(levels);
+                matching->setInputData(0, image);
+                matching->setInputData(1, templateImage);
+                auto scores = matching->updateAndGetOutputData<Image>();
+                CHECK(matching->getBestFitPixelPosition() == position);
+                auto access = scores->getImageAccess(ACCESS_READ);
+                CHECK(access->getScalar(position) == Approx(1.0f).margin(0.001));
+            }
+        }
+    }
+}
+
+TEST_CASE("Template matching on OpenCL device gives same scores as Host", "[fast][TemplateMatching]") {
+    auto image = createBlobImage(128, 96);
+    const Vector2i position(77, 57);
+    for(int size : {11, 41}) {
+        auto templateImage = image->crop(position - Vector2i(size/2, size/2), Vector2i(size, size));
+        for(auto metric : {TemplateMatching::MatchingMetric::NORMALIZED_CROSS_CORRELATION,
+                           TemplateMatching::MatchingMetric::SUM_OF_SQUARED_DIFFERENCES,
+                           TemplateMatching::MatchingMetric::SUM_OF_ABSOLUTE_DIFFERENCES}) {
+            for(int levels : {1, 3}) {
+                Image::pointer scores[2];
+                Vector2i bestFit[2];
+                for(int i = 0; i < 2; ++i) {
+                    auto matching = TemplateMatching::New();
+                    if(i == 1)
+                        matching->setMainDevice(Host::getInstance());
+                    matching->setMatchingMetric(metric);
+                    matching->setPyramidLevels(levels);
+                    matching->setInputData(0, image);
+                    matching->setInputData(1, templateImage);
+                    scores[i] = matching->updateAndGetOutputData<Image>();
+                    bestFit[i] = matching->getBestFitPixelPosition();
+                }
+                CHECK(bestFit[0] == bestFit[1]);
+                REQUIRE(scores[0]->getSize() == scores[1]->getSize());
+                auto accessCL = scores[0]->getImageAccess(ACCESS_READ);
+                auto accessHost = scores[1]->getImageAccess(ACCESS_READ);
+                const float* dataCL = (const float*)accessCL->get();
+                const float* dataHost = (const float*)accessHost->get();
+                float maxDifference = 0.0f;
+                for(int j = 0; j < scores[0]->getWidth()*scores[0]->getHeight(); ++j)
+                    maxDifference = std::max(maxDifference, std::fabs(dataCL[j] - dataHost[j]));
+                CHECK(maxDifference < 0.001f);
+            }
+        }
+    }
+}
@@ -8,6 +8,7 @@ ImageMovingAverage::ImageMovingAverage() {
     createOutputPort<Image>(0);
 
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/TemporalSmoothing/ImageMovingAverage.cl");
+    declareOpenCLProgramBuildOptions();
 
     m_frameCount = 10;
     m_keepDataType = false;
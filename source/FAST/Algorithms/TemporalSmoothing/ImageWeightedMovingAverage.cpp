@@ -8,6 +8,7 @@ ImageWeightedMovingAverage::ImageWeightedMovingAverage() {
     createOutputPort<Image>(0);
 
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/TemporalSmoothing/ImageWeightedMovingAverage.cl");
+    declareOpenCLProgramBuildOptions();
 
     m_frameCount = 10;
     m_keepDataType = false;
@@ -11,6 +11,7 @@ TissueSegmentation::TissueSegmentation() {
     createOutputPort<Segmentation>(0);
 
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/TissueSegmentation/TissueSegmentation.cl");
+    declareOpenCLProgramBuildOptions();
 }
 
 void TissueSegmentation::execute() {
@@ -19,6 +19,8 @@ TubeSegmentationAndCenterlineExtraction::TubeSegmentationAndCenterlineExtraction
     createOutputPort<Image>(2);
 
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/TubeSegmentationAndCenterlineExtraction/TubeSegmentationAndCenterlineExtraction.cl");
+    declareOpenCLProgramBuildOptions();
+    declareOpenCLProgramBuildOptions("", "-DVECTORS_16BIT");
 
     mSensitivity = 0.5;
     mMinimumRadius = 1;
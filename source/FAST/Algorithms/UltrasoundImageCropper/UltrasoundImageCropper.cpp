@@ -11,6 +11,7 @@ UltrasoundImageCropper::UltrasoundImageCropper() {
     createOutputPort<Image>(0);
 
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/UltrasoundImageCropper/UltrasoundImageCropper.cl");
+    declareOpenCLProgramBuildOptions();
 }
 
 void UltrasoundImageCropper::execute() {
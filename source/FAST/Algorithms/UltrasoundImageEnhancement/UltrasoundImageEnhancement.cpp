@@ -10,6 +10,7 @@ UltrasoundImageEnhancement::UltrasoundImageEnhancement() {
     createOutputPort<Image>(0);
 
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/UltrasoundImageEnhancement/UltrasoundImageEnhancement.cl");
+    declareOpenCLProgramBuildOptions();
 
     createIntegerAttribute("reject", "Reject", "How many intensity values at bottom to reject.", 40);
 
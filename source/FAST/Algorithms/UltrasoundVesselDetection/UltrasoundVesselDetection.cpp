@@ -23,6 +23,7 @@ namespace fast {
         createOutputPort<Segmentation>(0);
         createOutputPort<VesselCrossSection>(1, OUTPUT_STATIC, 0, true);
         createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/UltrasoundVesselDetection/UltrasoundVesselDetection.cl");
+        declareOpenCLProgramBuildOptions();
         mCreateSegmentation = false;
 
         mClassifier = ImageClassifier::New();
@@ -15,6 +15,7 @@ namespace fast {
         mDetector = UltrasoundVesselDetection::New();
         mFramesToKeep = 10;
         createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/UltrasoundVesselDetection/UltrasoundVesselDetection.cl");
+        declareOpenCLProgramBuildOptions();
     }
 
     void UltrasoundVesselSegmentation::execute() {
@@ -9,6 +9,7 @@ VectorMedianFilter::VectorMedianFilter() {
     createOutputPort<Image>(0);
 
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/VectorMedianFilter/VectorMedianFilter.cl");
+    declareOpenCLProgramBuildOptions();
 
     createIntegerAttribute("window-size", "Window size", "Size of area to perform median filter on", m_windowSize);
 }
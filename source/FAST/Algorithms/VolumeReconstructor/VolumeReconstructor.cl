@@ -0,0 +1,174 @@
+__constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
+
+// Compounding modes, same order as VolumeReconstructor::CompoundingMode
+#define MAXIMUM 0
+#define MEAN 1
+#define WEIGHTED 2
+
+// The brick pool stores value and weight of each voxel. With maximum compounding the value is the maximum,
+// otherwise the weighted sum.
+
+float getIntensity(__read_only image2d_t image, int2 pos) {
+    float value;
+    int dataType = get_image_channel_data_type(image);
+    if(dataType == CLK_FLOAT) {
+        value = read_imagef(image, sampler, pos).x;
+    } else if(dataType == CLK_UNSIGNED_INT8 || dataType == CLK_UNSIGNED_INT16) {
+        value = read_imageui(image, sampler, pos).x;
+    } else {
+        value = read_imagei(image, sampler, pos).x;
+    }
+    return value;
+}
+
+void atomicAddFloat(volatile __global float* address, float value) {
+    union { uint i; float f; } old, new;
+    do {
+        old.f = *address;
+        new.f = old.f + value;
+    } while(atomic_cmpxchg((volatile __global uint*)address, old.i, new.i) != old.i);
+}
+
+void atomicMaxFloat(volatile __global float* address, float value) {
+    union { uint i; float f; } old, new;
+    do {
+        old.f = *address;
+        if(old.f >= value)
+            return;
+        new.f = value;
+    } while(atomic_cmpxchg((volatile __global uint*)address, old.i, new.i) != old.i);
+}
+
+int floorDivide(int a, int b) {
+    return a >= 0 ? a / b : (a - b + 1) / b;
+}
+
+// Index of the value of a voxel in the brick pool, or -1 if its brick is not allocated.
+// bricks has the pool index of each brick in a grid of bricks starting at brick gridOffset.
+int getPoolIndex(int3 voxel, __global const int* bricks, int3 gridOffset, int3 gridSize) {
+    const int3 brick = (int3)(floorDivide(voxel.x, BRICK_SIZE), floorDivide(voxel.y, BRICK_SIZE), floorDivide(voxel.z, BRICK_SIZE));
+    const int3 gridPosition = brick - gridOffset;
+    if(any(gridPosition < 0) || any(gridPosition >= gridSize))
+        return -1;
+    const int brickIndex = bricks[gridPosition.x + (gridPosition.y + gridPosition.z*gridSize.y)*gridSize.x];
+    if(brickIndex < 0)
+        return -1;
+    const int3 local = voxel - brick*BRICK_SIZE;
+    return 2*(brickIndex*BRICK_SIZE*BRICK_SIZE*BRICK_SIZE + local.x + (local.y + local.z*BRICK_SIZE)*BRICK_SIZE);
+}
+
+float getCompoundedValue(__global const float* pool, int index) {
+#if COMPOUNDING == MAXIMUM
+    return pool[index];
+#else
+    return pool[index] / pool[index + 1];
+#endif
+}
+
+__kernel void splatFrame(
+        __read_only image2d_t frame,
+        __global float* pool,
+        __global const int* bricks,
+        __private int offsetX,
+        __private int offsetY,
+        __private int offsetZ,
+        __private int sizeX,
+        __private int sizeY,
+        __private int sizeZ,
+        __constant float* transform
+        ) {
+    const int2 pixel = {get_global_id(0), get_global_id(1)};
+    const int3 gridOffset = {offsetX, offsetY, offsetZ};
+    const int3 gridSize = {sizeX, sizeY, sizeZ};
+    const float value = getIntensity(frame, pixel);
+
+    // Pixel to voxel position, transform is column major
+    const float3 position = {
+            transform[0]*pixel.x + transform[4]*pixel.y + transform[12],
+            transform[1]*pixel.x + transform[5]*pixel.y + transform[13],
+            transform[2]*pixel.x + transform[6]*pixel.y + transform[14]
+    };
+
+#if COMPOUNDING == WEIGHTED
+    const float3 base = floor(position);
+    const float3 fraction = position - base;
+    for(int i = 0; i < 8; ++i) {
+        const int3 corner = {i & 1, (i >> 1) & 1, (i >> 2) & 1};
+        const float weight = (corner.x ? fraction.x : 1.0f - fraction.x)*
+                             (corner.y ? fraction.y : 1.0f - fraction.y)*
+                             (corner.z ? fraction.z : 1.0f - fraction.z);
+        if(weight <= 0.0f)
+            continue;
+        const int index = getPoolIndex(convert_int3(base) + corner, bricks, gridOffset, gridSize);
+        if(index < 0)
+            continue;
+        atomicAddFloat(&pool[index], weight*value);
+        atomicAddFloat(&pool[index + 1], weight);
+    }
+#else
+    const int index = getPoolIndex(convert_int3_rte(position), bricks, gridOffset, gridSize);
+    if(index < 0)
+        return;
+#if COMPOUNDING == MAXIMUM
+    atomicMaxFloat(&pool[index], value);
+#else
+    atomicAddFloat(&pool[index], value);
+#endif
+    atomicAddFloat(&pool[index + 1], 1.0f);
+#endif
+}
+
+// Create a dense volume of all allocated bricks. Voxels which no pixel hit are filled from their neighbors.
+// The kernel may be run on a region of the volume with a global offset. The volume covers the grid of bricks given
+// by the offset and size, bricks which are not allocated give zero.
+__kernel void createVolume(
+        __global const float* pool,
+        __global const int* bricks,
+        __private int offsetX,
+        __private int offsetY,
+        __private int offsetZ,
+        __private int sizeX,
+        __private int sizeY,
+        __private int sizeZ,
+        __global DATA_TYPE* volume
+        ) {
+    const int3 position = {get_global_id(0), get_global_id(1), get_global_id(2)};
+    const int3 gridOffset = {offsetX, offsetY, offsetZ};
+    const int3 gridSize = {sizeX, sizeY, sizeZ};
+    const int3 voxel = position + gridOffset*BRICK_SIZE;
+
+    float value = 0.0f;
+    const int index = getPoolIndex(voxel, bricks, gridOffset, gridSize);
+    if(index >= 0 && pool[index + 1] > 0.0f) {
+        value = getCompoundedValue(pool, index);
+    } else if(index >= 0) {
+#if HOLE_FILLING_RADIUS > 0
+        float sum = 0.0f;
+        int count = 0;
+        for(int z = -HOLE_FILLING_RADIUS; z <= HOLE_FILLING_RADIUS; ++z) {
+            for(int y = -HOLE_FILLING_RADIUS; y <= HOLE_FILLING_RADIUS; ++y) {
+                for(int x = -HOLE_FILLING_RADIUS; x <= HOLE_FILLING_RADIUS; ++x) {
+                    const int neighborIndex = getPoolIndex(voxel + (int3)(x, y, z), bricks, gridOffset, gridSize);
+                    if(neighborIndex < 0 || pool[neighborIndex + 1] <= 0.0f)
+                        continue;
+#if COMPOUNDING == MAXIMUM
+                    sum = max(sum, getCompoundedValue(pool, neighborIndex));
+#else
+                    sum += getCompoundedValue(pool, neighborIndex);
+#endif
+                    ++count;
+                }
+            }
+        }
+#if COMPOUNDING == MAXIMUM
+        value = sum;
+#else
+        if(count > 0)
+            value = sum / count;
+#endif
+#endif
+    }
+    const int width = sizeX*BRICK_SIZE;
+    const int height = sizeY*BRICK_SIZE;
+    volume[position.x + (position.y + position.z*height)*width] = CONVERT(value);
+}
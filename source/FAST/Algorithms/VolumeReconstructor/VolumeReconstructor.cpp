@@ -0,0 +1,424 @@
+#include "VolumeReconstructor.hpp"
+#include <FAST/Data/Image.hpp>
+#include <FAST/Data/Segmentation.hpp>
+#include <FAST/SceneGraph.hpp>
+#include <limits>
+
+namespace fast {
+
+// Voxels along each side of a brick, must match BRICK_SIZE in the kernels
+static const int brickSize = 16;
+static const int voxelsPerBrick = brickSize*brickSize*brickSize;
+
+static int floorDivide(int a, int b) {
+    return a >= 0 ? a / b : (a - b + 1) / b;
+}
+
+static int64_t getBrickKey(const Vector3i& brick) {
+    // 21 bits for each coordinate
+    const int64_t offset = 1 << 20;
+    return (brick.x() + offset) | ((brick.y() + offset) << 21) | ((brick.z() + offset) << 42);
+}
+
+VolumeReconstructor::VolumeReconstructor() {
+    createInputPort<Image>(0);
+    createOutputPort<Image>(0);
+    createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/VolumeReconstructor/VolumeReconstructor.cl");
+}
+
+void VolumeReconstructor::setCompoundingMode(CompoundingMode mode) {
+    // The bricks already splatted were compounded with the previous mode
+    if(m_initialized && mode != m_compounding)
+        reset();
+    m_compounding = mode;
+    m_compoundingSet = true;
+    setModified(true);
+}
+
+void VolumeReconstructor::setVoxelSpacing(float spacing) {
+    if(spacing <= 0)
+        throw Exception("Voxel spacing must be larger than 0 in VolumeReconstructor");
+    if(m_initialized && spacing != m_spacing)
+        reset();
+    m_voxelSpacing = spacing;
+    setModified(true);
+}
+
+void VolumeReconstructor::setHoleFillingRadius(int radius) {
+    if(radius < 0)
+        throw Exception("Hole filling radius can't be negative in VolumeReconstructor");
+    if(m_initialized && radius != m_holeFillingRadius)
+        reset();
+    m_holeFillingRadius = radius;
+    setModified(true);
+}
+
+void VolumeReconstructor::reset() {
+    m_initialized = false;
+    m_brickIndices.clear();
+    m_poolCapacity = 0;
+    m_pool = cl::Buffer();
+    m_hostPool.clear();
+    m_volume.reset();
+}
+
+/**
+ * Allocate all bricks within the bounding box of the frame which are close enough to the plane of the frame to be
+ * hit by a pixel. Returns the range of bricks covering the frame.
+ */
+void VolumeReconstructor::allocateBricks(const Affine3f& pixelToVoxel, const Vector2i& frameSize,
+                                         Vector3i& frameGridMin, Vector3i& frameGridMax) {
+    Vector3f minimum = Vector3f::Constant(std::numeric_limits<float>::max());
+    Vector3f maximum = Vector3f::Constant(std::numeric_limits<float>::lowest());
+    for(int corner = 0; corner < 4; ++corner) {
+        const Vector3f pixel((corner & 1)*(frameSize.x() - 1), (corner >> 1)*(frameSize.y() - 1), 0);
+        const Vector3f position = pixelToVoxel*pixel;
+        minimum = minimum.cwiseMin(position);
+        maximum = maximum.cwiseMax(position);
+    }
+    // Splatting reaches the voxels surrounding each position
+    for(int i = 0; i < 3; ++i) {
+        frameGridMin[i] = floorDivide((int)std::floor(minimum[i]) - 1, brickSize);
+        frameGridMax[i] = floorDivide((int)std::ceil(maximum[i]) + 1, brickSize);
+    }
+
+    const Vector3f origin = pixelToVoxel*Vector3f::Zero();
+    const Vector3f normal = (pixelToVoxel.linear()*Vector3f::UnitX()).cross(pixelToVoxel.linear()*Vector3f::UnitY()).normalized();
+    // Half diagonal of a brick grown by the one voxel a splatted position reaches in each direction
+    const float reach = std::sqrt(3.0f)*((brickSize - 1)/2.0f + 1.0f);
+    for(int z = frameGridMin.z(); z <= frameGridMax.z(); ++z) {
+        for(int y = frameGridMin.y(); y <= frameGridMax.y(); ++y) {
+            for(int x = frameGridMin.x(); x <= frameGridMax.x(); ++x) {
+                const Vector3i brick(x, y, z);
+                const Vector3f center = (brick*brickSize).cast<float>() + Vector3f::Constant((brickSize - 1)/2.0f);
+                if(std::fabs(normal.dot(center - origin)) > reach)
+                    continue;
+                const int64_t key = getBrickKey(brick);
+                if(m_brickIndices.count(key) > 0)
+                    continue;
+                if(m_brickIndices.empty()) {
+                    m_gridMin = brick;
+                    m_gridMax = brick;
+                }
+                const int index = m_brickIndices.size();
+                m_brickIndices[key] = index;
+                m_gridMin = m_gridMin.cwiseMin(brick);
+                m_gridMax = m_gridMax.cwiseMax(brick);
+            }
+        }
+    }
+}
+
+// Pool index of every brick in a range of bricks, -1 for bricks which are not allocated
+std::vector<int> VolumeReconstructor::getBrickTable(const Vector3i& gridMin, const Vector3i& gridMax) const {
+    const Vector3i size = gridMax - gridMin + Vector3i::Ones();
+    std::vector<int> table(size.prod(), -1);
+    int i = 0;
+    for(int z = gridMin.z(); z <= gridMax.z(); ++z) {
+        for(int y = gridMin.y(); y <= gridMax.y(); ++y) {
+            for(int x = gridMin.x(); x <= gridMax.x(); ++x) {
+                auto brick = m_brickIndices.find(getBrickKey(Vector3i(x, y, z)));
+                if(brick != m_brickIndices.end())
+                    table[i] = brick->second;
+                ++i;
+            }
+        }
+    }
+    return table;
+}
+
+void VolumeReconstructor::resizePool(int capacity) {
+    const std::size_t size = sizeof(float)*2*voxelsPerBrick*(std::size_t)capacity;
+    if(getMainDevice()->isHost()) {
+        m_hostPool.resize(2*voxelsPerBrick*(std::size_t)capacity, 0.0f);
+    } else {
+        auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+        if(size > device->getDevice().getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>())
+            throw Exception("The reconstructed volume is too large for the device in VolumeReconstructor");
+        auto queue = device->getCommandQueue();
+        cl::Buffer pool(device->getContext(), CL_MEM_READ_WRITE, size);
+        queue.enqueueFillBuffer(pool, 0.0f, 0, size);
+        if(m_poolCapacity > 0)
+            queue.enqueueCopyBuffer(m_pool, pool, 0, 0, sizeof(float)*2*voxelsPerBrick*(std::size_t)m_poolCapacity);
+        m_pool = pool;
+    }
+    m_poolCapacity = capacity;
+}
+
+static std::string getBuildOptions(VolumeReconstructor::CompoundingMode mode, DataType type, int holeFillingRadius) {
+    std::string options = "-DBRICK_SIZE=" + std::to_string(brickSize) +
+            " -DCOMPOUNDING=" + std::to_string((int)mode) +
+            " -DHOLE_FILLING_RADIUS=" + std::to_string(holeFillingRadius) +
+            " -DDATA_TYPE=" + getCTypeAsString(type);
+    if(type == TYPE_FLOAT) {
+        options += " -DCONVERT=";
+    } else {
+        options += " -DCONVERT=convert_" + getCTypeAsString(type) + "_sat_rte";
+    }
+    return options;
+}
+
+void VolumeReconstructor::splatFrameOnDevice(SharedPointer<Image> frame, const Affine3f& pixelToVoxel,
+                                             const Vector3i& gridMin, const Vector3i& gridMax) {
+    auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+    cl::Program program = getOpenCLProgram(device, "", getBuildOptions(m_compounding, m_dataType, m_holeFillingRadius));
+    auto queue = device->getCommandQueue();
+
+    const std::vector<int> table = getBrickTable(gridMin, gridMax);
+    const Vector3i gridSize = gridMax - gridMin + Vector3i::Ones();
+    cl::Buffer tableBuffer(device->getContext(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(int)*table.size(), (void*)table.data());
+    cl::Buffer transformBuffer(device->getContext(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, 16*sizeof(float), (void*)pixelToVoxel.data());
+
+    auto frameAccess = frame->getOpenCLImageAccess(ACCESS_READ, device);
+    cl::Kernel kernel(program, "splatFrame");
+    kernel.setArg(0, *frameAccess->get2DImage());
+    kernel.setArg(1, m_pool);
+    kernel.setArg(2, tableBuffer);
+    for(int i = 0; i < 3; ++i) {
+        kernel.setArg(3 + i, gridMin[i]);
+        kernel.setArg(6 + i, gridSize[i]);
+    }
+    kernel.setArg(9, transformBuffer);
+    queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(frame->getWidth(), frame->getHeight()), cl::NullRange);
+}
+
+template <class T>
+static void loadFrame(const void* data, std::size_t size, std::vector<float>& values) {
+    const T* input = (const T*)data;
+    values.resize(size);
+    for(std::size_t i = 0; i < size; ++i)
+        values[i] = (float)input[i];
+}
+
+// Same as getPoolIndex in the kernels
+static int getPoolIndex(const Vector3i& voxel, const std::vector<int>& bricks, const Vector3i& gridOffset, const Vector3i& gridSize) {
+    const Vector3i brick(floorDivide(voxel.x(), brickSize), floorDivide(voxel.y(), brickSize), floorDivide(voxel.z(), brickSize));
+    const Vector3i gridPosition = brick - gridOffset;
+    if((gridPosition.array() < 0).any() || (gridPosition.array() >= gridSize.array()).any())
+        return -1;
+    const int brickIndex = bricks[gridPosition.x() + (gridPosition.y() + gridPosition.z()*gridSize.y())*gridSize.x()];
+    if(brickIndex < 0)
+        return -1;
+    const Vector3i local = voxel - brick*brickSize;
+    return 2*(brickIndex*voxelsPerBrick + local.x() + (local.y() + local.z()*brickSize)*brickSize);
+}
+
+void VolumeReconstructor::splatFrameOnHost(SharedPointer<Image> frame, const Affine3f& pixelToVoxel,
+                                           const Vector3i& gridMin, const Vector3i& gridMax) {
+    const std::vector<int> table = getBrickTable(gridMin, gridMax);
+    const Vector3i gridSize = gridMax - gridMin + Vector3i::Ones();
+    std::vector<float> values;
+    {
+        auto access = frame->getImageAccess(ACCESS_READ);
+        switch(frame->getDataType()) {
+            fastSwitchTypeMacro(loadFrame<FAST_TYPE>(access->get(), frame->getWidth()*frame->getHeight(), values))
+        }
+    }
+
+    float* pool = m_hostPool.data();
+    for(int y = 0; y < frame->getHeight(); ++y) {
+        for(int x = 0; x < frame->getWidth(); ++x) {
+            const float value = values[x + y*frame->getWidth()];
+            const Vector3f position = pixelToVoxel*Vector3f(x, y, 0);
+            if(m_compounding == CompoundingMode::WEIGHTED) {
+                const Vector3f base = position.array().floor();
+                const Vector3f fraction = position - base;
+                for(int i = 0; i < 8; ++i) {
+                    const Vector3i corner(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+                    const float weight = (corner.x() ? fraction.x() : 1.0f - fraction.x())*
+                                         (corner.y() ? fraction.y() : 1.0f - fraction.y())*
+                                         (corner.z() ? fraction.z() : 1.0f - fraction.z());
+                    if(weight <= 0.0f)
+                        continue;
+                    const int index = getPoolIndex(base.cast<int>() + corner, table, gridMin, gridSize);
+                    if(index < 0)
+                        continue;
+                    pool[index] += weight*value;
+                    pool[index + 1] += weight;
+                }
+            } else {
+                const Vector3i voxel(std::nearbyint(position.x()), std::nearbyint(position.y()), std::nearbyint(position.z()));
+                const int index = getPoolIndex(voxel, table, gridMin, gridSize);
+                if(index < 0)
+                    continue;
+                if(m_compounding == CompoundingMode::MAXIMUM) {
+                    pool[index] = std::max(pool[index], value);
+                } else {
+                    pool[index] += value;
+                }
+                pool[index + 1] += 1.0f;
+            }
+        }
+    }
+}
+
+void VolumeReconstructor::createVolumeOnDevice(SharedPointer<Image> volume, const Vector3i& start, const Vector3i& end) {
+    auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+    cl::Program program = getOpenCLProgram(device, "", getBuildOptions(m_compounding, m_dataType, m_holeFillingRadius));
+
+    // Bricks of the volume outside the grid are not allocated, and give zero
+    const std::vector<int> table = getBrickTable(m_volumeMin, m_volumeMax);
+    const Vector3i gridSize = m_volumeMax - m_volumeMin + Vector3i::Ones();
+    cl::Buffer tableBuffer(device->getContext(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(int)*table.size(), (void*)table.data());
+
+    auto volumeAccess = volume->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+    cl::Kernel kernel(program, "createVolume");
+    kernel.setArg(0, m_pool);
+    kernel.setArg(1, tableBuffer);
+    for(int i = 0; i < 3; ++i) {
+        kernel.setArg(2 + i, m_volumeMin[i]);
+        kernel.setArg(5 + i, gridSize[i]);
+    }
+    kernel.setArg(8, *volumeAccess->get());
+    const Vector3i regionSize = end - start;
+    device->getCommandQueue().enqueueNDRangeKernel(
+            kernel,
+            cl::NDRange(start.x(), start.y(), start.z()),
+            cl::NDRange(regionSize.x(), regionSize.y(), regionSize.z()),
+            cl::NullRange
+    );
+}
+
+template <class T>
+static void storeVoxel(void* data, std::size_t index, float value) {
+    if(std::numeric_limits<T>::is_integer) {
+        value = std::min(std::max(std::nearbyint(value), (float)std::numeric_limits<T>::lowest()), (float)std::numeric_limits<T>::max());
+    }
+    ((T*)data)[index] = (T)value;
+}
+
+void VolumeReconstructor::createVolumeOnHost(SharedPointer<Image> volume, const Vector3i& start, const Vector3i& end) {
+    const std::vector<int> table = getBrickTable(m_volumeMin, m_volumeMax);
+    const Vector3i gridSize = m_volumeMax - m_volumeMin + Vector3i::Ones();
+    const float* pool = m_hostPool.data();
+    const bool maximum = m_compounding == CompoundingMode::MAXIMUM;
+    auto getCompoundedValue = [pool, maximum](int index) {
+        return maximum ? pool[index] : pool[index] / pool[index + 1];
+    };
+
+    auto access = volume->getImageAccess(ACCESS_READ_WRITE);
+    void* data = access->get();
+    for(int z = start.z(); z < end.z(); ++z) {
+        for(int y = start.y(); y < end.y(); ++y) {
+            for(int x = start.x(); x < end.x(); ++x) {
+                const std::size_t outputIndex = x + (y + (std::size_t)z*volume->getHeight())*volume->getWidth();
+                const Vector3i voxel = Vector3i(x, y, z) + m_volumeMin*brickSize;
+                float value = 0.0f;
+                const int index = getPoolIndex(voxel, table, m_volumeMin, gridSize);
+                if(index >= 0 && pool[index + 1] > 0.0f) {
+                    value = getCompoundedValue(index);
+                } else if(index >= 0 && m_holeFillingRadius > 0) {
+                    // Fill holes from the neighborhood, same as the createVolume kernel
+                    const int radius = m_holeFillingRadius;
+                    float sum = 0.0f;
+                    int count = 0;
+                    for(int c = -radius; c <= radius; ++c) {
+                        for(int b = -radius; b <= radius; ++b) {
+                            for(int a = -radius; a <= radius; ++a) {
+                                const int neighborIndex = getPoolIndex(voxel + Vector3i(a, b, c), table, m_volumeMin, gridSize);
+                                if(neighborIndex < 0 || pool[neighborIndex + 1] <= 0.0f)
+                                    continue;
+                                sum = maximum ? std::max(sum, getCompoundedValue(neighborIndex)) : sum + getCompoundedValue(neighborIndex);
+                                ++count;
+                            }
+                        }
+                    }
+                    if(maximum) {
+                        value = sum;
+                    } else if(count > 0) {
+                        value = sum / count;
+                    }
+                }
+                switch(m_dataType) {
+                    fastSwitchTypeMacro(storeVoxel<FAST_TYPE>(data, outputIndex, value))
+                }
+            }
+        }
+    }
+}
+
+void VolumeReconstructor::execute() {
+    auto frame = getInputData<Image>();
+    if(frame->getDimensions() != 2 || frame->getNrOfChannels() != 1)
+        throw Exception("VolumeReconstructor only supports 2D images with one channel");
+
+    const Affine3f frameTransform = SceneGraph::getEigenAffineTransformationFromData(frame);
+    if(!m_initialized) {
+        // The volume is aligned with the first frame
+        m_volumeTransform = frameTransform;
+        m_spacing = m_voxelSpacing > 0 ? m_voxelSpacing : frame->getSpacing().x();
+        m_segmentation = m_segmentationOutput || std::dynamic_pointer_cast<Segmentation>(frame);
+        m_dataType = frame->getDataType();
+        if(!m_compoundingSet)
+            m_compounding = m_segmentation ? CompoundingMode::MAXIMUM : CompoundingMode::WEIGHTED;
+        m_initialized = true;
+    }
+    if(frame->getDataType() != m_dataType)
+        throw Exception("All frames given to VolumeReconstructor must have the same data type");
+
+    Affine3f voxelToWorld = m_volumeTransform;
+    voxelToWorld.scale(m_spacing);
+    Affine3f pixelToWorld = frameTransform;
+    pixelToWorld.scale(frame->getSpacing());
+    const Affine3f pixelToVoxel = voxelToWorld.inverse()*pixelToWorld;
+
+    Vector3i frameGridMin, frameGridMax;
+    allocateBricks(pixelToVoxel, Vector2i(frame->getWidth(), frame->getHeight()), frameGridMin, frameGridMax);
+    if(m_brickIndices.empty()) // Frame has no pixels
+        return;
+    bool fullUpdate = false;
+    if(m_brickIndices.size() > m_poolCapacity) {
+        resizePool(std::max(64, std::max((int)m_brickIndices.size(), 2*m_poolCapacity)));
+        fullUpdate = true;
+    }
+
+    if(getMainDevice()->isHost()) {
+        splatFrameOnHost(frame, pixelToVoxel, frameGridMin, frameGridMax);
+    } else {
+        splatFrameOnDevice(frame, pixelToVoxel, frameGridMin, frameGridMax);
+    }
+
+    // Reuse the output volume until the grid of bricks grows outside it. It then grows by half its size on the
+    // sides where the grid grew, so that a sweep only reallocates and fully updates it a few times.
+    if(!m_volume || (m_gridMin.array() < m_volumeMin.array()).any() || (m_gridMax.array() > m_volumeMax.array()).any()) {
+        if(!m_volume) {
+            m_volumeMin = m_gridMin;
+            m_volumeMax = m_gridMax;
+        }
+        const Vector3i margin = ((m_volumeMax - m_volumeMin + Vector3i::Ones()) / 2).cwiseMax(Vector3i::Ones());
+        for(int i = 0; i < 3; ++i) {
+            if(m_gridMin[i] < m_volumeMin[i])
+                m_volumeMin[i] = m_gridMin[i] - margin[i];
+            if(m_gridMax[i] > m_volumeMax[i])
+                m_volumeMax[i] = m_gridMax[i] + margin[i];
+        }
+        const Vector3i volumeSize = (m_volumeMax - m_volumeMin + Vector3i::Ones())*brickSize;
+        m_volume = m_segmentation ? Segmentation::New() : Image::New();
+        m_volume->create(volumeSize.x(), volumeSize.y(), volumeSize.z(), m_dataType, 1);
+        m_volume->setSpacing(Vector3f(m_spacing, m_spacing, m_spacing));
+        Affine3f volumeTransform = m_volumeTransform;
+        volumeTransform.translate((m_volumeMin*brickSize).cast<float>()*m_spacing);
+        m_volume->getSceneGraphNode()->getTransformation()->setTransform(volumeTransform);
+        fullUpdate = true;
+    }
+    const Vector3i size = (m_volumeMax - m_volumeMin + Vector3i::Ones())*brickSize;
+
+    // Otherwise, only the bricks of this frame, and the holes filled from them, have changed
+    Vector3i start = Vector3i::Zero();
+    Vector3i end = size;
+    if(!fullUpdate) {
+        start = ((frameGridMin - m_volumeMin)*brickSize - Vector3i::Constant(m_holeFillingRadius)).cwiseMax(start);
+        end = ((frameGridMax - m_volumeMin + Vector3i::Ones())*brickSize + Vector3i::Constant(m_holeFillingRadius)).cwiseMin(end);
+    }
+    if((start.array() < end.array()).all()) {
+        if(getMainDevice()->isHost()) {
+            createVolumeOnHost(m_volume, start, end);
+        } else {
+            createVolumeOnDevice(m_volume, start, end);
+        }
+    }
+
+    addOutputData(0, m_volume);
+}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <FAST/ProcessObject.hpp>
+#include <unordered_map>
+
+namespace fast {
+
+class Image;
+
+/**
+ * Freehand 3D ultrasound reconstruction of a stream of tracked 2D frames into a volume.
+ *
+ * The volume is stored sparsely as bricks of 16^3 voxels, which are allocated when a frame passes through them,
+ * thus only the bounding box of the tracked frames is covered. The volume axes are aligned with the first frame.
+ * Each frame is splatted into the bricks, in an OpenCL kernel or on the host depending on the main device.
+ * After each frame, a dense volume covering all allocated bricks is updated, where voxels not hit by any frame
+ * can be filled from their neighbors. Only the region touched by the frame is updated. The dense volume has a margin
+ * of empty bricks on the sides the bricks have grown, and is only reallocated and fully updated when the bricks grow
+ * outside it.
+ *
+ * Both intensity images and segmentations are supported, the output has the same data type as the input, and is
+ * a Segmentation if the input is a Segmentation.
+ *
+ * Changing the compounding mode, voxel spacing or hole filling radius after the first frame resets the reconstruction.
+ */
+class FAST_EXPORT VolumeReconstructor : public ProcessObject {
+    FAST_OBJECT(VolumeReconstructor)
+    public:
+        enum class CompoundingMode {
+            // Maximum of all pixels closest to a voxel, assumes non-negative intensities
+            MAXIMUM,
+            // Mean of all pixels closest to a voxel
+            MEAN,
+            // Each pixel is splatted to the 8 surrounding voxels with trilinear weights
+            WEIGHTED
+        };
+        /**
+         * Set how several pixels hitting the same voxel are combined.
+         * Default is MAXIMUM for segmentations and WEIGHTED for other images.
+         * @param mode
+         */
+        void setCompoundingMode(CompoundingMode mode);
+        /**
+         * Set the isotropic voxel spacing of the volume. Default is the x spacing of the first frame.
+         * @param spacing
+         */
+        void setVoxelSpacing(float spacing);
+        /**
+         * Fill voxels not hit by any frame with the mean (maximum when compounding by maximum) of the hit voxels
+         * within this distance in voxels. 0 disables hole filling. Default is 1.
+         * @param radius
+         */
+        void setHoleFillingRadius(int radius);
+        /**
+         * Remove all frames added so far, the next frame starts a new volume
+         */
+        void reset();
+    protected:
+        VolumeReconstructor();
+        void execute() override;
+        void allocateBricks(const Affine3f& pixelToVoxel, const Vector2i& frameSize,
+                            Vector3i& frameGridMin, Vector3i& frameGridMax);
+        std::vector<int> getBrickTable(const Vector3i& gridMin, const Vector3i& gridMax) const;
+        void resizePool(int capacity);
+        void splatFrameOnDevice(SharedPointer<Image> frame, const Affine3f& pixelToVoxel,
+                                const Vector3i& gridMin, const Vector3i& gridMax);
+        void splatFrameOnHost(SharedPointer<Image> frame, const Affine3f& pixelToVoxel,
+                              const Vector3i& gridMin, const Vector3i& gridMax);
+        void createVolumeOnDevice(SharedPointer<Image> volume, const Vector3i& start, const Vector3i& end);
+        void createVolumeOnHost(SharedPointer<Image> volume, const Vector3i& start, const Vector3i& end);
+
+        // Output a Segmentation regardless of the input type
+        bool m_segmentationOutput = false;
+        CompoundingMode m_compounding = CompoundingMode::WEIGHTED;
+        bool m_compoundingSet = false;
+        float m_voxelSpacing = 0.0f;
+        int m_holeFillingRadius = 1;
+
+        // Reconstruction state, set by the first frame
+        bool m_initialized = false;
+        Affine3f m_volumeTransform;
+        float m_spacing;
+        bool m_segmentation;
+        DataType m_dataType;
+        // Index in the brick pool of every allocated brick, and the range of brick coordinates allocated
+        std::unordered_map<int64_t, int> m_brickIndices;
+        Vector3i m_gridMin, m_gridMax;
+        // Range of brick coordinates covered by the output volume, contains the allocated bricks
+        Vector3i m_volumeMin, m_volumeMax;
+        // Value and weight of every voxel of the allocated bricks, on the device or the host
+        int m_poolCapacity = 0;
+        cl::Buffer m_pool;
+        std::vector<float> m_hostPool;
+        SharedPointer<Image> m_volume;
+};
+
+}
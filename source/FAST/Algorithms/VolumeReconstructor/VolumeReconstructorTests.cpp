@@ -0,0 +1,147 @@
+#include "FAST/Testing.hpp"
+#include "VolumeReconstructor.hpp"
+#include "FAST/Algorithms/SegmentationVolumeReconstructor/SegmentationVolumeReconstructor.hpp"
+#include "FAST/Data/Segmentation.hpp"
+#include "FAST/Data/Image.hpp"
+#include "FAST/SceneGraph.hpp"
+
+namespace fast {
+
+static Image::pointer createFrame(int width, int height, const Affine3f& transform, bool segmentation = false) {
+    auto frame = Image::New();
+    frame->create(width, height, TYPE_UINT8, 1);
+    {
+        auto access = frame->getImageAccess(ACCESS_READ_WRITE);
+        uchar* data = (uchar*)access->get();
+        for(int y = 0; y < height; ++y) {
+            for(int x = 0; x < width; ++x) {
+                if(segmentation) {
+                    // A disk labeled 1
+                    data[x + y*width] = (x - width/2)*(x - width/2) + (y - height/2)*(y - height/2) < 100 ? 1 : 0;
+                } else {
+                    data[x + y*width] = x + 2*y;
+                }
+            }
+        }
+    }
+    frame->getSceneGraphNode()->getTransformation()->setTransform(transform);
+    return frame;
+}
+
+// Tilted sweep
+static Affine3f getSweepTransform(int frame) {
+    Affine3f transform = Affine3f::Identity();
+    transform.translate(Vector3f(0.5f*frame, 0, 0.8f*frame));
+    transform.rotate(Eigen::AngleAxisf(0.02f*frame, Vector3f::UnitY()));
+    return transform;
+}
+
+static int getMaximumDifference(Image::pointer volume, Image::pointer volume2) {
+    auto access = volume->getImageAccess(ACCESS_READ);
+    auto access2 = volume2->getImageAccess(ACCESS_READ);
+    uchar* data = (uchar*)access->get();
+    uchar* data2 = (uchar*)access2->get();
+    int maxDifference = 0;
+    for(int i = 0; i < volume->getWidth()*volume->getHeight()*volume->getDepth(); i++)
+        maxDifference = std::max(maxDifference, std::abs((int)data[i] - (int)data2[i]));
+    return maxDifference;
+}
+
+TEST_CASE("VolumeReconstructor on Host puts each pixel in its voxel", "[fast][VolumeReconstructor]") {
+    const int width = 40, height = 30, frames = 10;
+    auto reconstructor = VolumeReconstructor::New();
+    reconstructor->setMainDevice(Host::getInstance());
+    reconstructor->setCompoundingMode(VolumeReconstructor::CompoundingMode::MEAN);
+    reconstructor->setHoleFillingRadius(0);
+    Image::pointer volume;
+    for(int i = 0; i < frames; ++i) {
+        Affine3f transform = Affine3f::Identity();
+        transform.translation() = Vector3f(0, 0, i);
+        reconstructor->setInputData(createFrame(width, height, transform));
+        volume = reconstructor->updateAndGetOutputData<Image>();
+    }
+
+    REQUIRE(volume->getDataType() == TYPE_UINT8);
+    // The volume starts at the first brick covering the frames
+    const Vector3i offset = -SceneGraph::getEigenAffineTransformationFromData(volume).translation().cast<int>();
+    REQUIRE(volume->getWidth() >= width + offset.x());
+    REQUIRE(volume->getDepth() >= frames + offset.z());
+    auto access = volume->getImageAccess(ACCESS_READ);
+    uchar* data = (uchar*)access->get();
+    bool success = true;
+    for(int z = 0; z < frames + 1; ++z) {
+        for(int y = 0; y < height; ++y) {
+            for(int x = 0; x < width; ++x) {
+                const Vector3i voxel = Vector3i(x, y, z) + offset;
+                const int expected = z < frames ? x + 2*y : 0;
+                if(data[voxel.x() + (voxel.y() + voxel.z()*volume->getHeight())*volume->getWidth()] != expected)
+                    success = false;
+            }
+        }
+    }
+    CHECK(success);
+}
+
+TEST_CASE("VolumeReconstructor on OpenCL device gives same result as Host", "[fast][VolumeReconstructor]") {
+    const int width = 64, height = 48, frames = 20;
+    for(auto mode : {VolumeReconstructor::CompoundingMode::MAXIMUM,
+                     VolumeReconstructor::CompoundingMode::MEAN,
+                     VolumeReconstructor::CompoundingMode::WEIGHTED}) {
+        Image::pointer volumes[2];
+        for(int i = 0; i < 2; ++i) {
+            auto reconstructor = VolumeReconstructor::New();
+            if(i == 1)
+                reconstructor->setMainDevice(Host::getInstance());
+            reconstructor->setCompoundingMode(mode);
+            reconstructor->setVoxelSpacing(0.7f);
+            reconstructor->setHoleFillingRadius(1);
+            for(int j = 0; j < frames; ++j) {
+                reconstructor->setInputData(createFrame(width, height, getSweepTransform(j)));
+                volumes[i] = reconstructor->updateAndGetOutputData<Image>();
+            }
+        }
+
+        REQUIRE(volumes[0]->getSize() == volumes[1]->getSize());
+        if(mode == VolumeReconstructor::CompoundingMode::MAXIMUM) {
+            CHECK(getMaximumDifference(volumes[0], volumes[1]) == 0);
+        } else {
+            // Atomic float sums on the device are accumulated in another order
+            CHECK(getMaximumDifference(volumes[0], volumes[1]) <= 1);
+        }
+    }
+}
+
+TEST_CASE("SegmentationVolumeReconstructor outputs same Segmentation on OpenCL device and Host", "[fast][VolumeReconstructor][SegmentationVolumeReconstructor]") {
+    const int width = 64, height = 48, frames = 20;
+    Image::pointer volumes[2];
+    for(int i = 0; i < 2; ++i) {
+        auto reconstructor = SegmentationVolumeReconstructor::New();
+        if(i == 1)
+            reconstructor->setMainDevice(Host::getInstance());
+        reconstructor->setVoxelSpacing(0.7f);
+        for(int j = 0; j < frames; ++j) {
+            // Plain images, the output is a segmentation anyway
+            reconstructor->setInputData(createFrame(width, height, getSweepTransform(j), true));
+            volumes[i] = reconstructor->updateAndGetOutputData<Image>();
+        }
+        CHECK(std::dynamic_pointer_cast<Segmentation>(volumes[i]));
+    }
+
+    REQUIRE(volumes[0]->getSize() == volumes[1]->getSize());
+    CHECK(getMaximumDifference(volumes[0], volumes[1]) == 0);
+    // Maximum compounding and hole filling keep the labels
+    auto access = volumes[1]->getImageAccess(ACCESS_READ);
+    uchar* data = (uchar*)access->get();
+    int labeled = 0;
+    bool onlyLabels = true;
+    for(int i = 0; i < volumes[1]->getWidth()*volumes[1]->getHeight()*volumes[1]->getDepth(); i++) {
+        if(data[i] == 1)
+            ++labeled;
+        if(data[i] > 1)
+            onlyLabels = false;
+    }
+    CHECK(onlyLabels);
+    CHECK(labeled > 0);
+}
+
+}
@@ -27,6 +27,9 @@ namespace fast {
 			std::string mLibraryPath;
 			std::string mQtPluginsPath;
 			StreamingMode m_streamingMode = STREAMING_MODE_PROCESS_ALL_FRAMES;
+			bool m_lockFreeDataChannels = false;
+			std::size_t m_kernelBinaryCacheMaximumSize = 256*1024*1024;
+			bool m_asynchronousTransfers = false;
 		}
 
 		std::string getPath() {
@@ -270,6 +273,30 @@ namespace fast {
 		    return m_streamingMode;
 		}
 
+		void setLockFreeDataChannels(bool enabled) {
+		    m_lockFreeDataChannels = enabled;
+		}
+
+		bool getLockFreeDataChannels() {
+		    return m_lockFreeDataChannels;
+		}
+
+		void setAsynchronousTransfers(bool enabled) {
+		    m_asynchronousTransfers = enabled;
+		}
+
+		bool getAsynchronousTransfers() {
+		    return m_asynchronousTransfers;
+		}
+
+		void setKernelBinaryCacheMaximumSize(std::size_t bytes) {
+		    m_kernelBinaryCacheMaximumSize = bytes;
+		}
+
+		std::size_t getKernelBinaryCacheMaximumSize() {
+		    return m_kernelBinaryCacheMaximumSize;
+		}
+
 	} // end namespace Config
 
 }; // end namespace fast
@@ -16,6 +16,24 @@ namespace Config {
     FAST_EXPORT std::string getQtPluginsPath();
     FAST_EXPORT StreamingMode getStreamingMode();
     FAST_EXPORT void setStreamingMode(StreamingMode mode);
+    /**
+     * Use lock-free ring buffers (RingBufferDataChannel) instead of mutex guarded
+     * queues (QueuedDataChannel) when all frames are to be processed.
+     */
+    FAST_EXPORT bool getLockFreeDataChannels();
+    FAST_EXPORT void setLockFreeDataChannels(bool enabled);
+    /**
+     * Transfer image data between host and OpenCL devices without blocking the calling thread.
+     * The host only waits for a transfer when it requests access to the data, e.g. with Image::getImageAccess.
+     */
+    FAST_EXPORT bool getAsynchronousTransfers();
+    FAST_EXPORT void setAsynchronousTransfers(bool enabled);
+    /**
+     * Maximum total size in bytes of OpenCL program binaries stored in the program cache in the kernel binary path.
+     * When exceeded, the least recently used binaries are deleted. Setting this to 0 disables the program cache. Default is 256 MB.
+     */
+    FAST_EXPORT std::size_t getKernelBinaryCacheMaximumSize();
+    FAST_EXPORT void setKernelBinaryCacheMaximumSize(std::size_t bytes);
 	FAST_EXPORT void setTestDataPath(std::string path);
 	FAST_EXPORT void setKernelSourcePath(std::string path);
 	FAST_EXPORT void setKernelBinaryPath(std::string path);
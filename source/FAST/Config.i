@@ -13,6 +13,10 @@ namespace Config {
 	 void setPipelinePath(std::string path);
      void setConfigFilename(std::string filename);
      void setBasePath(std::string path);
+     bool getLockFreeDataChannels();
+     void setLockFreeDataChannels(bool enabled);
+     bool getAsynchronousTransfers();
+     void setAsynchronousTransfers(bool enabled);
 	 void loadConfiguration();
 }
 
@@ -1,5 +1,6 @@
 #include "ImagePyramidAccess.hpp"
 #include <FAST/Data/ImagePyramid.hpp>
+#include <FAST/Data/ImagePyramidTileCache.hpp>
 #include <FAST/Algorithms/ImageChannelConverter/ImageChannelConverter.hpp>
 #include <FAST/Utility.hpp>
 #include <openslide/openslide.h>
@@ -20,16 +21,34 @@ void ImagePyramidAccess::release() {
 	m_image->accessFinished();
 }
 
+void ImagePyramidAccess::openPrivateFileHandle() {
+    if(m_fileHandle == nullptr || m_ownsFileHandle)
+        return;
+    const std::string filename = m_image->getFilename();
+    if(filename.empty())
+        return;
+    openslide_t* fileHandle = openslide_open(filename.c_str());
+    if(fileHandle == nullptr || openslide_get_error(fileHandle) != nullptr) {
+        // Keep using the shared file handle
+        if(fileHandle != nullptr)
+            openslide_close(fileHandle);
+        reportWarning() << "Unable to open private file handle to " << filename << reportEnd();
+        return;
+    }
+    m_fileHandle = fileHandle;
+    m_ownsFileHandle = true;
+}
+
 ImagePyramidAccess::~ImagePyramidAccess() {
+    if(m_ownsFileHandle)
+        openslide_close(m_fileHandle);
 	release();
 }
 
-void ImagePyramidAccess::setScalarFast(uint x, uint y, uint level, uint8_t value, uint channel) noexcept {
+void ImagePyramidAccess::setScalarFast(uint x, uint y, uint level, uint8_t value, uint channel) {
     if(!m_write)
         return;
-	auto levelData = m_levels[level];
-    std::size_t pos = (x + (std::size_t)y * levelData.width) * m_image->getNrOfChannels() + channel;
-	levelData.data[pos] = value;
+	m_levels[level].tiles->setScalar(x, y, value, channel);
 
     // add patch to list of dirty patches
     int levelWidth = m_image->getLevelWidth(level);
@@ -67,7 +86,7 @@ void ImagePyramidAccess::setScalar(uint x, uint y, uint level, uint8_t value, ui
 	// Make sure it has write rights
 	if(!m_write)
 		throw Exception("ImagePyramidAccess has not write rights, but tried to write a value");
-	auto levelData = m_levels[level];
+	const auto& levelData = m_levels[level];
 	if(x >= levelData.width || y >= levelData.height)
 		throw OutOfBoundsException();
 
@@ -75,17 +94,97 @@ void ImagePyramidAccess::setScalar(uint x, uint y, uint level, uint8_t value, ui
 }
 
 uint8_t ImagePyramidAccess::getScalar(uint x, uint y, uint level, uint channel) {
-	auto levelData = m_levels[level];
+	const auto& levelData = m_levels[level];
 	if(x >= levelData.width || y >= levelData.height)
 		throw OutOfBoundsException();
-	return levelData.data[(x + y * levelData.width) * m_image->getNrOfChannels() + channel];
+	return levelData.tiles->getScalar(x, y, channel);
+}
+
+uint8_t ImagePyramidAccess::getScalarFast(uint x, uint y, uint level, uint channel) {
+	return m_levels[level].tiles->getScalar(x, y, channel);
 }
 
-uint8_t ImagePyramidAccess::getScalarFast(uint x, uint y, uint level, uint channel) noexcept {
-	auto levelData = m_levels[level];
-	return levelData.data[(x + y * levelData.width) * m_image->getNrOfChannels() + channel];
+
+void ImagePyramidAccess::setPatch(int level, int x, int y, int width, int height, const uint8_t* data) {
+	if(!m_write)
+		throw Exception("ImagePyramidAccess has not write rights, but tried to write a patch");
+	if(level < 0 || level >= m_levels.size())
+		throw Exception("Incorrect level given to setPatch " + std::to_string(level));
+	if(width <= 0 || height <= 0)
+		return;
+	m_levels[level].tiles->setRegion(x, y, width, height, data);
+	m_image->setDirtyRegion(level, x, y, width, height);
+	propagateRegion(level, x, y, width, height);
 }
 
+void ImagePyramidAccess::propagateRegion(int level, int x, int y, int width, int height) {
+	const int channels = m_levels[level].tiles->getNrOfChannels();
+	std::unique_ptr<uint8_t[]> fine;
+	std::unique_ptr<uint8_t[]> coarse;
+	std::size_t fineSize = 0;
+	std::size_t coarseSize = 0;
+	for(; level < (int)m_levels.size() - 1; ++level) {
+		const int levelWidth = m_levels[level].width;
+		const int levelHeight = m_levels[level].height;
+		// Region of the next level which depends on the changed region
+		const int startX = std::max(x, 0) / 2;
+		const int startY = std::max(y, 0) / 2;
+		const int endX = std::min((std::min(x + width, levelWidth) + 1) / 2, m_levels[level + 1].width);
+		const int endY = std::min((std::min(y + height, levelHeight) + 1) / 2, m_levels[level + 1].height);
+		if(endX <= startX || endY <= startY)
+			return;
+		const int coarseWidth = endX - startX;
+		const int coarseHeight = endY - startY;
+		const int fineWidth = coarseWidth*2;
+		const int fineHeight = coarseHeight*2;
+		if((std::size_t)fineWidth*fineHeight*channels > fineSize) {
+			fineSize = (std::size_t)fineWidth*fineHeight*channels;
+			fine = make_uninitialized_unique<uint8_t[]>(fineSize);
+		}
+		if((std::size_t)coarseWidth*coarseHeight*channels > coarseSize) {
+			coarseSize = (std::size_t)coarseWidth*coarseHeight*channels;
+			coarse = make_uninitialized_unique<uint8_t[]>(coarseSize);
+		}
+		m_levels[level].tiles->getRegion(startX*2, startY*2, fineWidth, fineHeight, fine.get());
+
+		// Average 2x2 pixels. Pixels outside the level are not counted.
+		// Only the last column and row can be partial, the rest is a simple loop which the compiler can vectorize.
+		const int fullWidth = std::min(coarseWidth, levelWidth/2 - startX);
+		const int fullHeight = std::min(coarseHeight, levelHeight/2 - startY);
+		const int rowSize = fineWidth*channels;
+		for(int cy = 0; cy < coarseHeight; ++cy) {
+			const uint8_t* row0 = &fine[(std::size_t)(cy*2)*rowSize];
+			const uint8_t* row1 = row0 + rowSize;
+			uint8_t* out = &coarse[(std::size_t)cy*coarseWidth*channels];
+			if(cy < fullHeight) {
+				for(int cx = 0; cx < fullWidth; ++cx) {
+					for(int c = 0; c < channels; ++c) {
+						const int fi = cx*2*channels + c;
+						out[cx*channels + c] = (uint8_t)((row0[fi] + row0[fi + channels] + row1[fi] + row1[fi + channels] + 2) >> 2);
+					}
+				}
+			}
+			const int partialStart = cy < fullHeight ? fullWidth : 0;
+			for(int cx = partialStart; cx < coarseWidth; ++cx) {
+				const bool hasRight = (startX + cx)*2 + 1 < levelWidth;
+				const bool hasBelow = (startY + cy)*2 + 1 < levelHeight;
+				const int counter = 1 + hasRight + hasBelow + (hasRight && hasBelow);
+				for(int c = 0; c < channels; ++c) {
+					const int fi = cx*2*channels + c;
+					// Pixels outside the level are read as zero
+					const int sum = row0[fi] + row0[fi + channels] + row1[fi] + row1[fi + channels];
+					out[cx*channels + c] = (uint8_t)((sum + counter/2) / counter);
+				}
+			}
+		}
+		m_levels[level + 1].tiles->setRegion(startX, startY, coarseWidth, coarseHeight, coarse.get());
+		m_image->setDirtyRegion(level + 1, startX, startY, coarseWidth, coarseHeight);
+		x = startX;
+		y = startY;
+		width = coarseWidth;
+		height = coarseHeight;
+	}
+}
 
 ImagePyramidPatch ImagePyramidAccess::getPatch(std::string tile) {
     auto parts = split(tile, "_");
@@ -106,22 +205,26 @@ std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchData(int level, int x, int
     const int channels = m_image->getNrOfChannels();
     auto data = make_uninitialized_unique<uchar[]>(width*height*channels);
     if(m_fileHandle != nullptr) {
-		float scale = (float)m_image->getFullWidth()/levelWidth;
-        openslide_read_region(m_fileHandle, (uint32_t*)data.get(), x * scale, y * scale, level, width, height);
+		readRegionFromFile(level, x, y, width, height, data.get());
     } else {
-        auto levelData = m_levels[level];
-        for(int cy = y; cy < std::min(y + height, levelHeight); ++cy) {
-            for(int cx = x; cx < std::min(x + width, levelWidth); ++cx) {
-                for(int channel = 0; channel < channels; ++channel) {
-                    data[(cx - x + (cy - y) * width)*channels + channel] = levelData.data[(cx + cy * levelWidth)*channels + channel];
-                }
-            }
-        }
+        // Only the tiles intersecting the region are read
+        m_levels[level].tiles->getRegion(x, y, width, height, data.get());
     }
 
     return data;
 }
 
+void ImagePyramidAccess::readRegionFromFile(int level, int x, int y, int width, int height, uchar* data) {
+    const float scale = (float)m_image->getFullWidth()/m_image->getLevelWidth(level);
+    openslide_t* fileHandle = m_fileHandle;
+    // Tiles are shared with all other accesses to the same file through the tile cache
+    ImagePyramidTileCache::getInstance()->readRegion(m_image->getFilename(), level, x, y, width, height, 4, data,
+        [fileHandle, scale, level](int regionX, int regionY, int regionWidth, int regionHeight, uint8_t* regionData) {
+            openslide_read_region(fileHandle, (uint32_t*)regionData, regionX * scale, regionY * scale, level, regionWidth, regionHeight);
+        }
+    );
+}
+
 ImagePyramidPatch ImagePyramidAccess::getPatch(int level, int tile_x, int tile_y) {
     // Create patch
     int levelWidth = m_image->getLevelWidth(level);
@@ -155,10 +258,12 @@ SharedPointer<Image> ImagePyramidAccess::getLevelAsImage(int level) {
 
     auto image = Image::New();
     if(m_fileHandle == nullptr) {
-		image->create(width, height, TYPE_UINT8, 4, m_levels[level].data);
+		auto data = make_uninitialized_unique<uchar[]>((std::size_t)width*height*m_image->getNrOfChannels());
+		m_levels[level].tiles->getRegion(0, 0, width, height, data.get());
+		image->create(width, height, TYPE_UINT8, m_image->getNrOfChannels(), std::move(data));
     } else {
 		auto data = make_uninitialized_unique<uchar[]>(width*height*4);
-        openslide_read_region(m_fileHandle, (uint32_t*)data.get(), 0, 0, level, width, height);
+		readRegionFromFile(level, 0, 0, width, height, data.get());
 		image->create(width, height, TYPE_UINT8, 4, std::move(data));
     }
     image->setSpacing(Vector3f(
@@ -2,6 +2,7 @@
 
 #include <FAST/Object.hpp>
 #include <FAST/Data/DataTypes.hpp>
+#include <FAST/Data/TiledImageStorage.hpp>
 
 typedef struct _openslide openslide_t;
 
@@ -22,13 +23,8 @@ typedef struct ImagePyramidLevel {
 	int width;
 	int height;
 	int patches;
-	bool memoryMapped;
-	uint8_t* data;
-#ifdef WIN32
-	void* fileHandle;
-#else
-	int fileHandle;
-#endif
+	// Tiled storage of levels created in memory, nullptr if read from file
+	std::shared_ptr<TiledImageStorage> tiles;
 } Level;
 
 class FAST_EXPORT ImagePyramidAccess : Object {
@@ -36,22 +32,49 @@ public:
 	typedef std::unique_ptr<ImagePyramidAccess> pointer;
 	ImagePyramidAccess(std::vector<ImagePyramidLevel> levels, openslide_t* fileHandle, SharedPointer<ImagePyramid> imagePyramid, bool writeAccess);
 	void setScalar(uint x, uint y, uint level, uint8_t value, uint channel = 0);
-	void setScalarFast(uint x, uint y, uint level, uint8_t value, uint channel = 0) noexcept;
+	/**
+	 * Same as setScalar, without bounds checking. May throw an Exception if tiles can't be written to or read from
+	 * their file.
+	 */
+	void setScalarFast(uint x, uint y, uint level, uint8_t value, uint channel = 0);
 	uint8_t getScalar(uint x, uint y, uint level, uint channel = 0);
-	uint8_t getScalarFast(uint x, uint y, uint level, uint channel = 0) noexcept;
+	/**
+	 * Same as getScalar, without bounds checking. May throw an Exception if tiles can't be read from their file.
+	 */
+	uint8_t getScalarFast(uint x, uint y, uint level, uint channel = 0);
+	/**
+	 * Write a region of a level, stored row by row with interleaved channels.
+	 * The affected region of each coarser level is recomputed once with 2x2 averaging, and
+	 * the patches intersecting the written regions are marked as dirty.
+	 * This is much faster than calling setScalar for every pixel of a large region.
+	 */
+	void setPatch(int level, int x, int y, int width, int height, const uint8_t* data);
 	std::unique_ptr<uchar[]> getPatchData(int level, int x, int y, int width, int height);
 	ImagePyramidPatch getPatch(std::string tile);
 	ImagePyramidPatch getPatch(int level, int patchX, int patchY);
 	SharedPointer<Image> getLevelAsImage(int level);
 	SharedPointer<Image> getPatchAsImage(int level, int offsetX, int offsetY, int width, int height);
 	SharedPointer<Image> getPatchAsImage(int level, int patchIdX, int patchIdY);
+	/**
+	 * Read from a file handle owned by this access object, instead of the file handle shared by all accesses.
+	 * Use this when reading patches from multiple threads, so that each thread has its own handle and cache.
+	 * Does nothing if the image pyramid is not read from a file.
+	 */
+	void openPrivateFileHandle();
 	void release();
 	~ImagePyramidAccess();
 private:
+	void propagateRegion(int level, int x, int y, int width, int height);
+	/**
+	 * Read BGRA region of a level from file through the ImagePyramidTileCache
+	 */
+	void readRegionFromFile(int level, int x, int y, int width, int height, uchar* data);
+
 	SharedPointer<ImagePyramid> m_image;
 	std::vector<ImagePyramidLevel> m_levels;
 	bool m_write;
 	openslide_t* m_fileHandle;
+	bool m_ownsFileHandle = false;
 };
 
 }
\ No newline at end of file
@@ -9,11 +9,16 @@ cl::Buffer* OpenCLBufferAccess::get() const {
     return mBuffer;
 }
 
-OpenCLBufferAccess::OpenCLBufferAccess(cl::Buffer* buffer,  SharedPointer<DataObject> dataObject) {
+std::vector<cl::Event> OpenCLBufferAccess::getEvents() const {
+    return m_events;
+}
+
+OpenCLBufferAccess::OpenCLBufferAccess(cl::Buffer* buffer,  SharedPointer<DataObject> dataObject, std::vector<cl::Event> events) {
     // Copy the image
     mBuffer = new cl::Buffer(*buffer);
     mIsDeleted = false;
     mDataObject = dataObject;
+    m_events = events;
 }
 
 void OpenCLBufferAccess::release() {
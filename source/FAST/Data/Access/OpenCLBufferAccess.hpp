@@ -13,7 +13,14 @@ class DataObject;
 class FAST_EXPORT OpenCLBufferAccess {
     public:
         cl::Buffer* get() const;
-        OpenCLBufferAccess(cl::Buffer* buffer,  SharedPointer<DataObject> dataObject);
+        /**
+         * Events of pending asynchronous transfers to this buffer, see Config::setAsynchronousTransfers.
+         * Kernels enqueued on the command queue of the device will run after these transfers,
+         * but they can be used as a wait list for commands enqueued elsewhere.
+         * @return
+         */
+        std::vector<cl::Event> getEvents() const;
+        OpenCLBufferAccess(cl::Buffer* buffer,  SharedPointer<DataObject> dataObject, std::vector<cl::Event> events = std::vector<cl::Event>());
         void release();
         ~OpenCLBufferAccess();
 		typedef std::unique_ptr<OpenCLBufferAccess> pointer;
@@ -23,6 +30,7 @@ class FAST_EXPORT OpenCLBufferAccess {
         cl::Buffer* mBuffer;
         bool mIsDeleted;
         SharedPointer<DataObject> mDataObject;
+        std::vector<cl::Event> m_events;
 };
 
 } // end namespace fast
@@ -16,18 +16,24 @@ cl::Image3D* OpenCLImageAccess::get3DImage() const {
 }
 
 
-OpenCLImageAccess::OpenCLImageAccess(cl::Image3D* image, SharedPointer<Image> object) {
+std::vector<cl::Event> OpenCLImageAccess::getEvents() const {
+    return m_events;
+}
+
+OpenCLImageAccess::OpenCLImageAccess(cl::Image3D* image, SharedPointer<Image> object, std::vector<cl::Event> events) {
     // Copy the image
     mImage = new cl::Image3D(*image);
     mIsDeleted = false;
     mImageObject = object;
+    m_events = events;
 }
 
-OpenCLImageAccess::OpenCLImageAccess(cl::Image2D* image, SharedPointer<Image> object) {
+OpenCLImageAccess::OpenCLImageAccess(cl::Image2D* image, SharedPointer<Image> object, std::vector<cl::Event> events) {
     // Copy the image
     mImage = new cl::Image2D(*image);
     mIsDeleted = false;
     mImageObject = object;
+    m_events = events;
 }
 
 void OpenCLImageAccess::release() {
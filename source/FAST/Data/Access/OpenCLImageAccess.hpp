@@ -16,8 +16,15 @@ class FAST_EXPORT  OpenCLImageAccess {
         cl::Image* get() const;
         cl::Image2D* get2DImage() const;
         cl::Image3D* get3DImage() const;
-        OpenCLImageAccess(cl::Image2D* image, SharedPointer<Image> object);
-        OpenCLImageAccess(cl::Image3D* image, SharedPointer<Image> object);
+        /**
+         * Events of pending asynchronous transfers to this image, see Config::setAsynchronousTransfers.
+         * Kernels enqueued on the command queue of the device will run after these transfers,
+         * but they can be used as a wait list for commands enqueued elsewhere.
+         * @return
+         */
+        std::vector<cl::Event> getEvents() const;
+        OpenCLImageAccess(cl::Image2D* image, SharedPointer<Image> object, std::vector<cl::Event> events = std::vector<cl::Event>());
+        OpenCLImageAccess(cl::Image3D* image, SharedPointer<Image> object, std::vector<cl::Event> events = std::vector<cl::Event>());
         void release();
         ~OpenCLImageAccess();
 		typedef std::unique_ptr<OpenCLImageAccess> pointer;
@@ -27,6 +34,7 @@ class FAST_EXPORT  OpenCLImageAccess {
         cl::Image* mImage;
         bool mIsDeleted;
         SharedPointer<Image> mImageObject;
+        std::vector<cl::Event> m_events;
 
 };
 
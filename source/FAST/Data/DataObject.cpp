@@ -94,18 +94,23 @@ std::unordered_set<std::string> DataObject::getLastFrame() {
 }
 
 void DataObject::setFrameData(std::string name, std::string value) {
-    m_frameData[name] = value;
+    m_frameData.set(FrameData::getKey(name), value);
 }
 
 std::string DataObject::getFrameData(std::string name) {
-    if(m_frameData.count(name) == 0)
-        throw Exception("Frame data " + name + " does not exist.");
+    return m_frameData.getString(FrameData::getKey(name));
+}
 
-    return m_frameData[name];
+FrameData& DataObject::getFrameData() {
+    return m_frameData;
 }
 
-std::unordered_map<std::string, std::string> DataObject::getFrameData() {
+const FrameData& DataObject::getFrameData() const {
     return m_frameData;
 }
 
+void DataObject::setFrameData(const FrameData& frameData) {
+    m_frameData.merge(frameData);
+}
+
 } // end namespace fast
@@ -4,6 +4,7 @@
 
 #include "FAST/Object.hpp"
 #include "FAST/ExecutionDevice.hpp"
+#include "FAST/Data/FrameData.hpp"
 #include <unordered_map>
 #include <unordered_set>
 #include <condition_variable>
@@ -34,8 +35,23 @@ class FAST_EXPORT  DataObject : public Object {
         bool isLastFrame(std::string streamer);
         std::unordered_set<std::string> getLastFrame();
         void setFrameData(std::string name, std::string value);
+        /**
+         * Get frame data attribute converted to a string
+         * @param name
+         * @return
+         */
         std::string getFrameData(std::string name);
-        std::unordered_map<std::string, std::string> getFrameData();
+        /**
+         * Get typed frame data of this data object. Use this for attributes which are read or written every frame.
+         * @return
+         */
+        FrameData& getFrameData();
+        const FrameData& getFrameData() const;
+        /**
+         * Add all attributes of frameData to the frame data of this data object
+         * @param frameData
+         */
+        void setFrameData(const FrameData& frameData);
         void accessFinished();
     protected:
         virtual void free(ExecutionDevice::pointer device) = 0;
@@ -63,7 +79,7 @@ class FAST_EXPORT  DataObject : public Object {
 
         // Frame data
         // Similar to metadata, only this is transferred from input to output
-        std::unordered_map<std::string, std::string> m_frameData;
+        FrameData m_frameData;
         // Indicates whether this data object is the last frame in a stream, and if so, the name of the stream
         std::unordered_set<std::string> m_lastFrame;
 
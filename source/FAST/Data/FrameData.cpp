@@ -0,0 +1,258 @@
+#include "FrameData.hpp"
+#include <mutex>
+#include <sstream>
+
+namespace fast {
+
+namespace {
+struct KeyTable {
+    std::mutex mutex;
+    std::unordered_map<std::string, FrameData::Key> keys;
+    std::vector<std::string> names;
+};
+
+KeyTable& getKeyTable() {
+    // Never deleted, as keys may be looked up during static destruction
+    static KeyTable* table = new KeyTable();
+    return *table;
+}
+}
+
+FrameData::Key FrameData::getKey(const std::string& name) {
+    auto& table = getKeyTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.keys.find(name);
+    if(it != table.keys.end())
+        return it->second;
+    const Key key = (Key)table.names.size();
+    table.keys[name] = key;
+    table.names.push_back(name);
+    return key;
+}
+
+std::string FrameData::getKeyName(Key key) {
+    auto& table = getKeyTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if(key >= table.names.size())
+        throw Exception("Frame data key " + std::to_string(key) + " does not exist.");
+    return table.names[key];
+}
+
+const FrameData::Entry* FrameData::find(Key key) const {
+    if(!m_entries)
+        return nullptr;
+    // Linear search, there are only a few attributes per frame
+    for(auto&& entry : *m_entries) {
+        if(entry.key == key)
+            return &entry;
+    }
+    return nullptr;
+}
+
+const FrameData::Entry& FrameData::get(Key key) const {
+    auto entry = find(key);
+    if(entry == nullptr)
+        throw Exception("Frame data " + getKeyName(key) + " does not exist.");
+    return *entry;
+}
+
+void FrameData::detach() {
+    if(!m_entries) {
+        m_entries = std::make_shared<std::vector<Entry>>();
+        m_entries->reserve(16);
+    } else if(m_entries.use_count() > 1) {
+        m_entries = std::make_shared<std::vector<Entry>>(*m_entries);
+    }
+}
+
+FrameData::Entry& FrameData::getForWriting(Key key, Type type) {
+    detach();
+    Entry* entry = nullptr;
+    for(auto&& existing : *m_entries) {
+        if(existing.key == key) {
+            entry = &existing;
+            break;
+        }
+    }
+    if(entry == nullptr) {
+        m_entries->emplace_back();
+        entry = &m_entries->back();
+        entry->key = key;
+    }
+    entry->type = type;
+    entry->stringValue.clear();
+    return *entry;
+}
+
+void FrameData::set(Key key, int value) {
+    getForWriting(key, Type::INT).intValue = value;
+}
+
+void FrameData::set(Key key, float value) {
+    getForWriting(key, Type::FLOAT).values[0] = value;
+}
+
+void FrameData::set(Key key, Vector3f value) {
+    auto& entry = getForWriting(key, Type::VECTOR);
+    for(int i = 0; i < 3; ++i)
+        entry.values[i] = value[i];
+}
+
+void FrameData::set(Key key, const Affine3f& value) {
+    auto& entry = getForWriting(key, Type::TRANSFORM);
+    for(int i = 0; i < 16; ++i)
+        entry.values[i] = value.matrix().data()[i];
+}
+
+void FrameData::set(Key key, std::string value) {
+    getForWriting(key, Type::STRING).stringValue = std::move(value);
+}
+
+bool FrameData::has(Key key) const {
+    return find(key) != nullptr;
+}
+
+FrameData::Type FrameData::getType(Key key) const {
+    return get(key).type;
+}
+
+int FrameData::getInt(Key key) const {
+    auto& entry = get(key);
+    switch(entry.type) {
+        case Type::INT:
+            return entry.intValue;
+        case Type::FLOAT:
+            return (int)entry.values[0];
+        case Type::STRING:
+            return std::stoi(entry.stringValue);
+        default:
+            throw Exception("Frame data " + getKeyName(key) + " is not a scalar");
+    }
+}
+
+float FrameData::getFloat(Key key) const {
+    auto& entry = get(key);
+    switch(entry.type) {
+        case Type::INT:
+            return (float)entry.intValue;
+        case Type::FLOAT:
+            return entry.values[0];
+        case Type::STRING:
+            return std::stof(entry.stringValue);
+        default:
+            throw Exception("Frame data " + getKeyName(key) + " is not a scalar");
+    }
+}
+
+Vector3f FrameData::getVector(Key key) const {
+    auto& entry = get(key);
+    Vector3f result;
+    if(entry.type == Type::VECTOR) {
+        for(int i = 0; i < 3; ++i)
+            result[i] = entry.values[i];
+    } else if(entry.type == Type::STRING) {
+        std::istringstream stream(entry.stringValue);
+        for(int i = 0; i < 3; ++i) {
+            if(!(stream >> result[i]))
+                throw Exception("Frame data " + getKeyName(key) + " is not a vector");
+        }
+    } else {
+        throw Exception("Frame data " + getKeyName(key) + " is not a vector");
+    }
+    return result;
+}
+
+Affine3f FrameData::getTransform(Key key) const {
+    auto& entry = get(key);
+    Affine3f result;
+    if(entry.type == Type::TRANSFORM) {
+        for(int i = 0; i < 16; ++i)
+            result.matrix().data()[i] = entry.values[i];
+    } else if(entry.type == Type::STRING) {
+        std::istringstream stream(entry.stringValue);
+        for(int i = 0; i < 16; ++i) {
+            if(!(stream >> result.matrix().data()[i]))
+                throw Exception("Frame data " + getKeyName(key) + " is not a transform");
+        }
+    } else {
+        throw Exception("Frame data " + getKeyName(key) + " is not a transform");
+    }
+    return result;
+}
+
+std::string FrameData::getString(Key key) const {
+    auto& entry = get(key);
+    switch(entry.type) {
+        case Type::INT:
+            return std::to_string(entry.intValue);
+        case Type::FLOAT:
+            return std::to_string(entry.values[0]);
+        case Type::STRING:
+            return entry.stringValue;
+        default: {
+            const int size = entry.type == Type::VECTOR ? 3 : 16;
+            std::string result;
+            for(int i = 0; i < size; ++i)
+                result += std::to_string(entry.values[i]) + " ";
+            return result;
+        }
+    }
+}
+
+void FrameData::remove(Key key) {
+    if(!has(key))
+        return;
+    detach();
+    for(auto it = m_entries->begin(); it != m_entries->end(); ++it) {
+        if(it->key == key) {
+            m_entries->erase(it);
+            break;
+        }
+    }
+}
+
+std::unordered_map<std::string, std::string> FrameData::toStringMap() const {
+    std::unordered_map<std::string, std::string> result;
+    if(!m_entries)
+        return result;
+    for(auto&& entry : *m_entries)
+        result[getKeyName(entry.key)] = getString(entry.key);
+    return result;
+}
+
+void FrameData::merge(const FrameData& other) {
+    if(other.empty() || m_entries == other.m_entries)
+        return;
+    bool otherContainsAll = true;
+    if(m_entries) {
+        for(auto&& entry : *m_entries) {
+            if(!other.has(entry.key)) {
+                otherContainsAll = false;
+                break;
+            }
+        }
+    }
+    if(otherContainsAll) {
+        // All attributes are overwritten, share storage of other instead of copying
+        m_entries = other.m_entries;
+        return;
+    }
+    for(auto&& entry : *other.m_entries) {
+        auto& target = getForWriting(entry.key, entry.type);
+        target = entry;
+    }
+}
+
+bool FrameData::empty() const {
+    return !m_entries || m_entries->empty();
+}
+
+int FrameData::size() const {
+    return m_entries ? (int)m_entries->size() : 0;
+}
+
+void FrameData::clear() {
+    m_entries.reset();
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "FAST/Data/DataTypes.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fast {
+
+/**
+ * Typed frame data attached to a data object.
+ *
+ * Frame data are small attributes (e.g. patch indices, original image size and transform) which process objects
+ * transfer from input data to output data. Attribute names are interned to integer keys, see FrameData::getKey,
+ * and values are stored as int, float, vector, transform or string without conversion to text.
+ *
+ * The attributes are stored in a flat array shared between copies of the FrameData object.
+ * The array is only copied when a shared FrameData object is modified (copy-on-write),
+ * thus passing frame data from input to output through a pipeline does not allocate memory.
+ */
+class FAST_EXPORT FrameData {
+    public:
+        typedef uint32_t Key;
+        enum class Type : uint8_t {
+            INT,
+            FLOAT,
+            VECTOR,
+            TRANSFORM,
+            STRING
+        };
+        /**
+         * Get the interned key of an attribute name. The same name always gives the same key.
+         * Looking up a key locks a global table, thus store the key when used for every frame.
+         * @param name
+         * @return key
+         */
+        static Key getKey(const std::string& name);
+        static std::string getKeyName(Key key);
+
+        void set(Key key, int value);
+        void set(Key key, float value);
+        void set(Key key, Vector3f value);
+        void set(Key key, const Affine3f& value);
+        void set(Key key, std::string value);
+        bool has(Key key) const;
+        Type getType(Key key) const;
+        /**
+         * Typed getters throw an Exception if the attribute does not exist.
+         * String attributes are converted to the requested type.
+         */
+        int getInt(Key key) const;
+        float getFloat(Key key) const;
+        Vector3f getVector(Key key) const;
+        Affine3f getTransform(Key key) const;
+        /**
+         * Get attribute converted to a string. Transforms are given as 16 column-major values
+         * separated by spaces and vectors as 3 values separated by spaces.
+         */
+        std::string getString(Key key) const;
+        void remove(Key key);
+        std::unordered_map<std::string, std::string> toStringMap() const;
+        /**
+         * Add all attributes of other to this, overwriting attributes with the same key.
+         * If other contains all attributes of this, the storage of other is shared instead of copied.
+         * @param other
+         */
+        void merge(const FrameData& other);
+        bool empty() const;
+        int size() const;
+        void clear();
+    private:
+        struct Entry {
+            Key key;
+            Type type;
+            int intValue;
+            float values[16];
+            std::string stringValue;
+        };
+        const Entry* find(Key key) const;
+        const Entry& get(Key key) const;
+        Entry& getForWriting(Key key, Type type);
+        void detach();
+
+        // Shared between copies, must be detached before modification
+        std::shared_ptr<std::vector<Entry>> m_entries;
+};
+
+}
@@ -10,12 +10,7 @@
 namespace fast {
 
 unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type) {
-    unique_pixel_ptr ptr;
-    switch(type) {
-        fastSwitchTypeMacro(ptr = make_unique_pixel<FAST_TYPE>(new FAST_TYPE[size]))
-    }
-
-    return ptr;
+    return PixelBufferPool::getInstance()->allocate(size*getSizeOfDataType(type, 1));
 }
 
 // Pad data with 1, 2 or 3 channels to 4 channels with 0
@@ -85,17 +80,124 @@ unique_pixel_ptr adaptImageDataToHostData(unique_pixel_ptr data, cl_channel_orde
 
 
 
+void Image::waitForHostData() {
+    // Wait for any transfers writing to the host data
+    if(!mHostDataWriteEvents.empty()) {
+        cl::Event::waitForEvents(mHostDataWriteEvents);
+        mHostDataWriteEvents.clear();
+    }
+}
+
+void Image::waitForHostDataReads() {
+    // Wait for any transfers reading from the host data
+    if(!mHostDataReadEvents.empty()) {
+        cl::Event::waitForEvents(mHostDataReadEvents);
+        mHostDataReadEvents.clear();
+    }
+    // Kernels enqueued on objects using the host data as storage read the host data directly
+    std::unordered_set<OpenCLDevice::pointer> devices = mCLImagesUsingHostData;
+    devices.insert(mCLBuffersUsingHostData.begin(), mCLBuffersUsingHostData.end());
+    for(auto&& device : devices)
+        device->getCommandQueue().finish();
+}
+
+void Image::addHostDataReadEvent(OpenCLDevice::pointer device, cl::Event event) {
+    mHostDataReadEvents.push_back(event);
+    mCLTransferEvents[device] = event;
+}
+
+void Image::synchronizeCLObjectUsingHostData(OpenCLDevice::pointer device, bool isImage, cl_map_flags flags) {
+    // Mapping an object created with CL_MEM_USE_HOST_PTR synchronizes its contents with the host data.
+    // On CPU devices this does not involve any copying.
+    cl::CommandQueue queue = device->getCommandQueue();
+    void* pointer;
+    if(isImage) {
+        std::size_t rowPitch, slicePitch;
+        pointer = queue.enqueueMapImage(*mCLImages[device], CL_TRUE, flags, createOrigoRegion(),
+                                        createRegion(mWidth, mHeight, mDepth), &rowPitch, &slicePitch);
+        queue.enqueueUnmapMemObject(*mCLImages[device], pointer);
+    } else {
+        pointer = queue.enqueueMapBuffer(*mCLBuffers[device], CL_TRUE, flags, 0, getBufferSize());
+        queue.enqueueUnmapMemObject(*mCLBuffers[device], pointer);
+    }
+}
+
+bool Image::canUseHostData(OpenCLDevice::pointer device, bool isImage) const {
+    // The memory layout of the host data and the image has to be equal
+    return device->isCPU() && (!isImage || canCopyBetweenImageAndBuffer(device));
+}
+
+void Image::allocateHostDataForDevice() {
+    if(mHostHasData) {
+        waitForHostData();
+        return;
+    }
+    mHostDataIsUpToDate = !hasAnyData();
+    mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels, mType);
+    mHostHasData = true;
+}
+
+void Image::releaseCLImage(OpenCLDevice::pointer device) {
+    if(mCLImages.count(device) > 0) {
+        if(mCLImagesUsingHostData.erase(device) > 0) {
+            // Images using host data are bound to it, and are not leased from the memory pool
+            if(mDimensions == 2) {
+                delete (cl::Image2D*)mCLImages[device];
+            } else {
+                delete (cl::Image3D*)mCLImages[device];
+            }
+        } else {
+            device->getMemoryPool()->returnImage(mCLImages[device]);
+        }
+    }
+    mCLImages.erase(device);
+    mCLImagesIsUpToDate.erase(device);
+}
+
+void Image::releaseCLBuffer(OpenCLDevice::pointer device) {
+    if(mCLBuffers.count(device) > 0) {
+        if(mCLBuffersUsingHostData.erase(device) > 0) {
+            delete mCLBuffers[device];
+        } else {
+            device->getMemoryPool()->returnBuffer(mCLBuffers[device]);
+        }
+    }
+    mCLBuffers.erase(device);
+    mCLBuffersIsUpToDate.erase(device);
+}
+
+void Image::releaseCLObjectsUsingHostData() {
+    auto images = mCLImagesUsingHostData;
+    for(auto&& device : images)
+        releaseCLImage(device);
+    auto buffers = mCLBuffersUsingHostData;
+    for(auto&& device : buffers)
+        releaseCLBuffer(device);
+}
+
 void Image::transferCLImageFromHost(OpenCLDevice::pointer device) {
+    waitForHostData();
+    if(mCLImagesUsingHostData.count(device) > 0) {
+        synchronizeCLObjectUsingHostData(device, true, CL_MAP_WRITE);
+        return;
+    }
 
     // Special treatment for images with 3 channels because an OpenCL image can only have 1, 2 or 4 channels
 	// And if the device does not support 1 or 2 channels
     cl::ImageFormat format = getOpenCLImageFormat(device, mDimensions == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D, mType, mChannels);
     if(format.image_channel_order == CL_RGBA && mChannels != 4) {
+        // Temporary data is deleted when this function returns, thus this transfer must be blocking
         auto tempData = adaptDataToImage(mHostData.get(), CL_RGBA, mWidth*mHeight*mDepth, mType, mChannels);
         device->getCommandQueue().enqueueWriteImage(*(cl::Image*)mCLImages[device],
         CL_TRUE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
                 0, (void*)tempData);
         deleteArray((void*)tempData, mType);
+    } else if(Config::getAsynchronousTransfers()) {
+        cl::Event event;
+        device->getCommandQueue().enqueueWriteImage(*(cl::Image*)mCLImages[device],
+        CL_FALSE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
+                0, mHostData.get(), NULL, &event);
+        addHostDataReadEvent(device, event);
     } else {
         device->getCommandQueue().enqueueWriteImage(*(cl::Image*)mCLImages[device],
         CL_TRUE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
@@ -104,24 +206,45 @@ void Image::transferCLImageFromHost(OpenCLDevice::pointer device) {
 }
 
 void Image::transferCLImageToHost(OpenCLDevice::pointer device) {
+    if(mCLImagesUsingHostData.count(device) > 0) {
+        synchronizeCLObjectUsingHostData(device, true, CL_MAP_READ);
+        return;
+    }
     // Special treatment for images with 3 channels because an OpenCL image can only have 1, 2 or 4 channels
 	// And if the device does not support 1 or 2 channels
     cl::ImageFormat format = getOpenCLImageFormat(device, mDimensions == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D, mType, mChannels);
     if(format.image_channel_order == CL_RGBA && mChannels != 4) {
+        // Data has to be adapted after reading, thus this transfer must be blocking
+        waitForHostDataReads();
         auto tempData = allocatePixelArray(mWidth*mHeight*mDepth*4, mType);
         device->getCommandQueue().enqueueReadImage(*(cl::Image*)mCLImages[device],
         CL_TRUE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
                 0, tempData.get());
-        mHostData = adaptImageDataToHostData(std::move(tempData), CL_RGBA, mWidth*mHeight*mDepth,mType,mChannels);
+        auto hostData = adaptImageDataToHostData(std::move(tempData), CL_RGBA, mWidth*mHeight*mDepth,mType,mChannels);
+        if(mHostHasData && (!mCLImagesUsingHostData.empty() || !mCLBuffersUsingHostData.empty())) {
+            // OpenCL objects use the current host data, thus it can't be replaced
+            std::memcpy(mHostData.get(), hostData.get(), getBufferSize());
+        } else {
+            mHostData = std::move(hostData);
+        }
     } else {
+        waitForHostDataReads();
         if(!mHostHasData) {
             // Must allocate memory for host data
             mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels,mType);
 			mHostHasData = true;
         }
-        device->getCommandQueue().enqueueReadImage(*(cl::Image*)mCLImages[device],
-        CL_TRUE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
-                0, mHostData.get());
+        if(Config::getAsynchronousTransfers()) {
+            cl::Event event;
+            device->getCommandQueue().enqueueReadImage(*(cl::Image*)mCLImages[device],
+            CL_FALSE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
+                    0, mHostData.get(), NULL, &event);
+            mHostDataWriteEvents.push_back(event);
+        } else {
+            device->getCommandQueue().enqueueReadImage(*(cl::Image*)mCLImages[device],
+            CL_TRUE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
+                    0, mHostData.get());
+        }
     }
 }
 
@@ -129,6 +252,95 @@ bool Image::hasAnyData() {
     return mHostHasData || mCLImages.size() > 0 || mCLBuffers.size() > 0;
 }
 
+static bool isSameContext(OpenCLDevice::pointer device1, OpenCLDevice::pointer device2) {
+    return device1 == device2 || device1->getContext()() == device2->getContext()();
+}
+
+// A copy enqueued on the queue of another device must wait for all commands on the source device
+static std::vector<cl::Event> getCopyWaitList(OpenCLDevice::pointer source, OpenCLDevice::pointer destination) {
+    std::vector<cl::Event> waitList;
+    if(source != destination) {
+        cl::Event marker;
+        source->getCommandQueue().enqueueMarkerWithWaitList(NULL, &marker);
+        waitList.push_back(marker);
+    }
+    return waitList;
+}
+
+static bool isSameImageFormat(cl::ImageFormat format1, cl::ImageFormat format2) {
+    return format1.image_channel_order == format2.image_channel_order &&
+        format1.image_channel_data_type == format2.image_channel_data_type;
+}
+
+cl::ImageFormat Image::getDeviceImageFormat(OpenCLDevice::pointer device) const {
+    return getOpenCLImageFormat(device, mDimensions == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D, mType, mChannels);
+}
+
+bool Image::canCopyBetweenImageAndBuffer(OpenCLDevice::pointer device) const {
+    // Images with 3 channels, or with 1 or 2 channels on devices which don't support it, are stored as RGBA
+    // images, and then the memory layout of the image and the buffer differs
+    cl::ImageFormat format = getDeviceImageFormat(device);
+    return !(format.image_channel_order == CL_RGBA && mChannels != 4);
+}
+
+bool Image::copyCLImageFromDevice(OpenCLDevice::pointer device) {
+    const auto origo = createOrigoRegion();
+    const auto region = createRegion(mWidth, mHeight, mDepth);
+    for(auto&& it : mCLImagesIsUpToDate) {
+        if(!it.second || it.first == device || !isSameContext(it.first, device) ||
+                !isSameImageFormat(getDeviceImageFormat(it.first), getDeviceImageFormat(device)))
+            continue;
+        auto waitList = getCopyWaitList(it.first, device);
+        cl::Event event;
+        device->getCommandQueue().enqueueCopyImage(*mCLImages[it.first], *mCLImages[device], origo, origo, region,
+                                                   &waitList, &event);
+        if(it.first != device)
+            event.wait();
+        return true;
+    }
+    if(!canCopyBetweenImageAndBuffer(device))
+        return false;
+    for(auto&& it : mCLBuffersIsUpToDate) {
+        if(!it.second || !isSameContext(it.first, device))
+            continue;
+        auto waitList = getCopyWaitList(it.first, device);
+        cl::Event event;
+        device->getCommandQueue().enqueueCopyBufferToImage(*mCLBuffers[it.first], *mCLImages[device], 0, origo,
+                                                           region, &waitList, &event);
+        if(it.first != device)
+            event.wait();
+        return true;
+    }
+    return false;
+}
+
+bool Image::copyCLBufferFromDevice(OpenCLDevice::pointer device) {
+    for(auto&& it : mCLBuffersIsUpToDate) {
+        if(!it.second || it.first == device || !isSameContext(it.first, device))
+            continue;
+        auto waitList = getCopyWaitList(it.first, device);
+        cl::Event event;
+        device->getCommandQueue().enqueueCopyBuffer(*mCLBuffers[it.first], *mCLBuffers[device], 0, 0, getBufferSize(),
+                                                    &waitList, &event);
+        if(it.first != device)
+            event.wait();
+        return true;
+    }
+    for(auto&& it : mCLImagesIsUpToDate) {
+        if(!it.second || !isSameContext(it.first, device) || !canCopyBetweenImageAndBuffer(it.first))
+            continue;
+        auto waitList = getCopyWaitList(it.first, device);
+        cl::Event event;
+        device->getCommandQueue().enqueueCopyImageToBuffer(*mCLImages[it.first], *mCLBuffers[device],
+                                                           createOrigoRegion(), createRegion(mWidth, mHeight, mDepth),
+                                                           0, &waitList, &event);
+        if(it.first != device)
+            event.wait();
+        return true;
+    }
+    return false;
+}
+
 void Image::updateOpenCLImageData(OpenCLDevice::pointer device) {
 
     // If data exist on device and is up to date do nothing
@@ -140,15 +352,27 @@ void Image::updateOpenCLImageData(OpenCLDevice::pointer device) {
     if (mCLImagesIsUpToDate.count(device) == 0) {
         // Data is not on device, create it
         cl::Image * newImage;
-        if(mDimensions == 2) {
-            newImage = new cl::Image2D(device->getContext(),
+        const bool anyData = hasAnyData();
+        if(canUseHostData(device, true)) {
+            // Use the host data as storage of the image, thus host and device share one allocation
+            allocateHostDataForDevice();
+            if(mDimensions == 2) {
+                newImage = new cl::Image2D(device->getContext(), CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR,
+                    getDeviceImageFormat(device), mWidth, mHeight, 0, mHostData.get());
+            } else {
+                newImage = new cl::Image3D(device->getContext(), CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR,
+                    getDeviceImageFormat(device), mWidth, mHeight, mDepth, 0, 0, mHostData.get());
+            }
+            mCLImagesUsingHostData.insert(device);
+        } else if(mDimensions == 2) {
+            newImage = device->getMemoryPool()->leaseImage(
             CL_MEM_READ_WRITE, getOpenCLImageFormat(device, CL_MEM_OBJECT_IMAGE2D, mType,mChannels), mWidth, mHeight);
         } else {
-            newImage = new cl::Image3D(device->getContext(),
+            newImage = device->getMemoryPool()->leaseImage(
             CL_MEM_READ_WRITE, getOpenCLImageFormat(device, CL_MEM_OBJECT_IMAGE3D, mType,mChannels), mWidth, mHeight, mDepth);
         }
 
-        if(hasAnyData()) {
+        if(anyData) {
             mCLImagesIsUpToDate[device] = false;
         } else {
             mCLImagesIsUpToDate[device] = true;
@@ -163,30 +387,34 @@ void Image::updateOpenCLImageData(OpenCLDevice::pointer device) {
 			// Transfer host data to this device
 			transferCLImageFromHost(device);
 			updated = true;
+		} else if(mCLImagesUsingHostData.count(device) > 0) {
+			// Image uses the host data, thus update the host data first
+			updateHostData();
+			mHostDataIsUpToDate = true;
+			transferCLImageFromHost(device);
+			updated = true;
 		} else {
+			// Copy directly from another OpenCL image or buffer if possible
+			updated = copyCLImageFromDevice(device);
 			std::unordered_map<OpenCLDevice::pointer, bool>::iterator it;
-			for (it = mCLImagesIsUpToDate.begin(); it != mCLImagesIsUpToDate.end();
+			for (it = mCLImagesIsUpToDate.begin(); it != mCLImagesIsUpToDate.end() && !updated;
 				it++) {
 				if (it->second == true) {
-					// Transfer from this device(it->first) to device
-					// TODO should use copy image to image here, if possible
+					// Transfer from this device(it->first) to device through host
 					transferCLImageToHost(it->first);
 					transferCLImageFromHost(device);
 					mHostDataIsUpToDate = true;
 					updated = true;
-					break;
 				}
 			}
-			for (it = mCLBuffersIsUpToDate.begin(); it != mCLBuffersIsUpToDate.end();
+			for (it = mCLBuffersIsUpToDate.begin(); it != mCLBuffersIsUpToDate.end() && !updated;
 				it++) {
 				if (it->second == true) {
-					// Transfer from this device(it->first) to device
-					// TODO should use copy buffer to image here, if possible
+					// Transfer from this device(it->first) to device through host
 					transferCLBufferToHost(it->first);
 					transferCLImageFromHost(device);
 					mHostDataIsUpToDate = true;
 					updated = true;
-					break;
 				}
 			}
 		}
@@ -222,8 +450,12 @@ OpenCLBufferAccess::pointer Image::getOpenCLBufferAccess(
         mDataIsBeingAccessed = true;
     }
 
-    // Now it is guaranteed that the data is on the device and that it is up to date
-	OpenCLBufferAccess::pointer accessObject(new OpenCLBufferAccess(mCLBuffers[device],  std::static_pointer_cast<Image>(mPtr.lock())));
+    // Now it is guaranteed that the data is on the device and that it is up to date,
+    // or that a transfer to the device has been enqueued
+    std::vector<cl::Event> events;
+    if(mCLTransferEvents.count(device) > 0)
+        events.push_back(mCLTransferEvents[device]);
+	OpenCLBufferAccess::pointer accessObject(new OpenCLBufferAccess(mCLBuffers[device],  std::static_pointer_cast<Image>(mPtr.lock()), events));
 	return std::move(accessObject);
 }
 
@@ -248,10 +480,18 @@ void Image::updateOpenCLBufferData(OpenCLDevice::pointer device) {
     if (mCLBuffers.count(device) == 0) {
         // Data is not on device, create it
         unsigned int bufferSize = getBufferSize();
-        cl::Buffer * newBuffer = new cl::Buffer(device->getContext(),
-        CL_MEM_READ_WRITE, bufferSize);
+        cl::Buffer * newBuffer;
+        const bool anyData = hasAnyData();
+        if(canUseHostData(device, false)) {
+            // Use the host data as storage of the buffer, thus host and device share one allocation
+            allocateHostDataForDevice();
+            newBuffer = new cl::Buffer(device->getContext(), CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, bufferSize, mHostData.get());
+            mCLBuffersUsingHostData.insert(device);
+        } else {
+            newBuffer = device->getMemoryPool()->leaseBuffer(CL_MEM_READ_WRITE, bufferSize);
+        }
 
-        if(hasAnyData()) {
+        if(anyData) {
             mCLBuffersIsUpToDate[device] = false;
         } else {
             mCLBuffersIsUpToDate[device] = true;
@@ -267,28 +507,34 @@ void Image::updateOpenCLBufferData(OpenCLDevice::pointer device) {
             // Transfer host data to this device
             transferCLBufferFromHost(device);
             updated = true;
+        } else if(mCLBuffersUsingHostData.count(device) > 0) {
+            // Buffer uses the host data, thus update the host data first
+            updateHostData();
+            mHostDataIsUpToDate = true;
+            transferCLBufferFromHost(device);
+            updated = true;
         } else {
+            // Copy directly from another OpenCL image or buffer if possible
+            updated = copyCLBufferFromDevice(device);
             std::unordered_map<OpenCLDevice::pointer, bool>::iterator it;
-            for (it = mCLImagesIsUpToDate.begin(); it != mCLImagesIsUpToDate.end();
+            for (it = mCLImagesIsUpToDate.begin(); it != mCLImagesIsUpToDate.end() && !updated;
                     it++) {
                 if (it->second == true) {
-                    // Transfer from this device(it->first) to device
+                    // Transfer from this device(it->first) to device through host
                     transferCLImageToHost(it->first);
                     transferCLBufferFromHost(device);
                     mHostDataIsUpToDate = true;
                     updated = true;
-                    break;
                 }
             }
-            for (it = mCLBuffersIsUpToDate.begin(); it != mCLBuffersIsUpToDate.end();
+            for (it = mCLBuffersIsUpToDate.begin(); it != mCLBuffersIsUpToDate.end() && !updated;
                     it++) {
                 if (it->second == true) {
-                    // Transfer from this device(it->first) to device
+                    // Transfer from this device(it->first) to device through host
                     transferCLBufferToHost(it->first);
                     transferCLBufferFromHost(device);
                     mHostDataIsUpToDate = true;
                     updated = true;
-                    break;
                 }
             }
         }
@@ -302,20 +548,44 @@ void Image::updateOpenCLBufferData(OpenCLDevice::pointer device) {
 }
 
 void Image::transferCLBufferFromHost(OpenCLDevice::pointer device) {
+    waitForHostData();
+    if(mCLBuffersUsingHostData.count(device) > 0) {
+        synchronizeCLObjectUsingHostData(device, false, CL_MAP_WRITE);
+        return;
+    }
     unsigned int bufferSize = getBufferSize();
-    device->getCommandQueue().enqueueWriteBuffer(*mCLBuffers[device],
-        CL_TRUE, 0, bufferSize, mHostData.get());
+    if(Config::getAsynchronousTransfers()) {
+        cl::Event event;
+        device->getCommandQueue().enqueueWriteBuffer(*mCLBuffers[device],
+            CL_FALSE, 0, bufferSize, mHostData.get(), NULL, &event);
+        addHostDataReadEvent(device, event);
+    } else {
+        device->getCommandQueue().enqueueWriteBuffer(*mCLBuffers[device],
+            CL_TRUE, 0, bufferSize, mHostData.get());
+    }
 }
 
 void Image::transferCLBufferToHost(OpenCLDevice::pointer device) {
+    if(mCLBuffersUsingHostData.count(device) > 0) {
+        synchronizeCLObjectUsingHostData(device, false, CL_MAP_READ);
+        return;
+    }
+    waitForHostDataReads();
 	if (!mHostHasData) {
 		// Must allocate memory for host data
 		mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels, mType);
 		mHostHasData = true;
 	}
     unsigned int bufferSize = getBufferSize();
-    device->getCommandQueue().enqueueReadBuffer(*mCLBuffers[device],
-        CL_TRUE, 0, bufferSize, mHostData.get());
+    if(Config::getAsynchronousTransfers()) {
+        cl::Event event;
+        device->getCommandQueue().enqueueReadBuffer(*mCLBuffers[device],
+            CL_FALSE, 0, bufferSize, mHostData.get(), NULL, &event);
+        mHostDataWriteEvents.push_back(event);
+    } else {
+        device->getCommandQueue().enqueueReadBuffer(*mCLBuffers[device],
+            CL_TRUE, 0, bufferSize, mHostData.get());
+    }
 }
 
 void Image::updateHostData() {
@@ -403,12 +673,16 @@ OpenCLImageAccess::pointer Image::getOpenCLImageAccess(
     }
     mCLImagesIsUpToDate[device] = true;
 
-    // Now it is guaranteed that the data is on the device and that it is up to date
+    // Now it is guaranteed that the data is on the device and that it is up to date,
+    // or that a transfer to the device has been enqueued
+    std::vector<cl::Event> events;
+    if(mCLTransferEvents.count(device) > 0)
+        events.push_back(mCLTransferEvents[device]);
     if(mDimensions == 2) {
-        OpenCLImageAccess::pointer accessObject(new OpenCLImageAccess((cl::Image2D*)mCLImages[device], std::static_pointer_cast<Image>(mPtr.lock())));
+        OpenCLImageAccess::pointer accessObject(new OpenCLImageAccess((cl::Image2D*)mCLImages[device], std::static_pointer_cast<Image>(mPtr.lock()), events));
         return accessObject;
     } else {
-        OpenCLImageAccess::pointer accessObject(new OpenCLImageAccess((cl::Image3D*)mCLImages[device], std::static_pointer_cast<Image>(mPtr.lock())));
+        OpenCLImageAccess::pointer accessObject(new OpenCLImageAccess((cl::Image3D*)mCLImages[device], std::static_pointer_cast<Image>(mPtr.lock()), events));
         return accessObject;
     }
 }
@@ -435,6 +709,8 @@ ImageAccess::pointer Image::getImageAccess(accessType type) {
     }
     updateHostData();
     if(type == ACCESS_READ_WRITE) {
+        // Host data can't be changed while it is being transferred to a device
+        waitForHostDataReads();
         setAllDataToOutOfDate();
         updateModifiedTimestamp();
     }
@@ -444,6 +720,8 @@ ImageAccess::pointer Image::getImageAccess(accessType type) {
         mDataIsBeingAccessed = true;
     }
 
+    // Wait once for pending transfers to the host, so that the access can index the data directly
+    waitForHostData();
 	ImageAccess::pointer accessObject(new ImageAccess(mHostData.get(), std::static_pointer_cast<Image>(mPtr.lock())));
 	return std::move(accessObject);
 }
@@ -590,6 +868,8 @@ void Image::copyData(ExecutionDevice::pointer device, const void* const data) {
         throw Exception("Image must be initialized");
     // We do not own this pointer, have to copy it
     if(device->isHost()) {
+        waitForHostDataReads();
+        releaseCLObjectsUsingHostData();
         mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels, mType);
         std::memcpy(mHostData.get(), data, getSizeOfDataType(mType, mChannels) * mWidth * mHeight * mDepth);
         mHostHasData = true;
@@ -604,24 +884,22 @@ void Image::copyData(ExecutionDevice::pointer device, const void* const data) {
             tempData = (void*)adaptDataToImage(data, getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE2D, mType,
                                                                          mChannels).image_channel_order,
                                               mWidth * mHeight, mType, mChannels);
-            clImage = new cl::Image2D(
-                    clDevice->getContext(),
-                    CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            clImage = clDevice->getMemoryPool()->leaseImage(
+                    CL_MEM_READ_WRITE,
                     getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE2D, mType, mChannels),
-                    mWidth, mHeight,
-                    0,
-                    tempData
+                    mWidth, mHeight
             );
+            clDevice->getCommandQueue().enqueueWriteImage(*clImage, CL_TRUE, createOrigoRegion(),
+                    createRegion(mWidth, mHeight, 1), 0, 0, tempData);
         } else {
             tempData = (void*)adaptDataToImage(data, getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE3D, mType, mChannels).image_channel_order, mWidth*mHeight*mDepth, mType, mChannels);
-            clImage = new cl::Image3D(
-                clDevice->getContext(),
-                CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            clImage = clDevice->getMemoryPool()->leaseImage(
+                CL_MEM_READ_WRITE,
                 getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE3D, mType, mChannels),
-                mWidth, mHeight, mDepth,
-                0, 0,
-                tempData
+                mWidth, mHeight, mDepth
             );
+            clDevice->getCommandQueue().enqueueWriteImage(*clImage, CL_TRUE, createOrigoRegion(),
+                    createRegion(mWidth, mHeight, mDepth), 0, 0, tempData);
         }
         mCLImages[clDevice] = clImage;
         mCLImagesIsUpToDate[clDevice] = true;
@@ -636,6 +914,8 @@ void Image::setData(ExecutionDevice::pointer device, void* data) {
         throw Exception("Image must be initialized");
 
     if(device->isHost()) {
+        waitForHostDataReads();
+        releaseCLObjectsUsingHostData();
         // Since we own the data pointer, we can put it in an unique_ptr:
         switch(mType) {
             fastSwitchTypeMacro(mHostData = make_unique_pixel<FAST_TYPE>((FAST_TYPE*)data))
@@ -651,6 +931,35 @@ void Image::setData(ExecutionDevice::pointer device, void* data) {
     mIsInitialized = true;
 }
 
+void Image::setData(ExecutionDevice::pointer device, unique_pixel_ptr data) {
+    if(!mIsInitialized)
+        throw Exception("Image must be initialized");
+
+    if(device->isHost()) {
+        waitForHostDataReads();
+        releaseCLObjectsUsingHostData();
+        mHostData = std::move(data);
+        mHostHasData = true;
+        mHostDataIsUpToDate = true;
+    } else {
+        // For OpenCL we have to do a copy, the data is returned to the pool when this function returns
+        copyData(device, data.get());
+    }
+    updateModifiedTimestamp();
+}
+
+void Image::create(VectorXui size, DataType type, uint nrOfChannels, ExecutionDevice::pointer device, unique_pixel_ptr data) {
+    create(size, type, nrOfChannels);
+
+    setData(device, std::move(data));
+}
+
+void Image::create(uint width, uint height, DataType type, uint nrOfChannels, unique_pixel_ptr data) {
+    create(width, height, type, nrOfChannels);
+
+    setData(DeviceManager::getInstance()->getDefaultComputationDevice(), std::move(data));
+}
+
 bool Image::isInitialized() const {
     return mIsInitialized;
 }
@@ -658,37 +967,32 @@ bool Image::isInitialized() const {
 void Image::free(ExecutionDevice::pointer device) {
     // Delete data on a specific device
     if(device->isHost()) {
+        // Host data can't be deleted while it is being transferred, or used by OpenCL objects
+        waitForHostData();
+        waitForHostDataReads();
+        releaseCLObjectsUsingHostData();
         mHostData.reset();
         mHostHasData = false;
     } else {
         OpenCLDevice::pointer clDevice = std::static_pointer_cast<OpenCLDevice>(device);
-        // Delete any OpenCL images
-        delete mCLImages[clDevice];
-        mCLImages.erase(clDevice);
-        mCLImagesIsUpToDate.erase(clDevice);
-        // Delete any OpenCL buffers
-        delete mCLBuffers[clDevice];
-        mCLBuffers.erase(clDevice);
-        mCLBuffersIsUpToDate.erase(clDevice);
+        // Return any OpenCL images and buffers to the memory pool of the device
+        releaseCLImage(clDevice);
+        releaseCLBuffer(clDevice);
+        mCLTransferEvents.erase(clDevice);
     }
 }
 
 void Image::freeAll() {
-    // Delete OpenCL Images
-    std::unordered_map<OpenCLDevice::pointer, cl::Image*>::iterator it;
-    for (it = mCLImages.begin(); it != mCLImages.end(); it++) {
-        delete it->second;
-    }
-    mCLImages.clear();
+    // OpenCL objects using the host data may still be used by enqueued commands
+    waitForHostDataReads();
+    // Return OpenCL Images and buffers to the memory pool of each device
+    while(!mCLImages.empty())
+        releaseCLImage(mCLImages.begin()->first);
     mCLImagesIsUpToDate.clear();
-
-    // Delete OpenCL buffers
-    std::unordered_map<OpenCLDevice::pointer, cl::Buffer*>::iterator it2;
-    for (it2 = mCLBuffers.begin(); it2 != mCLBuffers.end(); it2++) {
-        delete it2->second;
-    }
-    mCLBuffers.clear();
+    while(!mCLBuffers.empty())
+        releaseCLBuffer(mCLBuffers.begin()->first);
     mCLBuffersIsUpToDate.clear();
+    mCLTransferEvents.clear();
 
     // Delete host data
     if(mHostHasData) {
@@ -1032,15 +1336,13 @@ void Image::fill(float value) {
     	cl::Image* clImage;
         OpenCLDevice::pointer clDevice = std::dynamic_pointer_cast<OpenCLDevice>(DeviceManager::getInstance()->getDefaultComputationDevice());
     	if(getDimensions() == 2) {
-			clImage = new cl::Image2D(
-				clDevice->getContext(),
+			clImage = clDevice->getMemoryPool()->leaseImage(
 				CL_MEM_READ_WRITE,
 				getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE2D, mType, mChannels),
 				mWidth, mHeight
 			);
     	} else {
-			clImage = new cl::Image3D(
-				clDevice->getContext(),
+			clImage = clDevice->getMemoryPool()->leaseImage(
 				CL_MEM_READ_WRITE,
 				getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE3D, mType, mChannels),
 				mWidth, mHeight, mDepth
@@ -1148,6 +1450,7 @@ Image::pointer Image::crop(VectorXi offset, VectorXi size, bool allowOutOfBounds
     if(device->isHost()) { // If data is only on host, copy data to GPU first
         // TODO implement cropping on host instead
         clDevice = std::dynamic_pointer_cast<OpenCLDevice>(DeviceManager::getInstance()->getDefaultComputationDevice());
+        waitForHostData();
         copyData(clDevice, mHostData.get());
     } else {
         clDevice = std::static_pointer_cast<OpenCLDevice>(device);
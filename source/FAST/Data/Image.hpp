@@ -7,12 +7,12 @@
 #include <FAST/Data/Access/OpenCLImageAccess.hpp>
 #include <FAST/Data/Access/OpenCLBufferAccess.hpp>
 #include <FAST/DeviceManager.hpp>
+#include <FAST/Data/PixelBufferPool.hpp>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace fast {
 
-using pixel_deleter_t = std::function<void(void *)>;
-using unique_pixel_ptr = std::unique_ptr<void, pixel_deleter_t>;
 template<typename T>
 auto pixel_deleter(void const * data) -> void
 {
@@ -25,7 +25,10 @@ template<typename T>
 auto make_unique_pixel(T * ptr) -> unique_pixel_ptr {
     return unique_pixel_ptr(ptr, &pixel_deleter<T>);
 }
-unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type);
+/**
+ * Allocate an uninitialized array of size elements of the given type from the PixelBufferPool
+ */
+FAST_EXPORT unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type);
 
 class FAST_EXPORT  Image : public SpatialDataObject {
     FAST_OBJECT(Image)
@@ -202,6 +205,27 @@ class FAST_EXPORT  Image : public SpatialDataObject {
         template <class T>
         void create(VectorXui, DataType type, uint nrOfChannels, std::unique_ptr<T> ptr);
 
+        /**
+         * Moves the 2D/3D pixel data pointer, e.g. created by allocatePixelArray, to the given device
+         *
+         * @param size
+         * @param type
+         * @param nrOfChannels
+         * @param device
+         * @param data
+         */
+        void create(VectorXui size, DataType type, uint nrOfChannels, ExecutionDevice::pointer device, unique_pixel_ptr data);
+        /**
+         * Moves the 2D pixel data pointer, e.g. created by allocatePixelArray, to the default device
+         *
+         * @param width
+         * @param height
+         * @param type
+         * @param nrOfChannels
+         * @param data
+         */
+        void create(uint width, uint height, DataType type, uint nrOfChannels, unique_pixel_ptr data);
+
         OpenCLImageAccess::pointer getOpenCLImageAccess(accessType type, OpenCLDevice::pointer);
         OpenCLBufferAccess::pointer getOpenCLBufferAccess(accessType type, OpenCLDevice::pointer);
         ImageAccess::pointer getImageAccess(accessType type);
@@ -259,6 +283,13 @@ class FAST_EXPORT  Image : public SpatialDataObject {
          * @param data
          */
         void setData(ExecutionDevice::pointer device, void* data);
+        /**
+         * Give pixel data to appropriate device
+         *
+         * @param device
+         * @param data
+         */
+        void setData(ExecutionDevice::pointer device, unique_pixel_ptr data);
         /**
          * Copy data to appropriate device
          *
@@ -282,6 +313,40 @@ class FAST_EXPORT  Image : public SpatialDataObject {
         bool mHostHasData;
         bool mHostDataIsUpToDate;
 
+        // Events of pending asynchronous transfers, see Config::setAsynchronousTransfers
+        // Transfers from a device to the host data
+        std::vector<cl::Event> mHostDataWriteEvents;
+        // Transfers from the host data to a device
+        std::vector<cl::Event> mHostDataReadEvents;
+        // Last transfer to each device
+        std::unordered_map<OpenCLDevice::pointer, cl::Event> mCLTransferEvents;
+        /**
+         * Block until all pending transfers to the host data have finished
+         */
+        void waitForHostData();
+        /**
+         * Block until all pending transfers from the host data to devices have finished, and all commands
+         * enqueued on devices with OpenCL objects using the host data as storage.
+         * Has to be done before the host data is changed or deleted.
+         */
+        void waitForHostDataReads();
+        void addHostDataReadEvent(OpenCLDevice::pointer device, cl::Event event);
+
+        // Devices where the OpenCL image/buffer use the host data as storage (CL_MEM_USE_HOST_PTR).
+        // This is done on CPU devices to avoid copying data between host and device.
+        std::unordered_set<OpenCLDevice::pointer> mCLImagesUsingHostData;
+        std::unordered_set<OpenCLDevice::pointer> mCLBuffersUsingHostData;
+        bool canUseHostData(OpenCLDevice::pointer device, bool isImage) const;
+        void allocateHostDataForDevice();
+        void synchronizeCLObjectUsingHostData(OpenCLDevice::pointer device, bool isImage, cl_map_flags flags);
+        /**
+         * Delete all OpenCL images and buffers which use the host data.
+         * Has to be done before the host data is replaced or deleted.
+         */
+        void releaseCLObjectsUsingHostData();
+        void releaseCLImage(OpenCLDevice::pointer device);
+        void releaseCLBuffer(OpenCLDevice::pointer device);
+
         void setAllDataToOutOfDate();
         bool isInitialized() const;
 
@@ -290,6 +355,15 @@ class FAST_EXPORT  Image : public SpatialDataObject {
         void transferCLImageToHost(OpenCLDevice::pointer device);
 
         void updateOpenCLBufferData(OpenCLDevice::pointer device);
+        /**
+         * Copy data directly from an up to date OpenCL image or buffer on a device with the same context.
+         * @param device
+         * @return false if no such copy was possible, and the data has to be transferred through host
+         */
+        bool copyCLImageFromDevice(OpenCLDevice::pointer device);
+        bool copyCLBufferFromDevice(OpenCLDevice::pointer device);
+        bool canCopyBetweenImageAndBuffer(OpenCLDevice::pointer device) const;
+        cl::ImageFormat getDeviceImageFormat(OpenCLDevice::pointer device) const;
         void transferCLBufferFromHost(OpenCLDevice::pointer device);
         void transferCLBufferToHost(OpenCLDevice::pointer device);
 
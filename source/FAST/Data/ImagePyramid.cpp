@@ -3,25 +3,12 @@
 #include <FAST/Utility.hpp>
 #include <FAST/Data/Image.hpp>
 #include <FAST/Data/Access/ImagePyramidAccess.hpp>
-#ifdef WIN32
-#include <winbase.h>
-#else
-#include <sys/mman.h>
-#include <fcntl.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <unistd.h>
-#endif
 
 namespace fast {
 
 int ImagePyramid::m_counter = 0;
 
 void ImagePyramid::create(int width, int height, int channels, int levels) {
-    // TODO Create memory mapped files on disk to use as virtual memory
-
     if(channels <= 0 || channels > 4)
         throw Exception("Nr of channels must be between 1 and 4");
 
@@ -48,84 +35,12 @@ void ImagePyramid::create(int width, int height, int channels, int levels) {
 		ImagePyramidLevel levelData;
 		levelData.width = currentWidth;
 		levelData.height = currentHeight;
-
-		if(sizeInMB < 512) {
-			// If level is less than X MBs, use system memory
-			levelData.data = new uint8_t[bytes];
-			levelData.memoryMapped = false;
-		} else {
-			reportInfo() << "Using memory mapping.." << reportEnd();
-			uint8_t* data;
-#ifdef WIN32
-			HANDLE hFile = CreateFile(("C:/windows/temp/fast_mmap_" + std::to_string(currentLevel) + "_" + std::to_string(m_counter) + ".bin").c_str(),
-				GENERIC_WRITE | GENERIC_READ,FILE_SHARE_READ | FILE_SHARE_WRITE,
-				NULL, OPEN_ALWAYS, NULL, NULL);
-			if(hFile == nullptr) {
-				throw Exception("Error creating memory mapped file: " + std::to_string(GetLastError()));
-			}
-
-			levelData.fileHandle = hFile;
-
-			HANDLE hMapFile = CreateFileMappingA(
-				//INVALID_HANDLE_VALUE,    // use paging file, Creating Named Shared Memory
-				hFile,
-				NULL,                    // default security
-				PAGE_READWRITE,          // read/write access
-				bytes >> 32,                       // buffer size (high part of 64 bit nr)
-				bytes,                // buffer size (low part of 64 bit nr)
-				("fast_mmap_" + std::to_string(currentLevel)).c_str());                 // name of mapping object
-
-			if(hMapFile == NULL || hMapFile == INVALID_HANDLE_VALUE) {
-				throw Exception("Error opening memory mapped file");
-			}
-
-			data = (uint8_t*) MapViewOfFile(hMapFile,   // handle to map object
-				FILE_MAP_ALL_ACCESS, // read/write permission
-				0,
-				0,
-				bytes);
-			if(data == nullptr) {
-			  throw Exception("Failed to create map view of file: " + std::to_string(GetLastError()));
-			}
-#else
-			int fd = open(("/tmp/fast_mmap_" + std::to_string(currentLevel) + "_" + std::to_string(m_counter) + ".bin").c_str(), O_RDWR | O_CREAT | O_TRUNC, (mode_t)0600);
-			if (fd == -1) {
-				perror("Error opening file for writing");
-				exit(EXIT_FAILURE);
-			}
-
-			// Stretch the file size to the size of the (mmapped) array of ints
-			int result = lseek(fd, bytes-1, SEEK_SET);
-			if (result == -1) {
-				close(fd);
-				perror("Error calling lseek() to 'stretch' the file");
-				exit(EXIT_FAILURE);
-			}
-			result = write(fd, "", 1);
-			if (result != 1) {
-				close(fd);
-				perror("Error writing last byte of the file");
-				exit(EXIT_FAILURE);
-			}
-
-			// Now the file is ready to be mmapped.
-			data = (uint8_t*)mmap64(0, bytes-1, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-			if (data == MAP_FAILED) {
-				close(fd);
-				perror("Error mmapping the file");
-				exit(EXIT_FAILURE);
-			}
-			levelData.fileHandle = fd;
-#endif
-			// Initialize data to all zeros
-			std::memset(data, 0, bytes);
-
-			levelData.data = data;
-			levelData.memoryMapped = true;
-		}
+		// Tiles are allocated when written to, and moved to disk when exceeding the maximum resident size
+		levelData.tiles = std::make_shared<TiledImageStorage>(currentWidth, currentHeight, m_channels, m_tileSize);
+		levelData.tiles->setMaximumResidentBytes(m_maximumResidentBytes);
+		levelData.tiles->setCompression(m_compression);
 		m_levels.push_back(levelData);
 
-		// TODO Initialize data to zeros?
 		reportInfo() << "Done creating level " << currentLevel << reportEnd();
 		++currentLevel;
     }
@@ -136,12 +51,14 @@ void ImagePyramid::create(int width, int height, int channels, int levels) {
 		m_levels[i].patches = std::ceil(m_levels[i].width / 256);
     }
     mBoundingBox = BoundingBox(Vector3f(getFullWidth(), getFullHeight(), 0));
+    initializeDirtyPatches();
     m_initialized = true;
 	m_counter += 1;
 }
 
-void ImagePyramid::create(openslide_t *fileHandle, std::vector<ImagePyramidLevel> levels) {
+void ImagePyramid::create(openslide_t *fileHandle, std::vector<ImagePyramidLevel> levels, std::string filename) {
     m_fileHandle = fileHandle;
+    m_filename = filename;
     m_levels = levels;
     m_channels = 4;
     for(int i = 0; i < m_levels.size(); ++i) {
@@ -150,6 +67,7 @@ void ImagePyramid::create(openslide_t *fileHandle, std::vector<ImagePyramidLevel
 		m_levels[i].patches = std::ceil(m_levels[i].width / 256);// x* x* x + 10;
     }
     mBoundingBox = BoundingBox(Vector3f(getFullWidth(), getFullHeight(), 0));
+    initializeDirtyPatches();
     m_initialized = true;
 	m_counter += 1;
 }
@@ -191,23 +109,11 @@ void ImagePyramid::freeAll() {
         m_levels.clear();
         openslide_close(m_fileHandle);
     } else {
-		for(auto& item : m_levels) {
-			if(item.memoryMapped) {
-#ifdef WIN32
-				UnmapViewOfFile(item.data);
-				CloseHandle(item.fileHandle);
-#else
-				munmap(item.data, item.width*item.height*m_channels);
-				close(item.fileHandle);
-#endif
-			} else {
-				delete[] item.data;
-			}
-		}
         m_levels.clear();
     }
 	m_initialized = false;
 	m_fileHandle = nullptr;
+	m_filename = "";
 }
 
 ImagePyramid::~ImagePyramid() {
@@ -217,6 +123,34 @@ int ImagePyramid::getNrOfChannels() const {
     return m_channels;
 }
 
+void ImagePyramid::setTileSize(int size) {
+    if(m_initialized)
+        throw Exception("Tile size of ImagePyramid must be set before create");
+    if(size <= 0)
+        throw Exception("Tile size must be larger than 0");
+    m_tileSize = size;
+}
+
+void ImagePyramid::setMaximumResidentBytes(std::size_t bytes) {
+    m_maximumResidentBytes = bytes;
+    for(auto&& level : m_levels) {
+        if(level.tiles)
+            level.tiles->setMaximumResidentBytes(bytes);
+    }
+}
+
+void ImagePyramid::setCompression(bool compress) {
+    m_compression = compress;
+    for(auto&& level : m_levels) {
+        if(level.tiles)
+            level.tiles->setCompression(compress);
+    }
+}
+
+std::string ImagePyramid::getFilename() const {
+    return m_filename;
+}
+
 ImagePyramidAccess::pointer ImagePyramid::getAccess(accessType type) {
     if(!m_initialized)
         throw Exception("ImagePyramid has not been initialized.");
@@ -241,22 +175,88 @@ ImagePyramidAccess::pointer ImagePyramid::getAccess(accessType type) {
     return std::make_unique<ImagePyramidAccess>(m_levels, m_fileHandle, std::static_pointer_cast<ImagePyramid>(mPtr.lock()), type == ACCESS_READ_WRITE);
 }
 
+void ImagePyramid::initializeDirtyPatches() {
+	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
+	m_dirtyPatches.clear();
+	for(auto&& level : m_levels)
+		m_dirtyPatches.push_back(std::vector<bool>(level.patches*level.patches, false));
+	m_dirtyPatchCount = 0;
+}
+
 void ImagePyramid::setDirtyPatch(int level, int patchIdX, int patchIdY) {
 	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
-	const std::string tileString =
-		std::to_string(level) + "_" + std::to_string(patchIdX) + "_" + std::to_string(patchIdY);
-	m_dirtyPatches.insert(tileString);
+	const int patches = m_levels[level].patches;
+	const int index = patchIdX + patchIdY*patches;
+	if(!m_dirtyPatches[level][index]) {
+		m_dirtyPatches[level][index] = true;
+		m_dirtyPatchCount++;
+	}
 }
 
-std::set<std::string> ImagePyramid::getDirtyPatches() {
+void ImagePyramid::setDirtyRegion(int level, int x, int y, int width, int height) {
+	const int levelWidth = getLevelWidth(level);
+	const int levelHeight = getLevelHeight(level);
+	const int patches = getLevelPatches(level);
+	const int startX = std::max(x, 0);
+	const int startY = std::max(y, 0);
+	const int endX = std::min(x + width, levelWidth) - 1;
+	const int endY = std::min(y + height, levelHeight) - 1;
+	if(endX < startX || endY < startY)
+		return;
+	const int startPatchX = std::floor(((float)startX / levelWidth)*patches);
+	const int startPatchY = std::floor(((float)startY / levelHeight)*patches);
+	const int endPatchX = std::floor(((float)endX / levelWidth)*patches);
+	const int endPatchY = std::floor(((float)endY / levelHeight)*patches);
 	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
-	return m_dirtyPatches;
+	for(int patchY = startPatchY; patchY <= endPatchY; ++patchY) {
+		for(int patchX = startPatchX; patchX <= endPatchX; ++patchX) {
+			const int index = patchX + patchY*patches;
+			if(!m_dirtyPatches[level][index]) {
+				m_dirtyPatches[level][index] = true;
+				m_dirtyPatchCount++;
+			}
+		}
+	}
 }
 
-void ImagePyramid::clearDirtyPatches(std::set<std::string> patches) {
+bool ImagePyramid::isDirtyPatch(int level, int patchIdX, int patchIdY) {
 	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
-	for(auto&& patch : patches)
-		m_dirtyPatches.erase(patch);
+	if(m_dirtyPatchCount == 0)
+		return false;
+	return m_dirtyPatches[level][patchIdX + patchIdY*m_levels[level].patches];
 }
 
+void ImagePyramid::clearDirtyPatch(int level, int patchIdX, int patchIdY) {
+	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
+	const int index = patchIdX + patchIdY*m_levels[level].patches;
+	if(m_dirtyPatches[level][index]) {
+		m_dirtyPatches[level][index] = false;
+		m_dirtyPatchCount--;
+	}
 }
+
+std::set<std::string> ImagePyramid::getDirtyPatches() {
+	std::lock_guard<std::mutex> lock(m_dirtyPatchMutex);
+	std::set<std::string> result;
+	if(m_dirtyPatchCount == 0)
+		return result;
+	for(int level = 0; level < m_dirtyPatches.size(); ++level) {
+		const int patches = m_levels[level].patches;
+		for(int i = 0; i < m_dirtyPatches[level].size(); ++i) {
+			if(m_dirtyPatches[level][i])
+				result.insert(std::to_string(level) + "_" + std::to_string(i % patches) + "_" + std::to_string(i / patches));
+		}
+	}
+	return result;
+}
+
+void ImagePyramid::clearDirtyPatches(std::set<std::string> patches) {
+	for(auto&& patch : patches) {
+		auto parts = split(patch, "_");
+		if(parts.size() != 3)
+			throw Exception("incorrect tile format");
+		clearDirtyPatch(std::stoi(parts[0]), std::stoi(parts[1]), std::stoi(parts[2]));
+	}
+}
+
+}
\ No newline at end of file
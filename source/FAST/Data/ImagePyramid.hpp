@@ -13,14 +13,15 @@ class Image;
 
 /**
  * Data object for storing large images as tiled image pyramids.
- * Storage uses virtual memory enabling the images to be larger than
- * the available RAM.
+ * Image pyramids are either read from a whole slide image file, or created in memory with create(width, height, channels).
+ * Levels created in memory are stored in tiles which are allocated when written to, and moved to a temporary file
+ * when exceeding the maximum resident size, enabling the images to be larger than the available RAM.
  */
 class FAST_EXPORT ImagePyramid : public SpatialDataObject {
     FAST_OBJECT(ImagePyramid)
     public:
         void create(int width, int height, int channels, int levels = -1);
-        void create(openslide_t* fileHandle, std::vector<Level> levels);
+        void create(openslide_t* fileHandle, std::vector<Level> levels, std::string filename = "");
         int getNrOfLevels();
         int getLevelWidth(int level);
         int getLevelHeight(int level);
@@ -28,9 +29,39 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
         int getFullWidth();
         int getFullHeight();
         int getNrOfChannels() const;
+        /**
+         * Get filename of the file this image pyramid is read from, or empty string if it is stored in memory
+         * @return
+         */
+        std::string getFilename() const;
+        /**
+         * Set size of the square tiles used to store levels created in memory. Must be set before create. Default is 256.
+         * @param size
+         */
+        void setTileSize(int size);
+        /**
+         * Set maximum number of bytes of uncompressed tiles kept in memory per level. Default is 256 MB.
+         * @param bytes
+         */
+        void setMaximumResidentBytes(std::size_t bytes);
+        /**
+         * Compress tiles with zlib when they are moved to disk. Disabled by default.
+         * @param compress
+         */
+        void setCompression(bool compress);
         ImagePyramidAccess::pointer getAccess(accessType type);
+        /**
+         * Get all dirty patches as strings of the form level_x_y
+         * @return
+         */
         std::set<std::string> getDirtyPatches();
         void setDirtyPatch(int level, int patchIdX, int patchIdY);
+        /**
+         * Mark all patches intersecting the given region of a level as dirty
+         */
+        void setDirtyRegion(int level, int x, int y, int width, int height);
+        bool isDirtyPatch(int level, int patchIdX, int patchIdY);
+        void clearDirtyPatch(int level, int patchIdX, int patchIdY);
         void clearDirtyPatches(std::set<std::string> patches);
         void free(ExecutionDevice::pointer device) override;
         void freeAll() override;
@@ -40,11 +71,18 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
         std::vector<Level> m_levels;
 
         openslide_t* m_fileHandle = nullptr;
+        std::string m_filename;
+        int m_tileSize = 256;
+        std::size_t m_maximumResidentBytes = 256*1024*1024;
+        bool m_compression = false;
 
         int m_channels;
         bool m_initialized;
 
-        std::set<std::string> m_dirtyPatches;
+        void initializeDirtyPatches();
+        // One bit per patch of each level, with a count of dirty patches to quickly check if any are dirty
+        std::vector<std::vector<bool>> m_dirtyPatches;
+        int m_dirtyPatchCount = 0;
         static int m_counter;
         std::mutex m_dirtyPatchMutex;
 };
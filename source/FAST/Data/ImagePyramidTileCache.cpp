@@ -0,0 +1,179 @@
+#include "ImagePyramidTileCache.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace fast {
+
+ImagePyramidTileCache* ImagePyramidTileCache::m_instance = NULL;
+
+ImagePyramidTileCache* ImagePyramidTileCache::getInstance() {
+    // Never deleted, as tiles may be released during static destruction
+    static std::once_flag flag;
+    std::call_once(flag, []() { m_instance = new ImagePyramidTileCache(); });
+    return m_instance;
+}
+
+ImagePyramidTileCache::ImagePyramidTileCache() {
+}
+
+ImagePyramidTileCache::Tile ImagePyramidTileCache::getTile(const std::string& file, int level, int tileX, int tileY, int channels, const RegionReader& reader) {
+    return getTile(file, level, tileX, tileY, channels, getTileSize(), reader);
+}
+
+ImagePyramidTileCache::Tile ImagePyramidTileCache::getTile(const std::string& file, int level, int tileX, int tileY, int channels, int tileSize, const RegionReader& reader) {
+    // Tile size is part of the key, in case it is changed while tiles are read
+    const Key key = std::make_tuple(file, level, tileSize, tileX, tileY);
+    std::promise<Tile> promise;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto it = m_tiles.find(key);
+        if(it != m_tiles.end()) {
+            m_statistics.hits++;
+            m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+            return it->second.tile;
+        }
+        auto inFlight = m_inFlight.find(key);
+        if(inFlight != m_inFlight.end()) {
+            // Another thread is reading this tile, wait for it
+            m_statistics.coalesced++;
+            auto future = inFlight->second;
+            lock.unlock();
+            return future.get();
+        }
+        m_statistics.misses++;
+        m_inFlight[key] = promise.get_future().share();
+    }
+
+    // Read tile without holding the lock
+    Tile tile;
+    try {
+        auto data = std::make_shared<std::vector<uint8_t>>((std::size_t)tileSize*tileSize*channels);
+        reader(tileX*tileSize, tileY*tileSize, tileSize, tileSize, data->data());
+        tile = data;
+    } catch(...) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_inFlight.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_inFlight.erase(key);
+        if(tileSize == m_tileSize && tile->size() <= m_maximumBytes) {
+            m_lru.push_front(key);
+            m_tiles[key] = {tile, m_lru.begin()};
+            m_statistics.residentBytes += tile->size();
+            evict();
+        }
+    }
+    promise.set_value(tile);
+    return tile;
+}
+
+void ImagePyramidTileCache::evict() {
+    while(m_statistics.residentBytes > m_maximumBytes && !m_lru.empty()) {
+        auto it = m_tiles.find(m_lru.back());
+        m_statistics.residentBytes -= it->second.tile->size();
+        m_statistics.evicted++;
+        m_tiles.erase(it);
+        m_lru.pop_back();
+    }
+}
+
+void ImagePyramidTileCache::readRegion(const std::string& file, int level, int x, int y, int width, int height, int channels, uint8_t* data, const RegionReader& reader) {
+    int tileSize;
+    std::size_t maximumBytes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        tileSize = m_tileSize;
+        maximumBytes = m_maximumBytes;
+    }
+    if(file.empty() || (std::size_t)width*height*channels > maximumBytes/4 || x < 0 || y < 0) {
+        reader(x, y, width, height, data);
+        return;
+    }
+
+    for(int tileY = y / tileSize; tileY*tileSize < y + height; ++tileY) {
+        for(int tileX = x / tileSize; tileX*tileSize < x + width; ++tileX) {
+            auto tile = getTile(file, level, tileX, tileY, channels, tileSize, reader);
+            const int fromX = std::max(x, tileX*tileSize);
+            const int toX = std::min(x + width, (tileX + 1)*tileSize);
+            const int fromY = std::max(y, tileY*tileSize);
+            const int toY = std::min(y + height, (tileY + 1)*tileSize);
+            for(int cy = fromY; cy < toY; ++cy) {
+                std::memcpy(
+                        &data[((std::size_t)(cy - y)*width + fromX - x)*channels],
+                        &(*tile)[((std::size_t)(cy - tileY*tileSize)*tileSize + fromX - tileX*tileSize)*channels],
+                        (toX - fromX)*channels
+                );
+            }
+        }
+    }
+}
+
+void ImagePyramidTileCache::setTileSize(int size) {
+    if(size <= 0)
+        throw Exception("Tile size must be larger than 0");
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(size == m_tileSize)
+        return;
+    m_tileSize = size;
+    m_tiles.clear();
+    m_lru.clear();
+    m_statistics.residentBytes = 0;
+}
+
+int ImagePyramidTileCache::getTileSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tileSize;
+}
+
+void ImagePyramidTileCache::setMaximumBytes(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maximumBytes = bytes;
+    evict();
+}
+
+std::size_t ImagePyramidTileCache::getMaximumBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maximumBytes;
+}
+
+void ImagePyramidTileCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tiles.clear();
+    m_lru.clear();
+    m_statistics.residentBytes = 0;
+}
+
+void ImagePyramidTileCache::clear(const std::string& file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto it = m_lru.begin(); it != m_lru.end();) {
+        if(std::get<0>(*it) == file) {
+            auto entry = m_tiles.find(*it);
+            m_statistics.residentBytes -= entry->second.tile->size();
+            m_tiles.erase(entry);
+            it = m_lru.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+ImagePyramidTileCacheStatistics ImagePyramidTileCache::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+void ImagePyramidTileCache::resetStatistics() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statistics.hits = 0;
+    m_statistics.misses = 0;
+    m_statistics.coalesced = 0;
+    m_statistics.evicted = 0;
+}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace fast {
+
+struct FAST_EXPORT ImagePyramidTileCacheStatistics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Requests which waited for another thread decoding the same tile
+    uint64_t coalesced = 0;
+    uint64_t evicted = 0;
+    std::size_t residentBytes = 0;
+    float getHitRate() const {
+        return hits + misses == 0 ? 0.0f : (float)hits / (hits + misses);
+    };
+};
+
+/**
+ * A process wide cache of decoded tiles of image pyramids read from file.
+ *
+ * Tiles are square regions of a level, identified by file, level and tile index, thus different
+ * ImagePyramidAccess objects and threads reading the same slide (e.g. a renderer and a PatchGenerator)
+ * decode each tile only once. If a tile is requested while another thread is decoding it, the request waits
+ * for that thread instead of decoding the tile again. The least recently used tiles are removed when the
+ * size of the cache exceeds the maximum.
+ *
+ * All methods are thread safe.
+ */
+class FAST_EXPORT ImagePyramidTileCache : public Object {
+    public:
+        typedef std::shared_ptr<const std::vector<uint8_t>> Tile;
+        /**
+         * Function which reads a region, given as x, y, width and height in level coordinates, into a buffer
+         */
+        typedef std::function<void(int, int, int, int, uint8_t*)> RegionReader;
+        static ImagePyramidTileCache* getInstance();
+        /**
+         * Get a tile from the cache, reading it with the given reader if not in the cache.
+         * @param file identifier of the file, e.g. the filename
+         * @param level
+         * @param tileX
+         * @param tileY
+         * @param channels
+         * @param reader
+         * @return tile data, tile size x tile size pixels with interleaved channels
+         */
+        Tile getTile(const std::string& file, int level, int tileX, int tileY, int channels, const RegionReader& reader);
+        /**
+         * Copy a region of a level into data, stored row by row with interleaved channels, through the cache.
+         * Regions larger than a quarter of the cache are read directly with the reader,
+         * to avoid evicting the entire cache.
+         */
+        void readRegion(const std::string& file, int level, int x, int y, int width, int height, int channels, uint8_t* data, const RegionReader& reader);
+        /**
+         * Set size of tiles. Clears the cache. Default is 256.
+         * @param size
+         */
+        void setTileSize(int size);
+        int getTileSize() const;
+        /**
+         * Set maximum number of bytes of tiles in the cache. Default is 256 MB. Setting this to 0 disables the cache.
+         * @param bytes
+         */
+        void setMaximumBytes(std::size_t bytes);
+        std::size_t getMaximumBytes() const;
+        /**
+         * Remove all tiles from the cache
+         */
+        void clear();
+        /**
+         * Remove all tiles of a given file from the cache
+         * @param file
+         */
+        void clear(const std::string& file);
+        ImagePyramidTileCacheStatistics getStatistics() const;
+        void resetStatistics();
+    private:
+        // File, level, tile size, tile x and tile y
+        typedef std::tuple<std::string, int, int, int, int> Key;
+        struct Entry {
+            Tile tile;
+            std::list<Key>::iterator lruPosition;
+        };
+        ImagePyramidTileCache();
+        Tile getTile(const std::string& file, int level, int tileX, int tileY, int channels, int tileSize, const RegionReader& reader);
+        void evict();
+
+        static ImagePyramidTileCache* m_instance;
+        mutable std::mutex m_mutex;
+        std::map<Key, Entry> m_tiles;
+        // Tiles which are currently being read
+        std::map<Key, std::shared_future<Tile>> m_inFlight;
+        // Keys of tiles in the cache, most recently used first
+        std::list<Key> m_lru;
+        int m_tileSize = 256;
+        std::size_t m_maximumBytes = 256*1024*1024;
+        ImagePyramidTileCacheStatistics m_statistics;
+};
+
+}
@@ -0,0 +1,146 @@
+#include "PixelBufferPool.hpp"
+#include <cstdlib>
+#include <algorithm>
+
+namespace fast {
+
+PixelBufferPool* PixelBufferPool::m_instance = NULL;
+
+static void* alignedAllocate(std::size_t bytes, std::size_t alignment) {
+    void* buffer = nullptr;
+#ifdef _WIN32
+    buffer = _aligned_malloc(bytes, alignment);
+#else
+    if(posix_memalign(&buffer, std::max(alignment, sizeof(void*)), bytes) != 0)
+        buffer = nullptr;
+#endif
+    if(buffer == nullptr)
+        throw Exception("Out of memory: unable to allocate buffer of size " + std::to_string(bytes) + " bytes");
+    return buffer;
+}
+
+static void alignedFree(void* buffer) {
+#ifdef _WIN32
+    _aligned_free(buffer);
+#else
+    std::free(buffer);
+#endif
+}
+
+PixelBufferPool* PixelBufferPool::getInstance() {
+    // Never deleted, as buffers may be returned to the pool during static destruction
+    static std::once_flag flag;
+    std::call_once(flag, []() { m_instance = new PixelBufferPool(); });
+    return m_instance;
+}
+
+PixelBufferPool::PixelBufferPool() {
+}
+
+std::size_t PixelBufferPool::getSizeClass(std::size_t bytes) {
+    const std::size_t pageSize = 4096;
+    if(bytes <= pageSize)
+        return pageSize;
+    // Find the power of two below the size, and round up to nearest quarter of it
+    std::size_t power = pageSize;
+    while(power*2 < bytes)
+        power *= 2;
+    const std::size_t quarter = power / 4;
+    return ((bytes + quarter - 1) / quarter) * quarter;
+}
+
+unique_pixel_ptr PixelBufferPool::allocate(std::size_t bytes, std::size_t alignment) {
+    if(alignment == 0 || (alignment & (alignment - 1)) != 0)
+        throw Exception("Alignment of pixel buffer must be a power of two");
+    const std::size_t sizeClass = getSizeClass(bytes);
+    void* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_buffers.find(std::make_pair(sizeClass, alignment));
+        if(m_enabled && it != m_buffers.end() && !it->second.empty()) {
+            buffer = it->second.back();
+            it->second.pop_back();
+            m_statistics.residentBytes -= sizeClass;
+            m_statistics.hits++;
+        } else {
+            m_statistics.misses++;
+        }
+        m_statistics.leasedBytes += sizeClass;
+    }
+    if(buffer == nullptr)
+        buffer = alignedAllocate(sizeClass, alignment);
+
+    return unique_pixel_ptr(buffer, [this, sizeClass, alignment](void* data) {
+        release(data, sizeClass, alignment);
+    });
+}
+
+void PixelBufferPool::release(void* buffer, std::size_t sizeClass, std::size_t alignment) {
+    if(buffer == nullptr)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_statistics.leasedBytes -= sizeClass;
+        if(m_enabled && m_statistics.residentBytes + sizeClass <= m_maximumResidentBytes) {
+            m_buffers[std::make_pair(sizeClass, alignment)].push_back(buffer);
+            m_statistics.residentBytes += sizeClass;
+            return;
+        }
+        m_statistics.discarded++;
+    }
+    alignedFree(buffer);
+}
+
+void PixelBufferPool::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto&& buffers : m_buffers) {
+        for(auto buffer : buffers.second)
+            alignedFree(buffer);
+    }
+    m_buffers.clear();
+    m_statistics.residentBytes = 0;
+}
+
+void PixelBufferPool::setMaximumResidentBytes(std::size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maximumResidentBytes = bytes;
+        if(m_statistics.residentBytes <= bytes)
+            return;
+    }
+    // Simply empty the pool if it is above the new limit
+    clear();
+}
+
+std::size_t PixelBufferPool::getMaximumResidentBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maximumResidentBytes;
+}
+
+void PixelBufferPool::setEnabled(bool enabled) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_enabled = enabled;
+    }
+    if(!enabled)
+        clear();
+}
+
+bool PixelBufferPool::isEnabled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_enabled;
+}
+
+PixelBufferPoolStatistics PixelBufferPool::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+void PixelBufferPool::resetStatistics() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statistics.hits = 0;
+    m_statistics.misses = 0;
+    m_statistics.discarded = 0;
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <vector>
+
+namespace fast {
+
+using pixel_deleter_t = std::function<void(void *)>;
+using unique_pixel_ptr = std::unique_ptr<void, pixel_deleter_t>;
+
+struct FAST_EXPORT PixelBufferPoolStatistics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Buffers which were freed instead of returned to the pool because the pool was full
+    uint64_t discarded = 0;
+    // Bytes stored in the pool, ready to be reused
+    std::size_t residentBytes = 0;
+    // Bytes currently handed out by the pool
+    std::size_t leasedBytes = 0;
+    float getHitRate() const {
+        return hits + misses == 0 ? 0.0f : (float)hits / (hits + misses);
+    };
+};
+
+/**
+ * A pool of host memory buffers used for pixel and tensor data.
+ *
+ * Streaming pipelines typically allocate and free buffers of the same size for every frame.
+ * Instead of freeing these buffers, they are returned to this pool when the owning unique_pixel_ptr
+ * is released, and reused by the next allocation of the same size class.
+ * Size classes are a quarter of a power of two (minimum one page), thus at most 25% of a buffer is unused.
+ */
+class FAST_EXPORT PixelBufferPool : public Object {
+    public:
+        static PixelBufferPool* getInstance();
+        /**
+         * Get a buffer of at least the given size. The buffer is not initialized.
+         * The buffer is returned to the pool when the unique_pixel_ptr is released.
+         * Buffers are page aligned by default, so that OpenCL CPU devices can use them without copying.
+         *
+         * @param bytes
+         * @param alignment must be a power of two
+         * @return
+         */
+        unique_pixel_ptr allocate(std::size_t bytes, std::size_t alignment = 4096);
+        /**
+         * Set maximum number of bytes the pool can store for reuse.
+         * Buffers returned to a full pool are freed.
+         * @param bytes
+         */
+        void setMaximumResidentBytes(std::size_t bytes);
+        std::size_t getMaximumResidentBytes() const;
+        /**
+         * Disable to always allocate and free buffers directly. Enabled by default.
+         * @param enabled
+         */
+        void setEnabled(bool enabled);
+        bool isEnabled() const;
+        /**
+         * Free all buffers stored in the pool
+         */
+        void clear();
+        PixelBufferPoolStatistics getStatistics() const;
+        void resetStatistics();
+        static std::size_t getSizeClass(std::size_t bytes);
+    private:
+        PixelBufferPool();
+        void release(void* buffer, std::size_t sizeClass, std::size_t alignment);
+
+        static PixelBufferPool* m_instance;
+        mutable std::mutex m_mutex;
+        // Key is size class and alignment
+        std::map<std::pair<std::size_t, std::size_t>, std::vector<void*>> m_buffers;
+        std::size_t m_maximumResidentBytes = 256*1024*1024;
+        bool m_enabled = true;
+        PixelBufferPoolStatistics m_statistics;
+};
+
+}
@@ -7,7 +7,9 @@ namespace fast {
 void Tensor::create(std::unique_ptr<float[]> data, TensorShape shape) {
     if(shape.empty())
         throw Exception("Shape can't be empty");
-    m_data = std::move(data);
+    freeAll(); // delete any old data
+    m_batchFrameData.clear();
+    m_data = unique_pixel_ptr(data.release(), [](void* p) { delete[] (float*)p; });
     m_shape = shape;
     m_spacing = VectorXf::Ones(shape.getDimensions());
     mHostDataIsUpToDate = true;
@@ -23,7 +25,10 @@ void Tensor::create(TensorShape shape) {
         throw Exception("Shape can't be empty");
     if(shape.getUnknownDimensions() > 0)
         throw Exception("When creating a tensor, shape must be fully defined");
-    m_data = make_uninitialized_unique<float[]>(shape.getTotalSize());
+    freeAll(); // delete any old data
+    m_batchFrameData.clear();
+    m_data = PixelBufferPool::getInstance()->allocate(shape.getTotalSize()*sizeof(float));
+    m_shape = shape;
     m_spacing = VectorXf::Ones(shape.getDimensions());
     mHostDataIsUpToDate = true;
     if(m_shape.getDimensions() >= 3) {
@@ -37,10 +42,13 @@ void Tensor::create(std::initializer_list<float> data) {
 	if(data.size() == 0)
 		throw Exception("Shape can't be empty");
 
-	m_data = std::make_unique<float[]>(data.size());
+	freeAll(); // delete any old data
+	m_batchFrameData.clear();
+	m_data = PixelBufferPool::getInstance()->allocate(data.size()*sizeof(float));
+	float* values = (float*)m_data.get();
 	int i = 0;
 	for(auto item : data) {
-		m_data[i] = item;
+		values[i] = item;
 		++i;
 	}
 	m_shape = TensorShape({ (int)data.size() });
@@ -79,6 +87,7 @@ TensorAccess::pointer Tensor::getAccess(accessType type) {
     }
     updateHostData();
     if(type == ACCESS_READ_WRITE) {
+        waitForDevicesUsingHostData();
         setAllDataToOutOfDate();
         updateModifiedTimestamp();
     }
@@ -92,22 +101,44 @@ TensorAccess::pointer Tensor::getAccess(accessType type) {
 
 void Tensor::free(ExecutionDevice::pointer device) {
     if(device->isHost()) {
+        waitForDevicesUsingHostData();
+        // Buffers using the host data can't be kept
+        for(auto&& clDevice : std::unordered_set<OpenCLDevice::pointer>(mCLBuffersUsingHostData)) {
+            releaseCLBuffer(clDevice);
+            mCLBuffersIsUpToDate.erase(clDevice);
+        }
         m_data.reset();
     } else {
         auto clDevice = std::dynamic_pointer_cast<OpenCLDevice>(device);
-        delete mCLBuffers[clDevice];
-        mCLBuffers.erase(clDevice);
+        releaseCLBuffer(clDevice);
         mCLBuffersIsUpToDate.erase(clDevice);
     }
 }
 
-void Tensor::freeAll() {
-    m_data.reset();
-    for(auto buffer : mCLBuffers) {
-        delete buffer.second;
+void Tensor::waitForDevicesUsingHostData() {
+    // Kernels enqueued on buffers using the host data as storage read the host data directly
+    for(auto&& device : mCLBuffersUsingHostData)
+        device->getCommandQueue().finish();
+}
+
+void Tensor::releaseCLBuffer(OpenCLDevice::pointer device) {
+    if(mCLBuffers.count(device) > 0) {
+        if(mCLBuffersUsingHostData.erase(device) > 0) {
+            // Buffers using host data are bound to it, and are not leased from the memory pool
+            delete mCLBuffers[device];
+        } else {
+            device->getMemoryPool()->returnBuffer(mCLBuffers[device]);
+        }
     }
-    mCLBuffers.clear();
+    mCLBuffers.erase(device);
+}
+
+void Tensor::freeAll() {
+    waitForDevicesUsingHostData();
+    while(!mCLBuffers.empty())
+        releaseCLBuffer(mCLBuffers.begin()->first);
     mCLBuffersIsUpToDate.clear();
+    m_data.reset();
 }
 
 OpenCLBufferAccess::pointer Tensor::getOpenCLBufferAccess(accessType type, OpenCLDevice::pointer device) {
@@ -137,6 +168,16 @@ OpenCLBufferAccess::pointer Tensor::getOpenCLBufferAccess(accessType type, OpenC
 	return std::move(accessObject);
 }
 
+void Tensor::setBatchFrameData(std::vector<FrameData> frameData) {
+    if(!isInitialized() || frameData.size() != m_shape[0])
+        throw Exception("Number of batch frame data must match the first dimension of the tensor");
+    m_batchFrameData = std::move(frameData);
+}
+
+const std::vector<FrameData>& Tensor::getBatchFrameData() const {
+    return m_batchFrameData;
+}
+
 bool Tensor::isInitialized() {
     return !m_shape.empty();
 }
@@ -155,11 +196,14 @@ void Tensor::updateOpenCLBufferData(OpenCLDevice::pointer device) {
     if(mCLBuffers.count(device) == 0) {
         // Data is not on device, create it
         unsigned int bufferSize = getShape().getTotalSize()*4;
-        cl::Buffer * newBuffer = new cl::Buffer(
-                device->getContext(),
-                CL_MEM_READ_WRITE,
-                bufferSize
-        );
+        cl::Buffer * newBuffer;
+        if(device->isCPU() && m_data && (void*)getHostDataPointer() == m_data.get()) {
+            // Use the host data as storage of the buffer, thus host and device share one allocation
+            newBuffer = new cl::Buffer(device->getContext(), CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, bufferSize, m_data.get());
+            mCLBuffersUsingHostData.insert(device);
+        } else {
+            newBuffer = device->getMemoryPool()->leaseBuffer(CL_MEM_READ_WRITE, bufferSize);
+        }
 
         if(hasAnyData()) {
             mCLBuffersIsUpToDate[device] = false;
@@ -185,14 +229,26 @@ void Tensor::updateOpenCLBufferData(OpenCLDevice::pointer device) {
 
 void Tensor::transferCLBufferFromHost(OpenCLDevice::pointer device) {
     std::size_t bufferSize = m_shape.getTotalSize()*4;
+    if(mCLBuffersUsingHostData.count(device) > 0) {
+        // Mapping synchronizes the buffer with the host data. On CPU devices this does not involve any copying.
+        void* pointer = device->getCommandQueue().enqueueMapBuffer(*mCLBuffers[device], CL_TRUE, CL_MAP_WRITE, 0, bufferSize);
+        device->getCommandQueue().enqueueUnmapMemObject(*mCLBuffers[device], pointer);
+        return;
+    }
     device->getCommandQueue().enqueueWriteBuffer(*mCLBuffers[device],
         CL_TRUE, 0, bufferSize, getHostDataPointer());
 }
 
 void Tensor::transferCLBufferToHost(OpenCLDevice::pointer device) {
+    if(mCLBuffersUsingHostData.count(device) > 0) {
+        std::size_t bufferSize = m_shape.getTotalSize()*4;
+        void* pointer = device->getCommandQueue().enqueueMapBuffer(*mCLBuffers[device], CL_TRUE, CL_MAP_READ, 0, bufferSize);
+        device->getCommandQueue().enqueueUnmapMemObject(*mCLBuffers[device], pointer);
+        return;
+    }
 	if(!m_data) {
 		// Must allocate memory for host data
-        m_data = make_uninitialized_unique<float[]>(m_shape.getTotalSize());
+        m_data = PixelBufferPool::getInstance()->allocate(m_shape.getTotalSize()*sizeof(float));
 	}
     std::size_t bufferSize = m_shape.getTotalSize()*4;
     device->getCommandQueue().enqueueReadBuffer(*mCLBuffers[device],
@@ -216,7 +272,7 @@ void Tensor::updateHostData() {
     bool updated = false;
     if(!m_data) {
         // Data is not initialized, do that first
-        m_data = make_uninitialized_unique<float[]>(m_shape.getTotalSize());
+        m_data = PixelBufferPool::getInstance()->allocate(m_shape.getTotalSize()*sizeof(float));
 
         if(hasAnyData()) {
             mHostDataIsUpToDate = false;
@@ -278,7 +334,7 @@ BoundingBox Tensor::getBoundingBox() const {
 }
 
 float* Tensor::getHostDataPointer() {
-    return m_data.get();
+    return (float*)m_data.get();
 }
 
 Tensor::~Tensor() {
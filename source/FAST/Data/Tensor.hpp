@@ -4,6 +4,8 @@
 #include <FAST/Data/Access/TensorAccess.hpp>
 #include <FAST/Data/Access/Access.hpp>
 #include <FAST/Data/TensorShape.hpp>
+#include <FAST/Data/PixelBufferPool.hpp>
+#include <unordered_set>
 
 namespace fast {
 
@@ -41,6 +43,16 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
         virtual void setSpacing(VectorXf spacing);
         virtual VectorXf getSpacing() const;
         virtual void deleteDimension(int dimension);
+        /**
+         * Set frame data of each sample in the first dimension of this tensor, e.g. patch coordinates of a batch.
+         * @param frameData one per sample
+         */
+        void setBatchFrameData(std::vector<FrameData> frameData);
+        /**
+         * Get frame data of each sample in the first dimension. Empty if the tensor is not a batch.
+         * @return
+         */
+        const std::vector<FrameData>& getBatchFrameData() const;
 
         virtual BoundingBox getTransformedBoundingBox() const override;
         virtual BoundingBox getBoundingBox() const override;
@@ -57,13 +69,22 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
         void updateHostData();
         virtual float* getHostDataPointer();
 
-        std::unique_ptr<float[]> m_data;
+        unique_pixel_ptr m_data;
         std::unordered_map<SharedPointer<OpenCLDevice>, cl::Buffer*> mCLBuffers;
         std::unordered_map<SharedPointer<OpenCLDevice>, bool> mCLBuffersIsUpToDate;
+        // Devices where the OpenCL buffer uses the host data as storage (CL_MEM_USE_HOST_PTR), done for CPU devices
+        std::unordered_set<SharedPointer<OpenCLDevice>> mCLBuffersUsingHostData;
+        void releaseCLBuffer(SharedPointer<OpenCLDevice> device);
+        /**
+         * Block until all commands enqueued on devices with buffers using the host data have finished.
+         * Has to be done before the host data is changed or deleted.
+         */
+        void waitForDevicesUsingHostData();
         TensorShape m_shape;
         bool mHostDataIsUpToDate;
 
         VectorXf m_spacing;
+        std::vector<FrameData> m_batchFrameData;
 
         friend TensorAccess;
         friend OpenCLBufferAccess;
@@ -12,6 +12,50 @@ TEST_CASE("Update timestamp on DataObject", "[fast][DataObject]") {
     CHECK(timestamp != data->getTimestamp());
 }
 
+TEST_CASE("Typed frame data", "[fast][DataObject][FrameData]") {
+    DummyDataObject::pointer data = DummyDataObject::New();
+    const auto keyWidth = FrameData::getKey("original-width");
+    const auto keySpacing = FrameData::getKey("patch-spacing-x");
+    const auto keyTransform = FrameData::getKey("original-transform");
+    CHECK(FrameData::getKey("original-width") == keyWidth);
+
+    auto& frameData = data->getFrameData();
+    frameData.set(keyWidth, 512);
+    frameData.set(keySpacing, 0.5f);
+    Affine3f transform = Affine3f::Identity();
+    transform.translate(Vector3f(1, 2, 3));
+    frameData.set(keyTransform, transform);
+    CHECK(frameData.getInt(keyWidth) == 512);
+    CHECK(frameData.getFloat(keySpacing) == 0.5f);
+    CHECK(frameData.getTransform(keyTransform).matrix() == transform.matrix());
+    CHECK_THROWS(frameData.getInt(FrameData::getKey("does-not-exist")));
+
+    // String API is converted to and from typed values
+    CHECK(data->getFrameData("original-width") == "512");
+    data->setFrameData("patchid-x", "3");
+    CHECK(frameData.getInt(FrameData::getKey("patchid-x")) == 3);
+}
+
+TEST_CASE("Frame data is shared until modified", "[fast][DataObject][FrameData]") {
+    const auto key = FrameData::getKey("patchid-y");
+    FrameData input;
+    input.set(key, 1);
+
+    FrameData output;
+    output.merge(input);
+    CHECK(output.getInt(key) == 1);
+    output.set(key, 2);
+    CHECK(input.getInt(key) == 1);
+    CHECK(output.getInt(key) == 2);
+
+    // Attributes only in the target are kept when merging
+    const auto key2 = FrameData::getKey("patch-width");
+    output.set(key2, 256);
+    output.merge(input);
+    CHECK(output.getInt(key) == 1);
+    CHECK(output.getInt(key2) == 256);
+}
+
 
 
 };
@@ -0,0 +1,96 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Data/ImagePyramidTileCache.hpp"
+#include <atomic>
+#include <thread>
+
+using namespace fast;
+
+// Reader which sets every pixel to its x coordinate modulo 256 and counts the number of reads
+static ImagePyramidTileCache::RegionReader createReader(std::atomic_int& reads, int sleepMilliseconds = 0) {
+    return [&reads, sleepMilliseconds](int x, int y, int width, int height, uint8_t* data) {
+        reads++;
+        if(sleepMilliseconds > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(sleepMilliseconds));
+        for(int cy = 0; cy < height; ++cy) {
+            for(int cx = 0; cx < width; ++cx)
+                data[cx + cy*width] = (x + cx) % 256;
+        }
+    };
+}
+
+TEST_CASE("Image pyramid tile cache reads each tile once", "[fast][ImagePyramidTileCache]") {
+    auto cache = ImagePyramidTileCache::getInstance();
+    cache->clear();
+    cache->resetStatistics();
+    cache->setTileSize(256);
+    std::atomic_int reads(0);
+    auto reader = createReader(reads);
+
+    std::vector<uint8_t> data(300*100);
+    cache->readRegion("test-file-a", 0, 100, 100, 300, 100, 1, data.data(), reader);
+    CHECK(reads == 2);
+    for(int x = 0; x < 300; ++x)
+        CHECK(data[x + 50*300] == (100 + x) % 256);
+
+    // Overlapping region is read from the cache
+    cache->readRegion("test-file-a", 0, 200, 0, 100, 100, 1, data.data(), reader);
+    CHECK(reads == 2);
+    CHECK(data[0] == 200);
+    CHECK(cache->getStatistics().hits == 2);
+
+    // Different file and level have different tiles
+    cache->readRegion("test-file-b", 0, 10, 0, 100, 100, 1, data.data(), reader);
+    cache->readRegion("test-file-a", 1, 10, 0, 100, 100, 1, data.data(), reader);
+    CHECK(reads == 4);
+
+    cache->clear("test-file-a");
+    cache->readRegion("test-file-a", 0, 10, 0, 100, 100, 1, data.data(), reader);
+    CHECK(reads == 5);
+    cache->clear();
+}
+
+TEST_CASE("Image pyramid tile cache coalesces concurrent reads of the same tile", "[fast][ImagePyramidTileCache]") {
+    auto cache = ImagePyramidTileCache::getInstance();
+    cache->clear();
+    cache->resetStatistics();
+    std::atomic_int reads(0);
+    auto reader = createReader(reads, 100);
+
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 4; ++i) {
+        threads.push_back(std::thread([&]() {
+            auto tile = cache->getTile("test-file", 0, 1, 1, 1, reader);
+            CHECK((*tile)[10] == (256 + 10) % 256);
+        }));
+    }
+    for(auto&& thread : threads)
+        thread.join();
+    CHECK(reads == 1);
+    CHECK(cache->getStatistics().misses == 1);
+    CHECK(cache->getStatistics().hits + cache->getStatistics().coalesced == 3);
+    cache->clear();
+}
+
+TEST_CASE("Image pyramid tile cache evicts least recently used tiles", "[fast][ImagePyramidTileCache]") {
+    auto cache = ImagePyramidTileCache::getInstance();
+    cache->clear();
+    cache->setTileSize(64);
+    cache->setMaximumBytes(2*64*64);
+    std::atomic_int reads(0);
+    auto reader = createReader(reads);
+
+    cache->getTile("test-file", 0, 0, 0, 1, reader);
+    cache->getTile("test-file", 0, 1, 0, 1, reader);
+    cache->getTile("test-file", 0, 0, 0, 1, reader);
+    cache->getTile("test-file", 0, 2, 0, 1, reader); // Evicts tile 1
+    CHECK(reads == 3);
+    CHECK(cache->getStatistics().residentBytes == 2*64*64);
+    cache->getTile("test-file", 0, 0, 0, 1, reader);
+    CHECK(reads == 3);
+    cache->getTile("test-file", 0, 1, 0, 1, reader);
+    CHECK(reads == 4);
+
+    cache->setMaximumBytes(256*1024*1024);
+    cache->setTileSize(256);
+    cache->clear();
+}
@@ -3,6 +3,7 @@
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Tests/DataComparison.hpp"
 #include "FAST/Utility.hpp"
+#include "FAST/Config.hpp"
 #include <limits>
 
 using namespace fast;
@@ -1483,3 +1484,147 @@ TEST_CASE("createFromImage on 3D image", "[fast][image]") {
 }
 
 
+
+TEST_CASE("Transfer 2D image between host and OpenCL device asynchronously", "[fast][image]") {
+    DeviceManager* deviceManager = DeviceManager::getInstance();
+    OpenCLDevice::pointer device = deviceManager->getOneOpenCLDevice();
+    Config::setAsynchronousTransfers(true);
+
+    unsigned int width = 256;
+    unsigned int height = 512;
+    for(unsigned int nrOfChannels = 1; nrOfChannels <= 4; nrOfChannels++) {
+        for(unsigned int typeNr = 0; typeNr < 5; typeNr++) {
+            DataType type = (DataType)typeNr;
+            void* data = allocateRandomData(width*height*nrOfChannels, type);
+
+            Image::pointer image = Image::New();
+            image->create(width, height, type, nrOfChannels, Host::getInstance(), data);
+            {
+                // Host to device; write access marks host data as out of date
+                OpenCLImageAccess::pointer access = image->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
+                cl::Event::waitForEvents(access->getEvents());
+                CHECK(compareImage2DWithDataArray(*access->get2DImage(), device, data, width, height, nrOfChannels, type) == true);
+            }
+            {
+                // Device to host
+                ImageAccess::pointer access = image->getImageAccess(ACCESS_READ);
+                CHECK(compareDataArrays(data, access->get(), width*height*nrOfChannels, type) == true);
+            }
+
+            deleteArray(data, type);
+        }
+    }
+    Config::setAsynchronousTransfers(false);
+}
+
+TEST_CASE("Copy 2D image directly between OpenCL buffer and image on the same device", "[fast][image]") {
+    DeviceManager* deviceManager = DeviceManager::getInstance();
+    OpenCLDevice::pointer device = deviceManager->getOneOpenCLDevice();
+
+    unsigned int width = 256;
+    unsigned int height = 512;
+    for(unsigned int nrOfChannels = 1; nrOfChannels <= 4; nrOfChannels++) {
+        for(unsigned int typeNr = 0; typeNr < 5; typeNr++) {
+            DataType type = (DataType)typeNr;
+            void* data = allocateRandomData(width*height*nrOfChannels, type);
+
+            Image::pointer image = Image::New();
+            image->create(width, height, type, nrOfChannels, Host::getInstance(), data);
+            {
+                // Only the buffer is up to date after this
+                OpenCLBufferAccess::pointer access = image->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+            }
+            {
+                // Buffer to image
+                OpenCLImageAccess::pointer access = image->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
+                CHECK(compareImage2DWithDataArray(*access->get2DImage(), device, data, width, height, nrOfChannels, type) == true);
+            }
+            {
+                // Image to buffer
+                OpenCLBufferAccess::pointer access = image->getOpenCLBufferAccess(ACCESS_READ, device);
+                CHECK(compareBufferWithDataArray(*access->get(), device, data, width*height*nrOfChannels, type) == true);
+            }
+
+            deleteArray(data, type);
+        }
+    }
+}
+
+TEST_CASE("Image on OpenCL CPU device shares memory with host data", "[fast][image]") {
+    std::vector<OpenCLDevice::pointer> devices = DeviceManager::getInstance()->getAllCPUDevices();
+    if(devices.empty())
+        return;
+    OpenCLDevice::pointer device = devices[0];
+
+    unsigned int width = 256;
+    unsigned int height = 512;
+    DataType type = TYPE_FLOAT;
+    void* data = allocateRandomData(width*height, type);
+    Image::pointer image = Image::New();
+    image->create(width, height, type, 1, Host::getInstance(), data);
+    void* hostData;
+    {
+        ImageAccess::pointer access = image->getImageAccess(ACCESS_READ);
+        hostData = access->get();
+    }
+    {
+        OpenCLBufferAccess::pointer access = image->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+        CHECK(access->get()->getInfo<CL_MEM_HOST_PTR>() == hostData);
+        CHECK(compareBufferWithDataArray(*access->get(), device, data, width*height, type) == true);
+    }
+    {
+        OpenCLImageAccess::pointer access = image->getOpenCLImageAccess(ACCESS_READ, device);
+        CHECK(access->get()->getInfo<CL_MEM_HOST_PTR>() == hostData);
+        CHECK(compareImage2DWithDataArray(*access->get2DImage(), device, data, width, height, 1, type) == true);
+    }
+    {
+        ImageAccess::pointer access = image->getImageAccess(ACCESS_READ);
+        CHECK(access->get() == hostData);
+        CHECK(compareDataArrays(data, access->get(), width*height, type) == true);
+    }
+    deleteArray(data, type);
+}
+
+TEST_CASE("Host write access to image on OpenCL CPU device waits for enqueued kernels", "[fast][image]") {
+    std::vector<OpenCLDevice::pointer> devices = DeviceManager::getInstance()->getAllCPUDevices();
+    if(devices.empty())
+        return;
+    OpenCLDevice::pointer device = devices[0];
+
+    unsigned int width = 2048;
+    unsigned int height = 2048;
+    DataType type = TYPE_FLOAT;
+    void* data = allocateRandomData(width*height, type);
+    Image::pointer image = Image::New();
+    image->create(width, height, type, 1, Host::getInstance(), data);
+
+    // Enqueue a kernel reading the image, which uses the host data as storage, and don't wait for it
+    cl::Buffer result(device->getContext(), CL_MEM_READ_WRITE, width*height*sizeof(float));
+    {
+        OpenCLImageAccess::pointer access = image->getOpenCLImageAccess(ACCESS_READ, device);
+        int i = device->createProgramFromString("__constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;"
+                "__kernel void copyImage(__read_only image2d_t image, __global float* result) {"
+                "const int2 pos = {get_global_id(0), get_global_id(1)};"
+                "result[pos.x + pos.y*get_global_size(0)] = read_imagef(image, sampler, pos).x;"
+                "}");
+        cl::Kernel kernel(device->getProgram(i), "copyImage");
+        kernel.setArg(0, *access->get2DImage());
+        kernel.setArg(1, result);
+        device->getCommandQueue().enqueueNDRangeKernel(
+                kernel,
+                cl::NullRange,
+                cl::NDRange(width, height),
+                cl::NullRange
+        );
+    }
+
+    // The host must not change the data before the kernel is done
+    {
+        ImageAccess::pointer access = image->getImageAccess(ACCESS_READ_WRITE);
+        float* hostData = (float*)access->get();
+        for(unsigned int i = 0; i < width*height; i++)
+            hostData[i] = -1.0f;
+    }
+    CHECK(compareBufferWithDataArray(result, device, data, width*height, type) == true);
+    deleteArray(data, type);
+}
@@ -0,0 +1,70 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Data/PixelBufferPool.hpp"
+#include "FAST/Data/Image.hpp"
+
+using namespace fast;
+
+TEST_CASE("Pixel buffer pool size classes", "[fast][PixelBufferPool]") {
+    CHECK(PixelBufferPool::getSizeClass(1) == 4096);
+    CHECK(PixelBufferPool::getSizeClass(4096) == 4096);
+    CHECK(PixelBufferPool::getSizeClass(4097) == 5120);
+    CHECK(PixelBufferPool::getSizeClass(1024*1024) == 1024*1024);
+    CHECK(PixelBufferPool::getSizeClass(1024*1024 + 1) == 1024*1024 + 256*1024);
+    for(std::size_t bytes : {100, 5000, 70000, 1234567, 10*1024*1024 + 3}) {
+        CHECK(PixelBufferPool::getSizeClass(bytes) >= bytes);
+        CHECK(PixelBufferPool::getSizeClass(bytes) < bytes*1.25 + 4096);
+    }
+}
+
+TEST_CASE("Pixel buffer pool reuses released buffers", "[fast][PixelBufferPool]") {
+    auto pool = PixelBufferPool::getInstance();
+    pool->clear();
+    pool->resetStatistics();
+
+    void* first;
+    {
+        auto buffer = pool->allocate(1024*1024);
+        first = buffer.get();
+        CHECK(((std::size_t)first % 64) == 0);
+        CHECK(pool->getStatistics().leasedBytes == 1024*1024);
+        CHECK(pool->getStatistics().misses == 1);
+    }
+    CHECK(pool->getStatistics().leasedBytes == 0);
+    CHECK(pool->getStatistics().residentBytes == 1024*1024);
+
+    // Same size class, should get the same buffer
+    auto buffer = pool->allocate(1024*1000);
+    CHECK(buffer.get() == first);
+    CHECK(pool->getStatistics().hits == 1);
+    CHECK(pool->getStatistics().getHitRate() == Approx(0.5));
+    CHECK(pool->getStatistics().residentBytes == 0);
+}
+
+TEST_CASE("Pixel buffer pool respects maximum resident bytes", "[fast][PixelBufferPool]") {
+    auto pool = PixelBufferPool::getInstance();
+    pool->clear();
+    pool->resetStatistics();
+    const auto maximum = pool->getMaximumResidentBytes();
+    pool->setMaximumResidentBytes(1024*1024);
+    {
+        auto buffer1 = pool->allocate(1024*1024);
+        auto buffer2 = pool->allocate(1024*1024);
+    }
+    CHECK(pool->getStatistics().residentBytes == 1024*1024);
+    CHECK(pool->getStatistics().discarded == 1);
+    pool->setMaximumResidentBytes(maximum);
+}
+
+TEST_CASE("Streamed images reuse pixel buffers from pool", "[fast][PixelBufferPool][image]") {
+    auto pool = PixelBufferPool::getInstance();
+    pool->clear();
+    pool->resetStatistics();
+    for(int i = 0; i < 10; ++i) {
+        auto image = Image::New();
+        image->create(Vector2ui(512, 512), TYPE_FLOAT, 1, Host::getInstance(), allocatePixelArray(512*512, TYPE_FLOAT));
+        auto access = image->getImageAccess(ACCESS_READ_WRITE);
+        ((float*)access->get())[0] = i;
+    }
+    CHECK(pool->getStatistics().misses == 1);
+    CHECK(pool->getStatistics().hits == 9);
+}
@@ -0,0 +1,88 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Data/TiledImageStorage.hpp"
+#include "FAST/Data/ImagePyramid.hpp"
+
+using namespace fast;
+
+TEST_CASE("Tiled image storage allocates tiles when written to", "[fast][TiledImageStorage]") {
+    TiledImageStorage storage(1000, 600, 3, 256);
+    CHECK(storage.getNrOfAllocatedTiles() == 0);
+    CHECK(storage.getScalar(999, 599, 2) == 0);
+    CHECK(storage.getNrOfAllocatedTiles() == 0);
+
+    storage.setScalar(300, 10, 42, 1);
+    CHECK(storage.getNrOfAllocatedTiles() == 1);
+    CHECK(storage.getScalar(300, 10, 1) == 42);
+    CHECK(storage.getScalar(300, 10, 0) == 0);
+
+    // Region crossing tile borders
+    std::vector<uint8_t> region(100*50*3);
+    for(int i = 0; i < region.size(); ++i)
+        region[i] = i % 251;
+    storage.setRegion(230, 240, 100, 50, region.data());
+    CHECK(storage.getNrOfAllocatedTiles() == 4);
+    std::vector<uint8_t> result(100*50*3);
+    storage.getRegion(230, 240, 100, 50, result.data());
+    CHECK(result == region);
+}
+
+TEST_CASE("Tiled image storage moves tiles to disk and reads them back", "[fast][TiledImageStorage]") {
+    for(bool compress : {false, true}) {
+        TiledImageStorage storage(1024, 1024, 1, 256);
+        storage.setCompression(compress);
+        // Only room for two tiles in memory
+        storage.setMaximumResidentBytes(2*256*256);
+        for(int tile = 0; tile < 16; ++tile)
+            storage.setScalar((tile % 4)*256 + 7, (tile / 4)*256 + 9, tile + 1);
+        CHECK(storage.getResidentBytes() <= 2*256*256);
+        for(int tile = 0; tile < 16; ++tile) {
+            CHECK(storage.getScalar((tile % 4)*256 + 7, (tile / 4)*256 + 9) == tile + 1);
+            CHECK(storage.getScalar((tile % 4)*256, (tile / 4)*256) == 0);
+        }
+    }
+}
+
+TEST_CASE("Image pyramid created in memory reads zeros from untouched tiles", "[fast][ImagePyramid][TiledImageStorage]") {
+    auto pyramid = ImagePyramid::New();
+    pyramid->create(20000, 16000, 4);
+    auto access = pyramid->getAccess(ACCESS_READ_WRITE);
+    access->setScalar(5000, 6000, 0, 255, 2);
+    CHECK(access->getScalar(5000, 6000, 0, 2) == 255);
+    CHECK(access->getScalar(12345, 4321, 0, 0) == 0);
+    auto data = access->getPatchData(0, 4990, 5990, 20, 20);
+    CHECK(data[(10 + 10*20)*4 + 2] == 255);
+    CHECK(data[0] == 0);
+}
+
+TEST_CASE("Image pyramid setPatch updates coarser levels and dirty patches", "[fast][ImagePyramid][TiledImageStorage]") {
+    auto pyramid = ImagePyramid::New();
+    pyramid->create(20000, 16000, 1);
+    const int x = 1001;
+    const int y = 2003;
+    const int width = 301;
+    const int height = 157;
+    std::vector<uint8_t> data(width*height);
+    for(int i = 0; i < width*height; ++i)
+        data[i] = (i*7) % 256;
+    auto access = pyramid->getAccess(ACCESS_READ_WRITE);
+    access->setPatch(0, x, y, width, height, data.data());
+
+    CHECK(access->getScalar(x, y, 0) == data[0]);
+    CHECK(access->getScalar(x + width - 1, y + height - 1, 0) == data[width*height - 1]);
+    CHECK(access->getScalar(x - 1, y, 0) == 0);
+    // Every pixel of level 1 is the rounded average of 2x2 pixels of level 0
+    for(int cy = y/2; cy <= (y + height)/2; ++cy) {
+        for(int cx = x/2; cx <= (x + width)/2; ++cx) {
+            int sum = access->getScalar(cx*2, cy*2, 0) + access->getScalar(cx*2 + 1, cy*2, 0) +
+                    access->getScalar(cx*2, cy*2 + 1, 0) + access->getScalar(cx*2 + 1, cy*2 + 1, 0);
+            CHECK(access->getScalar(cx, cy, 1) == (sum + 2) / 4);
+        }
+    }
+
+    const int patches = pyramid->getLevelPatches(0);
+    CHECK(pyramid->isDirtyPatch(0, x*patches/20000, y*patches/16000));
+    CHECK(!pyramid->isDirtyPatch(0, 0, 0));
+    CHECK(pyramid->isDirtyPatch(1, (x/2)*pyramid->getLevelPatches(1)/10000, (y/2)*pyramid->getLevelPatches(1)/8000));
+    pyramid->clearDirtyPatch(0, x*patches/20000, y*patches/16000);
+    CHECK(!pyramid->isDirtyPatch(0, x*patches/20000, y*patches/16000));
+}
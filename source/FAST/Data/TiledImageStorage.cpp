@@ -0,0 +1,248 @@
+#include "TiledImageStorage.hpp"
+#include <FAST/Utility.hpp>
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+namespace fast {
+
+static void seekFile(std::FILE* file, int64_t offset) {
+#ifdef WIN32
+    int result = _fseeki64(file, offset, SEEK_SET);
+#else
+    int result = fseeko(file, offset, SEEK_SET);
+#endif
+    if(result != 0)
+        throw Exception("Unable to seek in tile storage file");
+}
+
+TiledImageStorage::TiledImageStorage(int width, int height, int channels, int tileSize) {
+    if(width <= 0 || height <= 0)
+        throw Exception("Size of tiled image storage must be larger than 0");
+    if(channels <= 0 || channels > 4)
+        throw Exception("Nr of channels must be between 1 and 4");
+    if(tileSize <= 0)
+        throw Exception("Tile size must be larger than 0");
+    m_width = width;
+    m_height = height;
+    m_channels = channels;
+    m_tileSize = tileSize;
+    m_tilesX = (width + tileSize - 1) / tileSize;
+    m_tilesY = (height + tileSize - 1) / tileSize;
+    m_tileBytes = (std::size_t)tileSize*tileSize*channels;
+    m_tiles.resize((std::size_t)m_tilesX*m_tilesY);
+}
+
+TiledImageStorage::~TiledImageStorage() {
+    if(m_file != nullptr)
+        std::fclose(m_file);
+}
+
+uint8_t* TiledImageStorage::getTileData(int index, bool allocate) {
+    Tile& tile = m_tiles[index];
+    if(tile.data) {
+        // Move to front of LRU list
+        m_lru.splice(m_lru.begin(), m_lru, tile.lruPosition);
+        return tile.data.get();
+    }
+    if(tile.fileOffset < 0) {
+        // Tile has never been written to
+        if(!allocate)
+            return nullptr;
+        tile.data = std::make_unique<uint8_t[]>(m_tileBytes); // Initialized to zero
+        tile.modified = true;
+        m_allocatedTiles++;
+    } else {
+        readTileFromDisk(tile);
+    }
+    m_lru.push_front(index);
+    tile.lruPosition = m_lru.begin();
+    evict();
+    return tile.data.get();
+}
+
+void TiledImageStorage::evict() {
+    // Never evict the most recently used tile, as it is being accessed
+    while(m_lru.size() > 1 && m_lru.size()*m_tileBytes > m_maximumResidentBytes) {
+        Tile& tile = m_tiles[m_lru.back()];
+        if(tile.modified || tile.fileOffset < 0)
+            writeTileToDisk(tile);
+        tile.data.reset();
+        m_lru.pop_back();
+    }
+}
+
+void TiledImageStorage::writeTileToDisk(Tile& tile) {
+    if(m_file == nullptr) {
+        // Temporary file is deleted automatically when closed
+        m_file = std::tmpfile();
+        if(m_file == nullptr)
+            throw Exception("Unable to create temporary file for tiled image storage");
+    }
+    const uint8_t* data = tile.data.get();
+    std::size_t bytes = m_tileBytes;
+    std::unique_ptr<uint8_t[]> compressed;
+    if(m_compress) {
+        uLongf compressedBytes = compressBound(m_tileBytes);
+        compressed = std::make_unique<uint8_t[]>(compressedBytes);
+        if(compress2(compressed.get(), &compressedBytes, data, m_tileBytes, Z_BEST_SPEED) != Z_OK)
+            throw Exception("Unable to compress tile");
+        data = compressed.get();
+        bytes = compressedBytes;
+    }
+    // Uncompressed tiles always fit in their slot and are rewritten in place. A compressed tile which no longer fits
+    // moves to the smallest free slot it fits in, or is appended to the file.
+    if(tile.fileOffset < 0 || bytes > tile.fileCapacity) {
+        if(tile.fileOffset >= 0)
+            m_freeSlots.emplace(tile.fileCapacity, tile.fileOffset);
+        auto slot = m_freeSlots.lower_bound(bytes);
+        if(slot != m_freeSlots.end()) {
+            tile.fileCapacity = slot->first;
+            tile.fileOffset = slot->second;
+            m_freeSlots.erase(slot);
+        } else {
+            tile.fileCapacity = bytes;
+            tile.fileOffset = m_fileSize;
+            m_fileSize += bytes;
+        }
+    }
+    seekFile(m_file, tile.fileOffset);
+    if(std::fwrite(data, 1, bytes, m_file) != bytes)
+        throw Exception("Unable to write tile to temporary file");
+    tile.fileBytes = bytes;
+    tile.compressed = m_compress;
+    tile.modified = false;
+}
+
+void TiledImageStorage::readTileFromDisk(Tile& tile) {
+    auto buffer = std::make_unique<uint8_t[]>(tile.fileBytes);
+    seekFile(m_file, tile.fileOffset);
+    if(std::fread(buffer.get(), 1, tile.fileBytes, m_file) != tile.fileBytes)
+        throw Exception("Unable to read tile from temporary file");
+    if(tile.compressed) {
+        tile.data = make_uninitialized_unique<uint8_t[]>(m_tileBytes);
+        uLongf bytes = m_tileBytes;
+        if(uncompress(tile.data.get(), &bytes, buffer.get(), tile.fileBytes) != Z_OK || bytes != m_tileBytes)
+            throw Exception("Unable to decompress tile");
+    } else {
+        tile.data = std::move(buffer);
+    }
+    tile.modified = false;
+}
+
+uint8_t TiledImageStorage::getScalar(int x, int y, int channel) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const int tileX = x / m_tileSize;
+    const int tileY = y / m_tileSize;
+    const uint8_t* data = getTileData(tileX + tileY*m_tilesX, false);
+    if(data == nullptr)
+        return 0;
+    const int localX = x - tileX*m_tileSize;
+    const int localY = y - tileY*m_tileSize;
+    return data[(localX + localY*m_tileSize)*m_channels + channel];
+}
+
+void TiledImageStorage::setScalar(int x, int y, uint8_t value, int channel) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const int tileX = x / m_tileSize;
+    const int tileY = y / m_tileSize;
+    const int index = tileX + tileY*m_tilesX;
+    uint8_t* data = getTileData(index, true);
+    m_tiles[index].modified = true;
+    const int localX = x - tileX*m_tileSize;
+    const int localY = y - tileY*m_tileSize;
+    data[(localX + localY*m_tileSize)*m_channels + channel] = value;
+}
+
+void TiledImageStorage::getRegion(int x, int y, int width, int height, uint8_t* data) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Clear entire region first, as parts of it may be outside the image or in tiles never written to
+    std::memset(data, 0, (std::size_t)width*height*m_channels);
+    const int startX = std::max(x, 0);
+    const int startY = std::max(y, 0);
+    const int endX = std::min(x + width, m_width);
+    const int endY = std::min(y + height, m_height);
+    for(int tileY = startY / m_tileSize; tileY*m_tileSize < endY; ++tileY) {
+        for(int tileX = startX / m_tileSize; tileX*m_tileSize < endX; ++tileX) {
+            const uint8_t* tileData = getTileData(tileX + tileY*m_tilesX, false);
+            if(tileData == nullptr)
+                continue;
+            const int fromX = std::max(startX, tileX*m_tileSize);
+            const int toX = std::min(endX, (tileX + 1)*m_tileSize);
+            const int fromY = std::max(startY, tileY*m_tileSize);
+            const int toY = std::min(endY, (tileY + 1)*m_tileSize);
+            for(int cy = fromY; cy < toY; ++cy) {
+                std::memcpy(
+                        &data[((std::size_t)(cy - y)*width + fromX - x)*m_channels],
+                        &tileData[((cy - tileY*m_tileSize)*m_tileSize + fromX - tileX*m_tileSize)*m_channels],
+                        (toX - fromX)*m_channels
+                );
+            }
+        }
+    }
+}
+
+void TiledImageStorage::setRegion(int x, int y, int width, int height, const uint8_t* data) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const int startX = std::max(x, 0);
+    const int startY = std::max(y, 0);
+    const int endX = std::min(x + width, m_width);
+    const int endY = std::min(y + height, m_height);
+    for(int tileY = startY / m_tileSize; tileY*m_tileSize < endY; ++tileY) {
+        for(int tileX = startX / m_tileSize; tileX*m_tileSize < endX; ++tileX) {
+            const int index = tileX + tileY*m_tilesX;
+            uint8_t* tileData = getTileData(index, true);
+            m_tiles[index].modified = true;
+            const int fromX = std::max(startX, tileX*m_tileSize);
+            const int toX = std::min(endX, (tileX + 1)*m_tileSize);
+            const int fromY = std::max(startY, tileY*m_tileSize);
+            const int toY = std::min(endY, (tileY + 1)*m_tileSize);
+            for(int cy = fromY; cy < toY; ++cy) {
+                std::memcpy(
+                        &tileData[((cy - tileY*m_tileSize)*m_tileSize + fromX - tileX*m_tileSize)*m_channels],
+                        &data[((std::size_t)(cy - y)*width + fromX - x)*m_channels],
+                        (toX - fromX)*m_channels
+                );
+            }
+        }
+    }
+}
+
+void TiledImageStorage::setMaximumResidentBytes(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maximumResidentBytes = bytes;
+    evict();
+}
+
+void TiledImageStorage::setCompression(bool compress) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_compress = compress;
+}
+
+int TiledImageStorage::getWidth() const {
+    return m_width;
+}
+
+int TiledImageStorage::getHeight() const {
+    return m_height;
+}
+
+int TiledImageStorage::getNrOfChannels() const {
+    return m_channels;
+}
+
+int TiledImageStorage::getTileSize() const {
+    return m_tileSize;
+}
+
+int TiledImageStorage::getNrOfAllocatedTiles() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocatedTiles;
+}
+
+std::size_t TiledImageStorage::getResidentBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lru.size()*m_tileBytes;
+}
+
+}
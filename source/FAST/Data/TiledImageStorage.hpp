@@ -0,0 +1,97 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <cstdio>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fast {
+
+/**
+ * Storage of a large 8 bit image as a grid of square tiles, used for the levels of an ImagePyramid.
+ *
+ * Tiles are allocated the first time they are written to; tiles which have never been written to read as zero
+ * and use no memory. When the uncompressed tiles in memory exceed the maximum resident size, the least recently
+ * used tiles are moved to a temporary file on disk, optionally compressed with zlib, and read back when accessed again.
+ *
+ * All methods are thread safe.
+ */
+class FAST_EXPORT TiledImageStorage : public Object {
+    public:
+        typedef SharedPointer<TiledImageStorage> pointer;
+        TiledImageStorage(int width, int height, int channels, int tileSize = 256);
+        uint8_t getScalar(int x, int y, int channel = 0);
+        void setScalar(int x, int y, uint8_t value, int channel = 0);
+        /**
+         * Copy a region into data, stored row by row with interleaved channels.
+         * Only the tiles intersecting the region are read. Pixels outside the image are set to zero.
+         */
+        void getRegion(int x, int y, int width, int height, uint8_t* data);
+        /**
+         * Copy data, stored row by row with interleaved channels, into a region.
+         * Pixels outside the image are ignored.
+         */
+        void setRegion(int x, int y, int width, int height, const uint8_t* data);
+        /**
+         * Set maximum number of bytes of uncompressed tiles kept in memory. Default is 256 MB.
+         * @param bytes
+         */
+        void setMaximumResidentBytes(std::size_t bytes);
+        /**
+         * Compress tiles with zlib when moving them to disk. Disabled by default.
+         * @param compress
+         */
+        void setCompression(bool compress);
+        int getWidth() const;
+        int getHeight() const;
+        int getNrOfChannels() const;
+        int getTileSize() const;
+        /**
+         * Number of tiles which have been written to
+         */
+        int getNrOfAllocatedTiles() const;
+        std::size_t getResidentBytes() const;
+        ~TiledImageStorage();
+    private:
+        struct Tile {
+            // Uncompressed tile data, if in memory
+            std::unique_ptr<uint8_t[]> data;
+            // Whether data has changed since the tile was last written to disk
+            bool modified = false;
+            // Location of tile in the temporary file, offset is -1 if not on disk
+            int64_t fileOffset = -1;
+            std::size_t fileBytes = 0;
+            // Size of the slot in the file reserved for this tile, which may be larger than fileBytes
+            std::size_t fileCapacity = 0;
+            bool compressed = false;
+            std::list<int>::iterator lruPosition;
+        };
+        /**
+         * Get tile data in memory, loading it from disk if needed. Returns nullptr if the tile has never been written
+         * and allocate is false. m_mutex must be locked.
+         */
+        uint8_t* getTileData(int index, bool allocate);
+        void evict();
+        void writeTileToDisk(Tile& tile);
+        void readTileFromDisk(Tile& tile);
+
+        int m_width, m_height, m_channels, m_tileSize;
+        int m_tilesX, m_tilesY;
+        std::size_t m_tileBytes;
+        std::vector<Tile> m_tiles;
+        // Indices of tiles in memory, most recently used first
+        std::list<int> m_lru;
+        std::size_t m_maximumResidentBytes = 256*1024*1024;
+        bool m_compress = false;
+        int m_allocatedTiles = 0;
+        std::FILE* m_file = nullptr;
+        int64_t m_fileSize = 0;
+        // Slots in the file no longer used by any tile, as size and offset
+        std::multimap<std::size_t, int64_t> m_freeSlots;
+        mutable std::mutex m_mutex;
+};
+
+}
@@ -48,6 +48,8 @@ void NewestFrameDataChannel::stop() {
 }
 
 bool NewestFrameDataChannel::hasCurrentData() {
+    // Lock, as the frame may be replaced from another thread, e.g. a PipelineExecutor worker
+    std::lock_guard<std::mutex> lock(m_mutex);
     return m_frame ? true: false;
 }
 
@@ -48,6 +48,7 @@ DataObject::pointer QueuedDataChannel::getNextDataFrame() {
 }
 
 int QueuedDataChannel::getSize() {
+    std::lock_guard<std::mutex> lock(m_mutex);
     return m_queue.size();
 }
 
@@ -0,0 +1,158 @@
+#include "RingBufferDataChannel.hpp"
+#include <thread>
+
+namespace fast {
+
+void RingBufferDataChannel::addFrame(DataObject::pointer data) {
+    // Decrement semaphore by one, wait if buffer is full
+    m_emptyCount->wait();
+
+    // If stop is signaled, throw an exception to stop the entire computation thread
+    if(m_stopped)
+        throw ThreadStopped();
+
+    push(data);
+
+    // Increment semaphore by one, signal any waiting due to empty buffer
+    m_fillCount->signal();
+}
+
+DataObject::pointer RingBufferDataChannel::getNextDataFrame() {
+    // Decrement semaphore by one, and wait if buffer is empty
+    m_fillCount->wait();
+
+    // If stop is signaled, throw an exception to stop the entire computation thread
+    if(m_stopped)
+        throw ThreadStopped();
+
+    DataObject::pointer data = pop();
+
+    // Increment semaphore by one and signal any waiting due to full buffer
+    m_emptyCount->signal();
+
+    return data;
+}
+
+void RingBufferDataChannel::push(DataObject::pointer data) {
+    // The semaphores guarantee that there is a free slot at this point
+    if(!m_multiple) {
+        // Single producer: only this thread writes the tail
+        const uint64_t position = m_tail.load(std::memory_order_relaxed);
+        m_buffer[position & m_mask].data = std::move(data);
+        m_tail.store(position + 1, std::memory_order_release);
+        return;
+    }
+
+    // Multiple producers: claim a slot by incrementing the tail, the sequence number of the slot
+    // tells whether a consumer has finished reading it
+    Slot* slot;
+    uint64_t position = m_tail.load(std::memory_order_relaxed);
+    while(true) {
+        slot = &m_buffer[position & m_mask];
+        const int64_t diff = (int64_t)slot->sequence.load(std::memory_order_acquire) - (int64_t)position;
+        if(diff == 0) {
+            if(m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if(diff < 0) {
+            // Slot is still being read by a consumer
+            std::this_thread::yield();
+            position = m_tail.load(std::memory_order_relaxed);
+        } else {
+            position = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+    slot->data = std::move(data);
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+DataObject::pointer RingBufferDataChannel::pop() {
+    // The semaphores guarantee that there is a frame available at this point
+    if(!m_multiple) {
+        // Single consumer: only this thread writes the head
+        const uint64_t position = m_head.load(std::memory_order_relaxed);
+        DataObject::pointer data = std::move(m_buffer[position & m_mask].data);
+        m_head.store(position + 1, std::memory_order_release);
+        return data;
+    }
+
+    Slot* slot;
+    uint64_t position = m_head.load(std::memory_order_relaxed);
+    while(true) {
+        slot = &m_buffer[position & m_mask];
+        const int64_t diff = (int64_t)slot->sequence.load(std::memory_order_acquire) - (int64_t)(position + 1);
+        if(diff == 0) {
+            if(m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if(diff < 0) {
+            // Slot is still being written by a producer
+            std::this_thread::yield();
+            position = m_head.load(std::memory_order_relaxed);
+        } else {
+            position = m_head.load(std::memory_order_relaxed);
+        }
+    }
+    DataObject::pointer data = std::move(slot->data);
+    slot->sequence.store(position + m_mask + 1, std::memory_order_release);
+    return data;
+}
+
+int RingBufferDataChannel::getSize() {
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    const uint64_t tail = m_tail.load(std::memory_order_acquire);
+    return tail > head ? (int)(tail - head) : 0;
+}
+
+void RingBufferDataChannel::setMaximumNumberOfFrames(uint frames) {
+    if(getSize() > 0)
+        throw Exception("Have to call setMaximumNumberOfFrames before executing pipeline");
+    if(frames == 0)
+        throw Exception("Maximum number of frames in RingBufferDataChannel must be larger than 0");
+    mMaximumNumberOfFrames = frames;
+
+    // Use a power of two buffer size so that positions can be wrapped using a mask
+    uint64_t size = 1;
+    while(size < frames)
+        size *= 2;
+    m_mask = size - 1;
+    m_buffer = std::unique_ptr<Slot[]>(new Slot[size]);
+    for(uint64_t i = 0; i < size; ++i)
+        m_buffer[i].sequence = i;
+    m_head = 0;
+    m_tail = 0;
+    m_fillCount = std::make_unique<LightweightSemaphore>(0);
+    m_emptyCount = std::make_unique<LightweightSemaphore>(mMaximumNumberOfFrames);
+}
+
+void RingBufferDataChannel::setMultipleProducersAndConsumers(bool enabled) {
+    if(getSize() > 0)
+        throw Exception("Have to call setMultipleProducersAndConsumers before executing pipeline");
+    m_multiple = enabled;
+}
+
+void RingBufferDataChannel::stop() {
+    DataChannel::stop();
+    m_stopped = true;
+    Reporter::info() << "SIGNALING SEMAPHORES in RingBufferDataChannel" << Reporter::end();
+
+    // Since getNextFrame or addFrame might be waiting, we need to signal the semaphores to stop them blocking.
+    // A negative count is the number of threads waiting.
+    m_fillCount->signal(std::max(1, -m_fillCount->getCount()));
+    m_emptyCount->signal(std::max(1, -m_emptyCount->getCount()));
+}
+
+bool RingBufferDataChannel::hasCurrentData() {
+    return getSize() > 0;
+}
+
+DataObject::pointer RingBufferDataChannel::getFrame() {
+    if(getSize() == 0)
+        throw Exception("No frames available in getFrame");
+    return m_buffer[m_head.load(std::memory_order_acquire) & m_mask].data;
+}
+
+RingBufferDataChannel::RingBufferDataChannel() {
+    m_stopped = false;
+    setMaximumNumberOfFrames(50);
+}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <FAST/DataChannels/DataChannel.hpp>
+#include <FAST/Semaphore.hpp>
+#include <atomic>
+
+namespace fast {
+
+/**
+ * This data channel implements the producer-consumer task using a pre-sized
+ * lock-free ring buffer instead of a mutex guarded queue. Thus no locking or memory
+ * allocation is done when frames are added or removed.
+ * Lightweight semaphores are used to block when the buffer is full or empty.
+ *
+ * By default the channel assumes a single producer and a single consumer, which
+ * is the case for all connections in FAST since every input connection has its own data channel.
+ * If several threads add or remove frames from the same channel, enable multiple producers and consumers.
+ *
+ * It is used on the output data channels of streamers when streaming mode is PROCESS_ALL_FRAMES
+ * and lock-free data channels are enabled, see Config::setLockFreeDataChannels.
+ */
+class FAST_EXPORT RingBufferDataChannel : public DataChannel {
+    FAST_OBJECT(RingBufferDataChannel)
+    public:
+        /**
+         * Add frame to the data channel. This call may block
+         * if the buffer is full.
+         */
+        void addFrame(DataObject::pointer data) override;
+
+        /**
+         * @return the number of frames stored in this DataChannel
+         */
+        int getSize() override;
+
+        /**
+         * Set the maximum nr of frames that can be stored in this data channel
+         */
+        void setMaximumNumberOfFrames(uint frames) override;
+
+        /**
+         * Allow several threads to add and get frames from this data channel at the same time.
+         * Has to be called before executing the pipeline.
+         */
+        void setMultipleProducersAndConsumers(bool enabled);
+
+        /**
+         * This will unblock if this DataChannel is currently blocking. Used to stop a pipeline.
+         */
+        void stop() override;
+
+        bool hasCurrentData() override;
+
+        /**
+         * Get current frame, throws if current frame is not available.
+         */
+        DataObject::pointer getFrame() override;
+    protected:
+        struct Slot {
+            std::atomic<uint64_t> sequence;
+            DataObject::pointer data;
+        };
+        std::unique_ptr<Slot[]> m_buffer;
+        uint64_t m_mask;
+        uint mMaximumNumberOfFrames;
+        bool m_multiple = false;
+        std::atomic_bool m_stopped;
+        std::atomic<uint64_t> m_head;
+        std::atomic<uint64_t> m_tail;
+        std::unique_ptr<LightweightSemaphore> m_fillCount;
+        std::unique_ptr<LightweightSemaphore> m_emptyCount;
+
+        void push(DataObject::pointer data);
+        DataObject::pointer pop();
+        DataObject::pointer getNextDataFrame() override;
+        RingBufferDataChannel();
+
+};
+
+}
@@ -3,6 +3,18 @@
 #include "FAST/Utility.hpp"
 #include <mutex>
 #include <fstream>
+#include <iomanip>
+#include <set>
+#include <list>
+#include <thread>
+#include <cstdio>
+#include <map>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
 #include "FAST/Config.hpp"
 
 #if defined(__APPLE__) || defined(__MACOSX)
@@ -81,6 +93,10 @@ bool OpenCLDevice::isWritingTo3DTexturesSupported() {
     return OpenCLDevice::getDevice(0).getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_3d_image_writes") != std::string::npos;
 }
 
+bool OpenCLDevice::isCPU() {
+    return m_isCPU;
+}
+
 OpenCLDevice::~OpenCLDevice() {
      //reportInfo() << "DESTROYING opencl device object..." << Reporter::end();
      // Make sure that all queues are finished
@@ -142,6 +158,7 @@ OpenCLDevice::OpenCLDevice(std::vector<cl::Device> devices, unsigned long* OpenG
 		runtimeManager->disable();
 
     this->devices = devices;
+    m_isCPU = devices[0].getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
     // TODO: make sure that all devices have the same platform
     this->platform = devices[0].getInfo<CL_DEVICE_PLATFORM>();
 
@@ -182,6 +199,7 @@ OpenCLDevice::OpenCLDevice(std::vector<cl::Device> devices, unsigned long* OpenG
     }
     this->context = cl::Context(devices,cps);
     delete[] cps;
+    m_memoryPool = std::make_shared<OpenCLMemoryPool>(context);
 
     // Create a command queue for each device
     for(int i = 0; i < devices.size(); i++) {
@@ -193,19 +211,25 @@ OpenCLDevice::OpenCLDevice(std::vector<cl::Device> devices, unsigned long* OpenG
     }
 }
 
+std::string OpenCLDevice::readProgramSource(std::string filename) {
+    std::string sourceCode = readFile(filename);
+    // If 3d image writes is supported, append the enable line to all source files (fix error on Intel devices)
+    if(isWritingTo3DTexturesSupported())
+        sourceCode = "#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n\n" + sourceCode;
+    return sourceCode;
+}
+
 int OpenCLDevice::createProgramFromSource(std::string filename, std::string buildOptions, bool useCaching) {
-    std::lock_guard<std::mutex> lock(buildBinaryMutex);
+    // Programs are built without holding the lock, so that multiple programs can be built concurrently
     cl::Program program;
+    const std::string sourceCode = readProgramSource(filename);
     if(useCaching) {
-        program = buildProgramFromBinary(filename, buildOptions);
+        program = buildProgram({sourceCode}, buildOptions, getDirName(filename));
     } else {
-        std::string sourceCode = readFile(filename);
-        // If 3d image writes is supported, append the enable line to all source files (fix error on Intel devices)
-        if(isWritingTo3DTexturesSupported())
-            sourceCode = "#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n\n" + sourceCode;
         cl::Program::Sources source(1, std::make_pair(sourceCode.c_str(), sourceCode.length()));
         program = buildSources(source, buildOptions);
     }
+    std::lock_guard<std::mutex> lock(buildBinaryMutex);
     programs.push_back(program);
     return programs.size()-1;
 }
@@ -214,30 +238,19 @@ int OpenCLDevice::createProgramFromSource(std::string filename, std::string buil
  * Compile several source files together
  */
 int OpenCLDevice::createProgramFromSource(std::vector<std::string> filenames, std::string buildOptions) {
-    std::lock_guard<std::mutex> lock(buildBinaryMutex);
-    // Do this in a weird way, because the the logical way does not work.
-    std::string sourceCode = readFile(filenames[0]);
-    if(isWritingTo3DTexturesSupported())
-        sourceCode = "#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n\n" + sourceCode;
-    cl::Program::Sources sources(filenames.size(), std::make_pair(sourceCode.c_str(), sourceCode.length()));
-    for(int i = 1; i < filenames.size(); i++) {
-        std::string sourceCode2 = readFile(filenames[i]);
-        // If 3d image writes is supported, append the enable line to all source files (fix error on Intel devices)
-        if(isWritingTo3DTexturesSupported())
-            sourceCode2 = "#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n\n" + sourceCode2;
-        sources[i] = std::make_pair(sourceCode2.c_str(), sourceCode2.length());
-    }
+    std::vector<std::string> sourceCodes;
+    for(int i = 0; i < filenames.size(); i++)
+        sourceCodes.push_back(readProgramSource(filenames[i]));
 
-    cl::Program program = buildSources(sources, buildOptions);
+    cl::Program program = buildProgram(sourceCodes, buildOptions, getDirName(filenames[0]));
+    std::lock_guard<std::mutex> lock(buildBinaryMutex);
     programs.push_back(program);
     return programs.size()-1;
 }
 
 int OpenCLDevice::createProgramFromString(std::string code, std::string buildOptions) {
+    cl::Program program = buildProgram({code}, buildOptions);
     std::lock_guard<std::mutex> lock(buildBinaryMutex);
-    cl::Program::Sources source(1, std::make_pair(code.c_str(), code.length()));
-
-    cl::Program program = buildSources(source, buildOptions);
     programs.push_back(program);
     return programs.size()-1;
 }
@@ -272,6 +285,7 @@ cl::Platform OpenCLDevice::getPlatform() {
 cl::Program OpenCLDevice::buildSources(cl::Program::Sources source, std::string buildOptions) {
     // Make program of the source code in the context
     cl::Program program = cl::Program(context, source);
+    ++m_programsBuiltFromSource;
 
     // Build program for the context devices
     try{
@@ -289,60 +303,221 @@ cl::Program OpenCLDevice::buildSources(cl::Program::Sources source, std::string
     return program;
 }
 
+OpenCLMemoryPool::pointer OpenCLDevice::getMemoryPool() {
+    return m_memoryPool;
+}
+
 RuntimeMeasurementsManager::pointer OpenCLDevice::getRunTimeMeasurementManager(){
 	return runtimeManager;
 }
 
 
-cl::Program OpenCLDevice::writeBinary(std::string filename, std::string buildOptions) {
-    // Build program from source file and store the binary file
-    std::string sourceCode = readFile(filename);
-    // If 3d image writes is supported, append the enable line to all source files (fix error on Intel devices)
-    if(isWritingTo3DTexturesSupported())
-        sourceCode = "#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n\n" + sourceCode;
+// 64 bit FNV-1a hash, which unlike std::hash is the same on all platforms and runs
+static uint64_t hashString(const std::string& str, uint64_t hash = 14695981039346656037ULL) {
+    for(unsigned char c : str) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Get the -I include directories of a set of build options
+static std::vector<std::string> getIncludeDirectories(const std::string& buildOptions) {
+    std::vector<std::string> directories;
+    std::istringstream stream(buildOptions);
+    std::string option;
+    while(stream >> option) {
+        if(option == "-I") {
+            if(stream >> option)
+                directories.push_back(option);
+        } else if(option.substr(0, 2) == "-I") {
+            directories.push_back(option.substr(2));
+        }
+    }
+    return directories;
+}
+
+// Append the contents of all files included by the source code, recursively, so that a change in an included file
+// changes the cache key.
+static void appendIncludedFiles(const std::string& sourceCode, const std::vector<std::string>& directories, std::set<std::string>& visited, std::string& result) {
+    std::istringstream stream(sourceCode);
+    std::string line;
+    while(std::getline(stream, line)) {
+        trim(line);
+        if(line.substr(0, 8) != "#include")
+            continue;
+        const std::size_t start = line.find_first_of("\"<");
+        const std::size_t end = line.find_first_of("\">", start + 1);
+        if(start == std::string::npos || end == std::string::npos)
+            continue;
+        const std::string includeName = line.substr(start + 1, end - start - 1);
+        for(auto&& directory : directories) {
+            const std::string path = join(directory, includeName);
+            if(!fileExists(path))
+                continue;
+            if(visited.count(path) == 0) {
+                visited.insert(path);
+                const std::string includedCode = readFile(path);
+                result += path + "\n" + includedCode;
+                auto includedDirectories = directories;
+                includedDirectories.insert(includedDirectories.begin(), getDirName(path));
+                appendIncludedFiles(includedCode, includedDirectories, visited, result);
+            }
+            break;
+        }
+    }
+}
+
+std::string OpenCLDevice::getProgramCacheKey(const std::vector<std::string>& sourceCodes, std::string buildOptions, std::string sourceDirectory) {
+    auto directories = getIncludeDirectories(buildOptions);
+    if(!sourceDirectory.empty())
+        directories.insert(directories.begin(), sourceDirectory);
+    std::string key;
+    std::set<std::string> visited;
+    for(auto&& sourceCode : sourceCodes) {
+        key += sourceCode;
+        key += '\0';
+        appendIncludedFiles(sourceCode, directories, visited, key);
+    }
+    key += '\0' + buildOptions;
+    // The binary is only valid for the device and driver it was compiled with
+    const cl::Device device = getDevice(0);
+    key += '\0' + device.getInfo<CL_DEVICE_NAME>();
+    key += '\0' + device.getInfo<CL_DEVICE_VERSION>();
+    key += '\0' + device.getInfo<CL_DRIVER_VERSION>();
+    key += '\0' + platform.getInfo<CL_PLATFORM_NAME>();
+    key += '\0' + platform.getInfo<CL_PLATFORM_VERSION>();
+    std::stringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << hashString(key);
+    return stream.str();
+}
+
+static std::string getProgramCachePath() {
+    return join(Config::getKernelBinaryPath(), "cache");
+}
+
+// Total size of the binaries in each program cache directory, as tracked by this process. The directory is only
+// scanned, and the least recently used binaries deleted, when this exceeds the maximum size.
+static std::mutex programCacheSizeMutex;
+static std::map<std::string, std::size_t> programCacheSizes;
+
+// Set the modification time of a file to now
+static void touchFile(const std::string& filename) {
+#ifdef _WIN32
+    _utime(filename.c_str(), nullptr);
+#else
+    utime(filename.c_str(), nullptr);
+#endif
+}
 
-    cl::Program::Sources source(1, std::make_pair(sourceCode.c_str(), sourceCode.length()));
-    cl::Program program = buildSources(source, buildOptions);
-
-    std::vector<std::size_t> binarySizes;
-    binarySizes = program.getInfo<CL_PROGRAM_BINARY_SIZES>();
-
-    std::vector<std::vector<uchar>> binaries;
-    binaries = program.getInfo<CL_PROGRAM_BINARIES>();
-
-    std::string deviceName = getDevice(0).getInfo<CL_DEVICE_NAME>();
-    std::size_t hash = std::hash<std::string>{}(buildOptions + deviceName);
-    std::string binaryPath = Config::getKernelBinaryPath();
-    // TODO fix this for both install and build
-    std::string kernelSourcePath = Config::getKernelSourcePath();
-    std::string binaryFilename = binaryPath + filename.substr(kernelSourcePath.size()) + "_" + std::to_string(hash) + ".bin";
-    std::string cacheFilename = binaryPath + filename.substr(kernelSourcePath.size()) + "_" + std::to_string(hash) + ".cache";
-
-    // Create directories if they don't exist
-    if(binaryFilename.rfind("/") != std::string::npos) {
-        std::string directoryPath = binaryFilename.substr(0, binaryFilename.rfind("/"));
-//        QDir dir(directoryPath.c_str());
-//        if (!dir.exists()) {
-//            dir.mkpath(".");
-//        }
-        createDirectories(directoryPath);
+std::string OpenCLDevice::getProgramBinaryFilename(const std::vector<std::string>& sourceCodes, std::string buildOptions, std::string sourceDirectory) {
+    return join(getProgramCachePath(), getProgramCacheKey(sourceCodes, buildOptions, sourceDirectory) + ".bin");
+}
+
+cl::Program OpenCLDevice::buildProgram(const std::vector<std::string>& sourceCodes, std::string buildOptions, std::string sourceDirectory) {
+    cl::Program::Sources sources;
+    for(auto&& sourceCode : sourceCodes)
+        sources.push_back(std::make_pair(sourceCode.c_str(), sourceCode.length()));
+    if(Config::getKernelBinaryCacheMaximumSize() > 0) {
+        const std::string binaryFilename = getProgramBinaryFilename(sourceCodes, buildOptions, sourceDirectory);
+        if(fileExists(binaryFilename)) {
+            try {
+                cl::Program program = readBinary(binaryFilename);
+                // The modification time of a binary is the last time it was used, see pruneProgramCache
+                touchFile(binaryFilename);
+                ++m_programsLoadedFromCache;
+                return program;
+            } catch(cl::Error &error) {
+                // Binary is corrupt or not accepted by the driver, compile and replace it
+                reportWarning() << "Unable to load kernel binary " << binaryFilename << ", compiling.." << reportEnd();
+            }
+        }
+        cl::Program program = buildSources(sources, buildOptions);
+        try {
+            writeBinary(program, binaryFilename);
+        } catch(Exception &e) {
+            // The program can still be used, even if the cache is not writable
+            reportWarning() << e.what() << reportEnd();
+        }
+        return program;
     }
-    FILE * file = fopen(binaryFilename.c_str(), "wb");
+    return buildSources(sources, buildOptions);
+}
+
+void OpenCLDevice::writeBinary(cl::Program program, std::string binaryFilename) {
+    std::vector<std::vector<uchar>> binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+    if(binaries.empty() || binaries[0].empty())
+        return;
+
+    createDirectories(getDirName(binaryFilename));
+    // Write to a temporary file first and rename it, so that other processes never read a partially written binary
+    std::stringstream temporaryFilename;
+    temporaryFilename << binaryFilename << "." << std::this_thread::get_id() << "." << this << ".tmp";
+    FILE * file = fopen(temporaryFilename.str().c_str(), "wb");
     if(!file)
-        throw Exception("Could not write kernel binary to file: " + binaryFilename);
-    fwrite(binaries[0].data(), sizeof(char), (int)binarySizes[0], file);
+        throw Exception("Could not write kernel binary to file: " + temporaryFilename.str());
+    const bool success = fwrite(binaries[0].data(), sizeof(char), binaries[0].size(), file) == binaries[0].size();
     fclose(file);
+#ifdef _WIN32
+    // Rename does not replace existing files on Windows
+    if(success)
+        std::remove(binaryFilename.c_str());
+#endif
+    if(!success || std::rename(temporaryFilename.str().c_str(), binaryFilename.c_str()) != 0) {
+        // Rename may fail if another process wrote the same binary at the same time
+        std::remove(temporaryFilename.str().c_str());
+        if(!success)
+            throw Exception("Could not write kernel binary to file: " + binaryFilename);
+        return;
+    }
 
-    // Write cache file
-    FILE * cacheFile = fopen(cacheFilename.c_str(), "w");
-    std::string timeStr = getModifiedDate(filename);
-    std::vector<cl::Device> devices = context.getInfo<CL_CONTEXT_DEVICES>();
-    timeStr += "-" + devices[0].getInfo<CL_DEVICE_NAME>() + "\n";
-    timeStr += "-" + buildOptions;
-    fwrite(timeStr.c_str(), sizeof(char), timeStr.size(), cacheFile);
-    fclose(cacheFile);
+    // A replaced binary is counted twice, which only makes the next scan happen earlier
+    const std::string cachePath = getProgramCachePath();
+    std::lock_guard<std::mutex> lock(programCacheSizeMutex);
+    auto size = programCacheSizes.find(cachePath);
+    if(size == programCacheSizes.end()) {
+        // Size of the binaries written by earlier runs is not known yet
+        programCacheSizes[cachePath] = pruneProgramCache();
+    } else {
+        size->second += binaries[0].size();
+        if(size->second > Config::getKernelBinaryCacheMaximumSize())
+            size->second = pruneProgramCache();
+    }
+}
 
-    return program;
+std::size_t OpenCLDevice::pruneProgramCache() {
+    const std::string cachePath = getProgramCachePath();
+    const std::size_t maximumSize = Config::getKernelBinaryCacheMaximumSize();
+    struct CacheFile {
+        std::string filename;
+        std::size_t size;
+        time_t modified;
+    };
+    std::vector<CacheFile> files;
+    std::size_t totalSize = 0;
+    for(auto&& name : getDirectoryList(cachePath)) {
+        if(name.size() < 4 || name.substr(name.size() - 4) != ".bin")
+            continue;
+        const std::string filename = join(cachePath, name);
+        struct stat attrib;
+        if(stat(filename.c_str(), &attrib) != 0)
+            continue;
+        files.push_back({filename, (std::size_t)attrib.st_size, attrib.st_mtime});
+        totalSize += attrib.st_size;
+    }
+    if(totalSize <= maximumSize)
+        return totalSize;
+    // Binaries are touched when loaded, thus delete the least recently used binaries first
+    std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) {
+        return a.modified < b.modified;
+    });
+    for(auto&& file : files) {
+        if(totalSize <= maximumSize)
+            break;
+        if(std::remove(file.filename.c_str()) == 0)
+            totalSize -= file.size;
+    }
+    return totalSize;
 }
 
 cl::Program OpenCLDevice::readBinary(std::string filename) {
@@ -367,90 +542,171 @@ cl::Program OpenCLDevice::readBinary(std::string filename) {
     return program;
 }
 
-cl::Program OpenCLDevice::buildProgramFromBinary(std::string filename, std::string buildOptions) {
-    cl::Program program;
+// Programs which have been created with a name, used by prewarmProgramCache. The most recently used program is first.
+static std::mutex programIndexMutex;
+static std::unique_ptr<std::list<std::pair<std::string, std::string>>> programIndex;
+// The least recently used programs are removed from the index when it is full
+static const std::size_t maximumProgramIndexSize = 256;
 
-    std::string deviceName = getDevice(0).getInfo<CL_DEVICE_NAME>();
-    std::size_t hash = std::hash<std::string>{}(buildOptions + deviceName);
-    std::string binaryPath = Config::getKernelBinaryPath();
-    std::string kernelSourcePath = Config::getKernelSourcePath();
-    std::string binaryFilename = binaryPath + filename.substr(kernelSourcePath.size()) + "_" + std::to_string(hash) + ".bin";
-    std::string cacheFilename = binaryPath + filename.substr(kernelSourcePath.size()) + "_" + std::to_string(hash) + ".cache";
-
-    // Check if a binary file exists
-    std::ifstream binaryFile(binaryFilename.c_str(), std::ios_base::binary | std::ios_base::in);
-    if(binaryFile.fail()) {
-        program = writeBinary(filename, buildOptions);
-    } else {
-        // Compare modified dates of binary file and source file
-
-        // Read cache file
-        std::ifstream cacheFile(cacheFilename.c_str());
-        std::string cache(
-            std::istreambuf_iterator<char>(cacheFile),
-            (std::istreambuf_iterator<char>()));
-
-        bool outOfDate = true;
-        bool wrongDeviceID = true;
-        bool buildOptionsChanged = true;
-        const size_t pos = cache.find("-");
-        const size_t pos2 = cache.find("-", pos+1);
-        if(pos != std::string::npos && pos2 != std::string::npos) {
-            // Get modification date of file
-            #ifdef WIN32
-            HANDLE hFile = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
-            FILETIME ftCreate, ftAccess, ftWrite;
-			SYSTEMTIME sysTime;
-            GetFileTime(hFile, &ftCreate, &ftAccess, &ftWrite);
-			FileTimeToSystemTime(&ftWrite, &sysTime);
-			char* buffer = new char[255];
-			sprintf(buffer, "%d%d%d%d%d", sysTime.wYear, sysTime.wMonth, sysTime.wDay, sysTime.wHour,sysTime.wMinute,sysTime.wSecond);
-			outOfDate = strcmp(buffer, cache.substr(0, pos).c_str()) != 0;
-			delete[] buffer;
-            #else
-            struct stat attrib; // create a file attribute structure
-            stat(filename.c_str(), &attrib);
-            outOfDate = strcmp(ctime(&(attrib.st_mtime)), cache.substr(0, pos).c_str()) != 0;
-            #endif
-            std::vector<cl::Device> devices = context.getInfo<CL_CONTEXT_DEVICES>();
-            wrongDeviceID = cache.substr(pos+1, pos2-pos-2) != devices[0].getInfo<CL_DEVICE_NAME>();
-            buildOptionsChanged = cache.substr(pos2+1) != buildOptions;
-        }
+static std::string getProgramIndexFilename() {
+    return join(getProgramCachePath(), "programs.txt");
+}
 
-        if(outOfDate || wrongDeviceID || buildOptionsChanged) {
-            Reporter::warning() << "Kernel binary " << filename.substr(kernelSourcePath.size()) << " is out of date. Compiling..." << Reporter::end();
-            program = writeBinary(filename, buildOptions);
-        } else {
-            //std::cout << "Binary is not out of date." << std::endl;
-            program = readBinary(binaryFilename);
+static void writeProgramIndex() {
+    // Must be called with programIndexMutex locked
+    try {
+        createDirectories(getProgramCachePath());
+    } catch(Exception &e) {
+        // Cache directory not writable, pre-warming will not be possible
+        return;
+    }
+    // Write to a temporary file first and rename it, so that other processes never read a partially written index
+    const std::string filename = getProgramIndexFilename();
+    std::stringstream temporaryFilename;
+    temporaryFilename << filename << "." << std::this_thread::get_id() << ".tmp";
+    {
+        std::ofstream file(temporaryFilename.str());
+        if(!file.is_open())
+            return;
+        for(auto&& entry : *programIndex)
+            file << entry.first << "\t" << entry.second << "\n";
+    }
+#ifdef _WIN32
+    // Rename does not replace existing files on Windows
+    std::remove(filename.c_str());
+#endif
+    if(std::rename(temporaryFilename.str().c_str(), filename.c_str()) != 0)
+        std::remove(temporaryFilename.str().c_str());
+}
+
+static void loadProgramIndex() {
+    // Must be called with programIndexMutex locked
+    if(programIndex != nullptr)
+        return;
+    programIndex = std::make_unique<std::list<std::pair<std::string, std::string>>>();
+    std::ifstream file(getProgramIndexFilename());
+    std::set<std::pair<std::string, std::string>> added;
+    bool compact = false;
+    std::string line;
+    while(std::getline(file, line)) {
+        const std::size_t pos = line.find('\t');
+        if(pos == std::string::npos)
+            continue;
+        const auto entry = std::make_pair(line.substr(0, pos), line.substr(pos + 1));
+        if(!added.insert(entry).second) {
+            compact = true;
+            continue;
         }
+        programIndex->push_back(entry);
+    }
+    if(programIndex->size() > maximumProgramIndexSize) {
+        programIndex->resize(maximumProgramIndexSize);
+        compact = true;
     }
+    if(compact)
+        writeProgramIndex();
+}
 
-    return program;
+static void addToProgramIndex(std::string filename, std::string buildOptions) {
+    const std::string kernelSourcePath = Config::getKernelSourcePath();
+    // Only kernels of FAST are stored, relative to the kernel source path, as other files may not exist in the next run
+    if(filename.substr(0, kernelSourcePath.size()) != kernelSourcePath)
+        return;
+    filename = filename.substr(kernelSourcePath.size());
+    std::lock_guard<std::mutex> lock(programIndexMutex);
+    loadProgramIndex();
+    const auto entry = std::make_pair(filename, buildOptions);
+    if(!programIndex->empty() && programIndex->front() == entry)
+        return;
+    programIndex->remove(entry);
+    programIndex->push_front(entry);
+    if(programIndex->size() > maximumProgramIndexSize)
+        programIndex->pop_back();
+    writeProgramIndex();
+}
+
+int OpenCLDevice::prewarmProgramCache() {
+    std::list<std::pair<std::string, std::string>> entries;
+    {
+        std::lock_guard<std::mutex> lock(programIndexMutex);
+        loadProgramIndex();
+        entries = *programIndex;
+    }
+    const std::string kernelSourcePath = Config::getKernelSourcePath();
+    const bool cacheEnabled = Config::getKernelBinaryCacheMaximumSize() > 0;
+    std::set<std::pair<std::string, std::string>> staleEntries;
+    int created = 0;
+    for(auto&& entry : entries) {
+        const std::string filename = kernelSourcePath + entry.first;
+        const std::string& buildOptions = entry.second;
+        // Skip programs built for devices with different capabilities
+        const bool needs3DImageWrites = buildOptions.find("-Dfast_3d_image_writes") != std::string::npos;
+        if(needs3DImageWrites != isWritingTo3DTexturesSupported())
+            continue;
+        if(!fileExists(filename)) {
+            staleEntries.insert(entry);
+            continue;
+        }
+        // Same name as used by OpenCLProgram::build
+        const std::string programName = filename + buildOptions;
+        if(hasProgram(programName))
+            continue;
+        try {
+            // The binary is missing if it was pruned from the cache, or if the source has changed since it was built
+            const std::string sourceCode = readProgramSource(filename);
+            if(cacheEnabled && !fileExists(getProgramBinaryFilename({sourceCode}, buildOptions, getDirName(filename)))) {
+                staleEntries.insert(entry);
+                continue;
+            }
+            // Not added to the index again, as that would change the order of least recently used programs
+            const int id = createProgramFromSource(filename, buildOptions);
+            std::lock_guard<std::mutex> lock(buildBinaryMutex);
+            programNames[programName] = id;
+            ++created;
+        } catch(std::exception &e) {
+            reportWarning() << "Unable to pre-warm kernel " << entry.first << ": " << e.what() << reportEnd();
+        }
+    }
+    if(!staleEntries.empty()) {
+        std::lock_guard<std::mutex> lock(programIndexMutex);
+        programIndex->remove_if([&staleEntries](const std::pair<std::string, std::string>& entry) {
+            return staleEntries.count(entry) > 0;
+        });
+        writeProgramIndex();
+    }
+    reportInfo() << "Pre-warmed " << created << " OpenCL programs, removed " << staleEntries.size() << " stale programs from the index" << reportEnd();
+    return created;
 }
 
 int OpenCLDevice::createProgramFromSourceWithName(
         std::string programName,
         std::string filename,
         std::string buildOptions) {
-    programNames[programName] = createProgramFromSource(filename,buildOptions);
-    return programNames[programName];
+    const int id = createProgramFromSource(filename,buildOptions);
+    addToProgramIndex(filename, buildOptions);
+    std::lock_guard<std::mutex> lock(buildBinaryMutex);
+    programNames[programName] = id;
+    return id;
 }
 
 int OpenCLDevice::createProgramFromSourceWithName(
         std::string programName,
         std::vector<std::string> filenames,
         std::string buildOptions) {
-    programNames[programName] = createProgramFromSource(filenames,buildOptions);
-    return programNames[programName];
+    const int id = createProgramFromSource(filenames,buildOptions);
+    std::lock_guard<std::mutex> lock(buildBinaryMutex);
+    programNames[programName] = id;
+    return id;
 }
 
 int OpenCLDevice::createProgramFromStringWithName(
         std::string programName,
         std::string code,
         std::string buildOptions) {
-    programNames[programName] = createProgramFromString(code,buildOptions);
-    return programNames[programName];
+    const int id = createProgramFromString(code,buildOptions);
+    std::lock_guard<std::mutex> lock(buildBinaryMutex);
+    programNames[programName] = id;
+    return id;
 }
 
 cl::Program OpenCLDevice::getProgram(std::string name) {
@@ -466,7 +722,16 @@ cl::Program OpenCLDevice::getProgram(std::string name) {
     return programs[programNames[name]];
 }
 
+int OpenCLDevice::getNrOfProgramsBuiltFromSource() const {
+    return m_programsBuiltFromSource;
+}
+
+int OpenCLDevice::getNrOfProgramsLoadedFromCache() const {
+    return m_programsLoadedFromCache;
+}
+
 bool OpenCLDevice::hasProgram(std::string name) {
+    std::lock_guard<std::mutex> lock(buildBinaryMutex);
     return programNames.count(name) > 0;
 }
 
@@ -3,6 +3,8 @@
 
 #include "FAST/Object.hpp"
 #include "RuntimeMeasurementManager.hpp"
+#include "OpenCLMemoryPool.hpp"
+#include <atomic>
 
 namespace fast {
 
@@ -80,6 +82,14 @@ class FAST_EXPORT  OpenCLDevice : public ExecutionDevice {
         cl::Program getProgram(unsigned int i);
         cl::Program getProgram(std::string name);
         bool hasProgram(std::string name);
+        /**
+         * @return number of programs this device has compiled from source code
+         */
+        int getNrOfProgramsBuiltFromSource() const;
+        /**
+         * @return number of programs this device has loaded from binaries in the program cache
+         */
+        int getNrOfProgramsLoadedFromCache() const;
 
         bool isImageFormatSupported(cl_channel_order order, cl_channel_type type, cl_mem_object_type imageType);
 
@@ -98,14 +108,44 @@ class FAST_EXPORT  OpenCLDevice : public ExecutionDevice {
             return getDevice().getInfo<CL_DEVICE_NAME>();
         }
         bool isWritingTo3DTexturesSupported();
+        /**
+         * @return true if this is a CPU device. Host data can then be used directly by the device,
+         * without copying it to separate device memory.
+         */
+        bool isCPU();
         RuntimeMeasurementsManager::pointer getRunTimeMeasurementManager();
+        /**
+         * Get the pool of OpenCL images and buffers of this device, used to reuse memory objects across frames
+         * @return
+         */
+        OpenCLMemoryPool::pointer getMemoryPool();
+        /**
+         * Load all programs created with a name (e.g. by process objects) in earlier runs from the program cache.
+         * Call this at startup to avoid building kernels the first time each process object is executed.
+         * The index of these programs keeps the most recently used programs only. Programs whose binary has been
+         * pruned from the cache, or whose source has changed, are removed from the index.
+         * @return number of programs loaded
+         */
+        int prewarmProgramCache();
         ~OpenCLDevice();
     private:
         OpenCLDevice();
         unsigned long * mGLContext;
-        cl::Program writeBinary(std::string filename, std::string buildOptions);
+        /**
+         * Build a program, using the binary in the program cache if it exists. Binaries are stored in the cache
+         * with a key given by the source code, included files, build options, device and driver.
+         */
+        cl::Program buildProgram(const std::vector<std::string>& sourceCodes, std::string buildOptions, std::string sourceDirectory = "");
+        std::string getProgramCacheKey(const std::vector<std::string>& sourceCodes, std::string buildOptions, std::string sourceDirectory);
+        std::string getProgramBinaryFilename(const std::vector<std::string>& sourceCodes, std::string buildOptions, std::string sourceDirectory);
+        std::string readProgramSource(std::string filename);
+        void writeBinary(cl::Program program, std::string binaryFilename);
         cl::Program readBinary(std::string filename);
-        cl::Program buildProgramFromBinary(std::string filename, std::string buildOptions);
+        /**
+         * Delete the least recently used binaries until the program cache is within its maximum size
+         * @return total size of the remaining binaries
+         */
+        std::size_t pruneProgramCache();
         cl::Program buildSources(cl::Program::Sources source, std::string buildOptions);
 
         cl::Context context;
@@ -116,7 +156,11 @@ class FAST_EXPORT  OpenCLDevice : public ExecutionDevice {
         cl::Platform platform;
 
         bool profilingEnabled;
+        bool m_isCPU;
+        std::atomic<int> m_programsBuiltFromSource{0};
+        std::atomic<int> m_programsLoadedFromCache{0};
         RuntimeMeasurementsManager::pointer runtimeManager;
+        OpenCLMemoryPool::pointer m_memoryPool;
 
 };
 
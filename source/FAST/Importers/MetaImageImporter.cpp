@@ -39,8 +39,8 @@ std::vector<std::string> stringSplit(std::string str, std::string delimiter) {
 }
 
 template <class T>
-static std::unique_ptr<T[]> readRawData(std::string rawFilename, std::size_t voxels, unsigned int nrOfComponents, bool compressed, std::size_t compressedFileSize) {
-    auto data = make_uninitialized_unique<T[]>(voxels*nrOfComponents);
+static unique_pixel_ptr readRawData(std::string rawFilename, std::size_t voxels, unsigned int nrOfComponents, bool compressed, std::size_t compressedFileSize) {
+    auto data = PixelBufferPool::getInstance()->allocate(voxels*nrOfComponents*sizeof(T));
     if(compressed) {
         // Read compressed data
         std::ifstream file(rawFilename, std::ifstream::binary | std::ifstream::in);
@@ -347,30 +347,30 @@ void MetaImageImporter::execute() {
     if(size.size() == 3)
         voxels *= size.z();
     if(typeName == "MET_SHORT" || typeName == "MET_INT") {
-        std::unique_ptr<short[]> data;
+        unique_pixel_ptr data;
         if(typeName == "MET_SHORT") {
-            data = std::move(readRawData<short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize));
+            data = readRawData<short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
         } else {
             reportWarning() << "Converting original dataset of type MET_INT (32 bit) to short (16 bit) overflow may occur." << reportEnd();
             auto tmp = readRawData<int>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
-            auto tmp2 = make_uninitialized_unique<short[]>(voxels*nrOfComponents);
+            auto tmp2 = allocatePixelArray(voxels*nrOfComponents, TYPE_INT16);
             for(int i = 0; i < voxels*nrOfComponents; ++i)
-                tmp2[i] = (short)tmp[i];
+                ((short*)tmp2.get())[i] = (short)((int*)tmp.get())[i];
 
             data = std::move(tmp2);
         }
         output->create(size,TYPE_INT16,nrOfComponents,getMainDevice(),std::move(data));
 
     } else if(typeName == "MET_USHORT" || typeName == "MET_UINT") {
-        std::unique_ptr<ushort[]> data;
+        unique_pixel_ptr data;
         if(typeName == "MET_USHORT") {
-            data = std::move(readRawData<unsigned short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize));
+            data = readRawData<unsigned short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
         } else {
             reportWarning() << "Converting original dataset of type MET_UINT (32 bit) to unsigned short (16 bit) overflow may occur." << reportEnd();
             auto tmp = readRawData<unsigned int>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
-            auto tmp2 = make_uninitialized_unique<ushort[]>(voxels*nrOfComponents);
+            auto tmp2 = allocatePixelArray(voxels*nrOfComponents, TYPE_UINT16);
             for(int i = 0; i < voxels*nrOfComponents; ++i)
-                tmp2[i] = (unsigned short)tmp[i];
+                ((ushort*)tmp2.get())[i] = (unsigned short)((unsigned int*)tmp.get())[i];
 
             data = std::move(tmp2);
         }
@@ -60,7 +60,7 @@ void WholeSlideImageImporter::execute() {
             break;
         }
     }
-    image->create(file, levelList);
+    image->create(file, levelList, mFilename);
 }
 
 WholeSlideImageImporter::WholeSlideImageImporter() {
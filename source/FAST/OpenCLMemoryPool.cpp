@@ -0,0 +1,224 @@
+#include "OpenCLMemoryPool.hpp"
+#include <algorithm>
+
+namespace fast {
+
+bool OpenCLMemoryPool::Key::operator==(const Key& other) const {
+    return type == other.type && flags == other.flags && order == other.order && channelType == other.channelType &&
+        width == other.width && height == other.height && depth == other.depth;
+}
+
+// Errors which may be caused by other memory objects using the device memory
+static bool isOutOfMemory(const cl::Error& error) {
+    return error.err() == CL_MEM_OBJECT_ALLOCATION_FAILURE || error.err() == CL_OUT_OF_RESOURCES;
+}
+
+OpenCLMemoryPool::OpenCLMemoryPool(cl::Context context) {
+    m_context = context;
+}
+
+OpenCLMemoryPool::~OpenCLMemoryPool() {
+    clear();
+    // Objects still leased are owned by data objects which outlived the device, they are not released here
+}
+
+cl::Memory* OpenCLMemoryPool::lease(const Key& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_enabled) {
+        for(auto it = m_free.begin(); it != m_free.end(); ++it) {
+            if(it->key == key) {
+                Entry entry = *it;
+                m_free.erase(it);
+                m_statistics.hits++;
+                m_statistics.residentBytes -= entry.bytes;
+                m_statistics.leasedBytes += entry.bytes;
+                m_leased[entry.object] = entry;
+                return entry.object;
+            }
+        }
+    }
+    m_statistics.misses++;
+    return nullptr;
+}
+
+cl::Image* OpenCLMemoryPool::leaseImage(cl_mem_flags flags, cl::ImageFormat format, uint width, uint height, uint depth) {
+    Key key;
+    key.type = depth > 0 ? CL_MEM_OBJECT_IMAGE3D : CL_MEM_OBJECT_IMAGE2D;
+    key.flags = flags;
+    key.order = format.image_channel_order;
+    key.channelType = format.image_channel_data_type;
+    key.width = width;
+    key.height = height;
+    key.depth = depth;
+    cl::Memory* object = lease(key);
+    if(object != nullptr)
+        return (cl::Image*)object;
+
+    auto create = [&]() -> cl::Image* {
+        if(key.type == CL_MEM_OBJECT_IMAGE2D) {
+            return new cl::Image2D(m_context, flags, format, width, height);
+        } else {
+            return new cl::Image3D(m_context, flags, format, width, height, depth);
+        }
+    };
+    cl::Image* image;
+    try {
+        image = create();
+    } catch(cl::Error &e) {
+        if(!isOutOfMemory(e))
+            throw;
+        // Release all pooled objects and try again
+        clear();
+        image = create();
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.bytes = width*height*std::max<uint>(depth, 1)*image->getImageInfo<CL_IMAGE_ELEMENT_SIZE>();
+    entry.object = image;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statistics.leasedBytes += entry.bytes;
+    m_leased[image] = entry;
+    return image;
+}
+
+cl::Buffer* OpenCLMemoryPool::leaseBuffer(cl_mem_flags flags, std::size_t size) {
+    Key key;
+    key.type = CL_MEM_OBJECT_BUFFER;
+    key.flags = flags;
+    key.order = 0;
+    key.channelType = 0;
+    key.width = size;
+    key.height = 1;
+    key.depth = 0;
+    cl::Memory* object = lease(key);
+    if(object != nullptr)
+        return (cl::Buffer*)object;
+
+    cl::Buffer* buffer;
+    try {
+        buffer = new cl::Buffer(m_context, flags, size);
+    } catch(cl::Error &e) {
+        if(!isOutOfMemory(e))
+            throw;
+        clear();
+        buffer = new cl::Buffer(m_context, flags, size);
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.bytes = size;
+    entry.object = buffer;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statistics.leasedBytes += entry.bytes;
+    m_leased[buffer] = entry;
+    return buffer;
+}
+
+void OpenCLMemoryPool::give(cl::Memory* object) {
+    if(object == nullptr)
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_leased.find(object);
+    if(it == m_leased.end()) {
+        // Called from destructors, thus don't throw. The caller gave up ownership, thus release it.
+        reportWarning() << "Memory object returned to OpenCLMemoryPool was not leased from this pool" << reportEnd();
+        Entry entry;
+        entry.key.type = object->getInfo<CL_MEM_TYPE>();
+        entry.object = object;
+        release(entry);
+        return;
+    }
+    Entry entry = it->second;
+    m_leased.erase(it);
+    m_statistics.leasedBytes -= entry.bytes;
+    if(!m_enabled || entry.bytes > m_maximumResidentBytes) {
+        m_statistics.evicted++;
+        release(entry);
+        return;
+    }
+    m_free.push_front(entry);
+    m_statistics.residentBytes += entry.bytes;
+    evict(m_maximumResidentBytes);
+}
+
+void OpenCLMemoryPool::returnImage(cl::Image* image) {
+    give(image);
+}
+
+void OpenCLMemoryPool::returnBuffer(cl::Buffer* buffer) {
+    give(buffer);
+}
+
+void OpenCLMemoryPool::release(Entry& entry) {
+    // Delete through the derived type, as cl::Memory has no virtual destructor
+    switch(entry.key.type) {
+        case CL_MEM_OBJECT_IMAGE2D:
+            delete (cl::Image2D*)entry.object;
+            break;
+        case CL_MEM_OBJECT_IMAGE3D:
+            delete (cl::Image3D*)entry.object;
+            break;
+        default:
+            delete (cl::Buffer*)entry.object;
+    }
+    entry.object = nullptr;
+}
+
+void OpenCLMemoryPool::evict(std::size_t maximumResidentBytes) {
+    // Release least recently returned objects first. m_mutex must be locked.
+    while(m_statistics.residentBytes > maximumResidentBytes && !m_free.empty()) {
+        Entry& entry = m_free.back();
+        m_statistics.residentBytes -= entry.bytes;
+        m_statistics.evicted++;
+        release(entry);
+        m_free.pop_back();
+    }
+}
+
+void OpenCLMemoryPool::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto&& entry : m_free)
+        release(entry);
+    m_free.clear();
+    m_statistics.residentBytes = 0;
+}
+
+void OpenCLMemoryPool::setMaximumResidentBytes(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maximumResidentBytes = bytes;
+    evict(bytes);
+}
+
+std::size_t OpenCLMemoryPool::getMaximumResidentBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maximumResidentBytes;
+}
+
+void OpenCLMemoryPool::setEnabled(bool enabled) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_enabled = enabled;
+    }
+    if(!enabled)
+        clear();
+}
+
+bool OpenCLMemoryPool::isEnabled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_enabled;
+}
+
+OpenCLMemoryPoolStatistics OpenCLMemoryPool::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+void OpenCLMemoryPool::resetStatistics() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statistics.hits = 0;
+    m_statistics.misses = 0;
+    m_statistics.evicted = 0;
+}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include "CL/OpenCL.hpp"
+#include <mutex>
+#include <list>
+#include <unordered_map>
+
+namespace fast {
+
+struct FAST_EXPORT OpenCLMemoryPoolStatistics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Memory objects released because the pool exceeded its maximum size
+    uint64_t evicted = 0;
+    // Bytes of memory objects stored in the pool, ready to be reused
+    std::size_t residentBytes = 0;
+    // Bytes of memory objects currently leased from the pool
+    std::size_t leasedBytes = 0;
+    float getHitRate() const {
+        return hits + misses == 0 ? 0.0f : (float)hits / (hits + misses);
+    };
+};
+
+/**
+ * A pool of OpenCL images and buffers which are reused across frames.
+ *
+ * Every OpenCLDevice has its own pool, see OpenCLDevice::getMemoryPool.
+ * Images and tensors lease their OpenCL memory objects from the pool of the device, and return them
+ * when the data on that device is freed. A later lease with the same flags, format and size
+ * will then get the same memory object instead of a new device allocation.
+ *
+ * When the returned memory objects exceed the maximum resident size of the pool,
+ * the least recently returned objects are released.
+ */
+class FAST_EXPORT OpenCLMemoryPool : public Object {
+    public:
+        typedef SharedPointer<OpenCLMemoryPool> pointer;
+        explicit OpenCLMemoryPool(cl::Context context);
+        /**
+         * Get a 2D image, or a 3D image if depth is larger than 0.
+         * The contents of the image are undefined.
+         * The object is of type cl::Image2D or cl::Image3D, and must be returned with returnImage.
+         *
+         * @param flags
+         * @param format
+         * @param width
+         * @param height
+         * @param depth
+         * @return
+         */
+        cl::Image* leaseImage(cl_mem_flags flags, cl::ImageFormat format, uint width, uint height, uint depth = 0);
+        /**
+         * Get a buffer of the given size. The contents of the buffer are undefined.
+         * The buffer must be returned with returnBuffer.
+         * @param flags
+         * @param size in bytes
+         * @return
+         */
+        cl::Buffer* leaseBuffer(cl_mem_flags flags, std::size_t size);
+        /**
+         * Return an image leased from this pool. The image may be reused by later leases.
+         * Images not leased from this pool are released.
+         * @param image
+         */
+        void returnImage(cl::Image* image);
+        /**
+         * Return a buffer leased from this pool. The buffer may be reused by later leases.
+         * Buffers not leased from this pool are released.
+         * @param buffer
+         */
+        void returnBuffer(cl::Buffer* buffer);
+        /**
+         * Set maximum number of bytes of memory objects the pool can store for reuse.
+         * Least recently returned objects are released to stay below this size.
+         * @param bytes
+         */
+        void setMaximumResidentBytes(std::size_t bytes);
+        std::size_t getMaximumResidentBytes() const;
+        /**
+         * Disable to always create and release memory objects directly. Enabled by default.
+         * @param enabled
+         */
+        void setEnabled(bool enabled);
+        bool isEnabled() const;
+        /**
+         * Release all memory objects stored in the pool
+         */
+        void clear();
+        OpenCLMemoryPoolStatistics getStatistics() const;
+        void resetStatistics();
+        ~OpenCLMemoryPool();
+    private:
+        struct Key {
+            cl_mem_object_type type;
+            cl_mem_flags flags;
+            cl_channel_order order;
+            cl_channel_type channelType;
+            std::size_t width;
+            std::size_t height;
+            std::size_t depth;
+            bool operator==(const Key& other) const;
+        };
+        struct Entry {
+            Key key;
+            std::size_t bytes;
+            cl::Memory* object;
+        };
+        cl::Memory* lease(const Key& key);
+        void give(cl::Memory* object);
+        void evict(std::size_t maximumResidentBytes);
+        void release(Entry& entry);
+
+        cl::Context m_context;
+        mutable std::mutex m_mutex;
+        // Memory objects ready for reuse. Most recently returned objects are at the front.
+        std::list<Entry> m_free;
+        // Memory objects currently leased
+        std::unordered_map<cl::Memory*, Entry> m_leased;
+        std::size_t m_maximumResidentBytes = 256*1024*1024;
+        bool m_enabled = true;
+        OpenCLMemoryPoolStatistics m_statistics;
+};
+
+}
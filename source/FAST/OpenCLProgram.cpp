@@ -1,5 +1,6 @@
 #include "OpenCLProgram.hpp"
 #include "ExecutionDevice.hpp"
+#include <algorithm>
 
 namespace fast {
 
@@ -19,6 +20,15 @@ std::string OpenCLProgram::getSourceFilename() const {
     return mSourceFilename;
 }
 
+void OpenCLProgram::addPrecompileBuildOptions(std::string buildOptions) {
+    if(std::find(mPrecompileBuildOptions.begin(), mPrecompileBuildOptions.end(), buildOptions) == mPrecompileBuildOptions.end())
+        mPrecompileBuildOptions.push_back(buildOptions);
+}
+
+std::vector<std::string> OpenCLProgram::getPrecompileBuildOptions() const {
+    return mPrecompileBuildOptions;
+}
+
 cl::Program OpenCLProgram::build(SharedPointer<OpenCLDevice> device,
         std::string buildOptions) {
     if(mSourceFilename == "")
@@ -3,6 +3,7 @@
 
 #include "Object.hpp"
 #include <unordered_map>
+#include <vector>
 
 namespace cl {
 
@@ -21,6 +22,13 @@ class FAST_EXPORT  OpenCLProgram : public Object {
         std::string getName() const;
         void setSourceFilename(std::string filename);
         std::string getSourceFilename() const;
+        /**
+         * Declare a set of build options this program will be built with, so that it can be built in advance
+         * by precompileOpenCLPrograms.
+         * @param buildOptions
+         */
+        void addPrecompileBuildOptions(std::string buildOptions);
+        std::vector<std::string> getPrecompileBuildOptions() const;
         cl::Program build(SharedPointer<OpenCLDevice>, std::string buildOptions = "");
     protected:
         OpenCLProgram();
@@ -29,6 +37,7 @@ class FAST_EXPORT  OpenCLProgram : public Object {
 
         std::string mName;
         std::string mSourceFilename;
+        std::vector<std::string> mPrecompileBuildOptions;
         std::unordered_map<SharedPointer<OpenCLDevice>, std::map<std::string, cl::Program> > mOpenCLPrograms;
 };
 
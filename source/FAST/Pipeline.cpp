@@ -251,6 +251,12 @@ void Pipeline::parsePipelineFile(std::unordered_map<std::string, SharedPointer<P
             lineNr--;
         }
     }
+
+    // Build all OpenCL programs of the pipeline concurrently, instead of one by one as each process object is executed
+    std::vector<SharedPointer<ProcessObject>> allProcessObjects;
+    for(auto&& processObject : mProcessObjects)
+        allProcessObjects.push_back(processObject.second);
+    precompileOpenCLPrograms(allProcessObjects);
 }
 
 std::vector<View*> Pipeline::getViews() {
@@ -22,7 +22,7 @@ class FAST_EXPORT  Pipeline : public Object {
         std::string getDescription() const;
         std::string getFilename() const;
         /**
-         * Parse the pipeline file
+         * Parse the pipeline file, and build the OpenCL programs of all process objects concurrently
          */
         void parsePipelineFile(std::unordered_map<std::string, SharedPointer<ProcessObject>> processObjects = {});
 
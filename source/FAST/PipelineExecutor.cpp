@@ -0,0 +1,182 @@
+#include "PipelineExecutor.hpp"
+#include <FAST/Streamers/Streamer.hpp>
+#include <FAST/DataChannels/QueuedDataChannel.hpp>
+#include <FAST/DataChannels/RingBufferDataChannel.hpp>
+
+namespace fast {
+
+PipelineExecutor::PipelineExecutor() {
+    m_running = false;
+    m_stop = false;
+}
+
+PipelineExecutor::~PipelineExecutor() {
+    if(m_running)
+        stop();
+}
+
+void PipelineExecutor::addProcessObject(SharedPointer<ProcessObject> po) {
+    if(m_running)
+        throw Exception("Process objects can't be added to the pipeline executor while it is running");
+    m_processObjects.push_back(po);
+}
+
+void PipelineExecutor::setMaximumNumberOfThreads(uint threads) {
+    m_maximumNumberOfThreads = threads;
+}
+
+void PipelineExecutor::setQueueSize(uint frames) {
+    if(frames == 0)
+        throw Exception("Queue size of pipeline executor must be larger than 0");
+    m_queueSize = frames;
+}
+
+bool PipelineExecutor::isRunning() const {
+    return m_running;
+}
+
+std::vector<SharedPointer<ProcessObject>> PipelineExecutor::getStages() const {
+    return m_stages;
+}
+
+void PipelineExecutor::visit(SharedPointer<ProcessObject> po, std::unordered_set<ProcessObject*>& visited) {
+    if(visited.count(po.get()) > 0)
+        return;
+    visited.insert(po.get());
+
+    // Depth first: parents are added to the graph before their children
+    bool streaming = std::dynamic_pointer_cast<Streamer>(po) != nullptr;
+    for(auto&& input : po->mInputConnections) {
+        auto parent = input.second->getProcessObject();
+        visit(parent, visited);
+        if(m_streaming.count(parent.get()) > 0)
+            streaming = true;
+    }
+    m_graph.push_back(po);
+    if(streaming) {
+        m_streaming.insert(po.get());
+        if(std::dynamic_pointer_cast<Streamer>(po) == nullptr)
+            m_stages.push_back(po);
+    }
+}
+
+void PipelineExecutor::buildGraph() {
+    m_graph.clear();
+    m_stages.clear();
+    m_streaming.clear();
+    std::unordered_set<ProcessObject*> visited;
+    for(auto&& po : m_processObjects)
+        visit(po, visited);
+}
+
+void PipelineExecutor::replaceInputChannel(SharedPointer<ProcessObject> consumer, uint portID) {
+    auto oldChannel = consumer->mInputConnections.at(portID);
+    auto producer = oldChannel->getProcessObject();
+    for(auto&& output : producer->mOutputConnections) {
+        for(auto&& connection : output.second) {
+            if(connection.lock() != oldChannel)
+                continue;
+            DataChannel::pointer channel;
+            if(Config::getLockFreeDataChannels()) {
+                channel = RingBufferDataChannel::New();
+            } else {
+                channel = QueuedDataChannel::New();
+            }
+            channel->setMaximumNumberOfFrames(m_queueSize);
+            channel->setProcessObject(producer);
+            connection = channel;
+            consumer->mInputConnections[portID] = channel;
+            return;
+        }
+    }
+    throw Exception("Unable to find the output connection of " + producer->getNameOfClass() +
+        " connected to " + consumer->getNameOfClass() + " in PipelineExecutor");
+}
+
+void PipelineExecutor::start() {
+    if(m_running)
+        throw Exception("Pipeline executor is already running");
+    m_stop = false;
+    buildGraph();
+    if(m_stages.empty())
+        reportWarning() << "No process objects depending on a streamer was found, pipeline executor will only execute once" << reportEnd();
+
+    // Execute process objects which does not depend on a streamer, and start all streamers
+    for(auto&& po : m_graph) {
+        if(std::find(m_stages.begin(), m_stages.end(), po) == m_stages.end())
+            po->update();
+    }
+
+    // Use bounded queues between all stages
+    for(auto&& stage : m_stages) {
+        for(auto&& input : stage->mInputConnections) {
+            auto parent = input.second->getProcessObject();
+            if(std::find(m_stages.begin(), m_stages.end(), parent) != m_stages.end())
+                replaceInputChannel(stage, input.first);
+        }
+        stage->mIsModified = false;
+        stage->m_executorManaged = true;
+    }
+
+    // Group consecutive stages if there are more stages than threads.
+    // Since the stages are in topological order, data will only flow from a group to itself or a later group.
+    const int stages = m_stages.size();
+    int threads = m_maximumNumberOfThreads == 0 ? stages : std::min<int>(m_maximumNumberOfThreads, stages);
+    m_running = true;
+    for(int i = 0; i < threads; ++i) {
+        std::vector<SharedPointer<ProcessObject>> group(
+                m_stages.begin() + (i*stages)/threads,
+                m_stages.begin() + ((i+1)*stages)/threads
+        );
+        m_workers.push_back(std::thread(std::bind(&PipelineExecutor::runWorker, this, group)));
+    }
+    reportInfo() << "Pipeline executor started " << threads << " worker threads for " << stages << " stages" << reportEnd();
+}
+
+void PipelineExecutor::runWorker(std::vector<SharedPointer<ProcessObject>> group) {
+    while(!m_stop) {
+        try {
+            for(auto&& po : group) {
+                po->mRuntimeManager->startRegularTimer("execute");
+                po->preExecute();
+                po->execute();
+                po->postExecute();
+                if(po->mRuntimeManager->isEnabled())
+                    po->waitToFinish();
+                po->mRuntimeManager->stopRegularTimer("execute");
+            }
+        } catch(ThreadStopped &e) {
+            break;
+        } catch(Exception &e) {
+            stopAfterError(e.what());
+            break;
+        } catch(std::exception &e) {
+            stopAfterError(e.what());
+            break;
+        }
+    }
+}
+
+void PipelineExecutor::stopAfterError(std::string message) {
+    reportError() << "Error in pipeline executor worker: " << message << reportEnd();
+    // Stop all other workers as well, as they may be waiting for data from this one
+    m_stop = true;
+    for(auto&& po : m_processObjects)
+        po->stopPipeline();
+}
+
+void PipelineExecutor::stop() {
+    m_stop = true;
+    // Stopping the data channels will unblock any worker waiting for data or space in a queue
+    for(auto&& po : m_processObjects)
+        po->stopPipeline();
+    for(auto&& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+    for(auto&& stage : m_stages)
+        stage->m_executorManaged = false;
+    m_running = false;
+    reportInfo() << "Pipeline executor stopped" << reportEnd();
+}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <FAST/ProcessObject.hpp>
+#include <thread>
+#include <atomic>
+
+namespace fast {
+
+/**
+ * Executes a streaming pipeline by running its process objects concurrently.
+ *
+ * The default way of executing a pipeline is to call update() on the last process object, which
+ * recursively updates all parents serially on the calling thread. The pipeline executor instead
+ * builds the graph of process objects from the input connections of the added process objects,
+ * and gives each stage which depends on a streamer its own worker thread. The data channels between
+ * these stages are replaced with bounded queues, which are used as the hand-off points between the workers.
+ * Thus, while a stage processes frame N, its parent stage can process frame N+1.
+ *
+ * Process objects which do not depend on any streamer are executed once, on the calling thread, in start().
+ * Process objects managed by the executor will ignore calls to update() until the executor is stopped.
+ */
+class FAST_EXPORT PipelineExecutor : public Object {
+    FAST_OBJECT(PipelineExecutor)
+    public:
+        /**
+         * Add a process object to execute. All of its parents are added as well.
+         * Typically, this is the last process object of a pipeline, or the input of a renderer.
+         * @param po
+         */
+        void addProcessObject(SharedPointer<ProcessObject> po);
+        /**
+         * Set the maximum number of worker threads to use. If there are more stages than threads,
+         * consecutive stages are grouped and executed in sequence on the same worker.
+         * @param threads 0 means one worker thread per stage (default)
+         */
+        void setMaximumNumberOfThreads(uint threads);
+        /**
+         * Set the number of frames which can be queued between two stages
+         * @param frames
+         */
+        void setQueueSize(uint frames);
+        /**
+         * Build the graph, execute static process objects and start the worker threads.
+         */
+        void start();
+        /**
+         * Stop the pipeline and wait for all worker threads to finish.
+         */
+        void stop();
+        bool isRunning() const;
+        /**
+         * @return the process objects executed by worker threads, in topological order
+         */
+        std::vector<SharedPointer<ProcessObject>> getStages() const;
+        ~PipelineExecutor();
+    private:
+        PipelineExecutor();
+        void buildGraph();
+        void visit(SharedPointer<ProcessObject> po, std::unordered_set<ProcessObject*>& visited);
+        void replaceInputChannel(SharedPointer<ProcessObject> consumer, uint portID);
+        void runWorker(std::vector<SharedPointer<ProcessObject>> group);
+        void stopAfterError(std::string message);
+
+        std::vector<SharedPointer<ProcessObject>> m_processObjects;
+        // All process objects of the graph, in topological order
+        std::vector<SharedPointer<ProcessObject>> m_graph;
+        std::vector<SharedPointer<ProcessObject>> m_stages;
+        std::unordered_set<ProcessObject*> m_streaming;
+        std::vector<std::thread> m_workers;
+        uint m_maximumNumberOfThreads = 0;
+        uint m_queueSize = 4;
+        std::atomic_bool m_running;
+        std::atomic_bool m_stop;
+};
+
+}
@@ -3,7 +3,13 @@
 #include "FAST/OpenCLProgram.hpp"
 #include "FAST/Streamers/Streamer.hpp"
 #include <unordered_set>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+#include <tuple>
 #include <FAST/DataChannels/QueuedDataChannel.hpp>
+#include <FAST/DataChannels/RingBufferDataChannel.hpp>
 #include <FAST/DataChannels/NewestFrameDataChannel.hpp>
 #include <FAST/DataChannels/StaticDataChannel.hpp>
 
@@ -25,6 +31,10 @@ static bool isStreamer(ProcessObject* po) {
 }
 
 void ProcessObject::update(int executeToken) {
+    // A pipeline executor is running this PO in a separate thread
+    if(m_executorManaged)
+        return;
+
     // Call update on all parents
     bool newInputData = false;
     for(auto parent : mInputConnections) {
@@ -124,7 +134,11 @@ DataChannel::pointer ProcessObject::getOutputPort(uint portID) {
     if(isStreamer(this)) {
         auto streamingMode = Config::getStreamingMode();
         if(streamingMode == STREAMING_MODE_PROCESS_ALL_FRAMES) {
-            dataChannel = QueuedDataChannel::New();
+            if(Config::getLockFreeDataChannels()) {
+                dataChannel = RingBufferDataChannel::New();
+            } else {
+                dataChannel = QueuedDataChannel::New();
+            }
         } else if(streamingMode == STREAMING_MODE_NEWEST_FRAME_ONLY) {
             dataChannel = NewestFrameDataChannel::New();
         } else {
@@ -165,8 +179,7 @@ void ProcessObject::addOutputData(uint portID, DataObject::pointer data) {
     // Copy frame data from input data
     for(auto&& lastFrame : m_lastFrame)
         data->setLastFrame(lastFrame);
-    for(auto&& frameData : m_frameData)
-        data->setFrameData(frameData.first, frameData.second);
+    data->setFrameData(m_frameData);
 
     // Add it to all output connections, if any connections exist
     if(mOutputConnections.count(portID) > 0) {
@@ -323,6 +336,12 @@ void ProcessObject::createOpenCLProgram(std::string sourceFilename, std::string
     mOpenCLPrograms[name] = program;
 }
 
+void ProcessObject::declareOpenCLProgramBuildOptions(std::string name, std::string buildOptions) {
+    if(mOpenCLPrograms.count(name) == 0)
+        throw Exception("OpenCL program with the name " + name + " not found in " + getNameOfClass());
+    mOpenCLPrograms[name]->addPrecompileBuildOptions(buildOptions);
+}
+
 cl::Program ProcessObject::getOpenCLProgram(
         OpenCLDevice::pointer device,
         std::string name,
@@ -337,6 +356,74 @@ cl::Program ProcessObject::getOpenCLProgram(
     return program->build(device, buildOptions);
 }
 
+std::vector<OpenCLProgram::pointer> ProcessObject::getOpenCLPrograms() const {
+    std::vector<OpenCLProgram::pointer> programs;
+    for(auto&& program : mOpenCLPrograms)
+        programs.push_back(program.second);
+    return programs;
+}
+
+void ProcessObject::precompileOpenCLPrograms(int threads) {
+    fast::precompileOpenCLPrograms({std::static_pointer_cast<ProcessObject>(mPtr.lock())}, threads);
+}
+
+void precompileOpenCLPrograms(std::vector<ProcessObject::pointer> processObjects, int threads) {
+    struct BuildJob {
+        std::string processObjectName;
+        OpenCLProgram::pointer program;
+        OpenCLDevice::pointer device;
+        std::string buildOptions;
+    };
+    std::vector<BuildJob> jobs;
+    std::set<std::tuple<std::string, OpenCLDevice::pointer, std::string>> added;
+    for(auto&& processObject : processObjects) {
+        auto device = std::dynamic_pointer_cast<OpenCLDevice>(processObject->getMainDevice());
+        if(!device)
+            continue;
+        for(auto&& program : processObject->getOpenCLPrograms()) {
+            const std::string filename = program->getSourceFilename();
+            // Programs without declared build options may need defines only known at execution
+            for(auto&& buildOptions : program->getPrecompileBuildOptions()) {
+                // Same program may be used by several process objects
+                if(added.insert(std::make_tuple(filename, device, buildOptions)).second)
+                    jobs.push_back({processObject->getNameOfClass(), program, device, buildOptions});
+            }
+        }
+    }
+    if(jobs.empty())
+        return;
+
+    if(threads <= 0)
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    threads = std::min(threads, (int)jobs.size());
+    Reporter::info() << "Building " << jobs.size() << " OpenCL programs using " << threads << " threads" << Reporter::end();
+    const auto start = std::chrono::high_resolution_clock::now();
+    std::atomic_int nextJob(0);
+    std::vector<std::thread> workers;
+    for(int i = 0; i < threads; ++i) {
+        workers.push_back(std::thread([&jobs, &nextJob]() {
+            int jobNr;
+            while((jobNr = nextJob++) < jobs.size()) {
+                auto& job = jobs[jobNr];
+                const auto jobStart = std::chrono::high_resolution_clock::now();
+                try {
+                    job.program->build(job.device, job.buildOptions);
+                    const std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - jobStart;
+                    Reporter::info() << "Built OpenCL program " << job.program->getSourceFilename() << " " << job.buildOptions
+                        << " for " << job.processObjectName << " in " << time.count() << " ms" << Reporter::end();
+                } catch(std::exception &e) {
+                    Reporter::info() << "OpenCL program " << job.program->getSourceFilename() << " of " << job.processObjectName
+                        << " could not be built in advance, it will be built when executed" << Reporter::end();
+                }
+            }
+        }));
+    }
+    for(auto&& worker : workers)
+        worker.join();
+    const std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - start;
+    Reporter::info() << "Finished building OpenCL programs in " << time.count() << " ms" << Reporter::end();
+}
+
 ProcessObject::~ProcessObject() {
 }
 
@@ -18,6 +18,7 @@ namespace fast {
 
 class OpenCLProgram;
 class ProcessObject;
+class PipelineExecutor;
 
 class FAST_EXPORT  ProcessObject : public Object {
     public:
@@ -76,7 +77,20 @@ class FAST_EXPORT  ProcessObject : public Object {
         template <class DataType>
         SharedPointer<DataType> updateAndGetOutputData(uint portID = 0);
 
+        /**
+         * Build all OpenCL programs created by this process object with createOpenCLProgram on the main device,
+         * with the build options declared with declareOpenCLProgramBuildOptions. Programs without declared build options,
+         * and programs which are built with other build options, are built the first time they are used in execute.
+         * @param threads number of programs to build concurrently, 0 uses the number of hardware threads
+         */
+        void precompileOpenCLPrograms(int threads = 0);
+        /**
+         * Get all OpenCL programs created by this process object with createOpenCLProgram
+         */
+        std::vector<SharedPointer<OpenCLProgram>> getOpenCLPrograms() const;
+
     protected:
+        friend class PipelineExecutor;
         ProcessObject();
         // Flag to indicate whether the object has been modified
         // and should be executed again
@@ -85,6 +99,9 @@ class FAST_EXPORT  ProcessObject : public Object {
         // An integer id which act as a token of when this PO last executed
         int m_lastExecuteToken = -1;
 
+        // Set when this PO is executed by a worker thread of a PipelineExecutor, update() is then ignored
+        bool m_executorManaged = false;
+
         // Pure virtual method for executing the pipeline object
         virtual void execute()=0;
         virtual void preExecute();
@@ -109,6 +126,12 @@ class FAST_EXPORT  ProcessObject : public Object {
         RuntimeMeasurementsManager::pointer mRuntimeManager;
 
         void createOpenCLProgram(std::string sourceFilename, std::string name = "");
+        /**
+         * Declare that the program with the given name is built with these build options in execute, so that
+         * precompileOpenCLPrograms can build it in advance. Build options only known at execution, e.g. defines
+         * depending on the input data type, should not be declared.
+         */
+        void declareOpenCLProgramBuildOptions(std::string name = "", std::string buildOptions = "");
         cl::Program getOpenCLProgram(
                 SharedPointer<OpenCLDevice> device,
                 std::string name = "",
@@ -154,13 +177,22 @@ class FAST_EXPORT  ProcessObject : public Object {
 
         // Frame data
         // Similar to metadata, only this is transferred from input to output
-        std::unordered_map<std::string, std::string> m_frameData;
+        FrameData m_frameData;
         // Indicates whether this data object is the last frame in a stream, and if so, the name of the stream
         std::unordered_set<std::string> m_lastFrame;
 
 
 };
 
+/**
+ * Build the OpenCL programs of several process objects concurrently using a pool of threads, e.g. before streaming starts,
+ * so that the first frame does not have to wait for every program to be built in sequence.
+ * Only the build options declared by each process object are built, other programs are built on first use.
+ * @param processObjects
+ * @param threads number of programs to build concurrently, 0 uses the number of hardware threads
+ */
+FAST_EXPORT void precompileOpenCLPrograms(std::vector<SharedPointer<ProcessObject>> processObjects, int threads = 0);
+
 
 template<class DataType>
 void ProcessObject::createInputPort(uint portID, bool required) {
@@ -187,8 +219,7 @@ SharedPointer<DataType> ProcessObject::getInputData(uint portID) {
     // Store frame data for this input data so it can be added to output data later
     for(auto&& lastFrame : data->getLastFrame())
         m_lastFrame.insert(lastFrame);
-    for(auto&& frameData : data->getFrameData())
-        m_frameData[frameData.first] = frameData.second;
+    m_frameData.merge(data->getFrameData());
 
     return convertedData;
 }
@@ -175,16 +175,20 @@ namespace fast {
                 for (int frameNr = 0; frameNr < frameCount; ++frameNr) {
                     reportInfo() << "Extracting frame " << frameNr << " in UFF file" << reportEnd();
                     // Extract 1 frame
-                    auto imaginary = std::make_unique<float[]>(width * height);
-                    auto real = std::make_unique<float[]>(width * height);
+                    // Buffers are drawn from and returned to the pixel buffer pool to avoid allocations for every frame
+                    auto imaginaryBuffer = allocatePixelArray(width * height, TYPE_FLOAT);
+                    auto realBuffer = allocatePixelArray(width * height, TYPE_FLOAT);
+                    auto imaginary = (float*)imaginaryBuffer.get();
+                    auto real = (float*)realBuffer.get();
                     offset[0] = frameNr;
                     imagDataspace.selectHyperslab(H5S_SELECT_SET, count, offset, NULL, blockSize);
-                    imagDataset.read(imaginary.get(), H5::PredType::NATIVE_FLOAT, memspace, imagDataspace);
+                    imagDataset.read(imaginary, H5::PredType::NATIVE_FLOAT, memspace, imagDataspace);
                     realDataspace.selectHyperslab(H5S_SELECT_SET, count, offset, NULL, blockSize);
-                    realDataset.read(real.get(), H5::PredType::NATIVE_FLOAT, memspace, realDataspace);
+                    realDataset.read(real, H5::PredType::NATIVE_FLOAT, memspace, realDataspace);
 
                     // TODO start env
-                    auto image_data = std::make_unique<float[]>(width * height);
+                    auto image_buffer = allocatePixelArray(width * height, TYPE_FLOAT);
+                    auto image_data = (float*)image_buffer.get();
                     for (int y = 0; y < height; ++y) {
                         for (int x = 0; x < width; ++x) {
 
@@ -194,7 +198,7 @@ namespace fast {
                     }
                     // TODO end env
                     auto image = Image::New();
-                    image->create(width, height, DataType::TYPE_FLOAT, 1, std::move(image_data));
+                    image->create(width, height, DataType::TYPE_FLOAT, 1, std::move(image_buffer));
                     //image->setSpacing(spacing);
                     //std::cout << image->calculateMaximumIntensity() << " " << image->calculateMinimumIntensity() << std::endl;
 
@@ -230,12 +234,14 @@ namespace fast {
                 for (int frameNr = 0; frameNr < frameCount; ++frameNr) {
                     reportInfo() << "Extracting frame " << frameNr << " in UFF file" << reportEnd();
                     // Extract 1 frame
-                    auto data = std::make_unique<uchar[]>(width * height);
+                    auto buffer = allocatePixelArray(width * height, TYPE_UINT8);
+                    auto data = (uchar*)buffer.get();
                     offset[0] = frameNr;
                     dataspace.selectHyperslab(H5S_SELECT_SET, count, offset, NULL, blockSize);
-                    dataset.read(data.get(), H5::PredType::NATIVE_UCHAR, memspace, dataspace);
+                    dataset.read(data, H5::PredType::NATIVE_UCHAR, memspace, dataspace);
 
-                    auto image_data = std::make_unique<uchar[]>(width * height);
+                    auto image_buffer = allocatePixelArray(width * height, TYPE_UINT8);
+                    auto image_data = (uchar*)image_buffer.get();
                     for (int y = 0; y < height; ++y) {
                         for (int x = 0; x < width; ++x) {
 
@@ -245,7 +251,7 @@ namespace fast {
                     }
 
                     auto image = Image::New();
-                    image->create(width, height, DataType::TYPE_UINT8, 1, std::move(image_data));
+                    image->create(width, height, DataType::TYPE_UINT8, 1, std::move(image_buffer));
                     image->setSpacing(spacing);
 
                     try {
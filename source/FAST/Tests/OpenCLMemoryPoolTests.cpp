@@ -0,0 +1,88 @@
+#include "FAST/Testing.hpp"
+#include "FAST/OpenCLMemoryPool.hpp"
+#include "FAST/DeviceManager.hpp"
+#include "FAST/Data/Image.hpp"
+
+using namespace fast;
+
+TEST_CASE("OpenCL memory pool reuses returned buffers and images", "[fast][OpenCLMemoryPool]") {
+    OpenCLDevice::pointer device = DeviceManager::getInstance()->getOneOpenCLDevice();
+    auto pool = std::make_shared<OpenCLMemoryPool>(device->getContext());
+
+    cl::Buffer* buffer = pool->leaseBuffer(CL_MEM_READ_WRITE, 1024);
+    pool->returnBuffer(buffer);
+    CHECK(pool->leaseBuffer(CL_MEM_READ_WRITE, 1024) == buffer);
+    // Different size should not reuse the buffer
+    cl::Buffer* buffer2 = pool->leaseBuffer(CL_MEM_READ_WRITE, 2048);
+    CHECK(buffer2 != buffer);
+    pool->returnBuffer(buffer);
+    pool->returnBuffer(buffer2);
+
+    cl::ImageFormat format(CL_R, CL_FLOAT);
+    cl::Image* image = pool->leaseImage(CL_MEM_READ_WRITE, format, 64, 64);
+    pool->returnImage(image);
+    // A 3D image should not reuse the 2D image
+    cl::Image* image3D = pool->leaseImage(CL_MEM_READ_WRITE, format, 64, 64, 4);
+    CHECK(image3D != image);
+    CHECK(pool->leaseImage(CL_MEM_READ_WRITE, format, 64, 64) == image);
+
+    auto statistics = pool->getStatistics();
+    CHECK(statistics.hits == 2);
+    CHECK(statistics.misses == 4);
+    CHECK(statistics.residentBytes == 1024 + 2048);
+    CHECK(statistics.leasedBytes == 64*64*4 + 64*64*4*4);
+
+    pool->returnImage(image);
+    pool->returnImage(image3D);
+    CHECK(pool->getStatistics().leasedBytes == 0);
+}
+
+TEST_CASE("OpenCL memory pool evicts least recently returned objects", "[fast][OpenCLMemoryPool]") {
+    OpenCLDevice::pointer device = DeviceManager::getInstance()->getOneOpenCLDevice();
+    auto pool = std::make_shared<OpenCLMemoryPool>(device->getContext());
+    pool->setMaximumResidentBytes(2048);
+
+    cl::Buffer* buffer = pool->leaseBuffer(CL_MEM_READ_WRITE, 1024);
+    cl::Buffer* buffer2 = pool->leaseBuffer(CL_MEM_READ_WRITE, 1024);
+    cl::Buffer* buffer3 = pool->leaseBuffer(CL_MEM_READ_WRITE, 1024);
+    pool->returnBuffer(buffer);
+    pool->returnBuffer(buffer2);
+    pool->returnBuffer(buffer3);
+    auto statistics = pool->getStatistics();
+    CHECK(statistics.evicted == 1);
+    CHECK(statistics.residentBytes == 2048);
+
+    pool->clear();
+    CHECK(pool->getStatistics().residentBytes == 0);
+}
+
+TEST_CASE("OpenCL memory pool only releases pooled objects when out of memory", "[fast][OpenCLMemoryPool]") {
+    OpenCLDevice::pointer device = DeviceManager::getInstance()->getOneOpenCLDevice();
+    auto pool = std::make_shared<OpenCLMemoryPool>(device->getContext());
+
+    pool->returnBuffer(pool->leaseBuffer(CL_MEM_READ_WRITE, 1024));
+    // Invalid size, not an allocation failure
+    CHECK_THROWS(pool->leaseBuffer(CL_MEM_READ_WRITE, 0));
+    CHECK(pool->getStatistics().residentBytes == 1024);
+
+    // Objects not leased from the pool are released, not stored
+    pool->returnBuffer(new cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, 1024));
+    CHECK(pool->getStatistics().residentBytes == 1024);
+}
+
+TEST_CASE("Streamed images reuse OpenCL images from the memory pool of the device", "[fast][OpenCLMemoryPool][image]") {
+    OpenCLDevice::pointer device = DeviceManager::getInstance()->getOneOpenCLDevice();
+    auto pool = device->getMemoryPool();
+    pool->clear();
+    pool->resetStatistics();
+
+    for(int i = 0; i < 10; ++i) {
+        auto image = Image::New();
+        image->create(128, 128, TYPE_UINT8, 1);
+        auto access = image->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
+        access->get2DImage();
+    }
+    auto statistics = pool->getStatistics();
+    CHECK(statistics.misses == 1);
+    CHECK(statistics.hits == 9);
+}
@@ -0,0 +1,114 @@
+#include "FAST/Testing.hpp"
+#include "FAST/DeviceManager.hpp"
+#include "FAST/Config.hpp"
+#include "FAST/Utility.hpp"
+#include <fstream>
+#include <ctime>
+
+using namespace fast;
+
+static int countBinaries(std::string path) {
+    if(!fileExists(path))
+        return 0;
+    int count = 0;
+    for(auto&& name : getDirectoryList(path)) {
+        if(name.size() > 4 && name.substr(name.size() - 4) == ".bin")
+            ++count;
+    }
+    return count;
+}
+
+static void writeTextFile(std::string filename, std::string text) {
+    std::ofstream file(filename);
+    file << text;
+}
+
+/**
+ * Points the kernel binary path to a new empty directory while it exists, so that tests don't use the
+ * program cache of the user.
+ */
+class TemporaryKernelBinaryPath {
+    public:
+        TemporaryKernelBinaryPath() {
+            m_previousPath = Config::getKernelBinaryPath();
+#ifdef _WIN32
+            const char* temporaryPath = std::getenv("TEMP");
+#else
+            const char* temporaryPath = std::getenv("TMPDIR");
+#endif
+            m_path = join(temporaryPath != nullptr ? temporaryPath : "/tmp",
+                          "fast_program_cache_test_" + std::to_string(std::time(nullptr)) + "_" + std::to_string(std::rand()));
+            createDirectories(m_path);
+            Config::setKernelBinaryPath(m_path + "/");
+        }
+        std::string getPath() const {
+            return m_path;
+        }
+        std::string getCachePath() const {
+            return join(m_path, "cache");
+        }
+        ~TemporaryKernelBinaryPath() {
+            Config::setKernelBinaryPath(m_previousPath);
+            for(auto&& directory : {getCachePath(), m_path}) {
+                for(auto&& name : getDirectoryList(directory))
+                    std::remove(join(directory, name).c_str());
+                std::remove(directory.c_str());
+            }
+        }
+    private:
+        std::string m_path;
+        std::string m_previousPath;
+};
+
+TEST_CASE("OpenCL programs built from strings are stored in the program cache", "[fast][OpenCLDevice][ProgramCache]") {
+    OpenCLDevice::pointer device = DeviceManager::getInstance()->getOneOpenCLDevice();
+    TemporaryKernelBinaryPath path;
+    const std::string code = "__kernel void test(__global int* out) { out[0] = 1; }";
+
+    const int built = device->getNrOfProgramsBuiltFromSource();
+    const int loaded = device->getNrOfProgramsLoadedFromCache();
+    device->createProgramFromString(code);
+    CHECK(countBinaries(path.getCachePath()) == 1);
+    CHECK(device->getNrOfProgramsBuiltFromSource() == built + 1);
+    CHECK(device->getNrOfProgramsLoadedFromCache() == loaded);
+    // Second build is loaded from the cache
+    device->createProgramFromString(code);
+    CHECK(countBinaries(path.getCachePath()) == 1);
+    CHECK(device->getNrOfProgramsBuiltFromSource() == built + 1);
+    CHECK(device->getNrOfProgramsLoadedFromCache() == loaded + 1);
+    // Different build options gives a different binary
+    device->createProgramFromString(code, "-DTEST_OPTION");
+    CHECK(countBinaries(path.getCachePath()) == 2);
+    CHECK(device->getNrOfProgramsBuiltFromSource() == built + 2);
+}
+
+TEST_CASE("Changing a file included by an OpenCL program invalidates its cached binary", "[fast][OpenCLDevice][ProgramCache]") {
+    OpenCLDevice::pointer device = DeviceManager::getInstance()->getOneOpenCLDevice();
+    TemporaryKernelBinaryPath path;
+    const std::string sourceFilename = join(path.getPath(), "program.cl");
+    const std::string buildOptions = "-I" + path.getPath();
+    writeTextFile(join(path.getPath(), "value.h"), "#define VALUE 1\n");
+    writeTextFile(sourceFilename, "#include \"value.h\"\n__kernel void test(__global int* out) { out[0] = VALUE; }\n");
+
+    const int built = device->getNrOfProgramsBuiltFromSource();
+    const int loaded = device->getNrOfProgramsLoadedFromCache();
+    device->createProgramFromSource(sourceFilename, buildOptions);
+    device->createProgramFromSource(sourceFilename, buildOptions);
+    CHECK(device->getNrOfProgramsBuiltFromSource() == built + 1);
+    CHECK(device->getNrOfProgramsLoadedFromCache() == loaded + 1);
+
+    writeTextFile(join(path.getPath(), "value.h"), "#define VALUE 2\n");
+    const int id = device->createProgramFromSource(sourceFilename, buildOptions);
+    CHECK(device->getNrOfProgramsBuiltFromSource() == built + 2);
+    CHECK(device->getNrOfProgramsLoadedFromCache() == loaded + 1);
+    CHECK(countBinaries(path.getCachePath()) == 2);
+
+    // The program uses the changed file
+    cl::Buffer buffer(device->getContext(), CL_MEM_READ_WRITE, sizeof(int));
+    cl::Kernel kernel(device->getProgram(id), "test");
+    kernel.setArg(0, buffer);
+    device->getCommandQueue().enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(1), cl::NullRange);
+    int value = 0;
+    device->getCommandQueue().enqueueReadBuffer(buffer, CL_TRUE, 0, sizeof(int), &value);
+    CHECK(value == 2);
+}
@@ -0,0 +1,78 @@
+#include <FAST/Testing.hpp>
+#include <FAST/PipelineExecutor.hpp>
+#include "DummyObjects.hpp"
+
+using namespace fast;
+
+static DummyDataObject::pointer waitForLastFrame(DataChannel::pointer port) {
+    // The last stage writes to a static data channel, poll it until the last frame arrives
+    for(int i = 0; i < 500; ++i) {
+        if(port->hasCurrentData()) {
+            auto data = std::dynamic_pointer_cast<DummyDataObject>(port->getFrame());
+            if(data->isLastFrame())
+                return data;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return nullptr;
+}
+
+TEST_CASE("Pipeline executor with two stages", "[fast][PipelineExecutor]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(5);
+    streamer->setTotalFrames(20);
+
+    auto po1 = DummyProcessObject::New();
+    po1->setInputConnection(streamer->getOutputPort());
+
+    auto po2 = DummyProcessObject::New();
+    po2->setInputConnection(po1->getOutputPort());
+    auto port = po2->getOutputPort();
+
+    auto executor = PipelineExecutor::New();
+    executor->addProcessObject(po2);
+    executor->start();
+    CHECK(executor->isRunning());
+    REQUIRE(executor->getStages().size() == 2);
+    CHECK(executor->getStages()[0] == po1);
+    CHECK(executor->getStages()[1] == po2);
+
+    auto data = waitForLastFrame(port);
+    REQUIRE(data != nullptr);
+    CHECK(data->getID() == 19);
+
+    executor->stop();
+    CHECK(!executor->isRunning());
+}
+
+TEST_CASE("Pipeline executor with stages grouped on a single thread", "[fast][PipelineExecutor]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(5);
+    streamer->setTotalFrames(20);
+
+    auto importer = DummyImporter::New();
+
+    auto po1 = DummyProcessObject::New();
+    po1->setInputConnection(streamer->getOutputPort());
+
+    auto po2 = DummyProcessObject2::New();
+    po2->setInputConnection(0, po1->getOutputPort());
+    po2->setInputConnection(1, importer->getOutputPort());
+    auto port = po2->getOutputPort();
+
+    auto executor = PipelineExecutor::New();
+    executor->setMaximumNumberOfThreads(1);
+    executor->addProcessObject(po2);
+    executor->start();
+    // The importer does not depend on the streamer, and should not be a stage
+    CHECK(executor->getStages().size() == 2);
+
+    auto data = waitForLastFrame(port);
+    REQUIRE(data != nullptr);
+    CHECK(data->getID() == 19);
+    CHECK(po2->getStaticDataID() == 0);
+
+    executor->stop();
+}
@@ -1,5 +1,11 @@
 #include "catch.hpp"
 #include "DummyObjects.hpp"
+#include <FAST/DataChannels/RingBufferDataChannel.hpp>
+#include <FAST/Algorithms/BinaryThresholding/BinaryThresholding.hpp>
+#include <FAST/Algorithms/ScaleImage/ScaleImage.hpp>
+#include <FAST/Algorithms/HounsefieldConverter/HounsefieldConverter.hpp>
+#include <FAST/Data/Image.hpp>
+#include <FAST/OpenCLProgram.hpp>
 
 namespace fast {
 
@@ -28,6 +34,34 @@ TEST_CASE("Simple pipeline with stream", "[process_all_frames][ProcessObject][fa
     CHECK(timestep == 20);
 }
 
+TEST_CASE("Simple pipeline with stream and lock-free data channels", "[process_all_frames][ProcessObject][fast]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    Config::setLockFreeDataChannels(true);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(20);
+    auto streamerPort = streamer->getOutputPort();
+    CHECK(std::dynamic_pointer_cast<RingBufferDataChannel>(streamerPort));
+    streamerPort->setMaximumNumberOfFrames(3);
+
+    auto po = DummyProcessObject::New();
+    po->setInputConnection(streamerPort);
+
+    auto port = po->getOutputPort();
+
+    bool lastFrame = false;
+    int timestep = 0;
+    while(!lastFrame) {
+        po->update();
+        auto image = port->getNextFrame<DummyDataObject>();
+        lastFrame = image->isLastFrame();
+        CHECK(image->getID() == timestep);
+        timestep++;
+    }
+    CHECK(timestep == 20);
+    Config::setLockFreeDataChannels(false);
+}
+
 TEST_CASE("Two step pipeline with stream", "[two_step][process_all_frames][ProcessObject][fast]") {
     Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
     auto streamer = DummyStreamer::New();
@@ -579,4 +613,41 @@ TEST_CASE("Trying to set input connection to self throws exception", "[ProcessOb
     CHECK_THROWS(po->setInputConnection(po->getOutputPort()));
 }
 
+TEST_CASE("Precompile OpenCL programs of process objects", "[ProcessObject][fast][OpenCLProgram]") {
+    auto thresholding = BinaryThresholding::New();
+    auto scaling = ScaleImage::New();
+    auto converter = HounsefieldConverter::New();
+    auto device = std::dynamic_pointer_cast<OpenCLDevice>(thresholding->getMainDevice());
+    REQUIRE(device);
+    precompileOpenCLPrograms({thresholding, scaling, converter});
+
+    int declaredPrograms = 0;
+    for(auto&& processObject : std::vector<ProcessObject::pointer>{thresholding, scaling, converter}) {
+        for(auto&& program : processObject->getOpenCLPrograms()) {
+            for(auto buildOptions : program->getPrecompileBuildOptions()) {
+                // Same name as used by OpenCLProgram::build
+                if(device->isWritingTo3DTexturesSupported())
+                    buildOptions += buildOptions.empty() ? "-Dfast_3d_image_writes" : " -Dfast_3d_image_writes";
+                CHECK(device->hasProgram(program->getSourceFilename() + buildOptions));
+                ++declaredPrograms;
+            }
+        }
+    }
+    CHECK(declaredPrograms == 4);
+
+    // Executing the process objects uses the precompiled programs
+    std::vector<float> data(64*64);
+    for(int i = 0; i < data.size(); ++i)
+        data[i] = i % 64;
+    auto image = Image::New();
+    image->create(64, 64, TYPE_FLOAT, 1, data.data());
+    const int programs = device->getNrOfProgramsBuiltFromSource() + device->getNrOfProgramsLoadedFromCache();
+    thresholding->setLowerThreshold(32);
+    thresholding->setInputData(image);
+    thresholding->update();
+    scaling->setInputData(image);
+    scaling->update();
+    CHECK(device->getNrOfProgramsBuiltFromSource() + device->getNrOfProgramsLoadedFromCache() == programs);
+}
+
 }
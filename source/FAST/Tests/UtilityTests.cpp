@@ -48,4 +48,20 @@ TEST_CASE("Replace", "[replace][utility]") {
 
     str = "Hello world!";
     CHECK(replace(str, "world", "fantasy") == "Hello fantasy!");
-}
\ No newline at end of file
+}
+TEST_CASE("parallelFor", "[parallelFor][utility]") {
+    // Every index is visited once
+    std::vector<int> visits(1000, 0);
+    parallelFor(visits.size(), [&visits](std::size_t start, std::size_t end) {
+        for(std::size_t i = start; i < end; ++i)
+            visits[i]++;
+    });
+    for(auto&& count : visits)
+        CHECK(count == 1);
+
+    // Exceptions thrown by a worker are rethrown on the calling thread
+    CHECK_THROWS_AS(parallelFor(visits.size(), [](std::size_t start, std::size_t end) {
+        if(start == 0)
+            throw Exception("Error in first range");
+    }), Exception);
+}
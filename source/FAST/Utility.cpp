@@ -2,6 +2,8 @@
 #include "FAST/Config.hpp"
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <thread>
+#include <exception>
 #ifdef _WIN32
 #include <windows.h>
 #include <direct.h> // Needed for _mkdir
@@ -803,4 +805,33 @@ std::string getModifiedDate(std::string filename) {
     return timeStr;
 }
 
+void parallelFor(std::size_t size, const std::function<void(std::size_t, std::size_t)>& function) {
+    const std::size_t threads = std::min(size, (std::size_t)std::max(1u, std::thread::hardware_concurrency()));
+    if(threads <= 1) {
+        function(0, size);
+        return;
+    }
+    std::vector<std::thread> workers;
+    const std::size_t chunkSize = (size + threads - 1) / threads;
+    // Exceptions can't propagate out of a thread, thus store them and rethrow the first one on this thread
+    std::vector<std::exception_ptr> exceptions(threads);
+    for(std::size_t start = 0; start < size; start += chunkSize) {
+        const std::size_t end = std::min(start + chunkSize, size);
+        std::exception_ptr& exception = exceptions[workers.size()];
+        workers.push_back(std::thread([&function, &exception, start, end]() {
+            try {
+                function(start, end);
+            } catch(...) {
+                exception = std::current_exception();
+            }
+        }));
+    }
+    for(auto&& worker : workers)
+        worker.join();
+    for(auto&& exception : exceptions) {
+        if(exception)
+            std::rethrow_exception(exception);
+    }
+}
+
 } // end namespace fast
@@ -248,7 +248,14 @@ std::unique_ptr<T> make_uninitialized_unique(std::size_t size) {
     return std::unique_ptr<T>(new typename std::remove_extent<T>::type[size]);
 }
 
-
+/**
+ * Run a function on consecutive ranges [start, end) of [0, size) using one thread per core.
+ * Returns when all ranges are done. The function is called once with the entire range if there is only one core.
+ * If the function throws, the first exception is rethrown on the calling thread after all ranges are done.
+ * @param size
+ * @param function called with start and end of each range
+ */
+FAST_EXPORT void parallelFor(std::size_t size, const std::function<void(std::size_t, std::size_t)>& function);
 
 } // end namespace fast
 
@@ -1,6 +1,7 @@
 #include "ComputationThread.hpp"
 #include "SimpleWindow.hpp"
 #include "View.hpp"
+#include <FAST/PipelineExecutor.hpp>
 #include <QGLContext>
 
 namespace fast {
@@ -37,6 +38,28 @@ void ComputationThread::run() {
     QGLContext* mainGLContext = Window::getMainGLContext();
     mainGLContext->makeCurrent();
 
+    PipelineExecutor::pointer executor;
+    if(m_parallelExecution) {
+        // Let the executor run the process objects and renderer inputs, the renderers are still updated here
+        executor = PipelineExecutor::New();
+        executor->setMaximumNumberOfThreads(m_parallelExecutionThreads);
+        for(auto po : m_processObjects)
+            executor->addProcessObject(po);
+        for(View* view : mViews) {
+            for(auto renderer : view->getRenderers()) {
+                for(int i = 0; i < renderer->getNrOfInputConnections(); ++i)
+                    executor->addProcessObject(renderer->getInputPort(i)->getProcessObject());
+            }
+        }
+        try {
+            executor->start();
+        } catch(ThreadStopped &e) {
+            // The pipeline was stopped while the executor updated the static process objects
+            std::unique_lock<std::mutex> lock(mUpdateThreadMutex);
+            mStop = true;
+        }
+    }
+
     uint executeToken = 0;
     while(true) {
         {
@@ -58,6 +81,8 @@ void ComputationThread::run() {
         }
         ++executeToken;
     }
+    if(executor)
+        executor->stop();
 
     // Move GL context back to main thread
     mainGLContext->doneCurrent();
@@ -94,6 +119,11 @@ void ComputationThread::stop() {
     }
 }
 
+void ComputationThread::setParallelExecution(bool parallel, uint threads) {
+    m_parallelExecution = parallel;
+    m_parallelExecutionThreads = threads;
+}
+
 void ComputationThread::setProcessObjects(std::vector<SharedPointer<ProcessObject>> pos) {
     m_processObjects = pos;
 }
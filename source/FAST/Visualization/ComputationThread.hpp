@@ -23,6 +23,12 @@ class FAST_EXPORT  ComputationThread : public QObject, public Object {
         void addView(View* view);
         void clearViews();
         void setProcessObjects(std::vector<SharedPointer<ProcessObject>> processObjects);
+        /**
+         * Execute the pipeline stages concurrently using a PipelineExecutor
+         * @param parallel
+         * @param threads max nr of worker threads, 0 means one thread per stage
+         */
+        void setParallelExecution(bool parallel, uint threads = 0);
     public slots:
         void run();
     signals:
@@ -39,6 +45,8 @@ class FAST_EXPORT  ComputationThread : public QObject, public Object {
         std::vector<SharedPointer<ProcessObject>> m_processObjects;
 
         bool mStop = false;
+        bool m_parallelExecution = false;
+        uint m_parallelExecutionThreads = 0;
 };
 
 }
@@ -7,6 +7,7 @@ namespace fast {
 HeatmapRenderer::HeatmapRenderer() {
     createInputPort<Tensor>(0, false);
     createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/HeatmapRenderer/HeatmapRenderer.cl");
+    declareOpenCLProgramBuildOptions();
     createShaderProgram({
                                 Config::getKernelSourcePath() + "/Visualization/ImageRenderer/ImageRenderer.vert",
                                 Config::getKernelSourcePath() + "/Visualization/ImageRenderer/ImageRenderer.frag",
@@ -7,6 +7,8 @@
 #include <QGLContext>
 #include <FAST/Visualization/Window.hpp>
 #include <FAST/Visualization/View.hpp>
+#include <algorithm>
+#include <tuple>
 #if defined(__APPLE__) || defined(__MACOSX)
 #include <OpenCL/cl_gl.h>
 #include <OpenGL/gl.h>
@@ -26,10 +28,73 @@ namespace fast {
 
 void ImagePyramidRenderer::clearPyramid() {
     // Clear buffer. Useful when processing a new image
+    std::lock_guard<std::mutex> lock(m_texturesToRenderMutex);
     mTexturesToRender.clear();
+    m_textureInfo.clear();
+    m_textureLRU.clear();
+    m_textureMemoryUsage = 0;
     mDataToRender.clear();
 }
 
+void ImagePyramidRenderer::setMaximumTextureMemory(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_texturesToRenderMutex);
+    // Textures are deleted by the buffer thread when the next tile is added
+    m_maximumTextureMemory = bytes;
+}
+
+std::size_t ImagePyramidRenderer::getMaximumTextureMemory() const {
+    std::lock_guard<std::mutex> lock(m_texturesToRenderMutex);
+    return m_maximumTextureMemory;
+}
+
+std::size_t ImagePyramidRenderer::getTextureMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(m_texturesToRenderMutex);
+    return m_textureMemoryUsage;
+}
+
+void ImagePyramidRenderer::touchTexture(const std::string& tileID) {
+    auto& info = m_textureInfo.at(tileID);
+    info.lastDrawn = m_frame;
+    m_textureLRU.splice(m_textureLRU.begin(), m_textureLRU, info.lruPosition);
+}
+
+void ImagePyramidRenderer::addTexture(const std::string& tileID, uint textureID, int level, std::size_t bytes) {
+    m_textureLRU.push_front(tileID);
+    m_textureInfo[tileID] = {level, bytes, m_frame, m_textureLRU.begin()};
+    mTexturesToRender[tileID] = textureID;
+    m_textureMemoryUsage += bytes;
+
+    // Delete least recently drawn textures until below maximum
+    const int coarsestLevel = m_input->getNrOfLevels() - 1;
+    auto it = m_textureLRU.end();
+    while(m_textureMemoryUsage > m_maximumTextureMemory && it != m_textureLRU.begin()) {
+        --it;
+        auto& info = m_textureInfo.at(*it);
+        // Coarsest level is always kept, as it is drawn below all other levels. Tiles of current frame are in use.
+        if(info.level == coarsestLevel || info.lastDrawn == m_frame)
+            continue;
+        GLuint oldTextureID = mTexturesToRender[*it];
+        glDeleteTextures(1, &oldTextureID);
+        m_textureMemoryUsage -= info.bytes;
+        mTexturesToRender.erase(*it);
+        // Buffers are shared with the render context, vertex arrays are not and are deleted in draw
+        if(mVBO.count(*it) > 0) {
+            glDeleteBuffers(1, &mVBO[*it]);
+            mVBO.erase(*it);
+        }
+        if(mEBO.count(*it) > 0) {
+            glDeleteBuffers(1, &mEBO[*it]);
+            mEBO.erase(*it);
+        }
+        if(mVAO.count(*it) > 0) {
+            m_unusedVAOs.push_back(mVAO[*it]);
+            mVAO.erase(*it);
+        }
+        m_textureInfo.erase(*it);
+        it = m_textureLRU.erase(it);
+    }
+}
+
 ImagePyramidRenderer::~ImagePyramidRenderer() {
     m_stop = true;
     m_queueEmptyCondition.notify_one();
@@ -48,6 +113,7 @@ ImagePyramidRenderer::ImagePyramidRenderer() : Renderer() {
     m_currentLevel = -1;
     createFloatAttribute("window", "Intensity window", "Intensity window", -1);
     createFloatAttribute("level", "Intensity level", "Intensity level", -1);
+    createIntegerAttribute("max-texture-memory", "Maximum texture memory", "Maximum GPU memory used for tile textures in MB", 512);
     createShaderProgram({
                                 Config::getKernelSourcePath() + "/Visualization/ImagePyramidRenderer/ImagePyramidRenderer.vert",
                                 Config::getKernelSourcePath() + "/Visualization/ImagePyramidRenderer/ImagePyramidRenderer.frag",
@@ -76,6 +142,7 @@ float ImagePyramidRenderer::getIntensityWindow() {
 void ImagePyramidRenderer::loadAttributes() {
     mWindow = getFloatAttribute("window");
     mLevel = (getFloatAttribute("level"));
+    setMaximumTextureMemory((std::size_t)getIntegerAttribute("max-texture-memory")*1024*1024);
 }
 
 void ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, float zNear, float zFar, bool mode2D) {
@@ -115,7 +182,6 @@ void ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatr
                 throw Exception("The custom Qt GL context is not sharing!");
             context->makeCurrent();
 #endif
-            uint64_t memoryUsage = 0;
             while(true) {
                 std::string tileID;
                 {
@@ -127,14 +193,17 @@ void ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatr
                     if(m_stop)
                         break;
 
-                    // Get next item on queue
-                    tileID = m_tileQueue.back();
-                    m_tileQueue.pop_back();
+                    // Get tile with highest priority
+                    tileID = m_tileQueue.front();
+                    m_tileQueue.pop_front();
                 }
 
                 // Check if tile has been processed before
-                if(mTexturesToRender.count(tileID) > 0)
-                    continue;
+                {
+                    std::lock_guard<std::mutex> lock(m_texturesToRenderMutex);
+                    if(mTexturesToRender.count(tileID) > 0)
+                        continue;
+                }
 
                 // Create texture
                 auto parts = split(tileID, "_");
@@ -170,9 +239,10 @@ void ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatr
                 glBindTexture(GL_TEXTURE_2D, 0);
                 glFinish();
 
-                mTexturesToRender[tileID] = textureID;
-                memoryUsage += compressedImageSize;
-                //std::cout << "Texture cache in ImagePyramidRenderer using " << (float)memoryUsage / (1024 * 1024) << " MB" << std::endl;
+                {
+                    std::lock_guard<std::mutex> lock(m_texturesToRenderMutex);
+                    addTexture(tileID, textureID, level, compressedImageSize);
+                }
             }
         });
     }
@@ -232,6 +302,18 @@ void ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatr
     transformLoc = glGetUniformLocation(getShaderProgram(), "viewTransform");
     glUniformMatrix4fv(transformLoc, 1, GL_FALSE, viewingMatrix.data());
 
+    // Missing visible tiles, with priority given by level and distance to center of view
+    std::vector<std::tuple<int, float, std::string>> missingTiles;
+    const float centerX = offset_x + width*0.5f;
+    const float centerY = offset_y + height*0.5f;
+    std::unique_lock<std::mutex> texturesLock(m_texturesToRenderMutex);
+    ++m_frame;
+    // Vertex arrays of evicted textures belong to this context
+    if(!m_unusedVAOs.empty()) {
+        glDeleteVertexArrays(m_unusedVAOs.size(), m_unusedVAOs.data());
+        m_unusedVAOs.clear();
+    }
+
     for(int level = m_input->getNrOfLevels()-1; level >= levelToUse; level--) {
         const int levelWidth = m_input->getLevelWidth(level);
         const int levelHeight = m_input->getLevelHeight(level);
@@ -280,14 +362,15 @@ void ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatr
 
                 // Is patch in cache?
                 if(mTexturesToRender.count(tileString) == 0) {
-                    // Add to queue if not in cache
-                    {
-                        std::lock_guard<std::mutex> lock(m_tileQueueMutex);
-                        m_tileQueue.push_back(tileString);
-                    }
-                    m_queueEmptyCondition.notify_one();
+                    // Add to queue if not in cache. Coarse levels are loaded first, then the tiles closest to the center.
+                    const float distance = std::hypot(
+                            (tile_offset_x + tile_width*0.5f)*mCurrentTileScale - centerX,
+                            (tile_offset_y + tile_height*0.5f)*mCurrentTileScale - centerY
+                    );
+                    missingTiles.push_back(std::make_tuple(-level, distance, tileString));
                     continue;
                 }
+                touchTexture(tileString);
 
                 // Delete old VAO
                 if(mVAO.count(tileString) > 0)
@@ -353,7 +436,19 @@ void ImagePyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatr
             }
         }
     }
+    texturesLock.unlock();
     deactivateShader();
+
+    // Replace queue with the tiles currently visible, so that tiles which have moved out of view are not loaded
+    std::sort(missingTiles.begin(), missingTiles.end());
+    {
+        std::lock_guard<std::mutex> lock(m_tileQueueMutex);
+        m_tileQueue.clear();
+        for(auto&& tile : missingTiles)
+            m_tileQueue.push_back(std::get<2>(tile));
+    }
+    if(!missingTiles.empty())
+        m_queueEmptyCondition.notify_one();
 }
 
 void ImagePyramidRenderer::drawTextures(Matrix4f &perspectiveMatrix, Matrix4f &viewingMatrix, bool mode2D) {
@@ -2,6 +2,7 @@
 
 #include <FAST/Visualization/Renderer.hpp>
 #include <deque>
+#include <list>
 #include <thread>
 
 namespace fast {
@@ -18,6 +19,15 @@ class FAST_EXPORT ImagePyramidRenderer : public Renderer {
         float getIntensityWindow();
         ~ImagePyramidRenderer() override;
         void clearPyramid();
+        /**
+         * Set maximum amount of GPU memory used for tile textures.
+         * When exceeded, the least recently drawn tiles are deleted, except tiles of the coarsest level
+         * and tiles drawn in the current frame. Default is 512 MB.
+         * @param bytes
+         */
+        void setMaximumTextureMemory(std::size_t bytes);
+        std::size_t getMaximumTextureMemory() const;
+        std::size_t getTextureMemoryUsage() const;
     private:
         ImagePyramidRenderer();
         void draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, float zNear, float zFar, bool mode2D);
@@ -27,9 +37,36 @@ class FAST_EXPORT ImagePyramidRenderer : public Renderer {
         std::unordered_map<std::string, uint> mVAO;
         std::unordered_map<std::string, uint> mVBO;
         std::unordered_map<std::string, uint> mEBO;
+        // Vertex arrays of evicted textures, to be deleted by the render thread
+        std::vector<uint> m_unusedVAOs;
 
-        // Queue of tiles to be loaded
-        std::deque<std::string> m_tileQueue; // LIFO queue
+        struct TextureInfo {
+            int level;
+            std::size_t bytes;
+            // Frame in which the tile was last drawn
+            uint64_t lastDrawn;
+            std::list<std::string>::iterator lruPosition;
+        };
+        /**
+         * Add texture to cache, and delete least recently drawn textures if the cache is full.
+         * m_texturesToRenderMutex must be locked.
+         */
+        void addTexture(const std::string& tileID, uint textureID, int level, std::size_t bytes);
+        /**
+         * Mark texture as drawn in the current frame. m_texturesToRenderMutex must be locked.
+         */
+        void touchTexture(const std::string& tileID);
+
+        std::unordered_map<std::string, TextureInfo> m_textureInfo;
+        // Tiles in texture cache, most recently drawn first
+        std::list<std::string> m_textureLRU;
+        std::size_t m_maximumTextureMemory = 512*1024*1024;
+        std::size_t m_textureMemoryUsage = 0;
+        uint64_t m_frame = 0;
+        mutable std::mutex m_texturesToRenderMutex;
+
+        // Queue of tiles to be loaded, ordered by priority. Replaced every frame, thus tiles no longer visible are not loaded.
+        std::deque<std::string> m_tileQueue;
         // Buffer to process queue
         std::unique_ptr<std::thread> m_bufferThread;
         // Condition variable to wait if queue is empty
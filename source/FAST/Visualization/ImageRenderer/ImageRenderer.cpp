@@ -26,6 +26,7 @@ ImageRenderer::ImageRenderer() : Renderer() {
     createInputPort<Image>(0, false);
     createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/ImageRenderer/ImageRenderer.cl", "3D");
     createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/ImageRenderer/ImageRenderer2D.cl", "2D");
+    declareOpenCLProgramBuildOptions("3D");
     mIsModified = true;
     mWindow = -1;
     mLevel = -1;
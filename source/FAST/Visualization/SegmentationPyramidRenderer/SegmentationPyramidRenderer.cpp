@@ -42,6 +42,7 @@ SegmentationPyramidRenderer::~SegmentationPyramidRenderer() {
 SegmentationPyramidRenderer::SegmentationPyramidRenderer() : Renderer() {
     createInputPort<ImagePyramid>(0, false);
     createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/SegmentationPyramidRenderer/SegmentationRenderer.cl");
+    declareOpenCLProgramBuildOptions();
     m_stop = false;
     m_currentLevel = -1;
     createShaderProgram({
@@ -177,23 +178,24 @@ void SegmentationPyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f view
                     m_tileQueue.pop_back();
                 }
 
+                auto parts = split(tileID, "_");
+                if(parts.size() != 3)
+                    throw Exception("incorrect tile format");
+
+                int level = std::stoi(parts[0]);
+                int tile_x = std::stoi(parts[1]);
+                int tile_y = std::stoi(parts[2]);
+
                 // Check if tile has been processed before
                 bool dirtyPatch = false;
                 if(mTexturesToRender.count(tileID) > 0) {
-                    if(m_input->getDirtyPatches().count(tileID) == 0) {
+                    if(!m_input->isDirtyPatch(level, tile_x, tile_y)) {
                         continue;
                     } else {
                         dirtyPatch = true;
                     }
                 }
                 // Create texture
-                auto parts = split(tileID, "_");
-                if(parts.size() != 3)
-                    throw Exception("incorrect tile format");
-
-                int level = std::stoi(parts[0]);
-                int tile_x = std::stoi(parts[1]);
-                int tile_y = std::stoi(parts[2]);
                 //std::cout << "Segmentation creating texture for tile " << tile_x << " " << tile_y << " at level " << level << std::endl;
                 
                 Image::pointer patch;
@@ -292,7 +294,7 @@ void SegmentationPyramidRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f view
                         mTexturesToRender[tileID] = textureID;
                         glDeleteTextures(1, &oldTextureID);
                     }
-                    m_input->clearDirtyPatches({tileID});
+                    m_input->clearDirtyPatch(level, tile_x, tile_y);
                 } else {
 					std::lock_guard<std::mutex> lock(m_texturesToRenderMutex);
 					mTexturesToRender[tileID] = textureID;
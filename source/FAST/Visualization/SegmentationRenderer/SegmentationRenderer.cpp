@@ -40,6 +40,7 @@ SegmentationRenderer::SegmentationRenderer() {
     createStringAttribute("label-colors", "Label color", "Label color set as <label1> <color1> <label2> <color2>", "");
 
     createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/SegmentationRenderer/SegmentationRenderer.cl");
+    declareOpenCLProgramBuildOptions();
     mIsModified = false;
     mColorsModified = true;
     mFillAreaModified = true;
@@ -5,6 +5,7 @@ namespace fast {
 VectorFieldColorRenderer::VectorFieldColorRenderer() {
     createInputPort<Image>(0, false);
     createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/VectorFieldRenderer/VectorFieldColorRenderer.cl");
+    declareOpenCLProgramBuildOptions();
     mIsModified = false;
 }
 
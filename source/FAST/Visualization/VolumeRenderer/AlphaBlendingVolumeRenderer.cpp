@@ -168,6 +168,7 @@ void AlphaBlendingVolumeRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f view
 
 AlphaBlendingVolumeRenderer::AlphaBlendingVolumeRenderer() {
     createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/VolumeRenderer/AlphaBlendingVolumeRenderer.cl");
+    declareOpenCLProgramBuildOptions();
 }
 
 void AlphaBlendingVolumeRenderer::setTransferFunction(TransferFunction transferFunction) {
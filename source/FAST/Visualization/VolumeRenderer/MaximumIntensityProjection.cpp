@@ -150,6 +150,7 @@ void MaximumIntensityProjection::draw(Matrix4f perspectiveMatrix, Matrix4f viewi
 
 MaximumIntensityProjection::MaximumIntensityProjection() {
     createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/VolumeRenderer/MaximumIntensityProjection.cl");
+    declareOpenCLProgramBuildOptions();
 }
 
 }
\ No newline at end of file
@@ -157,6 +157,7 @@ void ThresholdVolumeRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingM
 
 ThresholdVolumeRenderer::ThresholdVolumeRenderer() {
     createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/VolumeRenderer/ThresholdVolumeRenderer.cl");
+    declareOpenCLProgramBuildOptions();
 }
 
 }
\ No newline at end of file
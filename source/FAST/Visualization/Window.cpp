@@ -269,6 +269,7 @@ void Window::startComputationThread() {
         for(int i = 0; i < getViews().size(); i++)
             mThread->addView(getViews()[i]);
         mThread->setProcessObjects(m_processObjects);
+        mThread->setParallelExecution(m_parallelExecution, m_parallelExecutionThreads);
         QGLContext* mainGLContext = Window::getMainGLContext();
         if(!mainGLContext->isValid()) {
             throw Exception("QGL context is invalid!");
@@ -343,4 +344,13 @@ void Window::addProcessObject(SharedPointer<ProcessObject> po) {
     m_processObjects.push_back(po);
 }
 
+void Window::enableParallelExecution(uint threads) {
+    m_parallelExecution = true;
+    m_parallelExecutionThreads = threads;
+}
+
+void Window::disableParallelExecution() {
+    m_parallelExecution = false;
+}
+
 } // end namespace fast
@@ -61,6 +61,13 @@ class FAST_EXPORT  Window : public QObject, public Object {
         void saveScreenshotOfViewsOnClose(std::string filename);
         QWidget* getWidget();
         void addProcessObject(SharedPointer<ProcessObject> po);
+        /**
+         * Run the pipeline stages concurrently, each in its own worker thread,
+         * instead of updating them serially in the computation thread.
+         * @param threads max nr of worker threads, 0 means one thread per stage
+         */
+        void enableParallelExecution(uint threads = 0);
+        void disableParallelExecution();
     protected:
         void startComputationThread();
         void stopComputationThread();
@@ -75,6 +82,8 @@ class FAST_EXPORT  Window : public QObject, public Object {
         QEventLoop* mEventLoop;
         ComputationThread* mThread;
         std::vector<SharedPointer<ProcessObject>> m_processObjects;
+        bool m_parallelExecution = false;
+        uint m_parallelExecutionThreads = 0;
     private:
         static QGLContext* mMainGLContext;
     public slots: